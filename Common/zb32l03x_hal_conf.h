@@ -144,6 +144,10 @@ extern "C" {
 #define  PRIORITY_LOWEST              3
 #define  TICK_INT_PRIORITY            ((uint32_t)PRIORITY_LOWEST)    /*!< tick interrupt priority (lowest by default)  */
 #define  USE_RTOS                     0
+#define  USE_HAL_TICKLESS             0U                             /*!< 1: HAL time base from the free-running LPTIM instead of the 1ms SysTick */
+#define  TICKLESS_CLOCK_SOURCE        LPTIM_CLOCK_SOURCE_LXT         /*!< LPTIM clock of the tickless time base, LXT or SIRC */
+#define  TICKLESS_CLOCK_VALUE         LXT_VALUE                      /*!< Frequency of TICKLESS_CLOCK_SOURCE in Hz */
+#define  TICKLESS_PERIOD_COUNTS       (TICKLESS_CLOCK_VALUE / 8UL)   /*!< LPTIM free-running period (8 ~ 65536), the max latency of HAL_SetTickWakeup() */
 #define  PREFETCH_ENABLE              1
 
 /* ########################## Assert Selection ############################## */
@@ -241,26 +241,24 @@ void SystemCoreClockUpdate (void)
     switch (tmp)
     {
         case 0x01U:  /* HIRC used as system clock */
-            if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_24M)
+            /* Compare the trim level only, the fine trim may be adjusted at run-time */
+            tmp = RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM_TRIMLEVEL_MSK;
+            if(tmp == (RCC_HIRCCALIBRATION_24M & RCC_HIRCCR_HIRCTRIM_TRIMLEVEL_MSK))
             {
                 SystemCoreClock = HIRC_VALUE_24M;
             }
-            else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_22M)
+            else if(tmp == (RCC_HIRCCALIBRATION_22M & RCC_HIRCCR_HIRCTRIM_TRIMLEVEL_MSK))
             {
                 SystemCoreClock = HIRC_VALUE_22M;
             }
-            else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_16M)
+            else if(tmp == (RCC_HIRCCALIBRATION_16M & RCC_HIRCCR_HIRCTRIM_TRIMLEVEL_MSK))
             {
                 SystemCoreClock = HIRC_VALUE_16M;
             }
-            else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_8M)
+            else if(tmp == (RCC_HIRCCALIBRATION_8M & RCC_HIRCCR_HIRCTRIM_TRIMLEVEL_MSK))
             {
                 SystemCoreClock = HIRC_VALUE_8M;
             }
-            else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_4M)
-            {
-                SystemCoreClock = HIRC_VALUE_4M;
-            }
             else
             {
                 SystemCoreClock = HIRC_VALUE_4M;
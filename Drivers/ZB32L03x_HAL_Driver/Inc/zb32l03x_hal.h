@@ -343,6 +343,9 @@ HAL_StatusTypeDef HAL_SetTickFreq(HAL_TickFreqTypeDef Freq);
 HAL_TickFreqTypeDef HAL_GetTickFreq(void);
 void HAL_SuspendTick(void);
 void HAL_ResumeTick(void);
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+void HAL_SetTickWakeup(uint32_t Delay);
+#endif
 uint32_t HAL_GetHalVersion(void);
 uint32_t HAL_GetREVID(void);
 uint32_t HAL_GetDEVID(void);
@@ -326,6 +326,21 @@ typedef enum HAL_ADC_SampleShift
     HAL_ADC_SAMPLE_SHIFT_16NS_NE    = (ADC_CR0_ADCK_SF_12NS_SHIFT_NEDGE << ADC_CR0_ADCK_SF_Pos),     /*!< Shift 12 ns with SYSCLK negative edge */
 } HAL_ADC_SampleShiftTypeDef;
 
+/** @defgroup ADC_MonitorState ADC window monitor state
+ * @{
+ */
+typedef enum HAL_ADC_MonitorState
+{
+    HAL_ADC_MONITOR_STATE_IDLE      = 0,    /*!< Window monitor is not running                  */
+    HAL_ADC_MONITOR_STATE_IN_BAND,          /*!< Signal is inside [LowThreshold, HighThreshold] */
+    HAL_ADC_MONITOR_STATE_OVER_HIGH,        /*!< Signal left the band above HighThreshold       */
+    HAL_ADC_MONITOR_STATE_UNDER_LOW,        /*!< Signal left the band below LowThreshold        */
+} HAL_ADC_MonitorStateTypeDef;
+
+/**
+ * @}
+ */
+
 /** @defgroup ADC_Error_Code ADC Error Code
  * @{
  */
@@ -556,18 +571,82 @@ typedef struct HAL_ADC_ThresholdConf
 } HAL_ADC_ThresholdConfTypeDef;
 
 
+/**
+ * @brief  ADC channel descriptor
+ * @note   One entry per AINx, pre-computed at build time so that the ISR fast path
+ *         never has to search the channel bit or count leading zeros (no CLZ on M0+).
+ */
+typedef struct HAL_ADC_ChannelDesc
+{
+    uint32_t    ItMask;         /*!< End of conversion interrupt bit of the channel (INTEN/INTCLR/MSKINTSR) */
+
+    uint16_t    SelBits;        /*!< Channel select value at ADC_CR0_SEL position (single mode) */
+
+    uint8_t     ResultIdx;      /*!< Index of the result register from RESULT0 (multichannel mode) */
+
+    uint8_t     GroupSel;       /*!< Multichannel group select of ADC_CR2_CHSEL */
+
+} HAL_ADC_ChannelDescTypeDef;
+
+/**
+ * @brief  ADC window monitor configuration
+ * @note   The monitor converts one channel on a hardware trigger and lets the ADC
+ *         compare every result with the window, so the CPU is only woken when
+ *         the signal leaves (or comes back to) the band.
+ */
+typedef struct HAL_ADC_MonitorConf
+{
+    HAL_ADC_ChannelSelTypeDef       AChannelSel;    /*!< Specifies the monitored channel (only one channel).
+                                                        This parameter can be a value of @ref HAL_ADC_ChannelSelTypeDef */
+
+    HAL_ADC_ExtTrigger_SrcTypeDef   TriggerSrc;     /*!< Specifies the conversion trigger, e.g. HAL_ADC_EXTTRIG_LPTIM or HAL_ADC_EXTTRIG_TIM10.
+                                                        The trigger timer must run without its own interrupt enabled.
+                                                        With HAL_ADC_EXTTRIG_SW_START, conversions are kicked by
+                                                        HAL_ADC_Monitor_Trigger() (e.g. from HAL_AWK_WakeUpCallback()).
+                                                        This parameter can be a value of @ref ADC_External_Trigger_Source */
+
+    uint16_t                        HighThreshold;  /*!< Specifies the upper edge of the band, 0x000 ~ 0xFFF */
+
+    uint16_t                        LowThreshold;   /*!< Specifies the lower edge of the band, 0x000 ~ 0xFFF */
+
+    uint16_t                        Hysteresis;     /*!< Specifies how far (in ADC codes) the signal must come back
+                                                        inside the band before the in-band state is reported again */
+
+    uint16_t                        DebounceCount;  /*!< Specifies how many consecutive samples must agree before a state
+                                                        change is reported. 0 or 1 reports on the first sample. */
+} HAL_ADC_MonitorConfTypeDef;
+
+/**
+ * @brief  ADC window monitor context
+ */
+typedef struct HAL_ADC_Monitor
+{
+    HAL_ADC_MonitorConfTypeDef              Init;           /*!< Window monitor parameters */
+
+    __IO HAL_ADC_MonitorStateTypeDef        State;          /*!< Current debounced state */
+
+    __IO uint32_t                           PendingCnt;     /*!< Consecutive samples voting for a state change */
+
+    __IO uint32_t                           LastValue;      /*!< Conversion result which caused the last interrupt */
+
+    __IO uint32_t                           EventCnt;       /*!< Number of reported state changes */
+
+} HAL_ADC_MonitorTypeDef;
+
 /**
  * @brief  ADC handle Structure definition
  */
 typedef struct
 {
-    ADC_TypeDef         *Instance;          /*!< Register base address */
+    ADC_TypeDef             *Instance;      /*!< Register base address */
 
-    ADC_InitTypeDef     Init;               /*!< ADC required parameters */
+    ADC_InitTypeDef         Init;           /*!< ADC required parameters */
 
-    HAL_LockTypeDef     Lock;               /*!< ADC locking object */
+    HAL_LockTypeDef         Lock;           /*!< ADC locking object */
 
-    __IO uint32_t       State;              /*!< ADC communication state (bitmap of ADC states) */
+    __IO uint32_t           State;          /*!< ADC communication state (bitmap of ADC states) */
+
+    HAL_ADC_MonitorTypeDef  *pMonitor;      /*!< Window monitor context, NULL when the monitor is not running */
 
 } ADC_HandleTypeDef;
 /**
@@ -578,6 +657,16 @@ typedef struct
 //=============================================================================
 //                  Global Data Definition
 //=============================================================================
+/**
+ *  Channel descriptor table, indexed by the AINx number (0 ~ HAL_ADC_CHANNEL_NUM - 1)
+ */
+#if defined(CONFIG_USE_ZB32L003S)
+    #define HAL_ADC_CHANNEL_NUM         8
+#elif defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
+    #define HAL_ADC_CHANNEL_NUM         24
+#endif
+
+extern const HAL_ADC_ChannelDescTypeDef     HAL_ADC_ChannelDescTable[HAL_ADC_CHANNEL_NUM];
 
 //=============================================================================
 //                  Private Function Definition
@@ -612,6 +701,65 @@ uint32_t HAL_ADC_GetAccValue(ADC_HandleTypeDef *hADC);
 void HAL_ADC_ContConvCpltCallback(ADC_HandleTypeDef *hADC);
 void HAL_ADC_LevelOutOfRangeCallback(ADC_HandleTypeDef *hADC, HAL_ADC_ITTypeDef IT_Type);
 void HAL_ADC_ChannelxCallback(ADC_HandleTypeDef *hADC, HAL_ADC_ChannelSelTypeDef channel);
+void HAL_ADC_MonitorCallback(ADC_HandleTypeDef *hADC, HAL_ADC_MonitorStateTypeDef state);
+
+/* Channel descriptor */
+uint32_t HAL_ADC_GetChannelId(HAL_ADC_ChannelSelTypeDef channel);
+
+/* Window monitor (wake-on-threshold) */
+HAL_StatusTypeDef HAL_ADC_Monitor_Start(ADC_HandleTypeDef *hADC, HAL_ADC_MonitorTypeDef *pMonitor);
+HAL_StatusTypeDef HAL_ADC_Monitor_Stop(ADC_HandleTypeDef *hADC);
+void HAL_ADC_Monitor_Trigger(ADC_HandleTypeDef *hADC);
+HAL_ADC_MonitorStateTypeDef HAL_ADC_Monitor_WaitEvent(ADC_HandleTypeDef *hADC);
+
+/**
+ *  @brief  Fast path: select a channel and start one conversion with its end of conversion interrupt.
+ *              This API is safe to call in ISR (no lock, no state update, no search of the channel).
+ *
+ *  @note   The ADC must be configured in single mode and enabled once by HAL_ADC_Start_IT() before.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @param [in] ch_id       AINx number, 0 ~ (HAL_ADC_CHANNEL_NUM - 1), see HAL_ADC_GetChannelId()
+ *  @return                 None
+ */
+__STATIC_INLINE void HAL_ADC_FastStart_IT(ADC_HandleTypeDef *hADC, uint32_t ch_id)
+{
+    ADC_TypeDef                         *ADCx = hADC->Instance;
+    const HAL_ADC_ChannelDescTypeDef    *pDesc = &HAL_ADC_ChannelDescTable[ch_id];
+
+    WRITE_REG(ADCx->CR0, (READ_REG(ADCx->CR0) & ~ADC_CR0_SEL_Msk) | pDesc->SelBits);
+    WRITE_REG(ADCx->INTCLR, pDesc->ItMask);
+    SET_BIT(ADCx->INTEN, pDesc->ItMask);
+    SET_BIT(ADCx->CR0, ADC_CR0_START);
+    return;
+}
+
+/**
+ *  @brief  Fast path: get the conversion result of single mode.
+ *              This API is safe to call in ISR.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @return
+ *      ADC conversion data (12-bits)
+ */
+__STATIC_INLINE uint32_t HAL_ADC_FastGetValue(ADC_HandleTypeDef *hADC)
+{
+    return READ_REG(hADC->Instance->RESULT);
+}
+
+/**
+ *  @brief  Fast path: get the conversion result of a channel in multichannel (continue/circle) mode.
+ *              This API is safe to call in ISR.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @param [in] ch_id       AINx number, 0 ~ (HAL_ADC_CHANNEL_NUM - 1)
+ *  @return
+ *      ADC conversion data (12-bits)
+ */
+__STATIC_INLINE uint32_t HAL_ADC_FastGetChannelValue(ADC_HandleTypeDef *hADC, uint32_t ch_id)
+{
+    return READ_REG((&hADC->Instance->RESULT0)[HAL_ADC_ChannelDescTable[ch_id].ResultIdx]);
+}
 
 /**
  * @}
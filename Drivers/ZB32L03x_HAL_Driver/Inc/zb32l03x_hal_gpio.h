@@ -88,6 +88,17 @@ typedef struct
 
 } GPIO_InitTypeDef;
 
+/**
+ * @brief GPIO board pin table entry, see HAL_GPIO_InitBoard()
+ */
+typedef struct
+{
+    GPIO_TypeDef        *Port;              /*!< GPIOA ~ GPIOD */
+
+    GPIO_InitTypeDef    Init;               /*!< Configuration of the pins of Init.Pin */
+
+} GPIO_BoardPinTypeDef;
+
 /**
  * @brief  GPIO Bit SET and Bit RESET enumeration
  */
@@ -353,6 +364,8 @@ typedef enum
 /* Initialization and de-initialization functions *****************************/
 void  HAL_GPIO_Init(GPIO_TypeDef  *GPIOx, GPIO_InitTypeDef *GPIO_Init);
 void  HAL_GPIO_DeInit(GPIO_TypeDef  *GPIOx, uint32_t GPIO_Pin);
+void  HAL_GPIO_InitPort(GPIO_TypeDef *GPIOx, const GPIO_InitTypeDef *pInits, uint32_t Num);
+void  HAL_GPIO_InitBoard(const GPIO_BoardPinTypeDef *pTable, uint32_t Num);
 /**
  * @}
  */
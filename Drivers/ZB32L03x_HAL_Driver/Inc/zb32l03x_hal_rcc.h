@@ -136,6 +136,30 @@ typedef struct
 
 } RCC_OscInitTypeDef;
 
+/**
+ * @brief  Division by an invariant divisor, (Dividend / Divisor) is computed
+ *         as ((Dividend * Magic) >> Shift) without the software division
+ */
+typedef struct
+{
+    uint32_t Magic;                 /*!< ceil(2^Shift / Divisor) */
+    uint32_t Shift;                 /*!< 31 + ceil(log2(Divisor)) */
+} RCC_DividerTypeDef;
+
+/**
+ * @brief  Cached clock tree, it is updated only when the clocks are re-configured
+ */
+typedef struct
+{
+    uint32_t SYSCLKFreq;            /*!< SYSCLK frequency in Hz */
+    uint32_t HCLKFreq;              /*!< HCLK frequency in Hz */
+    uint32_t PCLKFreq;              /*!< PCLK frequency in Hz */
+
+    RCC_DividerTypeDef SYSCLKRecip; /*!< Reciprocal of SYSCLK, divides by SYSCLKFreq */
+    RCC_DividerTypeDef HCLKRecip;   /*!< Reciprocal of HCLK, divides by HCLKFreq */
+    RCC_DividerTypeDef PCLKRecip;   /*!< Reciprocal of PCLK, divides by PCLKFreq */
+} RCC_ClockTreeTypeDef;
+
 /**
  * @}
  */ /* End of group RCC_Exported_Types */
@@ -1775,9 +1799,27 @@ void     HAL_RCC_MCOConfig(uint32_t RCC_MCOx, uint32_t RCC_MCOSource, uint32_t R
 uint32_t HAL_RCC_GetSysClockFreq(void);
 uint32_t HAL_RCC_GetHCLKFreq(void);
 uint32_t HAL_RCC_GetPCLKFreq(void);
+void     HAL_RCC_SetHIRCFreq(uint32_t HIRCFreq);
+uint32_t HAL_RCC_GetHIRCFreq(void);
+const RCC_ClockTreeTypeDef* HAL_RCC_GetClockTree(void);
+void     HAL_RCC_Divider_Init(RCC_DividerTypeDef *pDiv, uint32_t Divisor);
 void     HAL_RCC_GetOscConfig(RCC_OscInitTypeDef  *RCC_OscInitStruct);
 void     HAL_RCC_GetClockConfig(RCC_ClkInitTypeDef  *RCC_ClkInitStruct);
 
+/**
+ * @brief  Fast path: divide by the invariant divisor of @ref HAL_RCC_Divider_Init().
+ *         This API is safe to call in ISR and costs no software division.
+ * @note   e.g. UART baud rate, BRG = HAL_RCC_Divide(&div, PCLKFreq) - 1 with
+ *         div initialized with 32 * baudrate once.
+ * @param  pDiv pointer to the divider
+ * @param  Dividend the dividend, MUST be less than 2^31
+ * @retval Dividend / Divisor (truncated)
+ */
+__STATIC_INLINE uint32_t HAL_RCC_Divide(const RCC_DividerTypeDef *pDiv, uint32_t Dividend)
+{
+    return (uint32_t)(((uint64_t)Dividend * pDiv->Magic) >> pDiv->Shift);
+}
+
 /**
  * @}
  */
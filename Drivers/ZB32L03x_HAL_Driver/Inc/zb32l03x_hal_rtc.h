@@ -154,6 +154,14 @@ typedef struct
 
     __IO HAL_RTCStateTypeDef    State;              /*!< Time communication state */
 
+    uint32_t                    EpochDateReg;       /*!< DATE register of EpochDayBase, RTC_EPOCH_CACHE_INVALID: not cached */
+    uint32_t                    EpochDayBase;       /*!< Unix seconds at 00:00:00 of the cached date */
+    uint32_t                    EpochTimeReg;       /*!< TIME register (hours and minutes) of EpochMinBase */
+    uint32_t                    EpochMinBase;       /*!< Unix seconds at hh:mm:00 of the cached time */
+
+    uint32_t                    SubSecSource;       /*!< Sub-second source, a value of @ref RTC_SubSecond_Source_Definitions */
+    __IO uint32_t               SubSecPhase;        /*!< Time stamp of the source at the last second boundary */
+
 } RTC_HandleTypeDef;
 
 /**
@@ -288,6 +296,20 @@ typedef struct
  * @}
  */
 
+/** @defgroup RTC_SubSecond_Source_Definitions Sub-second Source Definitions
+ * @{
+ */
+#define RTC_SUBSEC_SOURCE_NONE              0x00U   /*!< No sub-second, always 0                                  */
+#define RTC_SUBSEC_SOURCE_TICK              0x01U   /*!< HAL_GetTick() (1 ms), SysTick MUST run                   */
+#define RTC_SUBSEC_SOURCE_LPTIM             0x02U   /*!< LPTIM free running at 32768 Hz (LXT) with reload 0,
+                                                         not available with USE_HAL_TICKLESS                      */
+
+/**
+ * @}
+ */
+
+#define RTC_EPOCH_CACHE_INVALID             0xFFFFFFFFU
+
 /** @defgroup RTC_Alarms_Definitions Alarms Definitions
  * @{
  */
@@ -454,6 +476,8 @@ typedef struct
 #define IS_RTC_DATE(DATE)                   ((DATE) >= 1U && (DATE) <= 31U)
 #define IS_RTC_WEEKDAY(WEEKDAY)             (((int)(WEEKDAY) >= (int)RTC_WEEKDAY_SUNDAY) && ((WEEKDAY) <= RTC_WEEKDAY_SATURDAY))
 #define IS_RTC_ALARM(ALARM)                 ((ALARM) == RTC_ALARM_1 || (ALARM) == RTC_ALARM_2)
+#define IS_RTC_SUBSEC_SOURCE(SOURCE)        ((SOURCE) == RTC_SUBSEC_SOURCE_NONE || (SOURCE) == RTC_SUBSEC_SOURCE_TICK || \
+                                             (SOURCE) == RTC_SUBSEC_SOURCE_LPTIM)
 #define IS_RTC_CALIB_OUTPUT(__OUTPUT__)     (((__OUTPUT__) == RTC_OUTPUTSOURCE_NONE) || \
                                              ((__OUTPUT__) == RTC_OUTPUTSOURCE_CALIBCLOCK) || \
                                              ((__OUTPUT__) == RTC_OUTPUTSOURCE_ALARM) || \
@@ -499,6 +523,7 @@ HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTim
 HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate);
 HAL_StatusTypeDef HAL_RTC_SetTime_SetDate(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Hour_Format, RTC_DateTypeDef *sDate);
 HAL_StatusTypeDef HAL_RTC_GetTime_Date(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, RTC_DateTypeDef *sDate);
+uint32_t HAL_RTC_GetEpoch(RTC_HandleTypeDef *hrtc, uint16_t *pSubSeconds);
 
 
 /**
@@ -533,6 +558,12 @@ void HAL_RTC_IRQHandler(void);
  */
 HAL_StatusTypeDef HAL_RTC_1HZ_Config(RTC_HandleTypeDef *hrtc, FunctionalState NewState);
 HAL_RTCStateTypeDef HAL_RTC_GetState(RTC_HandleTypeDef *hrtc);
+
+HAL_StatusTypeDef HAL_RTC_SubSecond_Config(RTC_HandleTypeDef *hrtc, uint32_t Source);
+void HAL_RTC_SubSecond_Sync(RTC_HandleTypeDef *hrtc);
+
+HAL_StatusTypeDef HAL_RTC_Calibration_Config(RTC_HandleTypeDef *hrtc, uint32_t AdjustMode, int8_t Trim);
+void HAL_RTC_Calibration_Get(RTC_HandleTypeDef *hrtc, uint32_t *pAdjustMode, int8_t *pTrim);
 /**
  * @}
  */
@@ -292,16 +292,42 @@ typedef enum
     HAL_TIM_ACTIVE_CHANNEL_CLEARED  = 0x00U     /*!< All active channels cleared */
 } HAL_TIM_ActiveChannel;
 
+/**
+ * @brief  Index of the fast dispatch table, the same as the bit position in TIMx_SR/TIMx_DIER
+ */
+typedef enum
+{
+    HAL_TIM_FAST_CB_UPDATE          = TIM_SR_UIF_Pos,     /*!< Update event               */
+    HAL_TIM_FAST_CB_CC1             = TIM_SR_CC1IF_Pos,   /*!< Capture/Compare 1 event    */
+    HAL_TIM_FAST_CB_CC2             = TIM_SR_CC2IF_Pos,   /*!< Capture/Compare 2 event    */
+    HAL_TIM_FAST_CB_CC3             = TIM_SR_CC3IF_Pos,   /*!< Capture/Compare 3 event    */
+    HAL_TIM_FAST_CB_CC4             = TIM_SR_CC4IF_Pos,   /*!< Capture/Compare 4 event    */
+    HAL_TIM_FAST_CB_COM             = TIM_SR_COMIF_Pos,   /*!< Commutation event          */
+    HAL_TIM_FAST_CB_TRIGGER         = TIM_SR_TIF_Pos,     /*!< Trigger event              */
+    HAL_TIM_FAST_CB_BREAK           = TIM_SR_BIF_Pos,     /*!< Break event                */
+    HAL_TIM_FAST_CB_NUM
+} HAL_TIM_FastCallbackIdTypeDef;
+
+struct __TIM_HandleTypeDef;
+
+/**
+ * @brief  TIM callback pointer definition
+ */
+typedef void (*pTIM_CallbackTypeDef)(struct __TIM_HandleTypeDef *htim);
+
 /**
  * @brief  TIM Time Base Handle Structure definition
  */
-typedef struct
+typedef struct __TIM_HandleTypeDef
 {
     TIM_TypeDef                 *Instance;     /*!< Register base address             */
     TIM_Base_InitTypeDef        Init;          /*!< TIM Time Base required parameters */
     HAL_TIM_ActiveChannel       Channel;       /*!< Active channel                    */
     HAL_LockTypeDef             Lock;          /*!< Locking object                    */
     __IO HAL_TIM_StateTypeDef   State;         /*!< TIM operation state               */
+
+    const pTIM_CallbackTypeDef  *pFastCallbacks;   /*!< Fast dispatch table with HAL_TIM_FAST_CB_NUM items,
+                                                        NULL: use the weak callbacks */
 } TIM_HandleTypeDef;
 
 /**
@@ -1602,6 +1628,8 @@ HAL_StatusTypeDef HAL_TIM_Encoder_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Chan
  */
 /* Interrupt Handler functions  **********************************************/
 void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim);
+void HAL_TIM_FastIRQHandler(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_RegisterFastCallbacks(TIM_HandleTypeDef *htim, const pTIM_CallbackTypeDef *pCallbacks);
 /**
  * @}
  */
@@ -1655,6 +1683,21 @@ HAL_TIM_StateTypeDef HAL_TIM_IC_GetState(TIM_HandleTypeDef *htim);
 HAL_TIM_StateTypeDef HAL_TIM_OnePulse_GetState(TIM_HandleTypeDef *htim);
 HAL_TIM_StateTypeDef HAL_TIM_Encoder_GetState(TIM_HandleTypeDef *htim);
 
+/**
+ * @}
+ */
+
+/** @addtogroup TIM_Exported_Functions_Group11
+ * @{
+ */
+/* Timestamp functions  *********************************************************/
+HAL_StatusTypeDef HAL_TIM_Timestamp_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Timestamp_Stop(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Timestamp_Calibrate(uint32_t Ms);
+uint32_t HAL_TIM_Timestamp_GetFreq(void);
+uint64_t HAL_GetCycles64(void);
+uint64_t HAL_GetMicros64(void);
+
 /**
  * @}
  */
@@ -73,9 +73,78 @@ __IO uint32_t       uwTick;
 uint32_t            uwTickPrio = (1UL << __NVIC_PRIO_BITS); /* Invalid PRIO */
 HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;  /* 1KHz */
 
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+#if !defined(HAL_LPTIM_MODULE_ENABLED)
+#error "USE_HAL_TICKLESS needs HAL_LPTIM_MODULE_ENABLED !"
+#endif
+
+#define TICKLESS_FULL_COUNTS            (LPTIM_MAXCNTVALUE_16BIT + 1UL)
+#define TICKLESS_RUN_LOAD               ((TICKLESS_FULL_COUNTS - TICKLESS_PERIOD_COUNTS) & LPTIM_MAXCNTVALUE_16BIT)
+#define TICKLESS_MIN_COUNTS             8UL     /* Shortest wakeup period, longer than a BGLOAD synchronization */
+#define TICKLESS_GUARD_COUNTS           8UL     /* BGLOAD is not re-programmed this close to the reload */
+#define TICKLESS_READY_LOOP_CYCLES      8UL     /* Minimum CPU cycles of one oscillator ready poll */
+
+static uint32_t     uwTicklessLoad;     /* Start value of the counter in the running LPTIM period */
+static uint32_t     uwTicklessNextLoad; /* BGLOAD, start value of the counter in the next period */
+static uint32_t     uwTicklessBaseMs;   /* Milliseconds at the start of the running period */
+static uint32_t     uwTicklessBaseFrac; /* Remainder of (counts * 1000), less than TICKLESS_CLOCK_VALUE */
+#endif
+
+/**
+ * @}
+ */
+
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+/** @defgroup HAL_Private_Functions HAL Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Get the LPTIM counts since the start of the running period.
+ * @note   The next period is included if the overflow is not serviced yet.
+ *         Interrupts must be disabled by the caller.
+ * @retval Elapsed counts
+ */
+static uint32_t HAL_Tickless_GetElapsed(void)
+{
+    uint32_t is_ovf = READ_BIT(LPTIM->INTSR, LPTIM_INTSR_INTF);
+    uint32_t cnt    = READ_REG(LPTIM->CNTVAL);
+
+    /* the counter overflowed between the two reads */
+    if (!is_ovf && READ_BIT(LPTIM->INTSR, LPTIM_INTSR_INTF))
+    {
+        is_ovf = 1;
+        cnt    = READ_REG(LPTIM->CNTVAL);
+    }
+
+    if (is_ovf)
+    {
+        return (TICKLESS_FULL_COUNTS - uwTicklessLoad) +
+               ((cnt - uwTicklessNextLoad) & LPTIM_MAXCNTVALUE_16BIT);
+    }
+
+    return (cnt - uwTicklessLoad) & LPTIM_MAXCNTVALUE_16BIT;
+}
+
+/**
+ * @brief  Set the start value of the next LPTIM period.
+ * @note   BGLOAD is copied into the counter at the next overflow, the running
+ *         period is not restarted and no count is lost.
+ * @param  Load Start value of the counter in the next period
+ * @retval None
+ */
+static void HAL_Tickless_SetNextLoad(uint32_t Load)
+{
+    uwTicklessNextLoad = Load;
+
+    while (__HAL_LPTIM_SYNC_FLAG(LPTIM));
+    WRITE_REG(LPTIM->BGLOAD, Load);
+}
+
 /**
  * @}
  */
+#endif /* USE_HAL_TICKLESS */
 
 
 
@@ -327,6 +396,59 @@ __weak void HAL_MspDeInit(void)
  */
 __weak HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
 {
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+    if (TickPriority >= (1UL << __NVIC_PRIO_BITS))
+    {
+        return HAL_ERROR;
+    }
+
+    /* The LPTIM clock is independent of the system clock, keep the time when re-configured */
+    if (!READ_BIT(LPTIM->CR, LPTIM_CR_TIM_RUN))
+    {
+        /* No tick yet, bound the oscillator start-up by CPU loops (at least LXT_STARTUP_TIMEOUT ms) */
+        uint32_t loops = (SystemCoreClock / (1000UL * TICKLESS_READY_LOOP_CYCLES)) * LXT_STARTUP_TIMEOUT;
+
+        __HAL_RCC_LPTIM_CLK_ENABLE();
+
+        if (TICKLESS_CLOCK_SOURCE == LPTIM_CLOCK_SOURCE_SIRC)
+        {
+            __HAL_RCC_SIRC_ENABLE();
+            while (!__HAL_RCC_GET_FLAG(RCC_FLAG_SIRCRDY) && --loops);
+        }
+        else if (TICKLESS_CLOCK_SOURCE == LPTIM_CLOCK_SOURCE_LXT)
+        {
+            __HAL_RCC_LXT_CONFIG(RCC_LXT_ON);
+            while (!__HAL_RCC_GET_FLAG(RCC_FLAG_LXTRDY) && --loops);
+        }
+
+        /* The LPTIM synchronization never completes without its clock */
+        if (loops == 0U)
+        {
+            return HAL_ERROR;
+        }
+
+        WRITE_REG(LPTIM->CR, TICKLESS_CLOCK_SOURCE | LPTIM_AUTORELOAD_ENABLE | LPTIM_CR_TCK_EN);
+
+        uwTicklessLoad     = TICKLESS_RUN_LOAD;
+        uwTicklessBaseMs   = 0;
+        uwTicklessBaseFrac = 0;
+
+        /* LOAD is only written here, the running counter is never restarted */
+        WRITE_REG(LPTIM->INTCLR, LPTIM_INTCLR_ICLR);
+        while (__HAL_LPTIM_SYNC_FLAG(LPTIM));
+        WRITE_REG(LPTIM->LOAD, TICKLESS_RUN_LOAD);
+        HAL_Tickless_SetNextLoad(TICKLESS_RUN_LOAD);
+
+        /* Free-running, the overflow interrupt only extends the 16-bits counter */
+        SET_BIT(LPTIM->CR, LPTIM_CR_INT_EN | LPTIM_CR_TIM_RUN);
+    }
+
+    HAL_NVIC_SetPriority(LPTIM_IRQn, TickPriority);
+    HAL_NVIC_EnableIRQ(LPTIM_IRQn);
+    uwTickPrio = TickPriority;
+
+    return HAL_OK;
+#else
     /* Configure the SysTick to have interrupt in 1ms time basis*/
     if (HAL_SYSTICK_Config(SystemCoreClock / (1000U / uwTickFreq)) > 0U)
     {
@@ -346,6 +468,7 @@ __weak HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
 
     /* Return function status */
     return HAL_OK;
+#endif /* USE_HAL_TICKLESS */
 }
 
 /**
@@ -386,7 +509,30 @@ __weak HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
  */
 __weak void HAL_IncTick(void)
 {
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+    /* Called from LPTIM_IRQHandler() at the overflow, fold the finished period */
+    uint32_t primask = __get_PRIMASK();
+    uint32_t acc     = 0;
+    uint32_t ms      = 0;
+
+    /* Atomic for the readers in higher priority ISRs */
+    __disable_irq();
+    WRITE_REG(LPTIM->INTCLR, LPTIM_INTCLR_ICLR);
+
+    acc = uwTicklessBaseFrac + (TICKLESS_FULL_COUNTS - uwTicklessLoad) * 1000UL;
+    ms  = acc / TICKLESS_CLOCK_VALUE;
+
+    uwTicklessBaseMs  += ms;
+    uwTicklessBaseFrac = acc - ms * TICKLESS_CLOCK_VALUE;
+    uwTicklessLoad     = uwTicklessNextLoad;
+    __set_PRIMASK(primask);
+
+    /* A wakeup period is running, go back to free-running at its end */
+    if (uwTicklessNextLoad != TICKLESS_RUN_LOAD)
+        HAL_Tickless_SetNextLoad(TICKLESS_RUN_LOAD);
+#else
     uwTick += uwTickFreq;
+#endif
 }
 
 /**
@@ -397,7 +543,19 @@ __weak void HAL_IncTick(void)
  */
 __weak uint32_t HAL_GetTick(void)
 {
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+    uint32_t primask = __get_PRIMASK();
+    uint32_t tick    = 0;
+
+    __disable_irq();
+    tick = uwTicklessBaseMs +
+           (uwTicklessBaseFrac + HAL_Tickless_GetElapsed() * 1000UL) / TICKLESS_CLOCK_VALUE;
+    __set_PRIMASK(primask);
+
+    return tick;
+#else
     return uwTick;
+#endif
 }
 
 /**
@@ -477,8 +635,15 @@ __weak void HAL_Delay(uint32_t Delay)
  */
 __weak void HAL_SuspendTick(void)
 {
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+    /**
+     * The LPTIM interrupt extends the counter and MUST stay enabled, it only
+     * fires once per TICKLESS_PERIOD_COUNTS so there is nothing to suspend.
+     */
+#else
     /* Disable SysTick Interrupt */
     CLEAR_BIT(SysTick->CTRL, SysTick_CTRL_TICKINT_Msk);
+#endif
 }
 
 /**
@@ -493,9 +658,56 @@ __weak void HAL_SuspendTick(void)
  */
 __weak void HAL_ResumeTick(void)
 {
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+    /* The LPTIM interrupt is never disabled, see HAL_SuspendTick() */
+#else
     /* Enable SysTick Interrupt */
     SET_BIT(SysTick->CTRL, SysTick_CTRL_TICKINT_Msk);
+#endif
+}
+
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+/**
+ * @brief Program the next wakeup of the tickless time base.
+ * @note  The LPTIM is never restarted, the wakeup is put on the next reload:
+ *        the period following the running one is shortened so that its
+ *        overflow fires after Delay milliseconds. A wakeup which falls before
+ *        the end of the running period fires at that end, so the latency is
+ *        bounded by TICKLESS_PERIOD_COUNTS. Idle code calls it before every
+ *        sleep or deep-sleep, the time base goes back to free-running in
+ *        HAL_IncTick() and HAL_GetTick() keeps counting in all cases.
+ * @param Delay specifies the time to the wakeup, in milliseconds.
+ * @retval None
+ */
+void HAL_SetTickWakeup(uint32_t Delay)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t counts  = 2UL * TICKLESS_FULL_COUNTS;
+
+    if (Delay < ((2UL * TICKLESS_FULL_COUNTS * 1000UL) / TICKLESS_CLOCK_VALUE))
+        counts = (Delay * TICKLESS_CLOCK_VALUE) / 1000UL;
+
+    __disable_irq();
+
+    /* An un-serviced overflow wakes up at once, the wakeup is re-programmed after it */
+    if (!READ_BIT(LPTIM->INTSR, LPTIM_INTSR_INTF))
+    {
+        uint32_t remain = (TICKLESS_FULL_COUNTS - uwTicklessLoad) - HAL_Tickless_GetElapsed();
+
+        if (counts > remain && remain > TICKLESS_GUARD_COUNTS)
+        {
+            counts -= remain;
+            counts  = (counts < TICKLESS_MIN_COUNTS) ? TICKLESS_MIN_COUNTS :
+                      (counts > TICKLESS_PERIOD_COUNTS) ? TICKLESS_PERIOD_COUNTS : counts;
+
+            if (((TICKLESS_FULL_COUNTS - counts) & LPTIM_MAXCNTVALUE_16BIT) != uwTicklessNextLoad)
+                HAL_Tickless_SetNextLoad((TICKLESS_FULL_COUNTS - counts) & LPTIM_MAXCNTVALUE_16BIT);
+        }
+    }
+
+    __set_PRIMASK(primask);
 }
+#endif /* USE_HAL_TICKLESS */
 
 /**
  * @brief  Returns the HAL revision
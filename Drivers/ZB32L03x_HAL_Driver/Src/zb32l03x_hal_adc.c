@@ -54,6 +54,14 @@
              ADC_MSKINTSR_ADCMIS_6_Msk | ADC_MSKINTSR_ADCMIS_14_Msk | ADC_MSKINTSR_ADCMIS_22_Msk |  \
              ADC_MSKINTSR_ADCMIS_7_Msk | ADC_MSKINTSR_ADCMIS_15_Msk | ADC_MSKINTSR_ADCMIS_23_Msk)
 #endif
+
+/**
+ *  Threshold interrupts used by the window monitor
+ */
+#define HAL_ADC_THRESHOLD_IT_Msk        \
+            (ADC_MSKINTSR_LLT_MIF_Msk | ADC_MSKINTSR_HHT_MIF_Msk | ADC_MSKINTSR_REG_MIF_Msk)
+
+#define ADC_MONITOR_CODE_MAX            ADC_HT_HT_Msk
 //=============================================================================
 //                  Macro Definition
 //=============================================================================
@@ -103,6 +111,26 @@
             SET_BIT((__HANDLE__)->Instance->CR0, ADC_CR0_START)
 
 
+/**
+ *  @brief  Build the descriptor of AINx
+ *              + AIN0 ~ AIN7 interrupt bits are [7:0], AIN8 ~ AIN23 interrupt bits are [31:16]
+ *              + multichannel results of every group are placed in RESULT0 ~ RESULT7
+ */
+#define _ADC_CHANNEL_DESC(__ID__)                                                       \
+            {                                                                           \
+                .ItMask    = ((__ID__) < 8) ? (0x1ul << (__ID__)) : (0x1ul << ((__ID__) + 8)), \
+                .SelBits   = ((__ID__) << ADC_CR0_SEL_Pos),                             \
+                .ResultIdx = ((__ID__) & 0x7),                                          \
+                .GroupSel  = ((__ID__) >> 3),                                           \
+            }
+
+/**
+ *  De Bruijn multiplier to get the highest set bit position (the same result as
+ *  31 - __CLZ()) of a value with its lower bits filled, one multiply and one table
+ *  load (Cortex-M0+ has no CLZ instruction).
+ */
+#define ADC_DEBRUIJN_SEQ                0x07C4ACDDul
+
 //=============================================================================
 //                  Structure Definition
 //=============================================================================
@@ -110,10 +138,41 @@
 //=============================================================================
 //                  Global Data Definition
 //=============================================================================
+const HAL_ADC_ChannelDescTypeDef     HAL_ADC_ChannelDescTable[HAL_ADC_CHANNEL_NUM] =
+{
+    _ADC_CHANNEL_DESC(0),  _ADC_CHANNEL_DESC(1),  _ADC_CHANNEL_DESC(2),  _ADC_CHANNEL_DESC(3),
+    _ADC_CHANNEL_DESC(4),  _ADC_CHANNEL_DESC(5),  _ADC_CHANNEL_DESC(6),  _ADC_CHANNEL_DESC(7),
+#if defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
+    _ADC_CHANNEL_DESC(8),  _ADC_CHANNEL_DESC(9),  _ADC_CHANNEL_DESC(10), _ADC_CHANNEL_DESC(11),
+    _ADC_CHANNEL_DESC(12), _ADC_CHANNEL_DESC(13), _ADC_CHANNEL_DESC(14), _ADC_CHANNEL_DESC(15),
+    _ADC_CHANNEL_DESC(16), _ADC_CHANNEL_DESC(17), _ADC_CHANNEL_DESC(18), _ADC_CHANNEL_DESC(19),
+    _ADC_CHANNEL_DESC(20), _ADC_CHANNEL_DESC(21), _ADC_CHANNEL_DESC(22), _ADC_CHANNEL_DESC(23),
+#endif
+};
+
+static const uint8_t    g_ADC_DeBruijnIdx[32] =
+{
+    0,  9,  1,  10, 13, 21, 2,  29, 11, 14, 16, 18, 22, 25, 3,  30,
+    8,  12, 20, 28, 15, 17, 24, 7,  19, 27, 23, 6,  26, 5,  4,  31,
+};
 
 //=============================================================================
 //                  Private Function Definition
 //=============================================================================
+/**
+ *  @brief  Get the position of the highest set bit, the value MUST NOT be 0
+ */
+__STATIC_INLINE uint32_t _ADC_HighestBitIdx(uint32_t value)
+{
+    value |= value >> 1;
+    value |= value >> 2;
+    value |= value >> 4;
+    value |= value >> 8;
+    value |= value >> 16;
+
+    return g_ADC_DeBruijnIdx[(uint32_t)(value * ADC_DEBRUIJN_SEQ) >> 27];
+}
+
 /**
  * @brief  Initializes the ADC MSP.
  * @param  hADC: ADC handle
@@ -192,6 +251,24 @@ __weak void HAL_ADC_ChannelxCallback(ADC_HandleTypeDef *hADC, HAL_ADC_ChannelSel
     */
 }
 
+/**
+ *  @brief  Window monitor state change callback
+ *              Called from HAL_ADC_IRQHandler() once a new state is confirmed by the debounce counter.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @param [in] state       The new debounced state, @ref HAL_ADC_MonitorStateTypeDef
+ *  @return                 None
+ */
+__weak void HAL_ADC_MonitorCallback(ADC_HandleTypeDef *hADC, HAL_ADC_MonitorStateTypeDef state)
+{
+    /* Prevent unused argument(s) compilation warning */
+    UNUSED(hADC);
+    UNUSED(state);
+    /* NOTE : This function should not be modified. When the callback is needed,
+              function HAL_ADC_MonitorCallback must be implemented in the user file.
+    */
+}
+
 /**
  *  @brief  Reset ADC conversion status and disable the selected ADC
  *
@@ -274,6 +351,103 @@ static HAL_StatusTypeDef _ADC_Enable(ADC_HandleTypeDef *hADC)
     return HAL_OK;
 }
 
+/**
+ *  @brief  Program the window and the wake-up interrupts of a monitor state
+ *              + IN_BAND  : wake when the result goes above High or below Low
+ *              + OVER_HIGH: wake when the result falls below (High - Hysteresis)
+ *              + UNDER_LOW: wake when the result rises above (Low + Hysteresis)
+ *
+ *  @param [in] hADC        ADC handle
+ *  @param [in] state       Monitor state to arm
+ *  @return                 None
+ */
+static void _ADC_Monitor_Arm(ADC_HandleTypeDef *hADC, HAL_ADC_MonitorStateTypeDef state)
+{
+    HAL_ADC_MonitorConfTypeDef  *pInit = &hADC->pMonitor->Init;
+    uint32_t                    high = pInit->HighThreshold;
+    uint32_t                    low = pInit->LowThreshold;
+    uint32_t                    leave_it = HAL_ADC_IT_HIGH_THRESHOLD | HAL_ADC_IT_LOW_THRESHOLD;
+
+    if( state == HAL_ADC_MONITOR_STATE_OVER_HIGH )
+    {
+        low      = (high > pInit->Hysteresis) ? high - pInit->Hysteresis : 0;
+        high     = ADC_MONITOR_CODE_MAX;
+        leave_it = HAL_ADC_IT_LOW_THRESHOLD;
+    }
+    else if( state == HAL_ADC_MONITOR_STATE_UNDER_LOW )
+    {
+        high     = low + pInit->Hysteresis;
+        high     = (high > ADC_MONITOR_CODE_MAX) ? ADC_MONITOR_CODE_MAX : high;
+        low      = 0;
+        leave_it = HAL_ADC_IT_HIGH_THRESHOLD;
+    }
+
+    WRITE_REG(hADC->Instance->HT, high);
+    WRITE_REG(hADC->Instance->LT, low);
+
+    /* The in-range interrupt is only used while a state change is being debounced */
+    MODIFY_REG(hADC->Instance->INTEN, HAL_ADC_THRESHOLD_IT_Msk, leave_it);
+    return;
+}
+
+/**
+ *  @brief  Window monitor interrupt process
+ *              An out-of-window sample increases the pending counter, an in-window sample
+ *              cancels it. The state changes when DebounceCount samples in a row agree.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @param [in] it_flags    Masked interrupt flags of this IRQ
+ *  @return                 None
+ */
+static void _ADC_Monitor_Process(ADC_HandleTypeDef *hADC, uint32_t it_flags)
+{
+    HAL_ADC_MonitorTypeDef      *pMonitor = hADC->pMonitor;
+    HAL_ADC_MonitorStateTypeDef target = HAL_ADC_MONITOR_STATE_IN_BAND;
+    uint32_t                    leave_flags = 0;
+
+    pMonitor->LastValue = READ_REG(hADC->Instance->RESULT);
+
+    switch( pMonitor->State )
+    {
+        case HAL_ADC_MONITOR_STATE_OVER_HIGH:
+            leave_flags = it_flags & ADC_MSKINTSR_LLT_MIF_Msk;
+            break;
+        case HAL_ADC_MONITOR_STATE_UNDER_LOW:
+            leave_flags = it_flags & ADC_MSKINTSR_HHT_MIF_Msk;
+            break;
+        default:
+            leave_flags = it_flags & (ADC_MSKINTSR_HHT_MIF_Msk | ADC_MSKINTSR_LLT_MIF_Msk);
+            target = (leave_flags & ADC_MSKINTSR_HHT_MIF_Msk)
+                   ? HAL_ADC_MONITOR_STATE_OVER_HIGH : HAL_ADC_MONITOR_STATE_UNDER_LOW;
+            break;
+    }
+
+    if( leave_flags )
+    {
+        if( ++pMonitor->PendingCnt < pMonitor->Init.DebounceCount )
+        {
+            /* Watch the in-window result to cancel a glitch */
+            __HAL_ADC_ENABLE_IT(hADC, HAL_ADC_IT_RANGE_THRESHOLD);
+            return;
+        }
+
+        pMonitor->PendingCnt = 0;
+        pMonitor->State      = target;
+        pMonitor->EventCnt++;
+
+        _ADC_Monitor_Arm(hADC, target);
+
+        HAL_ADC_MonitorCallback(hADC, target);
+    }
+    else if( it_flags & ADC_MSKINTSR_REG_MIF_Msk )
+    {
+        /* The signal came back before the debounce count was reached */
+        pMonitor->PendingCnt = 0;
+        __HAL_ADC_DISABLE_IT(hADC, HAL_ADC_IT_RANGE_THRESHOLD);
+    }
+    return;
+}
+
 //=============================================================================
 //                  Public Function Definition
 //=============================================================================
@@ -327,6 +501,8 @@ HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hADC)
         {
             __HAL_UNLOCK(hADC);
 
+            hADC->pMonitor = NULL;
+
             /* Init the low level hardware */
             HAL_ADC_MspInit(hADC);
         }
@@ -397,7 +573,7 @@ HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hADC)
         }
         else
         {
-            int     channel_id = 31 - __CLZ(hADC->Init.AChannelSel);
+            uint32_t    channel_id = HAL_ADC_GetChannelId(hADC->Init.AChannelSel);
 
             CLEAR_BIT(cr2_value, ADC_CR2_CIRCLE_MODE);
 
@@ -472,7 +648,8 @@ HAL_StatusTypeDef HAL_ADC_DeInit(ADC_HandleTypeDef *hADC)
         /* DeInit the low level hardware: GPIO, NVIC */
         HAL_ADC_MspDeInit(hADC);
 
-        hADC->State = HAL_ADC_STATE_RESET;
+        hADC->pMonitor = NULL;
+        hADC->State    = HAL_ADC_STATE_RESET;
         status = HAL_OK;
     }
 
@@ -667,42 +844,9 @@ HAL_StatusTypeDef HAL_ADC_Start_IT(ADC_HandleTypeDef *hADC)
 
             if( hADC->Init.AChannelSel & HAL_ADC_ALL_CHANNEL_Msk )
             {
-        #if defined(CONFIG_USE_ZB32L003S)
-                adc_it_type  = (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_0)  ? HAL_ADC_IT_CHANNEL_0 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_1)  ? HAL_ADC_IT_CHANNEL_1 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_2)  ? HAL_ADC_IT_CHANNEL_2 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_3)  ? HAL_ADC_IT_CHANNEL_3 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_4)  ? HAL_ADC_IT_CHANNEL_4 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_5)  ? HAL_ADC_IT_CHANNEL_5 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_6)  ? HAL_ADC_IT_CHANNEL_6 :
-                               HAL_ADC_IT_CHANNEL_7;
+                uint32_t    channel_id = HAL_ADC_GetChannelId(hADC->Init.AChannelSel);
 
-        #elif defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
-                adc_it_type  = (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_0)  ? HAL_ADC_IT_CHANNEL_0 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_1)  ? HAL_ADC_IT_CHANNEL_1 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_2)  ? HAL_ADC_IT_CHANNEL_2 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_3)  ? HAL_ADC_IT_CHANNEL_3 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_4)  ? HAL_ADC_IT_CHANNEL_4 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_5)  ? HAL_ADC_IT_CHANNEL_5 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_6)  ? HAL_ADC_IT_CHANNEL_6 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_7)  ? HAL_ADC_IT_CHANNEL_7 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_8)  ? HAL_ADC_IT_CHANNEL_8 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_9)  ? HAL_ADC_IT_CHANNEL_9 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_10) ? HAL_ADC_IT_CHANNEL_10 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_11) ? HAL_ADC_IT_CHANNEL_11 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_12) ? HAL_ADC_IT_CHANNEL_12 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_13) ? HAL_ADC_IT_CHANNEL_13 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_14) ? HAL_ADC_IT_CHANNEL_14 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_15) ? HAL_ADC_IT_CHANNEL_15 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_16) ? HAL_ADC_IT_CHANNEL_16 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_17) ? HAL_ADC_IT_CHANNEL_17 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_18) ? HAL_ADC_IT_CHANNEL_18 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_19) ? HAL_ADC_IT_CHANNEL_19 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_20) ? HAL_ADC_IT_CHANNEL_20 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_21) ? HAL_ADC_IT_CHANNEL_21 :
-                               (hADC->Init.AChannelSel == HAL_ADC_CHANNEL_22) ? HAL_ADC_IT_CHANNEL_22 :
-                               HAL_ADC_IT_CHANNEL_23;
-        #endif  /* CONFIG_USE_ZB32L030 || CONFIG_USE_ZB32L032 */
+                adc_it_type = (HAL_ADC_ITTypeDef)HAL_ADC_ChannelDescTable[channel_id].ItMask;
             }
             else
             {
@@ -813,43 +957,30 @@ uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hADC, HAL_ADC_ChannelSelTypeDef cha
     }
     else
     {
-        int     index = 31 - __CLZ(channel);
+        uint32_t    channel_id = HAL_ADC_GetChannelId(channel);
 
-        if( channel & ADC_CR2_CHEN_Msk )
-        {
-            /* AIN 0 ~ AIN7 */
-        }
-    #if defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
-        else if( (channel >> 16) & ADC_CR2_CHEN_Msk )
-        {
-            /* AIN 16 ~ AIN23 */
-            index -= 16;
-        }
-        else if( (channel >> 8) & ADC_CR2_CHEN_Msk )
-        {
-            /* AIN 8 ~ AIN15 */
-            index -= 8;
-        }
-    #endif  /* CONFIG_USE_ZB32L030 || CONFIG_USE_ZB32L032 */
-
-        switch( index )
-        {
-            default:
-            case 0:     adc_code = READ_REG(hADC->Instance->RESULT0);   break;
-            case 1:     adc_code = READ_REG(hADC->Instance->RESULT1);   break;
-            case 2:     adc_code = READ_REG(hADC->Instance->RESULT2);   break;
-            case 3:     adc_code = READ_REG(hADC->Instance->RESULT3);   break;
-            case 4:     adc_code = READ_REG(hADC->Instance->RESULT4);   break;
-            case 5:     adc_code = READ_REG(hADC->Instance->RESULT5);   break;
-            case 6:     adc_code = READ_REG(hADC->Instance->RESULT6);   break;
-            case 7:     adc_code = READ_REG(hADC->Instance->RESULT7);   break;
-        }
+        adc_code = READ_REG((&hADC->Instance->RESULT0)[HAL_ADC_ChannelDescTable[channel_id].ResultIdx]);
     }
 
     return adc_code;
 }
 
 
+/**
+ *  @brief  Get the AINx number of a channel select value
+ *              The result is the index of HAL_ADC_ChannelDescTable[] and the ch_id of the fast path APIs.
+ *              This API may be called in ISR.
+ *
+ *  @param [in] channel     One channel of @ref HAL_ADC_ChannelSel
+ *  @return
+ *      AINx number
+ */
+uint32_t HAL_ADC_GetChannelId(HAL_ADC_ChannelSelTypeDef channel)
+{
+    /* Keep the highest channel if more than one channel is selected (as 31 - __CLZ()) */
+    return _ADC_HighestBitIdx((uint32_t)channel);
+}
+
 /**
  *  @brief  Get ADC accumulating result
  *
@@ -893,16 +1024,18 @@ uint32_t HAL_ADC_GetAccValue(ADC_HandleTypeDef *hADC)
 HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hADC, HAL_ADC_ChannelConfTypeDef *pChConfig)
 {
     HAL_StatusTypeDef       status = HAL_ERROR;
-    int                     aChannel_id = 31 - __CLZ(pChConfig->AChannelSel);
+    uint32_t                aChannel_id = 0;
 
     /* Check the parameters */
     assert_param(hADC);
     assert_param(hADC->Instance);
     assert_param(pChConfig);
 
-    if( !hADC )
+    if( !hADC || !pChConfig )
         return status;
 
+    aChannel_id = HAL_ADC_GetChannelId(pChConfig->AChannelSel);
+
     __HAL_LOCK(hADC);
 
     WRITE_REG_MASK(hADC->Instance->CR0,
@@ -1005,6 +1138,13 @@ void HAL_ADC_IRQHandler(ADC_HandleTypeDef *hADC)
     /* Clear IT Flag */
     WRITE_REG(hADC->Instance->INTCLR, trigger_source);
 
+    /* Window monitor owns the threshold interrupts */
+    if( hADC->pMonitor && (trigger_source & HAL_ADC_THRESHOLD_IT_Msk) )
+    {
+        _ADC_Monitor_Process(hADC, trigger_source);
+        trigger_source &= ~HAL_ADC_THRESHOLD_IT_Msk;
+    }
+
     /* ADC end of Continue Conversion IRQ */
     if( trigger_source & ADC_MSKINTSR_CONT_MIF_Msk )
     {
@@ -1067,9 +1207,9 @@ void HAL_ADC_IRQHandler(ADC_HandleTypeDef *hADC)
 
         while( trigger_source )
         {
-            int     index = 31 - __CLZ(trigger_source);
+            uint32_t    index = _ADC_HighestBitIdx(trigger_source);
 
-            trigger_source &= ~(0x1 << index);
+            trigger_source &= ~(0x1u << index);
 
             if( hADC->Init.ConvMode == HAL_ADC_MODE_SINGLE )
             {
@@ -1087,4 +1227,190 @@ void HAL_ADC_IRQHandler(ADC_HandleTypeDef *hADC)
     return;
 }
 
+
+/**
+ *  @brief  Start the window monitor (wake-on-threshold)
+ *              The selected channel is converted on every TriggerSrc event and the ADC compares
+ *              each result with the window by hardware. No end-of-conversion interrupt is used,
+ *              so the core only wakes when the signal leaves or re-enters the band.
+ *
+ *  @note   HAL_ADC_Init() must be called before. The trigger timer (LPTIM, TIM10, ...) is started
+ *          by the application, with its own interrupt disabled, and the ADC IRQ must be enabled in NVIC.
+ *  @note   The monitor overrides the channel/trigger/compare configuration of hADC,
+ *          call HAL_ADC_Init() again after HAL_ADC_Monitor_Stop() to restore it.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @param [in] pMonitor    Monitor context with the Init member filled, it must stay valid until
+ *                              HAL_ADC_Monitor_Stop()
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef HAL_ADC_Monitor_Start(ADC_HandleTypeDef *hADC, HAL_ADC_MonitorTypeDef *pMonitor)
+{
+    HAL_StatusTypeDef       status = HAL_ERROR;
+
+    /* Check the parameters */
+    assert_param(hADC);
+    assert_param(hADC->Instance);
+    assert_param(pMonitor);
+
+    if( !hADC || !pMonitor )
+        return status;
+
+    /* Only one channel can be monitored */
+    if( !pMonitor->Init.AChannelSel ||
+        (pMonitor->Init.AChannelSel & (pMonitor->Init.AChannelSel - 1)) ||
+        HAL_ADC_GetChannelId(pMonitor->Init.AChannelSel) >= HAL_ADC_CHANNEL_NUM ||
+        pMonitor->Init.LowThreshold > pMonitor->Init.HighThreshold ||
+        pMonitor->Init.HighThreshold > ADC_MONITOR_CODE_MAX )
+        return status;
+
+    __HAL_LOCK(hADC);
+
+    do {
+        uint32_t    channel_id = HAL_ADC_GetChannelId(pMonitor->Init.AChannelSel);
+
+        status = _ADC_Enable(hADC);
+        if( status != HAL_OK )  break;
+
+        pMonitor->State      = HAL_ADC_MONITOR_STATE_IN_BAND;
+        pMonitor->PendingCnt = 0;
+        pMonitor->LastValue  = 0;
+        pMonitor->EventCnt   = 0;
+
+        /* Stop all interrupts before switching the mode */
+        __HAL_ADC_DISABLE_IT(hADC, HAL_ADC_IT_CHANNEL_ALL);
+        __HAL_ADC_CLR_IT_FLAG(hADC, (uint32_t)HAL_ADC_IT_CHANNEL_ALL);
+
+        hADC->pMonitor = pMonitor;
+
+        /* Single conversion of the monitored channel */
+        CLEAR_BIT(hADC->Instance->CR2, ADC_CR2_CIRCLE_MODE);
+        WRITE_REG_MASK(hADC->Instance->CR0, ADC_CR0_SEL_Msk, channel_id << ADC_CR0_SEL_Pos);
+
+        _ADC_Monitor_Arm(hADC, HAL_ADC_MONITOR_STATE_IN_BAND);
+
+        /* Trigger source and the three comparators */
+        WRITE_REG_MASK(hADC->Instance->CR1,
+                       ADC_CR1_CT_Msk | ADC_CR1_RACC_EN_Msk | ADC_CR1_TRIGS0_Msk | ADC_CR1_TRIGS1_Msk |
+                       ADC_CR1_LTCMP_Msk | ADC_CR1_HTCMP_Msk | ADC_CR1_REGCMP_Msk,
+                       (pMonitor->Init.TriggerSrc << ADC_CR1_TRIGS0_Pos) |
+                       (HAL_ADC_EXTTRIG_SW_START << ADC_CR1_TRIGS1_Pos) |
+                       ADC_CR1_LTCMP | ADC_CR1_HTCMP | ADC_CR1_REGCMP);
+
+        MODIFY_REG(hADC->State, HAL_ADC_STATE_READY | HAL_ADC_STATE_EOC | HAL_ADC_STATE_OUTRANGE, HAL_ADC_STATE_BUSY);
+    } while(0);
+
+    __HAL_UNLOCK(hADC);
+    return status;
+}
+
+/**
+ *  @brief  Stop the window monitor and disable the ADC
+ *
+ *  @param [in] hADC        ADC handle
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef HAL_ADC_Monitor_Stop(ADC_HandleTypeDef *hADC)
+{
+    HAL_StatusTypeDef       status = HAL_ERROR;
+
+    /* Check the parameters */
+    assert_param(hADC);
+    assert_param(hADC->Instance);
+
+    if( !hADC )
+        return status;
+
+    __HAL_LOCK(hADC);
+
+    __HAL_ADC_DISABLE_IT(hADC, HAL_ADC_THRESHOLD_IT_Msk);
+    __HAL_ADC_CLR_IT_FLAG(hADC, HAL_ADC_THRESHOLD_IT_Msk);
+
+    CLEAR_BIT(hADC->Instance->CR1, ADC_CR1_LTCMP | ADC_CR1_HTCMP | ADC_CR1_REGCMP |
+                                   ADC_CR1_TRIGS0_Msk | ADC_CR1_TRIGS1_Msk);
+
+    if( hADC->pMonitor )
+    {
+        hADC->pMonitor->State = HAL_ADC_MONITOR_STATE_IDLE;
+        hADC->pMonitor        = NULL;
+    }
+
+    status = _ADC_Reset(hADC);
+    if( status == HAL_OK )
+    {
+        MODIFY_REG(hADC->State, HAL_ADC_STATE_BUSY, HAL_ADC_STATE_READY);
+    }
+
+    __HAL_UNLOCK(hADC);
+    return status;
+}
+
+/**
+ *  @brief  Kick one monitor conversion by software
+ *              Used when TriggerSrc is HAL_ADC_EXTTRIG_SW_START, e.g. paced by the AWK wake-up.
+ *              This API may be called in ISR.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @return                 None
+ */
+void HAL_ADC_Monitor_Trigger(ADC_HandleTypeDef *hADC)
+{
+    if( hADC->pMonitor && __ADC_IS_SOFTWARE_START(hADC) )
+    {
+        __HAL_ADC_START(hADC);
+    }
+    return;
+}
+
+/**
+ *  @brief  Sleep until the window monitor reports a state change
+ *              The HAL tick is suspended while waiting, so only the monitor (or any other
+ *              enabled interrupt source) wakes the core. Other interrupts are served and the
+ *              core goes back to sleep.
+ *
+ *  @param [in] hADC        ADC handle
+ *  @return
+ *      The new monitor state, @ref HAL_ADC_MonitorStateTypeDef
+ */
+HAL_ADC_MonitorStateTypeDef HAL_ADC_Monitor_WaitEvent(ADC_HandleTypeDef *hADC)
+{
+    HAL_ADC_MonitorTypeDef  *pMonitor = NULL;
+    uint32_t                event_cnt = 0;
+
+    assert_param(hADC);
+
+    if( !hADC || !hADC->pMonitor )
+        return HAL_ADC_MONITOR_STATE_IDLE;
+
+    pMonitor  = hADC->pMonitor;
+    event_cnt = pMonitor->EventCnt;
+
+    HAL_SuspendTick();
+
+    /**
+     *  Check the event counter with interrupts masked, WFI still wakes on a pending
+     *  interrupt so no event is lost between the check and the sleep.
+     */
+    __disable_irq();
+    while( hADC->pMonitor && pMonitor->EventCnt == event_cnt )
+    {
+    #if defined(HAL_PWR_MODULE_ENABLED)
+        HAL_PWR_EnterSleepMode(PWR_SLEEPENTRY_WFI);
+    #else
+        __WFI();
+    #endif
+
+        /* Serve the pending interrupt */
+        __enable_irq();
+        __disable_irq();
+    }
+    __enable_irq();
+
+    HAL_ResumeTick();
+
+    return pMonitor->State;
+}
+
 #endif  /* defined(HAL_ADC_MODULE_ENABLED) */
@@ -112,6 +112,50 @@
  */
 
 #define GPIO_NUMBER           16U
+#define GPIO_PORT_NUMBER      4U
+
+/**
+ * @}
+ */
+
+/** @addtogroup GPIO_Private_Types GPIO Private Types
+ * @{
+ */
+
+/**
+ * @brief Register images of a port, they are modified in RAM and written back once
+ */
+typedef struct
+{
+    uint32_t DIRCR;
+    uint32_t OTYPER;
+    uint32_t INTEN;
+    uint32_t INTTYPCR;
+    uint32_t INTPOLCR;
+    uint32_t INTANY;
+    uint32_t INDBEN;
+    uint32_t DBCLKCR;
+    uint32_t PUPDR;
+    uint32_t SLEWCR;
+    uint32_t DRVCR;
+#if defined(CONFIG_USE_ZB32L003S)
+    uint32_t AFR;
+#elif defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
+    uint32_t AFRL;
+    uint32_t AFRH;
+#endif
+} GPIO_PortImageTypeDef;
+
+/**
+ * @}
+ */
+
+/** @addtogroup GPIO_Private_Functions GPIO Private Functions
+ * @{
+ */
+static void GPIO_Image_Load(GPIO_TypeDef *GPIOx, GPIO_PortImageTypeDef *pImage);
+static void GPIO_Image_Apply(GPIO_PortImageTypeDef *pImage, const GPIO_InitTypeDef *GPIO_Init);
+static void GPIO_Image_Store(GPIO_TypeDef *GPIOx, const GPIO_PortImageTypeDef *pOld, const GPIO_PortImageTypeDef *pNew);
 
 /**
  * @}
@@ -449,6 +493,92 @@ void HAL_GPIO_DeInit(GPIO_TypeDef  *GPIOx, uint32_t GPIO_Pin)
     }
 }
 
+/**
+ * @brief  Initializes several pin groups of a port, the register images are
+ *         built in RAM and every register is written at most once.
+ * @note   The result is the same as calling HAL_GPIO_Init() for every entry in order.
+ *         INTEN is written twice when an enabled interrupt of a reconfigured
+ *         pin has to be masked during the reconfiguration.
+ * @param  GPIOx where x can be (A..D) to select the GPIO peripheral for ZB32L03x device
+ * @param  pInits table of the configurations, the Pin fields select the pins
+ * @param  Num number of entries of pInits
+ * @retval None
+ */
+void HAL_GPIO_InitPort(GPIO_TypeDef *GPIOx, const GPIO_InitTypeDef *pInits, uint32_t Num)
+{
+    GPIO_PortImageTypeDef old_image;
+    GPIO_PortImageTypeDef new_image;
+    uint32_t i;
+
+    /* Check the parameters */
+    assert_param(IS_GPIO_ALL_INSTANCE(GPIOx));
+
+    if(pInits == NULL || Num == 0U)
+        return;
+
+    GPIO_Image_Load(GPIOx, &old_image);
+    new_image = old_image;
+
+    for(i = 0U; i < Num; i++)
+    {
+        assert_param(IS_GPIO_PIN(pInits[i].Pin));
+        assert_param(IS_GPIO_MODE(pInits[i].Mode));
+        assert_param(IS_GPIO_PULL(pInits[i].Pull));
+
+        GPIO_Image_Apply(&new_image, &pInits[i]);
+    }
+
+    GPIO_Image_Store(GPIOx, &old_image, &new_image);
+    return;
+}
+
+/**
+ * @brief  Applies a whole-board pin table, the entries are grouped by port and
+ *         every port is configured in one pass (see HAL_GPIO_InitPort()).
+ * @param  pTable the board pin table, it is usually a const table in flash
+ * @param  Num number of entries of pTable
+ * @retval None
+ */
+void HAL_GPIO_InitBoard(const GPIO_BoardPinTypeDef *pTable, uint32_t Num)
+{
+    GPIO_TypeDef * const ports[GPIO_PORT_NUMBER] = { GPIOA, GPIOB, GPIOC, GPIOD };
+    GPIO_PortImageTypeDef old_image;
+    GPIO_PortImageTypeDef new_image;
+    uint32_t p;
+    uint32_t i;
+
+    if(pTable == NULL || Num == 0U)
+        return;
+
+    for(p = 0U; p < GPIO_PORT_NUMBER; p++)
+    {
+        uint32_t is_used = 0U;
+
+        for(i = 0U; i < Num; i++)
+        {
+            if(pTable[i].Port != ports[p])
+                continue;
+
+            assert_param(IS_GPIO_PIN(pTable[i].Init.Pin));
+            assert_param(IS_GPIO_MODE(pTable[i].Init.Mode));
+            assert_param(IS_GPIO_PULL(pTable[i].Init.Pull));
+
+            if(is_used == 0U)
+            {
+                GPIO_Image_Load(ports[p], &old_image);
+                new_image = old_image;
+                is_used = 1U;
+            }
+
+            GPIO_Image_Apply(&new_image, &pTable[i].Init);
+        }
+
+        if(is_used)
+            GPIO_Image_Store(ports[p], &old_image, &new_image);
+    }
+    return;
+}
+
 /**
  * @}
  */ /* End of group GPIO_Exported_Functions_Group1 */
@@ -576,6 +706,212 @@ __weak void HAL_GPIO_EXTI_Callback(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
  * @}
  */ /* End of group GPIO_Exported_Functions */
 
+/** @addtogroup GPIO_Private_Functions
+ * @{
+ */
+
+/**
+ * @brief  Spread the pin mask to 2-bits fields (bit n to bits 2n and 2n+1).
+ * @param  Pins pin mask
+ * @retval The field mask
+ */
+static uint32_t GPIO_SpreadMask2(uint32_t Pins)
+{
+    uint32_t x = Pins & GPIO_PIN_MASK;
+
+    x = (x | (x << 8)) & 0x00FF00FFU;
+    x = (x | (x << 4)) & 0x0F0F0F0FU;
+    x = (x | (x << 2)) & 0x33333333U;
+    x = (x | (x << 1)) & 0x55555555U;
+    return x * 0x3U;
+}
+
+/**
+ * @brief  Spread the 8-bits pin mask to 4-bits fields (bit n to bits 4n ~ 4n+3).
+ * @param  Pins pin mask of 8 pins
+ * @retval The field mask
+ */
+static uint32_t GPIO_SpreadMask4(uint32_t Pins)
+{
+    uint32_t x = Pins & 0xFFU;
+
+    x = (x | (x << 12)) & 0x000F000FU;
+    x = (x | (x << 6)) & 0x03030303U;
+    x = (x | (x << 3)) & 0x11111111U;
+    return x * 0xFU;
+}
+
+/**
+ * @brief  Read the register images of a port.
+ * @param  GPIOx the GPIO peripheral
+ * @param  pImage the images
+ * @retval None
+ */
+static void GPIO_Image_Load(GPIO_TypeDef *GPIOx, GPIO_PortImageTypeDef *pImage)
+{
+    pImage->DIRCR    = GPIOx->DIRCR;
+    pImage->OTYPER   = GPIOx->OTYPER;
+    pImage->INTEN    = GPIOx->INTEN;
+    pImage->INTTYPCR = GPIOx->INTTYPCR;
+    pImage->INTPOLCR = GPIOx->INTPOLCR;
+    pImage->INTANY   = GPIOx->INTANY;
+    pImage->INDBEN   = GPIOx->INDBEN;
+    pImage->DBCLKCR  = GPIOx->DBCLKCR;
+    pImage->PUPDR    = GPIOx->PUPDR;
+    pImage->SLEWCR   = GPIOx->SLEWCR;
+    pImage->DRVCR    = GPIOx->DRVCR;
+#if defined(CONFIG_USE_ZB32L003S)
+    pImage->AFR      = GPIOx->AFR;
+#elif defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
+    pImage->AFRL     = GPIOx->AFRL;
+    pImage->AFRH     = GPIOx->AFRH;
+#endif
+    return;
+}
+
+/**
+ * @brief  Apply a configuration to the register images, it follows HAL_GPIO_Init()
+ *         with pin masks instead of a loop over the 16 positions.
+ * @param  pImage the images
+ * @param  GPIO_Init the configuration
+ * @retval None
+ */
+static void GPIO_Image_Apply(GPIO_PortImageTypeDef *pImage, const GPIO_InitTypeDef *GPIO_Init)
+{
+    uint32_t pins = GPIO_Init->Pin & GPIO_PIN_MASK;
+    uint32_t mask2 = GPIO_SpreadMask2(pins);
+    uint32_t af = 0x0U;
+
+    if(pins == 0x0U)
+        return;
+
+    /* Reset the interrupt configuration */
+    pImage->INTEN    &= ~pins;
+    pImage->INTTYPCR &= ~pins;
+    pImage->INTPOLCR &= ~pins;
+    pImage->INTANY   &= ~pins;
+
+    /* Alternate function, direction */
+    if(GPIO_Init->Mode == GPIO_MODE_AF)
+    {
+        assert_param(IS_GPIO_AF(GPIO_Init->Alternate));
+        af = GPIO_Init->Alternate & 0xFU;
+    }
+    else if(GPIO_Init->Mode == GPIO_MODE_ANALOG)
+    {
+        af = 0xFU;
+    }
+
+#if defined(CONFIG_USE_ZB32L003S)
+    {
+        uint32_t mask4 = GPIO_SpreadMask4(pins);
+
+        pImage->AFR = (pImage->AFR & ~mask4) | ((af * 0x11111111U) & mask4);
+    }
+#elif defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
+    {
+        uint32_t mask4l = GPIO_SpreadMask4(pins);
+        uint32_t mask4h = GPIO_SpreadMask4(pins >> 8);
+
+        pImage->AFRL = (pImage->AFRL & ~mask4l) | ((af * 0x11111111U) & mask4l);
+        pImage->AFRH = (pImage->AFRH & ~mask4h) | ((af * 0x11111111U) & mask4h);
+    }
+#endif
+
+    if(GPIO_Init->Mode == GPIO_MODE_OUTPUT)
+        pImage->DIRCR |= pins;
+    else
+        pImage->DIRCR &= ~pins;
+
+    /* Debounce and two level sync */
+    if(GPIO_Init->Debounce.Enable == GPIO_DEBOUNCE_ENABLE)
+    {
+        pImage->DBCLKCR |= GPIO_Init->Debounce.DebounceClk << GPIO_DBCLKCR_DBCLK_DIV_Pos;
+        pImage->INDBEN  |= pins;
+    }
+    else if(GPIO_Init->Debounce.TwoLevelSync == GPIO_SYNC_ENABLE)
+    {
+        pImage->INDBEN  &= ~pins;
+        pImage->DBCLKCR &= ~(0x01U << GPIO_DBCLKCR_DBCLKEN_Pos);
+        pImage->INDBEN  |= (0x01U << GPIO_INDBEN_SYNC_EN_Pos);
+    }
+    else
+    {
+        pImage->INDBEN &= ~pins;
+    }
+
+    if((pImage->INDBEN & GPIO_INDBEN_PxDIDB) != 0x0U)
+        pImage->DBCLKCR |= GPIO_Init->Debounce.Enable << GPIO_DBCLKCR_DBCLKEN_Pos;
+    else
+        pImage->DBCLKCR &= ~(0x01U << GPIO_DBCLKCR_DBCLKEN_Pos);
+
+    /* Pull, output type, slew rate and driver strength */
+    pImage->PUPDR  = (pImage->PUPDR & ~mask2) | ((GPIO_Init->Pull * 0x55555555U) & mask2);
+    pImage->OTYPER = (GPIO_Init->OpenDrain) ? (pImage->OTYPER | pins) : (pImage->OTYPER & ~pins);
+    pImage->SLEWCR = (GPIO_Init->SlewRate) ? (pImage->SLEWCR | pins) : (pImage->SLEWCR & ~pins);
+    pImage->DRVCR  = (GPIO_Init->DrvStrength) ? (pImage->DRVCR | pins) : (pImage->DRVCR & ~pins);
+
+    /* External interrupt */
+    if((GPIO_Init->Mode & EXTI_MODE) == EXTI_MODE)
+    {
+        if(GPIO_Init->Exti.Enable)
+            pImage->INTEN |= pins;
+
+        if(GPIO_Init->Exti.EdgeLevelSel)
+            pImage->INTTYPCR |= pins;
+
+        if(GPIO_Init->Exti.RiseFallSel == GPIO_EXTI_INT_HIGHRISE)
+            pImage->INTPOLCR |= pins;
+        else if(GPIO_Init->Exti.RiseFallSel != GPIO_EXTI_INT_LOWFALL)
+            pImage->INTANY |= pins;
+    }
+    return;
+}
+
+/**
+ * @brief  Write the changed register images of a port, the interrupt enables
+ *         are written last.
+ * @param  GPIOx the GPIO peripheral
+ * @param  pOld the images read by GPIO_Image_Load()
+ * @param  pNew the new images
+ * @retval None
+ */
+static void GPIO_Image_Store(GPIO_TypeDef *GPIOx, const GPIO_PortImageTypeDef *pOld, const GPIO_PortImageTypeDef *pNew)
+{
+    uint32_t changed = (pOld->INTTYPCR ^ pNew->INTTYPCR) |
+                       (pOld->INTPOLCR ^ pNew->INTPOLCR) |
+                       (pOld->INTANY ^ pNew->INTANY);
+
+    /* Mask the enabled interrupts of which trigger is changed */
+    if(pOld->INTEN & changed)
+        GPIOx->INTEN = pOld->INTEN & ~changed;
+
+    if(pOld->INTTYPCR != pNew->INTTYPCR)    GPIOx->INTTYPCR = pNew->INTTYPCR;
+    if(pOld->INTPOLCR != pNew->INTPOLCR)    GPIOx->INTPOLCR = pNew->INTPOLCR;
+    if(pOld->INTANY != pNew->INTANY)        GPIOx->INTANY = pNew->INTANY;
+#if defined(CONFIG_USE_ZB32L003S)
+    if(pOld->AFR != pNew->AFR)              GPIOx->AFR = pNew->AFR;
+#elif defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
+    if(pOld->AFRL != pNew->AFRL)            GPIOx->AFRL = pNew->AFRL;
+    if(pOld->AFRH != pNew->AFRH)            GPIOx->AFRH = pNew->AFRH;
+#endif
+    if(pOld->PUPDR != pNew->PUPDR)          GPIOx->PUPDR = pNew->PUPDR;
+    if(pOld->OTYPER != pNew->OTYPER)        GPIOx->OTYPER = pNew->OTYPER;
+    if(pOld->SLEWCR != pNew->SLEWCR)        GPIOx->SLEWCR = pNew->SLEWCR;
+    if(pOld->DRVCR != pNew->DRVCR)          GPIOx->DRVCR = pNew->DRVCR;
+    if(pOld->DBCLKCR != pNew->DBCLKCR)      GPIOx->DBCLKCR = pNew->DBCLKCR;
+    if(pOld->INDBEN != pNew->INDBEN)        GPIOx->INDBEN = pNew->INDBEN;
+    if(pOld->DIRCR != pNew->DIRCR)          GPIOx->DIRCR = pNew->DIRCR;
+
+    if((pOld->INTEN & changed) || pOld->INTEN != pNew->INTEN)
+        GPIOx->INTEN = pNew->INTEN;
+    return;
+}
+
+/**
+ * @}
+ */
+
 #endif /* HAL_GPIO_MODULE_ENABLED */
 
 /**
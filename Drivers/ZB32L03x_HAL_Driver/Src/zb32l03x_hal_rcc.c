@@ -74,6 +74,15 @@
 /** @defgroup RCC_Private_Variables RCC Private Variables
  * @{
  */
+static uint32_t     RCC_HIRCMeasuredFreq = 0U;  /*!< Measured HIRC frequency published by HAL_RCC_SetHIRCFreq(), 0: nominal */
+static uint32_t     RCC_HIRCMeasuredTrim = 0U;  /*!< HIRCTRIM value of RCC_HIRCMeasuredFreq */
+
+/**
+ * The clock frequencies are cached and updated only when the clocks are
+ * re-configured by this driver, SYSCLKFreq == 0 means not yet computed.
+ */
+static RCC_ClockTreeTypeDef     RCC_ClockTree = {0};
+static uint32_t                 RCC_ClockTreeRecipValid = 0U;  /*!< The reciprocals match the frequencies */
 /**
  * @}
  */
@@ -97,6 +106,65 @@ static void RCC_Delay(uint32_t mdelay)
     return;
 }
 
+/**
+ * @brief  Get the HIRC frequency of the current trim level.
+ * @note   The trim level is HIRCTRIM[11:9], the fine trim bits HIRCTRIM[8:0]
+ *         may be adjusted at run time (e.g. by a clock trim service), so only
+ *         the level is compared. The measured frequency published by
+ *         @ref HAL_RCC_SetHIRCFreq() is used while HIRCTRIM is unchanged.
+ * @retval HIRC frequency
+ */
+static uint32_t RCC_GetHIRCFreq(void)
+{
+    uint32_t trim = (RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos;
+    uint32_t level = trim & RCC_HIRCCR_TRIMLEVEL_MSK;
+
+    if((RCC_HIRCMeasuredFreq != 0U) && (trim == RCC_HIRCMeasuredTrim))
+        return RCC_HIRCMeasuredFreq;
+
+    if(level == (RCC_HIRCCALIBRATION_24M & RCC_HIRCCR_TRIMLEVEL_MSK))
+        return HIRC_VALUE_24M;
+    else if(level == (RCC_HIRCCALIBRATION_22M & RCC_HIRCCR_TRIMLEVEL_MSK))
+        return HIRC_VALUE_22M;
+    else if(level == (RCC_HIRCCALIBRATION_16M & RCC_HIRCCR_TRIMLEVEL_MSK))
+        return HIRC_VALUE_16M;
+    else if(level == (RCC_HIRCCALIBRATION_8M & RCC_HIRCCR_TRIMLEVEL_MSK))
+        return HIRC_VALUE_8M;
+
+    return HIRC_VALUE_4M;
+}
+
+static uint32_t RCC_ComputeSysClockFreq(void);
+
+/**
+ * @brief  Re-compute the clock tree cache and the SystemCoreClock global variable.
+ * @note   It is called when the clocks are re-configured (maybe with the IRQs
+ *         disabled), the divisions are done here and not at every frequency
+ *         query. The reciprocals cost a 64-bits division each, they are
+ *         computed later by @ref HAL_RCC_GetClockTree().
+ * @retval None
+ */
+static void RCC_UpdateClockTree(void)
+{
+    uint32_t sysclk = RCC_ComputeSysClockFreq();
+    uint32_t hclk = sysclk;
+    uint32_t pclk = 0U;
+
+    if((RCC->HCLKDIV & RCC_HCLKDIV_AHBCKDIV) != 0)
+        hclk = (sysclk >> 1) / (RCC->HCLKDIV & RCC_HCLKDIV_AHBCKDIV);
+
+    pclk = (RCC->PCLKDIV != 0) ? ((hclk >> 1) / RCC->PCLKDIV) : hclk;
+
+    RCC_ClockTreeRecipValid = 0U;
+
+    RCC_ClockTree.HCLKFreq   = hclk;
+    RCC_ClockTree.PCLKFreq   = pclk;
+    RCC_ClockTree.SYSCLKFreq = sysclk;
+
+    SystemCoreClock = hclk;
+    return;
+}
+
 /**
  * @}
  */ /* End of group RCC_Private_Functions */
@@ -166,8 +234,8 @@ HAL_StatusTypeDef HAL_RCC_DeInit(void)
         }
     }
 
-    /* Update the SystemCoreClock global variable */
-    SystemCoreClock = HIRC_VALUE_4M;
+    /* Update the clock tree and the SystemCoreClock global variable */
+    RCC_UpdateClockTree();
 
     /* Adapt Systick interrupt period */
     if(HAL_InitTick(TICK_INT_PRIORITY) != HAL_OK)
@@ -551,6 +619,9 @@ HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef  *RCC_OscInitStruct)
     }
 #endif  /* defined(CONFIG_USE_ZB32L032) */
 
+    /* The calibration of HIRC may be changed */
+    RCC_UpdateClockTree();
+
     return HAL_OK;
 }
 
@@ -707,11 +778,8 @@ HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct)
         MODIFY_REG(RCC->PCLKDIV, RCC_PCLKDIV_APBCKDIV, RCC_ClkInitStruct->APBCLKDivider);
     }
 
-    /* Update the SystemCoreClock global variable */
-    if((RCC->HCLKDIV & RCC_HCLKDIV_AHBCKDIV) != 0)
-        SystemCoreClock = (HAL_RCC_GetSysClockFreq() >> 1) / (RCC->HCLKDIV & RCC_HCLKDIV_AHBCKDIV);
-    else
-        SystemCoreClock = HAL_RCC_GetSysClockFreq();
+    /* Update the clock tree and the SystemCoreClock global variable */
+    RCC_UpdateClockTree();
 
     /* Configure system tick overflow to 100Hz because of low frequency of LXT or SIRC*/
     if((RCC_ClkInitStruct->SYSCLKSource == RCC_SYSCLKSOURCE_SIRC) || (RCC_ClkInitStruct->SYSCLKSource == RCC_SYSCLKSOURCE_LXT))
@@ -825,6 +893,18 @@ void HAL_RCC_MCOConfig(uint32_t RCC_MCOx, uint32_t RCC_MCOSource, uint32_t RCC_M
  * @retval SYSCLK frequency
  */
 uint32_t HAL_RCC_GetSysClockFreq(void)
+{
+    if(RCC_ClockTree.SYSCLKFreq == 0U)
+        RCC_UpdateClockTree();
+
+    return RCC_ClockTree.SYSCLKFreq;
+}
+
+/**
+ * @brief  Compute the SYSCLK frequency from the RCC registers.
+ * @retval SYSCLK frequency
+ */
+static uint32_t RCC_ComputeSysClockFreq(void)
 {
     uint32_t tmpreg = 0U;
     uint32_t sysclockfreq = 0U;
@@ -836,30 +916,7 @@ uint32_t HAL_RCC_GetSysClockFreq(void)
     {
         case RCC_SYSCLKSOURCE_STATUS_HIRC:  /* HIRC used as system clock */
             {
-                if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_24M)
-                {
-                    sysclockfreq = HIRC_VALUE_24M;
-                }
-                else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_22M)
-                {
-                    sysclockfreq = HIRC_VALUE_22M;
-                }
-                else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_16M)
-                {
-                    sysclockfreq = HIRC_VALUE_16M;
-                }
-                else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_8M)
-                {
-                    sysclockfreq = HIRC_VALUE_8M;
-                }
-                else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_4M)
-                {
-                    sysclockfreq = HIRC_VALUE_4M;
-                }
-                else
-                {
-                    sysclockfreq = HIRC_VALUE_4M;
-                }
+                sysclockfreq = RCC_GetHIRCFreq();
                 break;
             }
         case RCC_SYSCLKSOURCE_STATUS_HXT:  /* HXT used as system clock */
@@ -887,16 +944,7 @@ uint32_t HAL_RCC_GetSysClockFreq(void)
                 else
                 {
                     /* RCLK is HIRC */
-                    if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_24M)
-                        rclk = HIRC_VALUE_24M;
-                    else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_22M)
-                        rclk = HIRC_VALUE_22M;
-                    else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_16M)
-                        rclk = HIRC_VALUE_16M;
-                    else if((uint32_t)((RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos) == RCC_HIRCCALIBRATION_8M)
-                        rclk = HIRC_VALUE_8M;
-                    else
-                        rclk = HIRC_VALUE_4M;
+                    rclk = RCC_GetHIRCFreq();
                 }
 
                 pll_n = (((RCC->PLLCR2 & RCC_PLLCR2_PLL_N_Msk) >> RCC_PLLCR2_PLL_N_Pos) == RCC_PLLCR2_PLL_N_RCLK_DIV6) ? 6 :
@@ -934,7 +982,10 @@ uint32_t HAL_RCC_GetSysClockFreq(void)
  */
 uint32_t HAL_RCC_GetHCLKFreq(void)
 {
-    return SystemCoreClock;
+    if(RCC_ClockTree.SYSCLKFreq == 0U)
+        RCC_UpdateClockTree();
+
+    return RCC_ClockTree.HCLKFreq;
 }
 
 /**
@@ -945,13 +996,93 @@ uint32_t HAL_RCC_GetHCLKFreq(void)
  */
 uint32_t HAL_RCC_GetPCLKFreq(void)
 {
-    /* Get HCLK source and Compute PCLK frequency ---------------------------*/
-    if(RCC->PCLKDIV != 0)
-        return ((HAL_RCC_GetHCLKFreq() >> 1) / RCC->PCLKDIV);
-    else
-        return (HAL_RCC_GetHCLKFreq());
+    if(RCC_ClockTree.SYSCLKFreq == 0U)
+        RCC_UpdateClockTree();
+
+    return RCC_ClockTree.PCLKFreq;
+}
+
+/**
+ * @brief  Returns the cached clock tree (frequencies and their reciprocals)
+ * @note   The cache is updated by @ref HAL_RCC_DeInit(), @ref HAL_RCC_OscConfig(),
+ *         @ref HAL_RCC_ClockConfig() and @ref HAL_RCC_SetHIRCFreq(). If the RCC
+ *         registers are modified directly, the cache is obsolete.
+ * @note   The reciprocals are computed at the first call after a re-configuration
+ *         (three 64-bits divisions), call it out of the time critical sections.
+ * @retval Pointer to the clock tree
+ */
+const RCC_ClockTreeTypeDef* HAL_RCC_GetClockTree(void)
+{
+    if(RCC_ClockTree.SYSCLKFreq == 0U)
+        RCC_UpdateClockTree();
+
+    if(RCC_ClockTreeRecipValid == 0U)
+    {
+        HAL_RCC_Divider_Init(&RCC_ClockTree.SYSCLKRecip, RCC_ClockTree.SYSCLKFreq);
+        HAL_RCC_Divider_Init(&RCC_ClockTree.HCLKRecip, RCC_ClockTree.HCLKFreq);
+        HAL_RCC_Divider_Init(&RCC_ClockTree.PCLKRecip, RCC_ClockTree.PCLKFreq);
+        RCC_ClockTreeRecipValid = 1U;
+    }
+
+    return &RCC_ClockTree;
+}
+
+/**
+ * @brief  Prepare a division by an invariant divisor with multiply-shift.
+ * @note   The magic number is ceil(2^Shift / Divisor) with Shift = 31 + ceil(log2(Divisor)),
+ *         @ref HAL_RCC_Divide() is exact for Dividend < 2^31. It costs one 64-bits
+ *         division, call it at init (e.g. Divisor = 32 * baudrate) and not in the
+ *         re-configuration path.
+ * @param  pDiv pointer to the divider
+ * @param  Divisor the divisor, 1 ~ (2^31 - 1), 0 is treated as 1
+ * @retval None
+ */
+void HAL_RCC_Divider_Init(RCC_DividerTypeDef *pDiv, uint32_t Divisor)
+{
+    uint32_t log2_ceil = 0U;
+
+    if(Divisor == 0U)
+        Divisor = 1U;
+
+    while((log2_ceil < 31U) && ((1UL << log2_ceil) < Divisor))
+        log2_ceil++;
+
+    pDiv->Shift = 31U + log2_ceil;
+    pDiv->Magic = (uint32_t)(((1ULL << pDiv->Shift) + Divisor - 1U) / Divisor);
+    return;
+}
+
+
+/**
+ * @brief  Publish the measured frequency of HIRC.
+ * @note   The frequency is bound to the current HIRCTRIM value, it is discarded
+ *         when HIRCTRIM is changed (e.g. by @ref HAL_RCC_OscConfig()) and the
+ *         nominal HIRC_VALUE_xxM is used again.
+ * @note   The clock tree and SystemCoreClock are updated, the peripherals
+ *         configured after this call use the measured frequency.
+ * @param  HIRCFreq measured HIRC frequency in Hz, 0 to restore the nominal value.
+ * @retval None
+ */
+void HAL_RCC_SetHIRCFreq(uint32_t HIRCFreq)
+{
+    RCC_HIRCMeasuredFreq = 0U;
+    RCC_HIRCMeasuredTrim = (RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos;
+    RCC_HIRCMeasuredFreq = HIRCFreq;
+
+    RCC_UpdateClockTree();
+    return;
 }
 
+/**
+ * @brief  Returns the HIRC frequency
+ * @note   The measured frequency published by @ref HAL_RCC_SetHIRCFreq() or
+ *         HIRC_VALUE_xxM of the current trim level.
+ * @retval HIRC frequency
+ */
+uint32_t HAL_RCC_GetHIRCFreq(void)
+{
+    return RCC_GetHIRCFreq();
+}
 
 /**
  * @brief  Configures the RCC_OscInitStruct according to the internal
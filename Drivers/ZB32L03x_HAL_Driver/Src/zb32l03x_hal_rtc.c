@@ -28,6 +28,8 @@
    (+) To configure the RTC Calendar (Time and Date) use the HAL_RTC_SetTime()
        and HAL_RTC_SetDate() functions.
    (+) To read the RTC Calendar, use the HAL_RTC_GetTime_Date() functions.
+   (+) To read time stamps in Unix seconds, use the HAL_RTC_GetEpoch() function,
+       the sub-second is enabled by HAL_RTC_SubSecond_Config().
 
  *** Alarm configuration ***
  ===========================
@@ -216,6 +218,107 @@ static void RTC_Clear_RSF_Flag(void)
     CLEAR_BIT(RTC->ISR, RTC_ISR_RSF);
     return;
 }
+
+/**
+ * @brief  Get the hours (0 ~ 23) of a TIME register.
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @param  time_reg: The TIME register
+ * @retval Hours
+ */
+static uint8_t RTC_Get_Hours(RTC_HandleTypeDef *hrtc, uint32_t time_reg)
+{
+    uint8_t hours = RTC_Bcd2ToByte((uint8_t)((time_reg & RTC_TIME_HOUR19_Msk) >> RTC_TIME_HOUR19_Pos));
+
+    if((time_reg & RTC_TIME_H20_PA) == RESET)
+    {
+        if(hrtc->Init.HourFormat == RTC_HOURFORMAT_12 && hours >= 12)
+            hours -= 12;
+    }
+    else
+    {
+        if(hrtc->Init.HourFormat == RTC_HOURFORMAT_12)
+        {
+            hours += 12;
+            if(hours >= 24)
+                hours -= 12;
+        }
+        else
+            hours += 20;
+    }
+
+    return hours;
+}
+
+/**
+ * @brief  Days from 1970/01/01 to the date of a DATE register.
+ * @note   A year divisible by 4 is a leap year, it is valid in 1901 ~ 2099.
+ * @param  date_reg: The DATE register
+ * @retval Days, 0 if the date is before 1970
+ */
+static uint32_t RTC_Date_To_Days(uint32_t date_reg)
+{
+    static const uint16_t   days_before_month[12] =
+    {
+        0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+    };
+    uint32_t year  = RTC_Bcd2ToByte((uint8_t)((date_reg & RTC_DATE_YEAR_Msk) >> RTC_DATE_YEAR_Pos));
+    uint32_t month = RTC_Bcd2ToByte((uint8_t)((date_reg & RTC_DATE_MONTH_Msk) >> RTC_DATE_MONTH_Pos));
+    uint32_t day   = RTC_Bcd2ToByte((uint8_t)(date_reg & RTC_DATE_DAY_Msk));
+    uint32_t days  = 0U;
+
+    year += ((date_reg & RTC_DATE_CEN) != RESET) ? 2000U : 1900U;
+
+    if(year < 1970U || month < 1U || month > 12U || day < 1U)
+        return 0U;
+
+    /* 365 days per year and the leap days of 1970 ~ (year - 1) */
+    days = (year - 1970U) * 365U + ((year - 1969U) >> 2) + days_before_month[month - 1] + day - 1U;
+
+    if(month > 2U && (year & 0x3U) == 0U)
+        days++;
+
+    return days;
+}
+
+/**
+ * @brief  Get the sub-second from the last second boundary.
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @retval Sub-second in 1/65536 second, saturated at 0xFFFF
+ */
+static uint32_t RTC_Get_SubSeconds(RTC_HandleTypeDef *hrtc)
+{
+    uint32_t elapsed = 0U;
+
+    if(hrtc->SubSecSource == RTC_SUBSEC_SOURCE_TICK)
+    {
+        elapsed = HAL_GetTick() - hrtc->SubSecPhase;
+
+        /* 65536 / 1000 ~= 67109 / 1024 */
+        elapsed = (elapsed < 1000U) ? ((elapsed * 67109U) >> 10) : 0xFFFFU;
+    }
+    else if(hrtc->SubSecSource == RTC_SUBSEC_SOURCE_LPTIM)
+    {
+        /* 32768 Hz */
+        elapsed = ((LPTIM->CNTVAL - hrtc->SubSecPhase) & LPTIM_CNTVAL_LPT_CNT_Msk) << 1;
+    }
+
+    return (elapsed > 0xFFFFU) ? 0xFFFFU : elapsed;
+}
+
+/**
+ * @brief  Invalidate the cache of HAL_RTC_GetEpoch().
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @retval None
+ */
+static void RTC_Epoch_Invalidate(RTC_HandleTypeDef *hrtc)
+{
+    hrtc->EpochDateReg = RTC_EPOCH_CACHE_INVALID;
+    hrtc->EpochTimeReg = RTC_EPOCH_CACHE_INVALID;
+    return;
+}
 /**
  * @}
  */
@@ -332,9 +435,12 @@ HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc)
     RTC_Disable_Write_Protected(hrtc);
     CLEAR_REG(hrtc->Instance->RCLKTRIM);
     RTC_Disable_Write_Protected(hrtc);
-    SET_BIT(hrtc->Instance->RCLKTRIM, hrtc->Init.TimeAdjustMode | hrtc->Init.TimeTrim);
+    SET_BIT(hrtc->Instance->RCLKTRIM, hrtc->Init.TimeAdjustMode | ((uint8_t)hrtc->Init.TimeTrim & RTC_RCLKTRIM_TRIM));
 
     __HAL_RTC_ENABLE(hrtc);
+
+    RTC_Epoch_Invalidate(hrtc);
+
     /* Set RTC state */
     hrtc->State = HAL_RTC_STATE_READY;
 
@@ -529,6 +635,8 @@ HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTim
     RTC_Disable_Write_Protected(hrtc);
     WRITE_REG(hrtc->Instance->TIME, time_reg);
 
+    RTC_Epoch_Invalidate(hrtc);
+
     /* Exit read/writ mode in RTC registers */
     if(RTC_Exit_Init_Mode(hrtc) != HAL_OK)
     {
@@ -673,6 +781,8 @@ HAL_StatusTypeDef HAL_RTC_SetTime_SetDate(RTC_HandleTypeDef *hrtc, RTC_TimeTypeD
     RTC_Disable_Write_Protected(hrtc);
     WRITE_REG(hrtc->Instance->DATE, data_reg);
 
+    RTC_Epoch_Invalidate(hrtc);
+
     /* Exit read/writ mode in RTC registers */
     if(RTC_Exit_Init_Mode(hrtc) != HAL_OK)
     {
@@ -747,28 +857,7 @@ HAL_StatusTypeDef HAL_RTC_GetTime_Date(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef
     }
 
     /* Fill the structure fields with the read parameters */
-    if((time1_reg & RTC_TIME_H20_PA) == RESET)
-    {
-        if (hrtc->Init.HourFormat == RTC_HOURFORMAT_12)
-        {
-            sTime->Hours =  RTC_Bcd2ToByte((uint8_t)((time1_reg & RTC_TIME_HOUR19_Msk) >> RTC_TIME_HOUR19_Pos));
-            if(sTime->Hours >= 12)
-                sTime->Hours -= 12;
-        }
-        else
-            sTime->Hours = RTC_Bcd2ToByte((uint8_t)((time1_reg & RTC_TIME_HOUR19_Msk) >> RTC_TIME_HOUR19_Pos));
-    }
-    else
-    {
-        if (hrtc->Init.HourFormat == RTC_HOURFORMAT_12)
-        {
-            sTime->Hours = 12 + RTC_Bcd2ToByte((uint8_t)((time1_reg & RTC_TIME_HOUR19_Msk) >> RTC_TIME_HOUR19_Pos));
-            if(sTime->Hours >= 24)
-                sTime->Hours -= 12;
-        }
-        else
-            sTime->Hours = 20 + RTC_Bcd2ToByte((uint8_t)((time1_reg & RTC_TIME_HOUR19_Msk) >> RTC_TIME_HOUR19_Pos));
-    }
+    sTime->Hours   = RTC_Get_Hours(hrtc, time1_reg);
     sTime->Minutes = RTC_Bcd2ToByte((uint8_t)((time1_reg & RTC_TIME_MIN) >> RTC_TIME_MIN_Pos));
     sTime->Seconds = RTC_Bcd2ToByte((uint8_t)(time1_reg & RTC_BCD_TO_BYTE_MASK));
 
@@ -791,6 +880,63 @@ HAL_StatusTypeDef HAL_RTC_GetTime_Date(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef
     return HAL_OK;
 }
 
+/**
+ * @brief  Gets RTC current time in Unix seconds (from 1970/01/01 00:00:00).
+ * @note   The days of the date are only recomputed when the date changes and
+ *         the seconds of hours/minutes when the minute changes, otherwise it
+ *         is a few register reads and one BCD conversion.
+ * @note   The sub-second needs HAL_RTC_SubSecond_Config() and
+ *         HAL_RTC_SubSecond_Sync() at every second boundary.
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @param  pSubSeconds: Sub-second in 1/65536 second, it can be NULL
+ * @retval Unix seconds, valid in 1970 ~ 2099
+ */
+uint32_t HAL_RTC_GetEpoch(RTC_HandleTypeDef *hrtc, uint16_t *pSubSeconds)
+{
+    uint32_t counter_times = RTC_READ_TIMEOUT;
+    uint32_t time_reg = 0U, date_reg = 0U;
+    uint32_t hm_reg = 0U, base = 0U;
+    uint32_t primask = 0U;
+
+    /* The DATE is consistent when the TIME does not change around it */
+    do {
+        time_reg = hrtc->Instance->TIME;
+        date_reg = hrtc->Instance->DATE;
+
+        if(pSubSeconds)
+            *pSubSeconds = (uint16_t)RTC_Get_SubSeconds(hrtc);
+
+    } while(time_reg != hrtc->Instance->TIME && counter_times-- > 0);
+
+    hm_reg = time_reg & (RTC_TIME_MIN_Msk | RTC_TIME_HOUR19_Msk | RTC_TIME_H20_PA_Msk);
+
+    /* The cache is shared with the callers of interrupt context */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if(date_reg != hrtc->EpochDateReg)
+    {
+        hrtc->EpochDayBase = RTC_Date_To_Days(date_reg) * 86400U;
+        hrtc->EpochDateReg = date_reg;
+        hrtc->EpochTimeReg = RTC_EPOCH_CACHE_INVALID;
+    }
+
+    if(hm_reg != hrtc->EpochTimeReg)
+    {
+        hrtc->EpochMinBase = hrtc->EpochDayBase
+                           + RTC_Get_Hours(hrtc, time_reg) * 3600U
+                           + RTC_Bcd2ToByte((uint8_t)((time_reg & RTC_TIME_MIN_Msk) >> RTC_TIME_MIN_Pos)) * 60U;
+        hrtc->EpochTimeReg = hm_reg;
+    }
+
+    base = hrtc->EpochMinBase;
+
+    __set_PRIMASK(primask);
+
+    return base + RTC_Bcd2ToByte((uint8_t)(time_reg & RTC_TIME_SEC_Msk));
+}
+
 
 /**
  * @brief  Sets RTC current date.
@@ -858,6 +1004,8 @@ HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDat
     RTC_Disable_Write_Protected(hrtc);
     SET_BIT(hrtc->Instance->TIME, sDate->WeekDay);
 
+    RTC_Epoch_Invalidate(hrtc);
+
     if(RTC_Exit_Init_Mode(hrtc) != HAL_OK)
     {
         hrtc->State = HAL_RTC_STATE_ERROR;
@@ -1413,6 +1561,127 @@ HAL_StatusTypeDef HAL_RTC_1HZ_Config(RTC_HandleTypeDef *hrtc, FunctionalState Ne
 
 }
 
+/**
+ * @brief  Select the sub-second source of HAL_RTC_GetEpoch().
+ * @note   Alarm2 is set to the 1s period interrupt, HAL_RTC_SubSecond_Sync()
+ *         MUST be called in HAL_RTC_Alarm2Callback().
+ * @note   RTC_SUBSEC_SOURCE_LPTIM is rejected with USE_HAL_TICKLESS, the HAL
+ *         time base reloads LPTIM and it does not free-run.
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @param  Source: The sub-second source.
+ *          This parameter can be a value of @ref RTC_SubSecond_Source_Definitions
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_RTC_SubSecond_Config(RTC_HandleTypeDef *hrtc, uint32_t Source)
+{
+    /* Check input parameters */
+    if( hrtc == NULL )
+        return HAL_ERROR;
+
+#if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+    if(Source == RTC_SUBSEC_SOURCE_LPTIM)
+        return HAL_ERROR;
+#endif
+
+    assert_param(IS_RTC_SUBSEC_SOURCE(Source));
+
+    /* Process Locked */
+    __HAL_LOCK(hrtc);
+
+    hrtc->SubSecSource = Source;
+    HAL_RTC_SubSecond_Sync(hrtc);
+
+    if(Source != RTC_SUBSEC_SOURCE_NONE)
+    {
+        RTC_Disable_Write_Protected(hrtc);
+        WRITE_REG(hrtc->Instance->ALM2PRD, HAL_RTC_ALARM2_1S);
+        RTC_Disable_Write_Protected(hrtc);
+        SET_BIT(hrtc->Instance->CR, RTC_CR_ALM2_INTEN);
+    }
+
+    /* Process Unlocked */
+    __HAL_UNLOCK(hrtc);
+
+    return HAL_OK;
+}
+
+/**
+ * @brief  Record the phase of the sub-second source at a second boundary.
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @retval None
+ */
+void HAL_RTC_SubSecond_Sync(RTC_HandleTypeDef *hrtc)
+{
+    if(hrtc->SubSecSource == RTC_SUBSEC_SOURCE_TICK)
+        hrtc->SubSecPhase = HAL_GetTick();
+    else if(hrtc->SubSecSource == RTC_SUBSEC_SOURCE_LPTIM)
+        hrtc->SubSecPhase = LPTIM->CNTVAL & LPTIM_CNTVAL_LPT_CNT_Msk;
+
+    return;
+}
+
+/**
+ * @brief  Set the digital calibration of the RTC clock.
+ * @note   Every adjust period (6/15/30/60 seconds), Trim RTC clock cycles are
+ *         compensated. The resolution is 1 / (period * RTC clock) and the range
+ *         is +/-127 cycles, e.g. 0.51 ppm and +/-64.6 ppm for 60 seconds with LXT.
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @param  AdjustMode: The adjust period.
+ *          This parameter can be a value of @ref RTC_TIME_ADJUST_MODE_Definitions
+ * @param  Trim: The compensated cycles of one adjust period, two's complement.
+ *          A positive value adds cycles (the RTC runs faster, for a slow clock),
+ *          a negative value removes cycles (the RTC runs slower, for a fast clock).
+ *          This parameter must be a number between Min_Data = -127 and Max_Data = 127
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_RTC_Calibration_Config(RTC_HandleTypeDef *hrtc, uint32_t AdjustMode, int8_t Trim)
+{
+    /* Check input parameters */
+    if( hrtc == NULL )
+        return HAL_ERROR;
+
+    assert_param(IS_RTC_TIME_ADJUST_MODE(AdjustMode));
+    assert_param(IS_RTC_TIME_TRIM(Trim));
+
+    /* Process Locked */
+    __HAL_LOCK(hrtc);
+
+    hrtc->State = HAL_RTC_STATE_BUSY;
+
+    hrtc->Init.TimeAdjustMode = AdjustMode;
+    hrtc->Init.TimeTrim       = Trim;
+
+    RTC_Disable_Write_Protected(hrtc);
+    WRITE_REG(hrtc->Instance->RCLKTRIM, AdjustMode | ((uint8_t)Trim & RTC_RCLKTRIM_TRIM));
+
+    hrtc->State = HAL_RTC_STATE_READY;
+
+    /* Process Unlocked */
+    __HAL_UNLOCK(hrtc);
+
+    return HAL_OK;
+}
+
+/**
+ * @brief  Get the digital calibration of the RTC clock.
+ * @param  hrtc   pointer to a RTC_HandleTypeDef structure that contains
+ *                the configuration information for RTC.
+ * @param  pAdjustMode: The adjust period, a value of @ref RTC_TIME_ADJUST_MODE_Definitions
+ * @param  pTrim: The compensated cycles of one adjust period
+ * @retval None
+ */
+void HAL_RTC_Calibration_Get(RTC_HandleTypeDef *hrtc, uint32_t *pAdjustMode, int8_t *pTrim)
+{
+    uint32_t tmpreg = READ_REG(hrtc->Instance->RCLKTRIM);
+
+    *pAdjustMode = tmpreg & RTC_RCLKTRIM_MODE;
+    *pTrim       = (int8_t)(tmpreg & RTC_RCLKTRIM_TRIM);
+    return;
+}
+
 /**
  * @}
  */
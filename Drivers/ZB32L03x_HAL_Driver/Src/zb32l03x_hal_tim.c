@@ -110,6 +110,27 @@
 #if defined(HAL_TIM_MODULE_ENABLED)
 
 
+/** @defgroup TIM_Private_Variables TIM Private Variables
+ * @{
+ */
+#define TIM_TIMESTAMP_PERIOD            0x10000ULL      /* Counts of one free-running TIM period */
+
+static TIM_TypeDef          *pTimestampTIM = NULL;      /* Free-running TIM of the timestamp */
+static __IO uint64_t        ullTimestampHigh;           /* Counts of the serviced overflows */
+static uint32_t             uwTimestampFreq;            /* Counter frequency in Hz */
+static uint32_t             uwTimestampUsMul;           /* (2^uwTimestampUsShift * 1000000) / uwTimestampFreq */
+static uint32_t             uwTimestampUsShift;         /* Fraction bits of uwTimestampUsMul, 2^31 <= uwTimestampUsMul < 2^32 */
+
+/* Index of the lowest set bit of a nibble (bit 0 of 0 is never used) */
+static const uint8_t        TIM_LowestBitTable[16] =
+{
+    0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+};
+
+/**
+ * @}
+ */
+
 /** @defgroup TIM_Private_Functions TIM Private Functions
  * @{
  */
@@ -915,6 +936,7 @@ HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
     {
         /* Allocate lock resource and initialize it */
         htim->Lock = HAL_UNLOCKED;
+        htim->pFastCallbacks = NULL;
 
         /* Init the low level hardware : GPIO, CLOCK, NVIC */
         HAL_TIM_Base_MspInit(htim);
@@ -1127,6 +1149,7 @@ HAL_StatusTypeDef HAL_TIM_OC_Init(TIM_HandleTypeDef *htim)
     {
         /* Allocate lock resource and initialize it */
         htim->Lock = HAL_UNLOCKED;
+        htim->pFastCallbacks = NULL;
 
         /* Init the low level hardware : GPIO, CLOCK, NVIC */
         HAL_TIM_OC_MspInit(htim);
@@ -1410,6 +1433,7 @@ HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim)
     {
         /* Allocate lock resource and initialize it */
         htim->Lock = HAL_UNLOCKED;
+        htim->pFastCallbacks = NULL;
 
         /* Init the low level hardware : GPIO, CLOCK, NVIC */
         HAL_TIM_PWM_MspInit(htim);
@@ -1844,6 +1868,7 @@ HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef *htim)
     {
         /* Allocate lock resource and initialize it */
         htim->Lock = HAL_UNLOCKED;
+        htim->pFastCallbacks = NULL;
 
         /* Init the low level hardware : GPIO, CLOCK, NVIC */
         HAL_TIM_IC_MspInit(htim);
@@ -2101,6 +2126,7 @@ HAL_StatusTypeDef HAL_TIM_OnePulse_Init(TIM_HandleTypeDef *htim, uint32_t OnePul
     {
         /* Allocate lock resource and initialize it */
         htim->Lock = HAL_UNLOCKED;
+        htim->pFastCallbacks = NULL;
 
         /* Init the low level hardware : GPIO, CLOCK, NVIC */
         HAL_TIM_OnePulse_MspInit(htim);
@@ -2391,6 +2417,7 @@ HAL_StatusTypeDef HAL_TIM_Encoder_Init(TIM_HandleTypeDef *htim, TIM_Encoder_Init
     {
         /* Allocate lock resource and initialize it */
         htim->Lock = HAL_UNLOCKED;
+        htim->pFastCallbacks = NULL;
 
         /* Init the low level hardware : GPIO, CLOCK, NVIC */
         HAL_TIM_Encoder_MspInit(htim);
@@ -2709,6 +2736,12 @@ HAL_StatusTypeDef HAL_TIM_Encoder_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Chan
  */
 void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim)
 {
+    if(htim->pFastCallbacks)
+    {
+        HAL_TIM_FastIRQHandler(htim);
+        return;
+    }
+
     /* Capture compare 1 event */
     if(__HAL_TIM_GET_FLAG(htim, TIM_FLAG_CC1) != RESET)
     {
@@ -2810,7 +2843,22 @@ void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim)
     {
         if(__HAL_TIM_GET_IT_SOURCE(htim, TIM_IT_UPDATE) != RESET)
         {
-            __HAL_TIM_CLEAR_IT(htim, TIM_IT_UPDATE);
+            /* Extend the free-running counter of the timestamp */
+            if(htim->Instance == pTimestampTIM)
+            {
+                uint32_t primask = __get_PRIMASK();
+
+                /* Atomic for the readers in higher priority ISRs */
+                __disable_irq();
+                __HAL_TIM_CLEAR_IT(htim, TIM_IT_UPDATE);
+                ullTimestampHigh += TIM_TIMESTAMP_PERIOD;
+                __set_PRIMASK(primask);
+            }
+            else
+            {
+                __HAL_TIM_CLEAR_IT(htim, TIM_IT_UPDATE);
+            }
+
             HAL_TIM_PeriodElapsedCallback(htim);
         }
     }
@@ -2848,6 +2896,77 @@ void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim)
     return;
 }
 
+/**
+ * @brief  This function handles TIM interrupts requests through the fast dispatch table.
+ * @note   SR and DIER are read once, all pending flags are cleared with one write
+ *         and the callbacks are called from the lowest bit (Update, CC1..CC4,
+ *         COM, Trigger, Break). It can be called directly from TIMx_IRQHandler().
+ * @param  htim : TIM  handle
+ * @retval None
+ */
+void HAL_TIM_FastIRQHandler(TIM_HandleTypeDef *htim)
+{
+    TIM_TypeDef                 *TIMx = htim->Instance;
+    const pTIM_CallbackTypeDef  *pCallbacks = htim->pFastCallbacks;
+    uint32_t                    pending = 0;
+
+    pending = TIMx->SR & TIMx->DIER & ((0x1UL << HAL_TIM_FAST_CB_NUM) - 1);
+
+    if((pending & TIM_FLAG_UPDATE) && TIMx == pTimestampTIM)
+    {
+        uint32_t primask = __get_PRIMASK();
+
+        /* Atomic for the timestamp readers in higher priority ISRs */
+        __disable_irq();
+        TIMx->SR = ~pending;
+        ullTimestampHigh += TIM_TIMESTAMP_PERIOD;
+        __set_PRIMASK(primask);
+    }
+    else
+    {
+        /* rc_w0, the flags raised after the read are kept */
+        TIMx->SR = ~pending;
+    }
+
+    while(pending)
+    {
+        uint32_t idx = (pending & 0xFUL)
+                     ? TIM_LowestBitTable[pending & 0xFUL]
+                     : 4 + TIM_LowestBitTable[(pending >> 4) & 0xFUL];
+
+        pending &= (pending - 1);
+
+        if(pCallbacks[idx])
+            pCallbacks[idx](htim);
+    }
+
+    return;
+}
+
+/**
+ * @brief  Register the fast dispatch table of the TIM interrupts.
+ * @note   Call it after the TIM initialization, the table must stay valid
+ *         while it is registered.
+ * @param  htim : TIM  handle
+ * @param  pCallbacks : Table of HAL_TIM_FAST_CB_NUM callbacks indexed by
+ *                      HAL_TIM_FastCallbackIdTypeDef (NULL items are skipped),
+ *                      NULL to go back to the weak callbacks
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_TIM_RegisterFastCallbacks(TIM_HandleTypeDef *htim, const pTIM_CallbackTypeDef *pCallbacks)
+{
+    if(htim == NULL)
+        return HAL_ERROR;
+
+    __HAL_LOCK(htim);
+
+    htim->pFastCallbacks = pCallbacks;
+
+    __HAL_UNLOCK(htim);
+
+    return HAL_OK;
+}
+
 /**
  * @}
  */
@@ -3966,6 +4085,196 @@ HAL_TIM_StateTypeDef HAL_TIM_Encoder_GetState(TIM_HandleTypeDef *htim)
     return htim->State;
 }
 
+/**
+ * @}
+ */
+
+/** @defgroup TIM_Exported_Functions_Group11 Timestamp functions
+ *  @brief   64-bits timestamp functions
+ *
+ @verbatim
+  ==============================================================================
+                        ##### Timestamp functions #####
+  ==============================================================================
+    [..]
+    TIM1 or TIM2 runs free at PCLK and HAL_TIM_IRQHandler() extends the 16-bits
+    counter with the update interrupt, so the TIM IRQ must be enabled in
+    HAL_TIM_Base_MspInit() and the TIMx_IRQHandler() must call HAL_TIM_IRQHandler().
+    (+) Start/Stop the timestamp counter.
+    (+) Read the 64-bits cycles or microseconds from any context.
+    (+) Calibrate the counter frequency against HAL_GetTick().
+
+ @endverbatim
+ * @{
+ */
+
+/**
+ * @brief  Update the cycles-to-microseconds multiplier
+ * @param  Freq : Counter frequency in Hz
+ * @retval None
+ */
+static void TIM_Timestamp_SetFreq(uint32_t Freq)
+{
+    uint64_t mul   = (1000000ULL << 44) / Freq;
+    uint32_t shift = 44;
+
+    /* Keep 32 significant bits for any frequency, floor() is preserved by the shift */
+    while(mul > 0xFFFFFFFFULL)
+    {
+        mul >>= 1;
+        shift--;
+    }
+
+    uwTimestampFreq    = Freq;
+    uwTimestampUsMul   = (uint32_t)mul;
+    uwTimestampUsShift = shift;
+}
+
+/**
+ * @brief  Start the free-running timestamp counter.
+ * @note   The time base parameters of the handle are overwritten.
+ * @param  htim : TIM handle, TIM1 or TIM2
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_TIM_Timestamp_Start(TIM_HandleTypeDef *htim)
+{
+    uint32_t freq = HAL_RCC_GetPCLKFreq();
+
+    if(htim == NULL || freq == 0)
+        return HAL_ERROR;
+
+    assert_param(IS_TIM_INSTANCE(htim->Instance));
+
+    htim->Init.Prescaler         = 0;
+    htim->Init.CounterMode       = TIM_COUNTERMODE_UP;
+    htim->Init.Period            = (uint32_t)(TIM_TIMESTAMP_PERIOD - 1);
+    htim->Init.ClockDivision     = TIM_CLOCKDIVISION_DIV1;
+    htim->Init.RepetitionCounter = 0;
+    htim->Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    if(HAL_TIM_Base_Init(htim) != HAL_OK)
+        return HAL_ERROR;
+
+    __disable_irq();
+    pTimestampTIM    = htim->Instance;
+    ullTimestampHigh = 0;
+    TIM_Timestamp_SetFreq(freq);
+    htim->Instance->CNT = 0;
+    __HAL_TIM_CLEAR_IT(htim, TIM_IT_UPDATE);
+    __enable_irq();
+
+    return HAL_TIM_Base_Start_IT(htim);
+}
+
+/**
+ * @brief  Stop the free-running timestamp counter.
+ * @param  htim : TIM handle
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_TIM_Timestamp_Stop(TIM_HandleTypeDef *htim)
+{
+    if(htim == NULL || htim->Instance != pTimestampTIM)
+        return HAL_ERROR;
+
+    pTimestampTIM = NULL;
+
+    return HAL_TIM_Base_Stop_IT(htim);
+}
+
+/**
+ * @brief  Calibrate the counter frequency against HAL_GetTick().
+ * @note   Useful when the tick comes from an independent clock
+ *         (e.g. the LXT tickless time base). It blocks for about Ms milliseconds.
+ * @param  Ms : Measurement window in milliseconds
+ * @retval HAL status
+ */
+HAL_StatusTypeDef HAL_TIM_Timestamp_Calibrate(uint32_t Ms)
+{
+    uint64_t cycles = 0;
+    uint32_t tickstart = 0;
+    uint64_t freq = 0;
+
+    if(pTimestampTIM == NULL || Ms == 0)
+        return HAL_ERROR;
+
+    /* Align to a tick edge */
+    tickstart = HAL_GetTick();
+    while(HAL_GetTick() == tickstart) {}
+
+    tickstart = HAL_GetTick();
+    cycles    = HAL_GetCycles64();
+
+    while((HAL_GetTick() - tickstart) < Ms) {}
+
+    cycles = HAL_GetCycles64() - cycles;
+    freq   = (cycles * 1000ULL) / Ms;
+
+    if(freq == 0 || freq > 0xFFFFFFFFULL)
+        return HAL_ERROR;
+
+    TIM_Timestamp_SetFreq((uint32_t)freq);
+    return HAL_OK;
+}
+
+/**
+ * @brief  Return the frequency of the timestamp counter
+ * @retval Frequency in Hz, 0 if the timestamp is not started
+ */
+uint32_t HAL_TIM_Timestamp_GetFreq(void)
+{
+    return (pTimestampTIM) ? uwTimestampFreq : 0;
+}
+
+/**
+ * @brief  Return the 64-bits count of timestamp cycles.
+ * @note   It is safe to call from any ISR, an overflow which is pending
+ *         (not yet serviced by HAL_TIM_IRQHandler) is accounted here.
+ * @retval Cycles since HAL_TIM_Timestamp_Start()
+ */
+uint64_t HAL_GetCycles64(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint64_t high    = 0;
+    uint32_t cnt     = 0;
+
+    if(pTimestampTIM == NULL)
+        return 0;
+
+    __disable_irq();
+
+    high = ullTimestampHigh;
+    cnt  = pTimestampTIM->CNT;
+
+    if(pTimestampTIM->SR & TIM_FLAG_UPDATE)
+    {
+        /* Re-read, the counter may have wrapped after the first read */
+        cnt   = pTimestampTIM->CNT;
+        high += TIM_TIMESTAMP_PERIOD;
+    }
+
+    __set_PRIMASK(primask);
+
+    return high + (cnt & 0xFFFFUL);
+}
+
+/**
+ * @brief  Return the 64-bits timestamp in microseconds.
+ * @note   The division is replaced by a fixed-point multiplication with
+ *         uwTimestampUsShift fraction bits (the 96-bits product is shifted).
+ * @retval Microseconds since HAL_TIM_Timestamp_Start()
+ */
+uint64_t HAL_GetMicros64(void)
+{
+    uint64_t cycles = HAL_GetCycles64();
+    uint64_t prod_hi = (uint64_t)(uint32_t)(cycles >> 32) * uwTimestampUsMul;
+    uint64_t prod_lo = (uint64_t)(uint32_t)cycles * uwTimestampUsMul;
+
+    if(uwTimestampUsShift >= 32)
+        return (prod_hi + (prod_lo >> 32)) >> (uwTimestampUsShift - 32);
+
+    return (prod_hi << (32 - uwTimestampUsShift)) + (prod_lo >> uwTimestampUsShift);
+}
+
 /**
  * @}
  */
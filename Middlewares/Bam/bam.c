@@ -0,0 +1,297 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file bam.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/20
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "bam.h"
+
+#if defined(HAL_BASETIM_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static Bam_TypeDef      *g_pBam = 0;
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  @brief  Precompute the port masks of all planes from the levels
+ *
+ *  @param [in] pBam        The BAM object
+ *  @param [in] buf         The buffer index
+ *  @return
+ *      None
+ */
+static void _Bam_BuildMasks(Bam_TypeDef *pBam, uint32_t buf)
+{
+    Bam_PortMaskTypeDef     (*pPlanes)[BAM_PORT_MAX] = pBam->Masks[buf];
+
+    memset(pPlanes, 0x0, sizeof(pBam->Masks[0]));
+
+    for(uint32_t ch = 0; ch < pBam->Init.ChannelNum; ch++)
+    {
+        uint32_t    port_idx = pBam->ChPortIdx[ch];
+        uint32_t    pin = pBam->Init.pChannels[ch].Pin;
+        uint32_t    level = pBam->Levels[ch];
+
+        if( pBam->Init.IsActiveLow )
+            level = ~level;
+
+        for(uint32_t b = 0; b < BAM_BITS; b++)
+        {
+            if( level & (0x1ul << b) )
+                pPlanes[b][port_idx].SetMask |= pin;
+            else
+                pPlanes[b][port_idx].ClrMask |= pin;
+        }
+    }
+
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the BAM engine, all channels are off
+ *
+ *  @param [in] pBam        The BAM object
+ *  @param [in] pInit       The configuration of the engine
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Bam_Init(Bam_TypeDef *pBam, Bam_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        BASETIM_HandleTypeDef   *hBASETIM = 0;
+        uint32_t                cnt_max = 0;
+        uint32_t                ch = 0;
+
+        if( !pBam || !pInit || !pInit->hBasetim || !pInit->pChannels || !pInit->BaseTicks ||
+            !pInit->ChannelNum || pInit->ChannelNum > BAM_CHANNEL_MAX )
+            break;
+
+        memset(pBam, 0x0, sizeof(Bam_TypeDef));
+        pBam->Init = *pInit;
+
+        for(ch = 0; ch < pInit->ChannelNum; ch++)
+        {
+            GPIO_TypeDef    *GPIOx = pInit->pChannels[ch].Port;
+            uint32_t        i = 0;
+
+            for(i = 0; i < pBam->PortNum && pBam->pPorts[i] != GPIOx; i++)
+                ;
+
+            if( i == pBam->PortNum )
+            {
+                if( pBam->PortNum == BAM_PORT_MAX )
+                    break;
+
+                pBam->pPorts[pBam->PortNum++] = GPIOx;
+            }
+
+            pBam->ChPortIdx[ch] = (uint8_t)i;
+        }
+
+        if( ch < pInit->ChannelNum )
+            break;
+
+        hBASETIM = pInit->hBasetim;
+        hBASETIM->Init.CntTimSel  = BASETIM_TIMER_SELECT;
+        hBASETIM->Init.AutoReload = BASETIM_AUTORELOAD_ENABLE;
+        hBASETIM->Init.OneShot    = BASETIM_REPEAT_MODE;
+        hBASETIM->Init.Period     = 0;
+        if( HAL_BASETIM_Base_Init(hBASETIM) != HAL_OK )
+            break;
+
+        cnt_max = (hBASETIM->Init.MaxCntLevel == BASETIM_MAXCNTLEVEL_32BIT)
+                ? BASETIM_MAXCNTVALUE_32BIT : BASETIM_MAXCNTVALUE_16BIT;
+
+        if( pInit->BaseTicks > (cnt_max >> (BAM_BITS - 1)) )
+            break;
+
+        /* the counter counts up from the load value and overflows at cnt_max */
+        for(uint32_t b = 0; b < BAM_BITS; b++)
+            pBam->PlaneLoad[b] = (cnt_max - (pInit->BaseTicks << b) + 1ul) & cnt_max;
+
+        _Bam_BuildMasks(pBam, 0);
+        _Bam_BuildMasks(pBam, 1);
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Start the modulation from the LSB plane
+ *
+ *  @param [in] pBam        The BAM object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Bam_Start(Bam_TypeDef *pBam)
+{
+    BASETIM_HandleTypeDef   *hBASETIM = 0;
+
+    if( !pBam || !pBam->PortNum || (g_pBam && g_pBam != pBam) )
+        return HAL_ERROR;
+
+    hBASETIM = pBam->Init.hBasetim;
+    g_pBam   = pBam;
+
+    if( pBam->IsPending )
+    {
+        pBam->ActiveBuf ^= 0x1;
+        pBam->IsPending  = 0;
+    }
+
+    pBam->Plane = 0;
+
+    /* the first ISR comes after one LSB plane, then BGLOAD reloads the plane durations */
+    __HAL_BASETIM_CLEAR_IT(hBASETIM);
+    WRITE_REG(hBASETIM->Instance->LOAD, pBam->PlaneLoad[0]);
+    WRITE_REG(hBASETIM->Instance->BGLOAD, pBam->PlaneLoad[0]);
+
+    return HAL_BASETIM_Base_Start_IT(hBASETIM);
+}
+
+/**
+ *  @brief  Stop the modulation, all channels are off
+ *
+ *  @param [in] pBam        The BAM object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Bam_Stop(Bam_TypeDef *pBam)
+{
+    if( !pBam || g_pBam != pBam )
+        return HAL_ERROR;
+
+    HAL_BASETIM_Base_Stop_IT(pBam->Init.hBasetim);
+    g_pBam = 0;
+
+    for(uint32_t ch = 0; ch < pBam->Init.ChannelNum; ch++)
+    {
+        const Bam_ChannelTypeDef    *pCh = &pBam->Init.pChannels[ch];
+
+        if( pBam->Init.IsActiveLow )
+            pCh->Port->ODSET = pCh->Pin;
+        else
+            pCh->Port->ODCLR = pCh->Pin;
+    }
+
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Set the level of a channel, it takes effect after Bam_Commit()
+ *
+ *  @param [in] pBam        The BAM object
+ *  @param [in] channel     Index of the channel table
+ *  @param [in] level       0 ~ BAM_LEVEL_MAX
+ *  @return
+ *      None
+ */
+void Bam_SetLevel(Bam_TypeDef *pBam, uint32_t channel, uint32_t level)
+{
+    if( channel >= pBam->Init.ChannelNum )
+        return;
+
+    pBam->Levels[channel] = (uint8_t)((level > BAM_LEVEL_MAX) ? BAM_LEVEL_MAX : level);
+    return;
+}
+
+/**
+ *  @brief  Build the masks of the levels in the back buffer,
+ *          the ISR swaps the buffers at the end of the current period
+ *
+ *  @param [in] pBam        The BAM object
+ *  @return
+ *      HAL status
+ *          HAL_BUSY: the previous commit is not swapped yet
+ */
+HAL_StatusTypeDef Bam_Commit(Bam_TypeDef *pBam)
+{
+    if( !pBam )
+        return HAL_ERROR;
+
+    if( pBam->IsPending )
+        return HAL_BUSY;
+
+    _Bam_BuildMasks(pBam, pBam->ActiveBuf ^ 0x1);
+
+    __DMB();
+    pBam->IsPending = 1;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  BASETIM ISR of the BAM engine,
+ *          call it from the BASETIM vector instead of HAL_BASETIM_IRQHandler()
+ *
+ *  @return
+ *      None
+ */
+void Bam_IRQHandler(void)
+{
+    Bam_TypeDef                 *pBam = g_pBam;
+    const Bam_PortMaskTypeDef   *pMask = 0;
+    GPIO_TypeDef * const        *ppPort = 0;
+    uint32_t                    plane = 0;
+
+    if( !pBam )
+        return;
+
+    __HAL_BASETIM_CLEAR_IT(pBam->Init.hBasetim);
+
+    plane  = pBam->Plane;
+    pMask  = pBam->Masks[pBam->ActiveBuf][plane];
+    ppPort = pBam->pPorts;
+
+    for(uint32_t i = pBam->PortNum; i > 0; i--, pMask++, ppPort++)
+    {
+        (*ppPort)->ODSET = pMask->SetMask;
+        (*ppPort)->ODCLR = pMask->ClrMask;
+    }
+
+    if( ++plane == BAM_BITS )
+    {
+        plane = 0;
+
+        if( pBam->IsPending )
+        {
+            pBam->ActiveBuf ^= 0x1;
+            pBam->IsPending  = 0;
+        }
+    }
+
+    /* the counter is reloaded with it at the end of the current plane */
+    WRITE_REG(pBam->Init.hBasetim->Instance->BGLOAD, pBam->PlaneLoad[plane]);
+    pBam->Plane = (uint8_t)plane;
+    return;
+}
+
+#endif /* HAL_BASETIM_MODULE_ENABLED */
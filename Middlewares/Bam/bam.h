@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file bam.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/20
+ * @license
+ * @description
+ *  Bit angle modulation (BAM) of GPIO channels driven by one BASETIM.
+ *
+ *  + A period has BAM_BITS bit-planes, plane b lasts (BaseTicks << b) counts.
+ *  + The ODSET/ODCLR masks of every plane and GPIO port are precomputed, the
+ *    ISR writes one ODSET and one ODCLR per used port, its cost only depends
+ *    on the number of ports.
+ *  + The duration of the next plane is written to BGLOAD, so the plane edges
+ *    are reloaded by hardware.
+ *  + Levels are double-buffered, Bam_Commit() rebuilds the masks in the back
+ *    buffer and the ISR swaps it at the end of a period.
+ */
+
+#ifndef __bam_H_r2KcP9wE_lFn6_HtXa_s3Qv_uM7gYs1dBjNe__
+#define __bam_H_r2KcP9wE_lFn6_HtXa_s3Qv_uM7gYs1dBjNe__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  Resolution of a level (1 ~ 8 bits)
+ */
+#ifndef BAM_BITS
+#define BAM_BITS                    8
+#endif
+
+#ifndef BAM_CHANNEL_MAX
+#define BAM_CHANNEL_MAX             32
+#endif
+
+/**
+ *  GPIOA ~ GPIOD
+ */
+#define BAM_PORT_MAX                4
+
+#define BAM_LEVEL_MAX               ((0x1ul << BAM_BITS) - 1)
+
+#if (BAM_BITS < 1) || (BAM_BITS > 8)
+#error "bam: BAM_BITS out of range !"
+#endif
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief A channel, the pin MUST be configured as output by user
+ */
+typedef struct Bam_Channel
+{
+    GPIO_TypeDef    *Port;
+    uint16_t        Pin;        /*!< GPIO_PIN_x, one pin */
+
+} Bam_ChannelTypeDef;
+
+/**
+ *  @brief Output masks of one port in one bit-plane
+ */
+typedef struct Bam_PortMask
+{
+    uint16_t    SetMask;
+    uint16_t    ClrMask;
+
+} Bam_PortMaskTypeDef;
+
+/**
+ *  @brief Initial configuration of the BAM engine
+ */
+typedef struct Bam_Init
+{
+    BASETIM_HandleTypeDef       *hBasetim;      /*!< Instance, clock and prescaler are set by user,
+                                                     the other fields are overwritten by Bam_Init() */
+
+    const Bam_ChannelTypeDef    *pChannels;     /*!< Channel table */
+    uint32_t                    ChannelNum;
+
+    uint32_t                    BaseTicks;      /*!< Counts of the LSB plane, it MUST be longer than the ISR */
+    uint32_t                    IsActiveLow;    /*!< 1: the output is low when a bit is set */
+
+} Bam_InitTypeDef;
+
+/**
+ *  @brief BAM object
+ */
+typedef struct Bam
+{
+    Bam_InitTypeDef         Init;
+
+    GPIO_TypeDef            *pPorts[BAM_PORT_MAX];          /*!< The used ports */
+    uint32_t                PortNum;
+    uint8_t                 ChPortIdx[BAM_CHANNEL_MAX];     /*!< Index of pPorts[] of a channel */
+
+    uint8_t                 Levels[BAM_CHANNEL_MAX];        /*!< Levels of the next commit */
+
+    Bam_PortMaskTypeDef     Masks[2][BAM_BITS][BAM_PORT_MAX];
+    uint32_t                PlaneLoad[BAM_BITS];            /*!< BGLOAD of every plane */
+
+    volatile uint8_t        ActiveBuf;
+    volatile uint8_t        IsPending;                      /*!< The back buffer waits the end of a period */
+    uint8_t                 Plane;                          /*!< The plane of the next ISR */
+
+} Bam_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef Bam_Init(Bam_TypeDef *pBam, Bam_InitTypeDef *pInit);
+HAL_StatusTypeDef Bam_Start(Bam_TypeDef *pBam);
+HAL_StatusTypeDef Bam_Stop(Bam_TypeDef *pBam);
+
+void Bam_SetLevel(Bam_TypeDef *pBam, uint32_t channel, uint32_t level);
+HAL_StatusTypeDef Bam_Commit(Bam_TypeDef *pBam);
+
+void Bam_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
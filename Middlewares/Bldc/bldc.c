@@ -0,0 +1,511 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file bldc.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/18
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "bldc.h"
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define BLDC_PHASE_NUM              3
+
+/**
+ *  The hall state which never matches, it forces the full register burst
+ */
+#define BLDC_HALL_NONE              BLDC_HALL_STATE_NUM
+
+#define BLDC_CCER_OUTPUT_MASK       (TIM_CCER_CC1E | TIM_CCER_CC1NE | \
+                                     TIM_CCER_CC2E | TIM_CCER_CC2NE | \
+                                     TIM_CCER_CC3E | TIM_CCER_CC3NE)
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _BLDC_READ_HALL(__pBldc__)      \
+            (((__pBldc__)->Init.HallPort->IDR >> (__pBldc__)->Init.HallPinShift) & 0x7ul)
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static Bldc_TypeDef         *g_pBldc = 0;
+
+/**
+ *  The forward step of the 120-degree hall sequence 5-4-6-2-3-1
+ */
+static const uint8_t        g_Bldc_DefHallToStep[BLDC_HALL_STATE_NUM] =
+{
+    BLDC_STEP_INVALID, 5, 3, 4, 1, 0, 2, BLDC_STEP_INVALID,
+};
+
+/**
+ *  { high-side phase, low-side phase } of a step
+ */
+static const uint8_t        g_Bldc_StepPhase[BLDC_STEP_NUM][2] =
+{
+    {0, 1}, {0, 2}, {1, 2}, {1, 0}, {2, 0}, {2, 1},
+};
+
+static void _Bldc_BreakISR(TIM_HandleTypeDef *htim);
+static void _Bldc_HallCaptureISR(TIM_HandleTypeDef *htim);
+
+static const pTIM_CallbackTypeDef   g_Bldc_FastCallbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_BREAK] = _Bldc_BreakISR,
+};
+
+static const pTIM_CallbackTypeDef   g_Bldc_HallFastCallbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_CC1] = _Bldc_HallCaptureISR,
+};
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  @brief  Precompute the register burst of every hall state for both directions
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @param [in] pMap        The forward step of every hall state
+ *  @param [in] ccmr2_keep  CCMR2 bits of CH4
+ *  @return
+ *      HAL status
+ */
+static HAL_StatusTypeDef
+_Bldc_BuildTable(Bldc_TypeDef *pBldc, const uint8_t *pMap, uint32_t ccmr2_keep)
+{
+    uint8_t     step_to_hall[BLDC_STEP_NUM];
+
+    memset(step_to_hall, BLDC_HALL_NONE, sizeof(step_to_hall));
+
+    for(uint32_t hall = 0; hall < BLDC_HALL_STATE_NUM; hall++)
+    {
+        if( pMap[hall] == BLDC_STEP_INVALID )
+            continue;
+
+        if( pMap[hall] >= BLDC_STEP_NUM || step_to_hall[pMap[hall]] != BLDC_HALL_NONE )
+            return HAL_ERROR;
+
+        step_to_hall[pMap[hall]] = (uint8_t)hall;
+    }
+
+    for(uint32_t i = 0; i < BLDC_STEP_NUM; i++)
+    {
+        if( step_to_hall[i] == BLDC_HALL_NONE )
+            return HAL_ERROR;
+    }
+
+    for(uint32_t dir = 0; dir < 2; dir++)
+    {
+        for(uint32_t hall = 0; hall < BLDC_HALL_STATE_NUM; hall++)
+        {
+            Bldc_StepTypeDef    *pStep = &pBldc->Table[dir][hall];
+            uint32_t            oc_mode[BLDC_PHASE_NUM];
+            uint32_t            ccer = pBldc->CCERIdle;
+            uint32_t            step = pMap[hall];
+
+            for(uint32_t ph = 0; ph < BLDC_PHASE_NUM; ph++)
+                oc_mode[ph] = TIM_OCMODE_FORCED_INACTIVE;
+
+            if( step == BLDC_STEP_INVALID )
+            {
+                /* all phases floating, stay here until a valid hall state */
+                pStep->NextHall = (uint8_t)hall;
+                pStep->IsValid  = 0;
+            }
+            else
+            {
+                uint32_t    hi = 0, lo = 0;
+
+                /* the reverse torque is the opposite step, the rotor moves to the previous hall state */
+                pStep->NextHall = (dir == BLDC_DIR_FORWARD)
+                                ? step_to_hall[(step + 1) % BLDC_STEP_NUM]
+                                : step_to_hall[(step + BLDC_STEP_NUM - 1) % BLDC_STEP_NUM];
+                pStep->IsValid  = 1;
+
+                if( dir == BLDC_DIR_REVERSE )
+                    step = (step + (BLDC_STEP_NUM >> 1)) % BLDC_STEP_NUM;
+
+                hi = g_Bldc_StepPhase[step][0];
+                lo = g_Bldc_StepPhase[step][1];
+
+                /* high-side: complementary PWM with dead time */
+                oc_mode[hi] = TIM_OCMODE_PWM1;
+                ccer |= (TIM_CCER_CC1E | TIM_CCER_CC1NE) << (hi << 2);
+
+                /* low-side: only OCxN enabled, it follows OCxREF which is forced active */
+                oc_mode[lo] = TIM_OCMODE_FORCED_ACTIVE;
+                ccer |= TIM_CCER_CC1NE << (lo << 2);
+            }
+
+            pStep->CCER  = (uint16_t)ccer;
+            pStep->CCMR1 = (uint16_t)((oc_mode[0] | TIM_CCMR1_OUT_OC1PE) |
+                                      ((oc_mode[1] << 8) | TIM_CCMR1_OUT_OC2PE));
+            pStep->CCMR2 = (uint16_t)((oc_mode[2] | TIM_CCMR2_OUT_OC3PE) | ccmr2_keep);
+        }
+    }
+
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Commutate to a hall state and preload the step of the next one.
+ *          It MUST be called with the hall/break interrupts masked.
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @param [in] hall        The current hall state
+ *  @return
+ *      None
+ */
+static void _Bldc_Commutate(Bldc_TypeDef *pBldc, uint32_t hall)
+{
+    TIM_TypeDef             *TIMx = pBldc->Init.htim->Instance;
+    const Bldc_StepTypeDef  *pStep = &pBldc->pTable[hall];
+
+    if( hall != pBldc->ExpectedHall )
+    {
+        /* missed or bounced edge, load the step of this hall state */
+        TIMx->CCMR1_OUT = pStep->CCMR1;
+        TIMx->CCMR2_OUT = pStep->CCMR2;
+        TIMx->CCER      = pStep->CCER;
+    }
+
+    /* all three phases switch at once */
+    TIMx->EGR = TIM_EGR_COMG;
+
+    pBldc->Hall = (uint8_t)hall;
+    pBldc->CommutationCnt++;
+
+    if( !pStep->IsValid )
+        pBldc->HallErrorCnt++;
+
+    /* preload the next step, the next hall edge only needs COMG */
+    pBldc->ExpectedHall = pStep->NextHall;
+    pStep = &pBldc->pTable[pStep->NextHall];
+
+    TIMx->CCMR1_OUT = pStep->CCMR1;
+    TIMx->CCMR2_OUT = pStep->CCMR2;
+    TIMx->CCER      = pStep->CCER;
+    return;
+}
+
+/**
+ *  @brief  Commutate to the current hall state (start, direction change, fault recovery)
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @return
+ *      None
+ */
+static void _Bldc_Resync(Bldc_TypeDef *pBldc)
+{
+    uint32_t    primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    pBldc->ExpectedHall = BLDC_HALL_NONE;
+    _Bldc_Commutate(pBldc, _BLDC_READ_HALL(pBldc));
+
+    __set_PRIMASK(primask);
+    return;
+}
+
+/**
+ *  @brief  TIM1 break ISR, the outputs are already off by hardware (MOE cleared)
+ *
+ *  @param [in] htim        TIM handle
+ *  @return
+ *      None
+ */
+static void _Bldc_BreakISR(TIM_HandleTypeDef *htim)
+{
+    Bldc_TypeDef    *pBldc = g_pBldc;
+
+    /* BIF is set again as long as the break input is active */
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_BREAK);
+
+    pBldc->State = BLDC_STATE_FAULT;
+
+    if( pBldc->Init.pfFaultCallback )
+        pBldc->Init.pfFaultCallback(pBldc);
+
+    return;
+}
+
+/**
+ *  @brief  TIM2 CH1 capture ISR, a hall edge on the XOR input
+ *
+ *  @param [in] htim        TIM handle
+ *  @return
+ *      None
+ */
+static void _Bldc_HallCaptureISR(TIM_HandleTypeDef *htim)
+{
+    Bldc_TypeDef    *pBldc = g_pBldc;
+
+    if( pBldc->State != BLDC_STATE_RUN )
+        return;
+
+    _Bldc_Commutate(pBldc, _BLDC_READ_HALL(pBldc));
+
+    pBldc->LatencyTicks = (uint16_t)(htim->Instance->CNT - htim->Instance->CCR1);
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the commutation, it MUST be called after the TIM1 PWM
+ *          configuration (CH4 of TIM1 is kept as configured)
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @param [in] pInit       The configuration of the commutation
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Bldc_Init(Bldc_TypeDef *pBldc, Bldc_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        TIM_TypeDef     *TIMx = 0;
+
+        if( !pBldc || !pInit || !pInit->htim || !pInit->HallPort || pInit->HallPinShift > 13 )
+            break;
+
+        if( pInit->HallSrc == BLDC_HALL_SRC_TIM && !pInit->htimHall )
+            break;
+
+        memset(pBldc, 0x0, sizeof(Bldc_TypeDef));
+        pBldc->Init = *pInit;
+
+        TIMx = pInit->htim->Instance;
+
+        pBldc->CCERIdle = (uint16_t)(TIMx->CCER & ~BLDC_CCER_OUTPUT_MASK);
+
+        status = _Bldc_BuildTable(pBldc, (pInit->pHallToStep) ? pInit->pHallToStep : g_Bldc_DefHallToStep,
+                                  TIMx->CCMR2_OUT & 0xFF00ul);
+        if( status != HAL_OK )
+            break;
+
+        pBldc->pTable       = pBldc->Table[BLDC_DIR_FORWARD];
+        pBldc->ExpectedHall = BLDC_HALL_NONE;
+        pBldc->State        = BLDC_STATE_IDLE;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Start the motor, the outputs are enabled at the current hall state
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @param [in] dir         Bldc_DirTypeDef
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Bldc_Start(Bldc_TypeDef *pBldc, Bldc_DirTypeDef dir)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        TIM_HandleTypeDef   *htim = 0;
+
+        if( !pBldc || !pBldc->pTable || pBldc->State != BLDC_STATE_IDLE )
+            break;
+
+        if( g_pBldc && g_pBldc != pBldc && g_pBldc->State != BLDC_STATE_IDLE )
+        {
+            status = HAL_BUSY;
+            break;
+        }
+
+        g_pBldc = pBldc;
+        htim    = pBldc->Init.htim;
+
+        pBldc->Dir    = (uint8_t)dir;
+        pBldc->pTable = pBldc->Table[dir & 0x1];
+
+        /* CCxE/CCxNE/OCxM are preloaded, COMG by software only */
+        SET_BIT(htim->Instance->CR2, TIM_CR2_CCPC);
+        CLEAR_BIT(htim->Instance->CR2, TIM_CR2_CCUS);
+
+        Bldc_SetDuty(pBldc, pBldc->Init.Duty);
+
+        HAL_TIM_RegisterFastCallbacks(htim, g_Bldc_FastCallbacks);
+        __HAL_TIM_CLEAR_IT(htim, TIM_IT_BREAK);
+        __HAL_TIM_ENABLE_IT(htim, TIM_IT_BREAK);
+        __HAL_TIM_ENABLE(htim);
+
+        pBldc->State = BLDC_STATE_RUN;
+        _Bldc_Resync(pBldc);
+
+        if( pBldc->Init.HallSrc == BLDC_HALL_SRC_TIM )
+        {
+            TIM_HandleTypeDef   *htimHall = pBldc->Init.htimHall;
+
+            /* TI1 is the XOR of CH1/CH2/CH3 */
+            SET_BIT(htimHall->Instance->CR2, TIM_CR2_TI1S);
+
+            HAL_TIM_RegisterFastCallbacks(htimHall, g_Bldc_HallFastCallbacks);
+            HAL_TIM_IC_Start_IT(htimHall, TIM_CHANNEL_1);
+        }
+        else
+        {
+            __HAL_GPIO_EXTI_CLEAR_FLAG(pBldc->Init.HallPort, 0x7ul << pBldc->Init.HallPinShift);
+        }
+
+        __HAL_TIM_MOE_ENABLE(htim);
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Stop the motor, all phases are floating
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Bldc_Stop(Bldc_TypeDef *pBldc)
+{
+    TIM_HandleTypeDef   *htim = 0;
+
+    if( !pBldc || !pBldc->Init.htim )
+        return HAL_ERROR;
+
+    htim = pBldc->Init.htim;
+
+    __HAL_TIM_MOE_DISABLE_UNCONDITIONALLY(htim);
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_BREAK);
+
+    if( pBldc->Init.HallSrc == BLDC_HALL_SRC_TIM )
+    {
+        HAL_TIM_IC_Stop_IT(pBldc->Init.htimHall, TIM_CHANNEL_1);
+        HAL_TIM_RegisterFastCallbacks(pBldc->Init.htimHall, NULL);
+    }
+
+    pBldc->State = BLDC_STATE_IDLE;
+
+    htim->Instance->CCER = pBldc->CCERIdle;
+    htim->Instance->EGR  = TIM_EGR_COMG;
+
+    HAL_TIM_RegisterFastCallbacks(htim, NULL);
+
+    pBldc->ExpectedHall = BLDC_HALL_NONE;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Change the direction, it takes effect immediately
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @param [in] dir         Bldc_DirTypeDef
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Bldc_SetDirection(Bldc_TypeDef *pBldc, Bldc_DirTypeDef dir)
+{
+    if( !pBldc || !pBldc->pTable )
+        return HAL_ERROR;
+
+    pBldc->Dir    = (uint8_t)dir;
+    pBldc->pTable = pBldc->Table[dir & 0x1];
+
+    if( pBldc->State == BLDC_STATE_RUN )
+        _Bldc_Resync(pBldc);
+
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Set the duty of the high-side PWM, it takes effect at the next update event
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @param [in] duty        CCR value (0 ~ ARR)
+ *  @return
+ *      None
+ */
+void Bldc_SetDuty(Bldc_TypeDef *pBldc, uint16_t duty)
+{
+    TIM_TypeDef     *TIMx = pBldc->Init.htim->Instance;
+
+    TIMx->CCR1 = duty;
+    TIMx->CCR2 = duty;
+    TIMx->CCR3 = duty;
+    return;
+}
+
+/**
+ *  @brief  Recover from a break, the outputs are enabled again at the current hall state
+ *
+ *  @param [in] pBldc       The BLDC object
+ *  @return
+ *      HAL status
+ *          HAL_BUSY: the break input is still active
+ */
+HAL_StatusTypeDef Bldc_ClearFault(Bldc_TypeDef *pBldc)
+{
+    TIM_HandleTypeDef   *htim = 0;
+
+    if( !pBldc || pBldc->State != BLDC_STATE_FAULT )
+        return HAL_ERROR;
+
+    htim = pBldc->Init.htim;
+
+    __HAL_TIM_CLEAR_IT(htim, TIM_IT_BREAK);
+    if( __HAL_TIM_GET_FLAG(htim, TIM_FLAG_BREAK) )
+        return HAL_BUSY;
+
+    __HAL_TIM_ENABLE_IT(htim, TIM_IT_BREAK);
+
+    pBldc->State = BLDC_STATE_RUN;
+    _Bldc_Resync(pBldc);
+
+    __HAL_TIM_MOE_ENABLE(htim);
+    return HAL_OK;
+}
+
+/**
+ *  @brief  GPIO EXTI handler of the hall pins (BLDC_HALL_SRC_EXTI),
+ *          call it from the GPIO vector of the hall port
+ *
+ *  @return
+ *      None
+ */
+void Bldc_HallIRQHandler(void)
+{
+    Bldc_TypeDef    *pBldc = g_pBldc;
+    GPIO_TypeDef    *GPIOx = 0;
+    uint32_t        hall = 0;
+
+    if( !pBldc )
+        return;
+
+    GPIOx = pBldc->Init.HallPort;
+    hall  = (GPIOx->IDR >> pBldc->Init.HallPinShift) & 0x7ul;
+
+    /* commutate first, the flags are cleared after the outputs changed */
+    if( pBldc->State == BLDC_STATE_RUN )
+        _Bldc_Commutate(pBldc, hall);
+
+    __HAL_GPIO_EXTI_CLEAR_FLAG(GPIOx, 0x7ul << pBldc->Init.HallPinShift);
+    return;
+}
+
+#endif /* HAL_TIM_MODULE_ENABLED */
@@ -0,0 +1,173 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file bldc.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/18
+ * @license
+ * @description
+ *  Hall sensor six-step (trapezoidal) BLDC commutation on the complementary
+ *  outputs of TIM1, phase U/V/W are CH1/CH2/CH3.
+ *
+ *  + The CCER/CCMR1/CCMR2 values of every hall state are precomputed for both
+ *    directions at Bldc_Init().
+ *  + CCxE/CCxNE/OCxM are preloaded (TIM1 CR2.CCPC), the step of the expected
+ *    next hall state is written in advance, so a hall edge only costs one
+ *    COMG write to switch all three phases at once.
+ *  + The break input (BKIN) shuts the outputs down by hardware (MOE is cleared),
+ *    the service only reports it and waits Bldc_ClearFault().
+ *  + With the TIM hall source, the hall edge is captured by TIM2 CH1 (TI1 is the
+ *    XOR of CH1/CH2/CH3) and the latency from the edge to the COMG write is
+ *    reported in TIM2 counts.
+ *
+ *  The hall signals MUST be 3 consecutive pins of one GPIO port (A, B, C).
+ */
+
+#ifndef __bldc_H_e6NwT1pZ_lCs4_HyKb_s9Gm_uV2dQr8xJhAu__
+#define __bldc_H_e6NwT1pZ_lCs4_HyKb_s9Gm_uV2dQr8xJhAu__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define BLDC_HALL_STATE_NUM         8
+
+/**
+ *  Step index of a hall state in the table of Bldc_InitTypeDef.pHallToStep
+ *      step 0: U+ V-, step 1: U+ W-, step 2: V+ W-,
+ *      step 3: V+ U-, step 4: W+ U-, step 5: W+ V-
+ */
+#define BLDC_STEP_NUM               6
+#define BLDC_STEP_INVALID           0xFF
+
+typedef enum Bldc_HallSrc
+{
+    BLDC_HALL_SRC_EXTI      = 0,    /*!< GPIO EXTI of the hall pins, call Bldc_HallIRQHandler() from the GPIO vector */
+    BLDC_HALL_SRC_TIM,              /*!< TIM2 CH1 input capture (both edges) on the XOR of the hall pins */
+
+} Bldc_HallSrcTypeDef;
+
+typedef enum Bldc_Dir
+{
+    BLDC_DIR_FORWARD        = 0,
+    BLDC_DIR_REVERSE,
+
+} Bldc_DirTypeDef;
+
+typedef enum Bldc_State
+{
+    BLDC_STATE_IDLE         = 0,
+    BLDC_STATE_RUN,
+    BLDC_STATE_FAULT,               /*!< Break input, the outputs are off */
+
+} Bldc_StateTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+struct Bldc;
+
+/**
+ *  @brief Fault callback, it is executed in the TIM1 ISR
+ */
+typedef void (*Bldc_CallbackTypeDef)(struct Bldc *pBldc);
+
+/**
+ *  @brief Initial configuration of the commutation
+ */
+typedef struct Bldc_Init
+{
+    TIM_HandleTypeDef       *htim;          /*!< TIM1 handle, initialized by HAL_TIM_PWM_Init(),
+                                                 dead time and break by HAL_TIM_ConfigBreakDeadTime()
+                                                 (AutomaticOutput MUST be disabled) */
+
+    Bldc_HallSrcTypeDef     HallSrc;
+    GPIO_TypeDef            *HallPort;      /*!< GPIO port of the hall pins */
+    uint32_t                HallPinShift;   /*!< Pin number of hall A, hall B/C are the next pins */
+    TIM_HandleTypeDef       *htimHall;      /*!< TIM2 handle of BLDC_HALL_SRC_TIM, CH1 configured as input
+                                                 capture of TI1 with TIM_ICPOLARITY_BOTHEDGE */
+
+    const uint8_t           *pHallToStep;   /*!< BLDC_HALL_STATE_NUM entries, the forward step of a hall state,
+                                                 NULL: the default 120-degree sequence 5-4-6-2-3-1 */
+
+    uint16_t                Duty;           /*!< Initial CCR of the high-side PWM */
+
+    Bldc_CallbackTypeDef    pfFaultCallback;
+    void                    *pUserData;
+
+} Bldc_InitTypeDef;
+
+/**
+ *  @brief Register burst of one hall state
+ */
+typedef struct Bldc_Step
+{
+    uint16_t    CCER;
+    uint16_t    CCMR1;
+    uint16_t    CCMR2;
+    uint8_t     NextHall;       /*!< The expected next hall state */
+    uint8_t     IsValid;
+
+} Bldc_StepTypeDef;
+
+/**
+ *  @brief BLDC object
+ */
+typedef struct Bldc
+{
+    Bldc_InitTypeDef        Init;
+
+    Bldc_StepTypeDef        Table[2][BLDC_HALL_STATE_NUM];  /*!< [direction][hall state] */
+    const Bldc_StepTypeDef  *pTable;                        /*!< Table of the current direction */
+    uint16_t                CCERIdle;                       /*!< CCER with CH1~CH3 outputs disabled */
+
+    volatile uint8_t        State;          /*!< Bldc_StateTypeDef */
+    volatile uint8_t        Dir;            /*!< Bldc_DirTypeDef */
+    volatile uint8_t        Hall;           /*!< The last hall state */
+    volatile uint8_t        ExpectedHall;   /*!< The hall state of the preloaded step */
+
+    volatile uint16_t       LatencyTicks;   /*!< BLDC_HALL_SRC_TIM: TIM2 counts from the hall edge to COMG */
+    volatile uint32_t       CommutationCnt;
+    volatile uint32_t       HallErrorCnt;   /*!< Invalid hall state (000 or 111) */
+
+} Bldc_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef Bldc_Init(Bldc_TypeDef *pBldc, Bldc_InitTypeDef *pInit);
+HAL_StatusTypeDef Bldc_Start(Bldc_TypeDef *pBldc, Bldc_DirTypeDef dir);
+HAL_StatusTypeDef Bldc_Stop(Bldc_TypeDef *pBldc);
+
+HAL_StatusTypeDef Bldc_SetDirection(Bldc_TypeDef *pBldc, Bldc_DirTypeDef dir);
+void Bldc_SetDuty(Bldc_TypeDef *pBldc, uint16_t duty);
+
+HAL_StatusTypeDef Bldc_ClearFault(Bldc_TypeDef *pBldc);
+
+void Bldc_HallIRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,426 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file clk_profile.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "clk_profile.h"
+
+#if defined(HAL_RCC_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+/**
+ *  The polling count of the SYSCLK switching status, the interrupts are
+ *  disabled (no HAL_GetTick()). A switching takes a few cycles of the
+ *  slowest source (SIRC 38.4 KHz, about 2000 cycles of HCLK 24 MHz).
+ */
+#define CLK_PROFILE_SWITCH_LOOPS        20000ul
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct clk_profile_dev
+{
+    const ClkProfile_TypeDef    *pCurrent;
+    ClkProfile_ListenerTypeDef  *pListeners;
+
+    HAL_TickFreqTypeDef         TickFreq;   /*!< Tick frequency of the fast clocks */
+
+} clk_profile_dev_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+const ClkProfile_TypeDef    g_ClkProfile_Full24M =
+{
+    .pName         = "full-24M",
+    .SysClkSource  = RCC_SYSCLKSOURCE_HIRC,
+    .HircFreq      = HIRC_VALUE_24M,
+    .AHBCLKDivider = RCC_HCLK_DIV1,
+    .APBCLKDivider = RCC_PCLK_DIV1,
+    .IsHircOff     = 0,
+};
+
+const ClkProfile_TypeDef    g_ClkProfile_Idle4M =
+{
+    .pName         = "idle-4M",
+    .SysClkSource  = RCC_SYSCLKSOURCE_HIRC,
+    .HircFreq      = HIRC_VALUE_4M,
+    .AHBCLKDivider = RCC_HCLK_DIV1,
+    .APBCLKDivider = RCC_PCLK_DIV1,
+    .IsHircOff     = 0,
+};
+
+const ClkProfile_TypeDef    g_ClkProfile_Sirc =
+{
+    .pName         = "sirc-38K4",
+    .SysClkSource  = RCC_SYSCLKSOURCE_SIRC,
+    .HircFreq      = 0,
+    .AHBCLKDivider = RCC_HCLK_DIV1,
+    .APBCLKDivider = RCC_PCLK_DIV1,
+    .IsHircOff     = 1,
+};
+
+static clk_profile_dev_t    g_ClkProfile_Dev;
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static uint32_t _ClkProfile_HircCalibration(uint32_t freq)
+{
+    switch( freq )
+    {
+        case HIRC_VALUE_24M:    return RCC_HIRCCALIBRATION_24M;
+        case HIRC_VALUE_22M:    return RCC_HIRCCALIBRATION_22M;
+        case HIRC_VALUE_16M:    return RCC_HIRCCALIBRATION_16M;
+        case HIRC_VALUE_8M:     return RCC_HIRCCALIBRATION_8M;
+        case HIRC_VALUE_4M:     return RCC_HIRCCALIBRATION_4M;
+        default:                break;
+    }
+    return 0;
+}
+
+static void _ClkProfile_Notify(ClkProfile_ListenerTypeDef *pEnd, uint32_t event, const ClkProfile_TypeDef *pProfile)
+{
+    for(ClkProfile_ListenerTypeDef *pCur = g_ClkProfile_Dev.pListeners; pCur != pEnd; pCur = pCur->pNext)
+        pCur->pfCallback(pCur, event, pProfile);
+
+    return;
+}
+
+/**
+ *  @brief  Start the oscillator of the profile, it waits the ready flag with
+ *          HAL_GetTick() and MUST be called with the interrupts enabled
+ */
+static HAL_StatusTypeDef _ClkProfile_StartOsc(const ClkProfile_TypeDef *pProfile)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        if( pProfile->SysClkSource == RCC_SYSCLKSOURCE_HIRC )
+        {
+            RCC_OscInitTypeDef  osc = {0};
+
+            osc.HIRCCalibrationValue = _ClkProfile_HircCalibration(pProfile->HircFreq);
+            if( !osc.HIRCCalibrationValue )
+                break;
+
+            /* HIRC is the SYSCLK source, the trim is changed in the critical section */
+            if( __HAL_RCC_GET_SYSCLK_SOURCE() == RCC_SYSCLKSOURCE_STATUS_HIRC )
+            {
+                status = HAL_OK;
+                break;
+            }
+
+            osc.OscillatorType = RCC_OSCILLATORTYPE_HIRC;
+            osc.HIRCState      = RCC_HIRC_ON;
+            status = HAL_RCC_OscConfig(&osc);
+        }
+        else if( pProfile->SysClkSource == RCC_SYSCLKSOURCE_SIRC )
+        {
+            uint32_t    tickstart = HAL_GetTick();
+
+            __HAL_RCC_SIRC_ENABLE();
+
+            while( __HAL_RCC_GET_FLAG(RCC_FLAG_SIRCRDY) == RESET )
+            {
+                if( (HAL_GetTick() - tickstart) > SIRC_TIMEOUT_VALUE )
+                    break;
+            }
+
+            status = (__HAL_RCC_GET_FLAG(RCC_FLAG_SIRCRDY) == RESET) ? HAL_TIMEOUT : HAL_OK;
+        }
+        else if( pProfile->SysClkSource == RCC_SYSCLKSOURCE_HXT )
+        {
+            status = (__HAL_RCC_GET_FLAG(RCC_FLAG_HXTRDY) == RESET) ? HAL_ERROR : HAL_OK;
+        }
+        else if( pProfile->SysClkSource == RCC_SYSCLKSOURCE_LXT )
+        {
+            status = (__HAL_RCC_GET_FLAG(RCC_FLAG_LXTRDY) == RESET) ? HAL_ERROR : HAL_OK;
+        }
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Switch the clocks, it is called with the interrupts disabled
+ */
+static HAL_StatusTypeDef _ClkProfile_Apply(const ClkProfile_TypeDef *pProfile)
+{
+    RCC_ClkInitTypeDef  clk = {0};
+
+    if( pProfile->SysClkSource == RCC_SYSCLKSOURCE_HIRC &&
+        __HAL_RCC_GET_SYSCLK_SOURCE() == RCC_SYSCLKSOURCE_STATUS_HIRC )
+    {
+        uint32_t    calibration = _ClkProfile_HircCalibration(pProfile->HircFreq);
+
+        __HAL_RCC_HIRC_CALIBRATIONVALUE_ADJUST(calibration);
+    }
+
+    /**
+     *  HAL_RCC_ClockConfig() waits the switching with HAL_GetTick(), which
+     *  does not advance here. Switch and poll the status with a bounded
+     *  count first, then HAL_RCC_ClockConfig() finds SYSCLK switched.
+     */
+    if( __HAL_RCC_GET_SYSCLK_SOURCE() != pProfile->SysClkSource )
+    {
+        uint32_t    prev_source = __HAL_RCC_GET_SYSCLK_SOURCE();
+        uint32_t    loops = CLK_PROFILE_SWITCH_LOOPS;
+
+        __HAL_RCC_SYSCLK_CONFIG(pProfile->SysClkSource);
+
+        while( __HAL_RCC_GET_SYSCLK_SOURCE() != pProfile->SysClkSource && --loops )
+            __NOP();
+
+        if( !loops )
+        {
+            __HAL_RCC_SYSCLK_CONFIG(prev_source);
+            return HAL_TIMEOUT;
+        }
+    }
+
+    clk.ClockType     = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_PCLK;
+    clk.SYSCLKSource  = pProfile->SysClkSource;
+    clk.AHBCLKDivider = pProfile->AHBCLKDivider;
+    clk.APBCLKDivider = pProfile->APBCLKDivider;
+
+    if( HAL_RCC_ClockConfig(&clk) != HAL_OK )
+        return HAL_ERROR;
+
+    /* HAL_RCC_ClockConfig() lowers the tick frequency for SIRC/LXT only */
+    if( pProfile->SysClkSource != RCC_SYSCLKSOURCE_SIRC &&
+        pProfile->SysClkSource != RCC_SYSCLKSOURCE_LXT &&
+        uwTickFreq != g_ClkProfile_Dev.TickFreq )
+    {
+        HAL_SetTickFreq(g_ClkProfile_Dev.TickFreq);
+    }
+
+    if( pProfile->IsHircOff && pProfile->SysClkSource != RCC_SYSCLKSOURCE_HIRC )
+        __HAL_RCC_HIRC_DISABLE();
+
+    return HAL_OK;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the profile manager, the clocks are configured with
+ *          the initial profile (no listener is notified)
+ *
+ *  @param [in] pProfile    The initial profile
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef ClkProfile_Init(const ClkProfile_TypeDef *pProfile)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        uint32_t    primask = 0;
+
+        if( !pProfile )
+            break;
+
+        memset(&g_ClkProfile_Dev, 0x0, sizeof(g_ClkProfile_Dev));
+        g_ClkProfile_Dev.TickFreq = HAL_GetTickFreq();
+
+        /* the tick frequency of the fast clocks is unknown when started from SIRC/LXT */
+        if( __HAL_RCC_GET_SYSCLK_SOURCE() == RCC_SYSCLKSOURCE_STATUS_SIRC ||
+            __HAL_RCC_GET_SYSCLK_SOURCE() == RCC_SYSCLKSOURCE_STATUS_LXT )
+            g_ClkProfile_Dev.TickFreq = HAL_TICK_FREQ_DEFAULT;
+
+        if( (status = _ClkProfile_StartOsc(pProfile)) != HAL_OK )
+            break;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        status = _ClkProfile_Apply(pProfile);
+
+        __set_PRIMASK(primask);
+
+        if( status == HAL_OK )
+            g_ClkProfile_Dev.pCurrent = pProfile;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Register a listener, it is notified in the order of registration
+ *
+ *  @param [in] pListener       The listener
+ *  @param [in] pfCallback      The callback
+ *  @param [in] pUserData       The user data (e.g. a driver handle)
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef ClkProfile_Register(ClkProfile_ListenerTypeDef *pListener, ClkProfile_CallbackTypeDef pfCallback, void *pUserData)
+{
+    ClkProfile_ListenerTypeDef  **ppCur = &g_ClkProfile_Dev.pListeners;
+
+    if( !pListener || !pfCallback )
+        return HAL_ERROR;
+
+    while( *ppCur )
+    {
+        if( *ppCur == pListener )
+            return HAL_ERROR;
+
+        ppCur = &(*ppCur)->pNext;
+    }
+
+    pListener->pNext      = 0;
+    pListener->pfCallback = pfCallback;
+    pListener->pUserData  = pUserData;
+
+    *ppCur = pListener;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Unregister a listener
+ *
+ *  @param [in] pListener       The listener
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef ClkProfile_Unregister(ClkProfile_ListenerTypeDef *pListener)
+{
+    ClkProfile_ListenerTypeDef  **ppCur = &g_ClkProfile_Dev.pListeners;
+
+    while( *ppCur )
+    {
+        if( *ppCur == pListener )
+        {
+            *ppCur = pListener->pNext;
+            pListener->pNext = 0;
+            return HAL_OK;
+        }
+
+        ppCur = &(*ppCur)->pNext;
+    }
+
+    return HAL_ERROR;
+}
+
+/**
+ *  @brief  Switch to a profile
+ *
+ *  @param [in] pProfile    The target profile
+ *  @return
+ *      HAL_OK: switched,
+ *      HAL_BUSY: vetoed by a listener,
+ *      others: the oscillator is not ready or the switching fails (the clocks
+ *              are not changed and the listeners get CLK_PROFILE_EVENT_ABORT)
+ */
+HAL_StatusTypeDef ClkProfile_Switch(const ClkProfile_TypeDef *pProfile)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        ClkProfile_ListenerTypeDef  *pCur = 0;
+        uint32_t                    primask = 0;
+
+        if( !pProfile )
+            break;
+
+        if( pProfile == g_ClkProfile_Dev.pCurrent )
+        {
+            status = HAL_OK;
+            break;
+        }
+
+        for(pCur = g_ClkProfile_Dev.pListeners; pCur; pCur = pCur->pNext)
+        {
+            if( pCur->pfCallback(pCur, CLK_PROFILE_EVENT_PRE, pProfile) != HAL_OK )
+                break;
+        }
+
+        if( pCur )
+        {
+            /* notify the listeners before the vetoing one */
+            _ClkProfile_Notify(pCur, CLK_PROFILE_EVENT_ABORT, pProfile);
+            status = HAL_BUSY;
+            break;
+        }
+
+        if( (status = _ClkProfile_StartOsc(pProfile)) != HAL_OK )
+        {
+            _ClkProfile_Notify(0, CLK_PROFILE_EVENT_ABORT, pProfile);
+            break;
+        }
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        status = _ClkProfile_Apply(pProfile);
+        if( status == HAL_OK )
+        {
+            g_ClkProfile_Dev.pCurrent = pProfile;
+            _ClkProfile_Notify(0, CLK_PROFILE_EVENT_POST, pProfile);
+        }
+
+        __set_PRIMASK(primask);
+
+        if( status != HAL_OK )
+            _ClkProfile_Notify(0, CLK_PROFILE_EVENT_ABORT, pProfile);
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Get the current profile
+ *
+ *  @return
+ *      The current profile, NULL before ClkProfile_Init()
+ */
+const ClkProfile_TypeDef* ClkProfile_GetCurrent(void)
+{
+    return g_ClkProfile_Dev.pCurrent;
+}
+
+#if defined(HAL_UART_MODULE_ENABLED)
+/**
+ *  @brief  The listener of a UART, pListener->pUserData is the UART handle.
+ *          The switching is vetoed during a transmission or a reception and
+ *          BAUDCR is recomputed with the new PCLK (the same as UART_SetConfig()).
+ */
+HAL_StatusTypeDef ClkProfile_UartCallback(ClkProfile_ListenerTypeDef *pListener, uint32_t event, const ClkProfile_TypeDef *pProfile)
+{
+    UART_HandleTypeDef  *huart = (UART_HandleTypeDef*)pListener->pUserData;
+
+    UNUSED(pProfile);
+
+    if( event == CLK_PROFILE_EVENT_PRE )
+    {
+        return (huart->gState == HAL_UART_STATE_BUSY_TX ||
+                huart->RxState == HAL_UART_STATE_BUSY_RX) ? HAL_BUSY : HAL_OK;
+    }
+
+    if( event == CLK_PROFILE_EVENT_POST && !huart->Init.ProgTimer )
+    {
+        uint32_t    baudrate = ((((huart->Init.BaudDouble >> UART_SCON_DBAUD_Pos) + 1) * HAL_RCC_GetPCLKFreq()) / (32 * (huart->Init.BaudRate))) - 1;
+
+        WRITE_REG_MASK(huart->Instance->BAUDCR, UART_BAUDCR_BRG_Msk, baudrate);
+    }
+
+    return HAL_OK;
+}
+#endif
+
+#endif /* HAL_RCC_MODULE_ENABLED */
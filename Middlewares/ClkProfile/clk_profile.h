@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file clk_profile.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Clock profiles (named operating points) and run-time switching.
+ *
+ *  + A profile is SYSCLK source, HIRC frequency, AHB/APB dividers. Full speed
+ *    (HIRC 24 MHz), idle (HIRC 4 MHz) and low power (SIRC 38.4 KHz) are
+ *    predefined, user can define more.
+ *  + The drivers which derive dividers from the clocks (baud rates, timer
+ *    prescalers, ...) register a listener:
+ *      - CLK_PROFILE_EVENT_PRE: thread context, before the switch. A listener
+ *        can veto the switch (e.g. a transfer is on-going) by returning
+ *        non-HAL_OK, the notified listeners get CLK_PROFILE_EVENT_ABORT.
+ *      - CLK_PROFILE_EVENT_POST: the interrupts are disabled, the clocks are
+ *        switched. The listener recomputes its dividers with
+ *        HAL_RCC_GetPCLKFreq(), no ISR sees a half-updated configuration.
+ *  + The oscillator of the target profile is started (and waited) before the
+ *    critical section. In the critical section, the SYSCLK switching is
+ *    polled with a bounded count (HAL_TIMEOUT and the previous source is
+ *    restored if it does not complete), the SysTick is re-configured by
+ *    HAL_RCC_ClockConfig() and the tick frequency is restored when leaving
+ *    SIRC/LXT.
+ *
+ *  ClkProfile_UartCallback() is a ready-made listener for UART (pUserData is
+ *  the UART handle). ClkProfile_Switch() MUST be called in thread context.
+ *  If the HIRC trim service (hirc_trim) is running, it MUST be re-initialized
+ *  with the new target after the HIRC frequency is changed.
+ */
+
+#ifndef __clk_profile_H_w3HbK9sD_lMx4_HtCq_s7Ne_uJ5fZa8yRkPo__
+#define __clk_profile_H_w3HbK9sD_lMx4_HtCq_s7Ne_uJ5fZa8yRkPo__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+typedef enum ClkProfile_Event
+{
+    CLK_PROFILE_EVENT_PRE       = 0,
+    CLK_PROFILE_EVENT_POST,
+    CLK_PROFILE_EVENT_ABORT,
+
+} ClkProfile_EventTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief An operating point
+ */
+typedef struct ClkProfile
+{
+    const char      *pName;
+
+    uint32_t        SysClkSource;   /*!< RCC_SYSCLKSOURCE_HIRC/HXT/SIRC/LXT, HXT and LXT MUST be started by user */
+    uint32_t        HircFreq;       /*!< HIRC_VALUE_24M/22M/16M/8M/4M, only for RCC_SYSCLKSOURCE_HIRC */
+    uint32_t        AHBCLKDivider;  /*!< RCC_HCLK_DIVx */
+    uint32_t        APBCLKDivider;  /*!< RCC_PCLK_DIVx */
+    uint32_t        IsHircOff;      /*!< Stop HIRC when it is not the SYSCLK source */
+
+} ClkProfile_TypeDef;
+
+struct ClkProfile_Listener;
+
+/**
+ *  @brief Listener callback
+ *
+ *  @param [in] pListener   The listener
+ *  @param [in] event       ClkProfile_EventTypeDef
+ *  @param [in] pProfile    The target profile
+ *  @return
+ *      CLK_PROFILE_EVENT_PRE: HAL_OK to accept the switch, others to veto
+ */
+typedef HAL_StatusTypeDef (*ClkProfile_CallbackTypeDef)(struct ClkProfile_Listener *pListener, uint32_t event, const ClkProfile_TypeDef *pProfile);
+
+/**
+ *  @brief A listener, it MUST be setup with ClkProfile_Register()
+ */
+typedef struct ClkProfile_Listener
+{
+    struct ClkProfile_Listener  *pNext;
+
+    ClkProfile_CallbackTypeDef  pfCallback;
+    void                        *pUserData;
+
+} ClkProfile_ListenerTypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+extern const ClkProfile_TypeDef     g_ClkProfile_Full24M;
+extern const ClkProfile_TypeDef     g_ClkProfile_Idle4M;
+extern const ClkProfile_TypeDef     g_ClkProfile_Sirc;
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef ClkProfile_Init(const ClkProfile_TypeDef *pProfile);
+
+HAL_StatusTypeDef ClkProfile_Register(ClkProfile_ListenerTypeDef *pListener, ClkProfile_CallbackTypeDef pfCallback, void *pUserData);
+HAL_StatusTypeDef ClkProfile_Unregister(ClkProfile_ListenerTypeDef *pListener);
+
+HAL_StatusTypeDef ClkProfile_Switch(const ClkProfile_TypeDef *pProfile);
+const ClkProfile_TypeDef* ClkProfile_GetCurrent(void);
+
+#if defined(HAL_UART_MODULE_ENABLED)
+HAL_StatusTypeDef ClkProfile_UartCallback(ClkProfile_ListenerTypeDef *pListener, uint32_t event, const ClkProfile_TypeDef *pProfile);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
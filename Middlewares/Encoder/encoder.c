@@ -0,0 +1,389 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file encoder.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/17
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "encoder.h"
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/* Counts between two TI1 edges in the x4 encoder mode */
+#define ENCODER_COUNTS_PER_EDGE         2
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+/* ENCODER_TIMER_MAX for the instances without the encoder interface (TIM1A/TIM1B/TIM2A/TIM2B/TIM2C) */
+#define _ENCODER_SLOT(__TIMx__)         (((__TIMx__) == TIM1) ? 0 :                     \
+                                         ((__TIMx__) == TIM2) ? 1 : ENCODER_TIMER_MAX)
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static Encoder_TypeDef      *g_pEncoder[ENCODER_TIMER_MAX] = {0};
+
+static void _Encoder_EdgeISR(TIM_HandleTypeDef *htim);
+
+static const pTIM_CallbackTypeDef   g_Encoder_FastCallbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_CC1] = _Encoder_EdgeISR,
+};
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  @brief  CC1 (TI1 edge) ISR, time-stamp the captured count
+ *
+ *  @param [in] htim        TIM handle
+ *  @return
+ *      None
+ */
+static void _Encoder_EdgeISR(TIM_HandleTypeDef *htim)
+{
+    Encoder_TypeDef     *pEnc = g_pEncoder[_ENCODER_SLOT(htim->Instance)];
+
+    pEnc->EdgeTime  = HAL_GetCycles64();
+    pEnc->EdgeCnt   = (uint16_t)htim->Instance->CCR1;
+    pEnc->IsEdgeNew = 1;
+    return;
+}
+
+/**
+ *  @brief  Velocity of counts in cycles
+ *
+ *  @param [in] counts      Signed counts
+ *  @param [in] cycles      Elapsed cycles of the timestamp counter
+ *  @return
+ *      Counts per second with ENCODER_VELOCITY_FRAC_BITS fraction bits
+ */
+static int32_t _Encoder_CalcVelocity(int64_t counts, uint64_t cycles)
+{
+    int64_t     vel = 0;
+
+    if( cycles == 0 )
+        return 0;
+
+    vel = (counts << ENCODER_VELOCITY_FRAC_BITS) * (int64_t)HAL_TIM_Timestamp_GetFreq();
+    vel /= (int64_t)cycles;
+
+    if( vel > INT32_MAX )       vel = INT32_MAX;
+    else if( vel < -INT32_MAX ) vel = -INT32_MAX;
+
+    return (int32_t)vel;
+}
+
+/**
+ *  @brief  Switch the velocity method and reset the reference to the current sample
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @param [in] mode        Encoder_VelModeTypeDef
+ *  @param [in] now         Timestamp of the current sample
+ *  @return
+ *      None
+ */
+static void _Encoder_SetVelMode(Encoder_TypeDef *pEnc, Encoder_VelModeTypeDef mode, uint64_t now)
+{
+    TIM_HandleTypeDef   *htim = pEnc->Init.htim;
+
+    if( mode == ENCODER_VEL_MODE_EDGE )
+    {
+        pEnc->IsEdgeNew = 0;
+        __HAL_TIM_CLEAR_IT(htim, TIM_IT_CC1);
+        __HAL_TIM_ENABLE_IT(htim, TIM_IT_CC1);
+    }
+    else
+    {
+        __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1);
+    }
+
+    pEnc->VelMode = (uint8_t)mode;
+    pEnc->RefPos  = pEnc->Position;
+    pEnc->RefTime = now;
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize an encoder object
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @param [in] pInit       The configuration of the encoder
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Encoder_Init(Encoder_TypeDef *pEnc, Encoder_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        uint32_t    freq = HAL_TIM_Timestamp_GetFreq();
+
+        if( !pEnc || !pInit || !pInit->htim || !pInit->WindowThreshold ||
+            pInit->WindowThreshold > 0x7FFFul || freq == 0 ||
+            _ENCODER_SLOT(pInit->htim->Instance) >= ENCODER_TIMER_MAX )
+            break;
+
+        memset(pEnc, 0x0, sizeof(Encoder_TypeDef));
+        pEnc->Init = *pInit;
+
+        pEnc->StallCycles = (pInit->StallTimeMs)
+                          ? (uint32_t)(((uint64_t)freq * pInit->StallTimeMs) / 1000ul)
+                          : freq;
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Start the encoder interface and the edge time-stamping
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Encoder_Start(Encoder_TypeDef *pEnc)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        TIM_HandleTypeDef           *htim = 0;
+        const pTIM_CallbackTypeDef  *pCallbacks = 0;
+        uint32_t                    slot = 0;
+
+        if( !pEnc || !pEnc->Init.htim )
+            break;
+
+        htim = pEnc->Init.htim;
+        slot = _ENCODER_SLOT(htim->Instance);
+        if( slot >= ENCODER_TIMER_MAX )
+            break;
+
+        if( g_pEncoder[slot] && g_pEncoder[slot] != pEnc )
+        {
+            status = HAL_BUSY;
+            break;
+        }
+
+        pCallbacks = htim->pFastCallbacks;
+
+        status = HAL_TIM_RegisterFastCallbacks(htim, g_Encoder_FastCallbacks);
+        if( status != HAL_OK )
+            break;
+
+        g_pEncoder[slot] = pEnc;
+
+        status = HAL_TIM_Encoder_Start(htim, TIM_CHANNEL_ALL);
+        if( status != HAL_OK )
+        {
+            /* roll back, the TIM is left as it was */
+            g_pEncoder[slot] = 0;
+            HAL_TIM_RegisterFastCallbacks(htim, pCallbacks);
+            break;
+        }
+
+        pEnc->LastCnt = (uint16_t)htim->Instance->CNT;
+        _Encoder_SetVelMode(pEnc, ENCODER_VEL_MODE_EDGE, HAL_GetCycles64());
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Stop the encoder interface, the position is kept
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Encoder_Stop(Encoder_TypeDef *pEnc)
+{
+    TIM_HandleTypeDef   *htim = 0;
+    uint32_t            slot = 0;
+
+    if( !pEnc || !pEnc->Init.htim )
+        return HAL_ERROR;
+
+    htim = pEnc->Init.htim;
+    slot = _ENCODER_SLOT(htim->Instance);
+
+    /* Not started, the TIM may be used by another owner */
+    if( slot >= ENCODER_TIMER_MAX || g_pEncoder[slot] != pEnc )
+        return HAL_OK;
+
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1);
+    HAL_TIM_Encoder_Stop(htim, TIM_CHANNEL_ALL);
+    HAL_TIM_RegisterFastCallbacks(htim, NULL);
+
+    g_pEncoder[slot] = 0;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Overwrite the extended position (e.g. homing),
+ *          it MUST be called in the context of Encoder_Sample()
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @param [in] position    The new position
+ *  @return
+ *      None
+ */
+void Encoder_SetPosition(Encoder_TypeDef *pEnc, int64_t position)
+{
+    int64_t     offset = position - pEnc->Position;
+
+    pEnc->Position += offset;
+    pEnc->RefPos   += offset;
+    return;
+}
+
+/**
+ *  @brief  Sample the counter, extend the position and estimate the velocity.
+ *          It is called periodically from the control loop, the counter MUST
+ *          NOT move more than 32767 counts between two calls.
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @return
+ *      None
+ */
+void Encoder_Sample(Encoder_TypeDef *pEnc)
+{
+    TIM_HandleTypeDef   *htim = pEnc->Init.htim;
+    uint64_t            now = HAL_GetCycles64();
+    uint16_t            cnt = (uint16_t)htim->Instance->CNT;
+    int32_t             delta = (int16_t)(cnt - pEnc->LastCnt);
+    uint32_t            abs_delta = (delta < 0) ? -delta : delta;
+
+    pEnc->LastCnt   = cnt;
+    pEnc->Position += delta;
+
+    if( pEnc->VelMode == ENCODER_VEL_MODE_EDGE )
+    {
+        uint32_t    primask = 0;
+        uint32_t    is_edge_new = 0;
+        uint16_t    edge_cnt = 0;
+        uint64_t    edge_time = 0;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        is_edge_new     = pEnc->IsEdgeNew;
+        edge_cnt        = pEnc->EdgeCnt;
+        edge_time       = pEnc->EdgeTime;
+        pEnc->IsEdgeNew = 0;
+
+        __set_PRIMASK(primask);
+
+        if( is_edge_new )
+        {
+            /* the captured count is behind the sampled one, extend it from the position */
+            int64_t     edge_pos = pEnc->Position + (int16_t)(edge_cnt - cnt);
+
+            pEnc->Velocity = (edge_pos == pEnc->RefPos)
+                           ? 0 : _Encoder_CalcVelocity(edge_pos - pEnc->RefPos, edge_time - pEnc->RefTime);
+
+            pEnc->RefPos  = edge_pos;
+            pEnc->RefTime = edge_time;
+        }
+        else
+        {
+            /* no edge, the speed is less than one edge pitch since the last edge */
+            uint64_t    elapsed = now - pEnc->RefTime;
+
+            if( elapsed >= pEnc->StallCycles )
+                pEnc->Velocity = 0;
+            else
+            {
+                int32_t     bound = _Encoder_CalcVelocity(ENCODER_COUNTS_PER_EDGE, elapsed);
+
+                if( pEnc->Velocity > bound )        pEnc->Velocity = bound;
+                else if( pEnc->Velocity < -bound )  pEnc->Velocity = -bound;
+            }
+        }
+
+        if( abs_delta > pEnc->Init.WindowThreshold )
+            _Encoder_SetVelMode(pEnc, ENCODER_VEL_MODE_WINDOW, now);
+    }
+    else
+    {
+        pEnc->Velocity = _Encoder_CalcVelocity(pEnc->Position - pEnc->RefPos, now - pEnc->RefTime);
+        pEnc->RefPos   = pEnc->Position;
+        pEnc->RefTime  = now;
+
+        if( abs_delta < (pEnc->Init.WindowThreshold >> 1) )
+            _Encoder_SetVelMode(pEnc, ENCODER_VEL_MODE_EDGE, now);
+    }
+
+    /* publish, the sequence is odd while updating */
+    pEnc->Sequence++;
+    __DMB();
+
+    pEnc->Snapshot.Position  = pEnc->Position;
+    pEnc->Snapshot.Velocity  = pEnc->Velocity;
+    pEnc->Snapshot.Timestamp = now;
+
+    __DMB();
+    pEnc->Sequence++;
+    return;
+}
+
+/**
+ *  @brief  Get a consistent copy of the last sample without locking
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @param [in] pSnapshot   Report the snapshot
+ *  @return
+ *      None
+ */
+void Encoder_GetSnapshot(Encoder_TypeDef *pEnc, Encoder_SnapshotTypeDef *pSnapshot)
+{
+    uint32_t    seq = 0;
+
+    do {
+        seq = pEnc->Sequence;
+        __DMB();
+
+        pSnapshot->Position  = pEnc->Snapshot.Position;
+        pSnapshot->Velocity  = pEnc->Snapshot.Velocity;
+        pSnapshot->Timestamp = pEnc->Snapshot.Timestamp;
+
+        __DMB();
+    } while( (seq & 0x1ul) || seq != pEnc->Sequence );
+
+    return;
+}
+
+/**
+ *  @brief  Get the low 32-bits of the extended position of the last sample
+ *
+ *  @param [in] pEnc        The encoder object
+ *  @return
+ *      The position in counts
+ */
+int32_t Encoder_GetPosition32(Encoder_TypeDef *pEnc)
+{
+    Encoder_SnapshotTypeDef     snapshot;
+
+    Encoder_GetSnapshot(pEnc, &snapshot);
+    return (int32_t)snapshot.Position;
+}
+
+#endif /* HAL_TIM_MODULE_ENABLED */
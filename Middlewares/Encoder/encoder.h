@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file encoder.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/17
+ * @license
+ * @description
+ *  Quadrature encoder service on the encoder interface of TIM1/TIM2.
+ *
+ *  + The 16-bits hardware counter is extended to a 64-bits position with the
+ *    signed difference of two samples, so Encoder_Sample() MUST be called
+ *    before the counter moves more than 32767 counts.
+ *  + Velocity is estimated with the M/T method. At low speed the CC1 capture
+ *    (TI1 edge) is time-stamped with HAL_GetCycles64() and the velocity is the
+ *    counts between the last edges of two sample windows divided by the time
+ *    between those edges. At high speed the edge interrupt is turned off and
+ *    the counts of the sample window are divided by the window time.
+ *  + The result is published with a sequence counter, Encoder_GetSnapshot()
+ *    never blocks the writer. The reader MUST NOT preempt Encoder_Sample()
+ *    (call it from the same or a lower priority).
+ *
+ *  The timestamp counter (HAL_TIM_Timestamp_Start()) MUST be running on the
+ *  other TIM, and the encoder TIM is initialized by HAL_TIM_Encoder_Init().
+ */
+
+#ifndef __encoder_H_k3RvX8mQ_lJa2_HcTn_s7Wd_uP5yLe9bZgFo__
+#define __encoder_H_k3RvX8mQ_lJa2_HcTn_s7Wd_uP5yLe9bZgFo__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  Number of timers which can run an encoder at the same time (TIM1 and TIM2)
+ */
+#define ENCODER_TIMER_MAX           2
+
+/**
+ *  Fraction bits of the velocity (counts per second)
+ */
+#define ENCODER_VELOCITY_FRAC_BITS  8
+
+typedef enum Encoder_VelMode
+{
+    ENCODER_VEL_MODE_EDGE   = 0,    /*!< T method, time-stamped TI1 edges */
+    ENCODER_VEL_MODE_WINDOW,        /*!< M method, counts of the sample window */
+
+} Encoder_VelModeTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief Initial configuration of an encoder
+ */
+typedef struct Encoder_Init
+{
+    TIM_HandleTypeDef   *htim;          /*!< TIM handle, initialized by HAL_TIM_Encoder_Init() */
+
+    uint32_t            WindowThreshold;/*!< Counts per sample above which the velocity uses
+                                             the sample window (M method) and the edge interrupt
+                                             is turned off. It switches back at the half of it. */
+
+    uint32_t            StallTimeMs;    /*!< No edge in this time reports zero velocity */
+
+} Encoder_InitTypeDef;
+
+/**
+ *  @brief Consistent result of one Encoder_Sample()
+ */
+typedef struct Encoder_Snapshot
+{
+    int64_t     Position;       /*!< Extended position in counts */
+    int32_t     Velocity;       /*!< Counts per second, ENCODER_VELOCITY_FRAC_BITS fraction bits */
+    uint64_t    Timestamp;      /*!< HAL_GetCycles64() of the sample */
+
+} Encoder_SnapshotTypeDef;
+
+/**
+ *  @brief Encoder object
+ */
+typedef struct Encoder
+{
+    Encoder_InitTypeDef         Init;
+
+    /* written by Encoder_Sample() */
+    uint16_t                    LastCnt;
+    uint8_t                     VelMode;    /*!< Encoder_VelModeTypeDef */
+    int64_t                     Position;
+    int64_t                     RefPos;     /*!< Position of the reference edge/window */
+    uint64_t                    RefTime;    /*!< Time of the reference edge/window */
+    int32_t                     Velocity;
+    uint32_t                    StallCycles;
+
+    /* written by the edge ISR */
+    volatile uint32_t           IsEdgeNew;
+    volatile uint16_t           EdgeCnt;
+    volatile uint64_t           EdgeTime;
+
+    /* published snapshot */
+    volatile uint32_t           Sequence;   /*!< Odd while the snapshot is updating */
+    Encoder_SnapshotTypeDef     Snapshot;
+
+} Encoder_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef Encoder_Init(Encoder_TypeDef *pEnc, Encoder_InitTypeDef *pInit);
+HAL_StatusTypeDef Encoder_Start(Encoder_TypeDef *pEnc);
+HAL_StatusTypeDef Encoder_Stop(Encoder_TypeDef *pEnc);
+
+void Encoder_SetPosition(Encoder_TypeDef *pEnc, int64_t position);
+
+void Encoder_Sample(Encoder_TypeDef *pEnc);
+void Encoder_GetSnapshot(Encoder_TypeDef *pEnc, Encoder_SnapshotTypeDef *pSnapshot);
+
+int32_t Encoder_GetPosition32(Encoder_TypeDef *pEnc);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,425 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file gpio_exti.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/24
+ * @license
+ * @description
+ */
+
+
+#include "gpio_exti.h"
+
+#if defined(HAL_GPIO_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  De Bruijn sequence to get the bit position of the lowest pending pin
+ *  with one multiply and one table load (Cortex-M0+ has no CLZ instruction).
+ */
+#define GPIO_EXTI_DEBRUIJN_SEQ      0x077CB531ul
+
+#define GPIO_EXTI_DB_DIV_MAX        15
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _GPIO_EXTI_BIT_IDX(__ONE_HOT__)     g_GpioExti_DeBruijnIdx[(uint32_t)((__ONE_HOT__) * GPIO_EXTI_DEBRUIJN_SEQ) >> 27]
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct gpio_exti_pin
+{
+    GpioExti_CallbackTypeDef    pfCallback;
+    void                        *pUserData;
+    uint16_t                    HoldMs;     /*!< Software debounce hold time */
+    uint16_t                    Deadline;   /*!< Low 16-bits of HAL_GetTick() when the hold time ends */
+
+} gpio_exti_pin_t;
+
+typedef struct gpio_exti_port
+{
+    gpio_exti_pin_t     Pins[GPIO_EXTI_PIN_NUM];
+
+    uint16_t            SwDbMask;       /*!< Pins with software debounce */
+    uint16_t            HwDbMask;       /*!< Pins with hardware debounce */
+    uint16_t            PendingMask;    /*!< Pins in the hold time, the interrupts are masked */
+    uint16_t            StableLevel;    /*!< Debounced levels */
+    uint16_t            RiseMask;       /*!< Report the rising of the debounced level */
+    uint16_t            FallMask;       /*!< Report the falling of the debounced level */
+
+} gpio_exti_port_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static const uint8_t    g_GpioExti_DeBruijnIdx[32] =
+{
+    0,  1,  28, 2,  29, 14, 24, 3,  30, 22, 20, 15, 25, 17, 4,  8,
+    31, 27, 13, 23, 21, 19, 16, 7,  26, 12, 18, 6,  11, 5,  10, 9,
+};
+
+static GPIO_TypeDef * const     g_GpioExti_Ports[GPIO_EXTI_PORT_NUM] = { GPIOA, GPIOB, GPIOC, GPIOD };
+
+static gpio_exti_port_t         g_GpioExti_Dev[GPIO_EXTI_PORT_NUM];
+static volatile uint32_t        g_GpioExti_PendingPorts = 0;
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static uint32_t _GpioExti_PortIdx(GPIO_TypeDef *GPIOx)
+{
+    uint32_t    idx = 0;
+
+    while( idx < GPIO_EXTI_PORT_NUM && g_GpioExti_Ports[idx] != GPIOx )
+        idx++;
+
+    return idx;
+}
+
+/**
+ *  @brief  The smallest debounce clock divider of which filter covers the hold time
+ *
+ *  @param [in] hold_us     The hold time
+ *  @return
+ *      DBCLK_DIV, or (GPIO_EXTI_DB_DIV_MAX + 1) if the hardware can not cover it
+ */
+static uint32_t _GpioExti_HwDebounceDiv(uint32_t hold_us)
+{
+    uint64_t    need = (uint64_t)hold_us * HAL_RCC_GetHCLKFreq();
+    uint32_t    div = 0;
+
+    while( div <= GPIO_EXTI_DB_DIV_MAX && ((uint64_t)GPIO_EXTI_HW_DB_CYCLES << div) * 1000000ull < need )
+        div++;
+
+    return div;
+}
+
+/**
+ *  @brief  Start the hold time of the pins, the interrupts MUST be disabled
+ *
+ *  @param [in] port_idx    The port index
+ *  @param [in] pins        The pins
+ *  @return
+ *      None
+ */
+static void _GpioExti_StartHold(uint32_t port_idx, uint32_t pins)
+{
+    gpio_exti_port_t    *pPort = &g_GpioExti_Dev[port_idx];
+    uint16_t            now = (uint16_t)HAL_GetTick();
+
+    g_GpioExti_Ports[port_idx]->INTEN &= ~pins;
+    pPort->PendingMask |= (uint16_t)pins;
+    g_GpioExti_PendingPorts |= (0x1ul << port_idx);
+
+    while( pins )
+    {
+        uint32_t        bit = pins & (~pins + 1);
+        gpio_exti_pin_t *pPin = &pPort->Pins[_GPIO_EXTI_BIT_IDX(bit)];
+
+        pins &= ~bit;
+        pPin->Deadline = (uint16_t)(now + pPin->HoldMs);
+    }
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Register the callback and the debounce of a pin, the edge interrupt
+ *          of the pin and the GPIO IRQ of the port are enabled
+ *
+ *  @param [in] GPIOx       The port (GPIOA ~ GPIOD)
+ *  @param [in] pin_idx     The pin index (0 ~ 15)
+ *  @param [in] pConfig     The configuration
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef GpioExti_Register(GPIO_TypeDef *GPIOx, uint32_t pin_idx, const GpioExti_PinConfigTypeDef *pConfig)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        uint32_t            port_idx = _GpioExti_PortIdx(GPIOx);
+        uint32_t            bit = (0x1ul << pin_idx);
+        uint32_t            div = GPIO_EXTI_DB_DIV_MAX + 1;
+        uint32_t            primask = 0;
+        gpio_exti_port_t    *pPort = 0;
+        gpio_exti_pin_t     *pPin = 0;
+
+        if( port_idx >= GPIO_EXTI_PORT_NUM || pin_idx >= GPIO_EXTI_PIN_NUM ||
+            !pConfig || !pConfig->pfCallback || !(pConfig->Trigger & GPIO_EXTI_TRIGGER_BOTH) )
+            break;
+
+        if( pConfig->HoldUs )
+            div = _GpioExti_HwDebounceDiv(pConfig->HoldUs);
+
+        pPort = &g_GpioExti_Dev[port_idx];
+        pPin  = &pPort->Pins[pin_idx];
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        GPIOx->INTEN &= ~bit;
+
+        pPin->pfCallback = pConfig->pfCallback;
+        pPin->pUserData  = pConfig->pUserData;
+        pPin->HoldMs     = 0;
+
+        pPort->SwDbMask    &= ~bit;
+        pPort->HwDbMask    &= ~bit;
+        pPort->PendingMask &= ~bit;
+        pPort->RiseMask     = (pConfig->Trigger & GPIO_EXTI_TRIGGER_RISING) ? (pPort->RiseMask | bit) : (pPort->RiseMask & ~bit);
+        pPort->FallMask     = (pConfig->Trigger & GPIO_EXTI_TRIGGER_FALLING) ? (pPort->FallMask | bit) : (pPort->FallMask & ~bit);
+
+        GPIOx->INDBEN &= ~bit;
+
+        if( pConfig->HoldUs )
+        {
+            uint32_t    cur_div = (GPIOx->DBCLKCR & GPIO_DBCLKCR_DBCLK_DIV_Msk) >> GPIO_DBCLKCR_DBCLK_DIV_Pos;
+
+            /* the divider is shared by the port */
+            if( div <= GPIO_EXTI_DB_DIV_MAX && (!pPort->HwDbMask || cur_div == div) )
+            {
+                GPIOx->DBCLKCR = (GPIOx->DBCLKCR & ~GPIO_DBCLKCR_DBCLK_DIV_Msk)
+                               | (div << GPIO_DBCLKCR_DBCLK_DIV_Pos)
+                               | (0x1ul << GPIO_DBCLKCR_DBCLKEN_Pos);
+                GPIOx->INDBEN |= bit;
+                pPort->HwDbMask |= bit;
+            }
+            else
+            {
+                /* +1 ms for the granularity of HAL_GetTick() */
+                uint32_t    hold_ms = (pConfig->HoldUs + 999) / 1000 + 1;
+
+                pPin->HoldMs = (uint16_t)((hold_ms > 0x7FFF) ? 0x7FFF : hold_ms);
+                pPort->SwDbMask |= bit;
+            }
+        }
+
+        /* edge trigger, the software debounce needs both edges */
+        GPIOx->INTTYPCR &= ~bit;
+
+        if( (pPort->SwDbMask & bit) || pConfig->Trigger == GPIO_EXTI_TRIGGER_BOTH )
+        {
+            GPIOx->INTANY |= bit;
+        }
+        else
+        {
+            GPIOx->INTANY &= ~bit;
+
+            if( pConfig->Trigger == GPIO_EXTI_TRIGGER_RISING )
+                GPIOx->INTPOLCR |= bit;
+            else
+                GPIOx->INTPOLCR &= ~bit;
+        }
+
+        pPort->StableLevel = (uint16_t)((pPort->StableLevel & ~bit) | (GPIOx->IDR & bit));
+
+        GPIOx->INTCLR = bit;
+        GPIOx->INTEN |= bit;
+
+        __set_PRIMASK(primask);
+
+        HAL_NVIC_EnableIRQ((IRQn_Type)(GPIOA_IRQn + port_idx));
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Disable the interrupt of a pin and remove its callback
+ *
+ *  @param [in] GPIOx       The port (GPIOA ~ GPIOD)
+ *  @param [in] pin_idx     The pin index (0 ~ 15)
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef GpioExti_Unregister(GPIO_TypeDef *GPIOx, uint32_t pin_idx)
+{
+    uint32_t            port_idx = _GpioExti_PortIdx(GPIOx);
+    uint32_t            bit = (0x1ul << pin_idx);
+    uint32_t            primask = 0;
+    gpio_exti_port_t    *pPort = 0;
+
+    if( port_idx >= GPIO_EXTI_PORT_NUM || pin_idx >= GPIO_EXTI_PIN_NUM )
+        return HAL_ERROR;
+
+    pPort = &g_GpioExti_Dev[port_idx];
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    GPIOx->INTEN  &= ~bit;
+    GPIOx->INDBEN &= ~bit;
+    GPIOx->INTCLR  = bit;
+
+    pPort->SwDbMask    &= ~bit;
+    pPort->HwDbMask    &= ~bit;
+    pPort->PendingMask &= ~bit;
+    pPort->Pins[pin_idx].pfCallback = 0;
+
+    if( !pPort->HwDbMask )
+        GPIOx->DBCLKCR &= ~(0x1ul << GPIO_DBCLKCR_DBCLKEN_Pos);
+
+    __set_PRIMASK(primask);
+    return HAL_OK;
+}
+
+/**
+ *  @brief  GPIO ISR of a port, call it from GPIOx_IRQHandler() instead of
+ *          HAL_GPIO_EXTI_IRQHandler()
+ *
+ *  @param [in] GPIOx       The port (GPIOA ~ GPIOD)
+ *  @return
+ *      None
+ */
+void GpioExti_IRQHandler(GPIO_TypeDef *GPIOx)
+{
+    uint32_t            port_idx = _GpioExti_PortIdx(GPIOx);
+    gpio_exti_port_t    *pPort = 0;
+    uint32_t            pending = 0;
+    uint32_t            hold = 0;
+    uint32_t            levels = 0;
+
+    if( port_idx >= GPIO_EXTI_PORT_NUM )
+        return;
+
+    pPort   = &g_GpioExti_Dev[port_idx];
+    pending = GPIOx->MSKINTSR & 0xFFFFul;
+    GPIOx->INTCLR = pending;
+
+    levels = GPIOx->IDR;
+
+    /* the pins with software debounce are dispatched by GpioExti_DebounceTick() */
+    hold = pending & pPort->SwDbMask;
+    if( hold )
+    {
+        uint32_t    primask = __get_PRIMASK();
+
+        __disable_irq();
+        _GpioExti_StartHold(port_idx, hold);
+        __set_PRIMASK(primask);
+
+        pending &= ~hold;
+    }
+
+    while( pending )
+    {
+        uint32_t        bit = pending & (~pending + 1);
+        uint32_t        pin_idx = _GPIO_EXTI_BIT_IDX(bit);
+        gpio_exti_pin_t *pPin = &pPort->Pins[pin_idx];
+
+        pending &= ~bit;
+
+        if( pPin->pfCallback )
+            pPin->pfCallback(GPIOx, pin_idx, (levels & bit) ? 1 : 0, pPin->pUserData);
+    }
+
+    return;
+}
+
+/**
+ *  @brief  Software debounce engine, call it periodically (e.g. every 1 ms from
+ *          a timer ISR). It only scans the pins in the hold time, the cost is
+ *          near zero when no pin is bouncing.
+ *
+ *  @return
+ *      None
+ */
+void GpioExti_DebounceTick(void)
+{
+    uint32_t    ports = g_GpioExti_PendingPorts;
+    uint16_t    now = 0;
+
+    if( !ports )
+        return;
+
+    now = (uint16_t)HAL_GetTick();
+
+    for(uint32_t port_idx = 0; ports; port_idx++, ports >>= 1)
+    {
+        GPIO_TypeDef        *GPIOx = g_GpioExti_Ports[port_idx];
+        gpio_exti_port_t    *pPort = &g_GpioExti_Dev[port_idx];
+        uint32_t            pending = 0;
+        uint32_t            done = 0;
+        uint32_t            levels = 0;
+        uint32_t            changed = 0;
+        uint32_t            primask = 0;
+
+        if( !(ports & 0x1) )
+            continue;
+
+        pending = pPort->PendingMask;
+        levels  = GPIOx->IDR;
+
+        while( pending )
+        {
+            uint32_t        bit = pending & (~pending + 1);
+            uint32_t        pin_idx = _GPIO_EXTI_BIT_IDX(bit);
+            gpio_exti_pin_t *pPin = &pPort->Pins[pin_idx];
+
+            pending &= ~bit;
+
+            if( (int16_t)(now - pPin->Deadline) < 0 )
+                continue;
+
+            done |= bit;
+
+            if( (levels ^ pPort->StableLevel) & bit )
+            {
+                uint32_t    level = (levels & bit) ? 1 : 0;
+
+                pPort->StableLevel ^= (uint16_t)bit;
+
+                if( pPin->pfCallback && (((level) ? pPort->RiseMask : pPort->FallMask) & bit) )
+                    pPin->pfCallback(GPIOx, pin_idx, level, pPin->pUserData);
+            }
+        }
+
+        if( !done )
+            continue;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        pPort->PendingMask &= ~done;
+
+        /* the bounces in the hold time are discarded */
+        GPIOx->INTCLR = done;
+        GPIOx->INTEN |= done;
+
+        /* a change between the sampling and the re-enabling starts a new hold time */
+        changed = (GPIOx->IDR ^ pPort->StableLevel) & done;
+        if( changed )
+            _GpioExti_StartHold(port_idx, changed);
+
+        if( !pPort->PendingMask )
+            g_GpioExti_PendingPorts &= ~(0x1ul << port_idx);
+
+        __set_PRIMASK(primask);
+    }
+
+    return;
+}
+
+/**
+ *  @brief  Check any pin is in the hold time, GpioExti_DebounceTick() can be
+ *          stopped (e.g. before deep-sleep) when it returns 0
+ *
+ *  @return
+ *      1: debouncing, 0: idle
+ */
+uint32_t GpioExti_IsDebouncing(void)
+{
+    return (g_GpioExti_PendingPorts) ? 1 : 0;
+}
+
+#endif /* HAL_GPIO_MODULE_ENABLED */
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file gpio_exti.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/24
+ * @license
+ * @description
+ *  Per-pin EXTI dispatch of GPIOA ~ GPIOD with a debounce engine.
+ *
+ *  + Every pin has its own callback, GpioExti_IRQHandler() reads MSKINTSR once
+ *    and walks the pending bits with a De Bruijn bit scan (Cortex-M0+ has no
+ *    CLZ), so simultaneous pins are handled in one ISR entry.
+ *  + Debounce: a hold time which fits in the hardware filter (INDBEN/DBCLKCR,
+ *    one divider per port) uses the hardware. Longer hold times are done in
+ *    software: the edge masks the pin interrupt and GpioExti_DebounceTick()
+ *    samples the level after the hold time, the callback is only called when
+ *    the stable level changes.
+ *
+ *  The pins MUST be configured as input (pull-up/down) by user, the callbacks
+ *  are executed in ISR context.
+ */
+
+#ifndef __gpio_exti_H_k5RbW1hT_lNz3_HqLs_s8Dp_uV0cJf4yXmOe__
+#define __gpio_exti_H_k5RbW1hT_lNz3_HqLs_s8Dp_uV0cJf4yXmOe__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define GPIO_EXTI_PORT_NUM          4       /*!< GPIOA ~ GPIOD */
+#define GPIO_EXTI_PIN_NUM           16
+
+#define GPIO_EXTI_TRIGGER_RISING    0x1u
+#define GPIO_EXTI_TRIGGER_FALLING   0x2u
+#define GPIO_EXTI_TRIGGER_BOTH      (GPIO_EXTI_TRIGGER_RISING | GPIO_EXTI_TRIGGER_FALLING)
+
+/**
+ *  Debounce clocks of the hardware filter, a level MUST be stable for this
+ *  number of debounce clocks (HCLK >> DBCLK_DIV) to pass
+ */
+#ifndef GPIO_EXTI_HW_DB_CYCLES
+#define GPIO_EXTI_HW_DB_CYCLES      3
+#endif
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief Pin callback, it is executed in ISR context
+ *
+ *  @param [in] GPIOx       The port
+ *  @param [in] pin_idx     The pin index (0 ~ 15)
+ *  @param [in] level       The (debounced) level of the pin
+ *  @param [in] pUserData   The user data of the registration
+ */
+typedef void (*GpioExti_CallbackTypeDef)(GPIO_TypeDef *GPIOx, uint32_t pin_idx, uint32_t level, void *pUserData);
+
+/**
+ *  @brief Configuration of a pin
+ */
+typedef struct GpioExti_PinConfig
+{
+    GpioExti_CallbackTypeDef    pfCallback;
+    void                        *pUserData;
+    uint32_t                    Trigger;    /*!< GPIO_EXTI_TRIGGER_xxx */
+    uint32_t                    HoldUs;     /*!< Debounce hold time, 0: no debounce */
+
+} GpioExti_PinConfigTypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef GpioExti_Register(GPIO_TypeDef *GPIOx, uint32_t pin_idx, const GpioExti_PinConfigTypeDef *pConfig);
+HAL_StatusTypeDef GpioExti_Unregister(GPIO_TypeDef *GPIOx, uint32_t pin_idx);
+
+void GpioExti_IRQHandler(GPIO_TypeDef *GPIOx);
+void GpioExti_DebounceTick(void);
+uint32_t GpioExti_IsDebouncing(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
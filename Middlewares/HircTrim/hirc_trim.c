@@ -0,0 +1,334 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file hirc_trim.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  All divisions (64-bits) are done in thread context once per measurement.
+ */
+
+
+#include <string.h>
+#include "hirc_trim.h"
+
+#if defined(HAL_CLKTRIM_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  Initial guess of ppm per fine trim LSB if it is not given by user. It is
+ *  large on purpose, the first steps are small and the real value is learned.
+ */
+#define HIRC_TRIM_PPM_PER_STEP_DEFAULT      1000
+
+#define HIRC_TRIM_TIMEOUT_MARGIN_MS         10
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _ABS(x)                             (((x) < 0) ? -(x) : (x))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct hirc_trim_dev
+{
+    CLKTRIM_HandleTypeDef   *hclktrim;
+    HircTrim_InitTypeDef    Init;
+    HircTrim_StatusTypeDef  Status;
+
+    uint32_t                StartTick;
+    uint32_t                WaitMs;         /*!< Delay before the next measurement */
+    uint32_t                TimeoutMs;      /*!< Max duration of a measurement */
+    int32_t                 NoisePpm;       /*!< Resolution of a measurement (1 HIRC count) */
+
+    int32_t                 LastStep;       /*!< The last fine trim step, 0: no adjustment */
+    int32_t                 LastErrorPpm;   /*!< The error before the last adjustment */
+    uint32_t                IsGainLearned;  /*!< PpmPerStep is learned at least once */
+
+} hirc_trim_dev_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static hirc_trim_dev_t      g_HircTrim_Dev;
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static void _HircTrim_Start(void)
+{
+    CLKTRIM_HandleTypeDef   *hclktrim = g_HircTrim_Dev.hclktrim;
+
+    /* clear the previous STOP flag */
+    __HAL_CLKTRIM_CLEAR_FLAG(hclktrim, CLKTRIM_FLAG_STOP);
+    __HAL_CLKTRIM_START(hclktrim);
+
+    g_HircTrim_Dev.StartTick    = HAL_GetTick();
+    g_HircTrim_Dev.Status.State = HIRC_TRIM_STATE_MEASURING;
+    return;
+}
+
+/**
+ *  @brief  Learn the ppm per trim LSB from the result of the last adjustment
+ */
+static void _HircTrim_Learn(int32_t err_ppm)
+{
+    int32_t     delta = err_ppm - g_HircTrim_Dev.LastErrorPpm;
+    int32_t     gain = 0;
+
+    if( !g_HircTrim_Dev.LastStep || _ABS(delta) <= (g_HircTrim_Dev.NoisePpm << 2) )
+        return;
+
+    gain = delta / g_HircTrim_Dev.LastStep;
+    if( !gain )
+        return;
+
+    /* an opposite sign means the initial guess is wrong, take the new one */
+    if( (gain ^ g_HircTrim_Dev.Status.PpmPerStep) < 0 )
+        g_HircTrim_Dev.Status.PpmPerStep = gain;
+    else
+        g_HircTrim_Dev.Status.PpmPerStep = (g_HircTrim_Dev.Status.PpmPerStep + gain) / 2;
+
+    if( !g_HircTrim_Dev.Status.PpmPerStep )
+        g_HircTrim_Dev.Status.PpmPerStep = (gain < 0) ? -1 : 1;
+
+    g_HircTrim_Dev.IsGainLearned = 1;
+    return;
+}
+
+/**
+ *  @brief  Evaluate a measurement and adjust the fine trim
+ *
+ *  @param [in] cnt     HIRC cycles during WindowCycles LXT cycles
+ *  @return
+ *      Delay (ms) before the next measurement
+ */
+static uint32_t _HircTrim_Evaluate(uint32_t cnt)
+{
+    HircTrim_StatusTypeDef  *pStatus = &g_HircTrim_Dev.Status;
+    int64_t                 expected = (int64_t)g_HircTrim_Dev.Init.TargetFreq * g_HircTrim_Dev.Init.WindowCycles;
+    int64_t                 actual = (int64_t)cnt * LXT_VALUE;
+    int32_t                 err_ppm = 0;
+    int32_t                 gain = 0;
+    int32_t                 threshold = 0;
+    int32_t                 step = 0;
+    uint32_t                trim = 0;
+    uint32_t                fine = 0;
+
+    err_ppm = (int32_t)(((actual - expected) * 1000000) / expected);
+
+    pStatus->MeasuredFreq = (uint32_t)((actual + (g_HircTrim_Dev.Init.WindowCycles >> 1)) / g_HircTrim_Dev.Init.WindowCycles);
+    pStatus->ErrorPpm     = err_ppm;
+
+    _HircTrim_Learn(err_ppm);
+
+    /**
+     *  Inside half a trim LSB the trim can not do better. The guess of the
+     *  gain is large on purpose, so only the dead-band is used until the
+     *  gain is learned (or the loop locks far from the target).
+     */
+    gain      = pStatus->PpmPerStep;
+    threshold = (int32_t)g_HircTrim_Dev.Init.DeadbandPpm;
+    if( g_HircTrim_Dev.IsGainLearned && threshold < (_ABS(gain) >> 1) )
+        threshold = _ABS(gain) >> 1;
+
+    g_HircTrim_Dev.LastStep = 0;
+
+    if( _ABS(err_ppm) <= threshold )
+    {
+        pStatus->IsLocked    = 1;
+        pStatus->IsSaturated = 0;
+        HAL_RCC_SetHIRCFreq(pStatus->MeasuredFreq);
+        return g_HircTrim_Dev.Init.PeriodMs;
+    }
+
+    pStatus->IsLocked = 0;
+
+    /* proportional step with rounding, at least 1 LSB */
+    step = (_ABS(err_ppm) + (_ABS(gain) >> 1)) / _ABS(gain);
+    if( step > HIRC_TRIM_STEP_MAX )     step = HIRC_TRIM_STEP_MAX;
+    else if( step == 0 )                step = 1;
+
+    if( (err_ppm ^ gain) >= 0 )
+        step = -step;
+
+    trim = (RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos;
+    fine = trim & HIRC_TRIM_FINE_MSK;
+
+    if( (int32_t)fine + step < 0 )
+        step = -(int32_t)fine;
+    else if( (int32_t)fine + step > (int32_t)HIRC_TRIM_FINE_MSK )
+        step = (int32_t)(HIRC_TRIM_FINE_MSK - fine);
+
+    if( !step )
+    {
+        /* out of the trim range, the best is the measured frequency */
+        pStatus->IsSaturated = 1;
+        HAL_RCC_SetHIRCFreq(pStatus->MeasuredFreq);
+        return g_HircTrim_Dev.Init.PeriodMs;
+    }
+
+    pStatus->IsSaturated = 0;
+
+    trim = (trim & ~HIRC_TRIM_FINE_MSK) | (uint32_t)((int32_t)fine + step);
+    __HAL_RCC_HIRC_CALIBRATIONVALUE_ADJUST(trim);
+
+    pStatus->Trim = trim;
+    pStatus->AdjustCnt++;
+
+    g_HircTrim_Dev.LastStep     = step;
+    g_HircTrim_Dev.LastErrorPpm = err_ppm;
+
+    /* the published frequency is obsolete, use the nominal until locked */
+    HAL_RCC_SetHIRCFreq(0);
+
+    /* measure again immediately */
+    return 0;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the trim loop, CLKTRIM is configured to the calibration
+ *          mode (reference LXT, calibrated HIRC). The first measurement starts
+ *          at the first HircTrim_Process().
+ *
+ *  @param [in] hclktrim    The CLKTRIM handle, it is owned by the trim loop
+ *  @param [in] pInit       The configuration
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef HircTrim_Init(CLKTRIM_HandleTypeDef *hclktrim, HircTrim_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        if( !hclktrim || !pInit || !pInit->TargetFreq || !pInit->WindowCycles )
+            break;
+
+        /* CALCNT is 32-bits */
+        if( ((uint64_t)pInit->TargetFreq * 2 * pInit->WindowCycles) / LXT_VALUE > 0xFFFFFFFFull )
+            break;
+
+        if( __HAL_RCC_GET_FLAG(RCC_FLAG_LXTRDY) == RESET )
+            break;
+
+        memset(&g_HircTrim_Dev, 0x0, sizeof(g_HircTrim_Dev));
+        g_HircTrim_Dev.hclktrim = hclktrim;
+        g_HircTrim_Dev.Init     = *pInit;
+
+        g_HircTrim_Dev.Status.PpmPerStep = (pInit->PpmPerStep) ? pInit->PpmPerStep : HIRC_TRIM_PPM_PER_STEP_DEFAULT;
+        g_HircTrim_Dev.Status.Trim       = (RCC->HIRCCR & RCC_HIRCCR_HIRCTRIM) >> RCC_HIRCCR_HIRCTRIM_Pos;
+
+        g_HircTrim_Dev.TimeoutMs = (uint32_t)(((uint64_t)pInit->WindowCycles * 2000) / LXT_VALUE) + HIRC_TRIM_TIMEOUT_MARGIN_MS;
+        g_HircTrim_Dev.NoisePpm  = (int32_t)(((uint64_t)LXT_VALUE * 1000000) / ((uint64_t)pInit->TargetFreq * pInit->WindowCycles)) + 1;
+
+        __HAL_RCC_CLKTRIM_CLK_ENABLE();
+
+        hclktrim->Instance                 = CLKTRIM;
+        hclktrim->Init.ReferClockSel       = CLKTRIM_REFCLK_LXT;
+        hclktrim->Init.MonitorCalClockSel  = CLKTRIM_MONCALCLK_HIRC;
+        hclktrim->Init.MonitorInterval     = pInit->WindowCycles;
+        hclktrim->Init.MonitorOverflowTime = 0;
+        hclktrim->Init.ClkTrimMode         = CLKTRIM_MODE_CAL;
+        if( HAL_CLKTRIM_Init(hclktrim) != HAL_OK )
+            break;
+
+        g_HircTrim_Dev.Status.State = HIRC_TRIM_STATE_IDLE;
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Stop the trim loop, the current trim and the published frequency
+ *          are kept
+ *
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef HircTrim_DeInit(void)
+{
+    if( !g_HircTrim_Dev.hclktrim )
+        return HAL_ERROR;
+
+    __HAL_CLKTRIM_STOP(g_HircTrim_Dev.hclktrim);
+    HAL_CLKTRIM_DeInit(g_HircTrim_Dev.hclktrim);
+
+    g_HircTrim_Dev.hclktrim = 0;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Run the trim loop, call it periodically from the main loop
+ *
+ *  @return
+ *      None
+ */
+void HircTrim_Process(void)
+{
+    CLKTRIM_HandleTypeDef   *hclktrim = g_HircTrim_Dev.hclktrim;
+    uint32_t                elapsed = 0;
+
+    if( !hclktrim )
+        return;
+
+    elapsed = HAL_GetTick() - g_HircTrim_Dev.StartTick;
+
+    switch( g_HircTrim_Dev.Status.State )
+    {
+        case HIRC_TRIM_STATE_IDLE:
+        case HIRC_TRIM_STATE_ERROR:
+            if( elapsed >= g_HircTrim_Dev.WaitMs )
+                _HircTrim_Start();
+            break;
+
+        case HIRC_TRIM_STATE_MEASURING:
+            if( __HAL_CLKTRIM_GET_FLAG(hclktrim, CLKTRIM_FLAG_STOP) )
+            {
+                uint32_t    cnt = __HAL_CLKTRIM_GET_VALCNT(hclktrim);
+
+                __HAL_CLKTRIM_STOP(hclktrim);
+
+                g_HircTrim_Dev.Status.State = HIRC_TRIM_STATE_IDLE;
+                g_HircTrim_Dev.WaitMs       = _HircTrim_Evaluate(cnt);
+                g_HircTrim_Dev.StartTick    = HAL_GetTick();
+            }
+            else if( elapsed > g_HircTrim_Dev.TimeoutMs )
+            {
+                __HAL_CLKTRIM_STOP(hclktrim);
+
+                /* LXT is not running, the trim is not changed */
+                g_HircTrim_Dev.Status.State    = HIRC_TRIM_STATE_ERROR;
+                g_HircTrim_Dev.Status.IsLocked = 0;
+                g_HircTrim_Dev.WaitMs          = g_HircTrim_Dev.Init.PeriodMs;
+                g_HircTrim_Dev.StartTick       = HAL_GetTick();
+            }
+            break;
+
+        default:
+            break;
+    }
+    return;
+}
+
+/**
+ *  @brief  Get the status of the trim loop
+ *
+ *  @param [in] pStatus     The status
+ *  @return
+ *      None
+ */
+void HircTrim_GetStatus(HircTrim_StatusTypeDef *pStatus)
+{
+    *pStatus = g_HircTrim_Dev.Status;
+    return;
+}
+
+#endif /* HAL_CLKTRIM_MODULE_ENABLED */
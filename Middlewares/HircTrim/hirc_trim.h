@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file hirc_trim.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Closed-loop trim of HIRC against the 32.768 KHz LXT.
+ *
+ *  + CLKTRIM counts HIRC cycles (CALCNT) during WindowCycles LXT cycles, the
+ *    frequency error in ppm is (CALCNT * LXT_VALUE / WindowCycles - Target).
+ *  + The fine trim bits HIRCTRIM[8:0] are nudged toward the target, the step
+ *    is proportional to the error. The ppm per trim LSB is learned from the
+ *    previous adjustments (the sign too, an inverted trim still converges).
+ *  + When the error is inside the dead-band the loop is locked and the
+ *    measured frequency is published with HAL_RCC_SetHIRCFreq(), so the
+ *    peripherals configured afterwards (baud rates, timers) use the real HIRC.
+ *    The loop keeps re-measuring every PeriodMs to follow the temperature.
+ *
+ *  HircTrim_Process() is a non-blocking state machine, it MUST be called
+ *  periodically from the main loop (thread context). The LXT MUST be enabled
+ *  and ready by user.
+ */
+
+#ifndef __hirc_trim_H_p8WcN3kR_lQy6_HfTz_s5Md_uA2jVx7nBeGo__
+#define __hirc_trim_H_p8WcN3kR_lQy6_HfTz_s5Md_uA2jVx7nBeGo__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define HIRC_TRIM_FINE_MSK              0x1FFul     /*!< HIRCTRIM[8:0] */
+
+/**
+ *  Max fine trim step of one adjustment
+ */
+#ifndef HIRC_TRIM_STEP_MAX
+#define HIRC_TRIM_STEP_MAX              16
+#endif
+
+typedef enum HircTrim_State
+{
+    HIRC_TRIM_STATE_IDLE        = 0,
+    HIRC_TRIM_STATE_MEASURING,
+    HIRC_TRIM_STATE_ERROR,          /*!< CLKTRIM timeout (LXT is not running) */
+
+} HircTrim_StateTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief Configuration of the trim loop
+ */
+typedef struct HircTrim_Init
+{
+    uint32_t    TargetFreq;     /*!< Nominal HIRC frequency in Hz, e.g. HIRC_VALUE_24M */
+    uint32_t    WindowCycles;   /*!< LXT cycles of a measurement, e.g. 4096 (125 ms, 0.33 ppm at 24 MHz) */
+    uint32_t    PeriodMs;       /*!< Interval between the measurements when locked */
+    uint32_t    DeadbandPpm;    /*!< No adjustment inside +/- DeadbandPpm */
+    int32_t     PpmPerStep;     /*!< Initial guess of ppm per fine trim LSB (signed), it is learned at run time */
+
+} HircTrim_InitTypeDef;
+
+/**
+ *  @brief Status of the trim loop
+ */
+typedef struct HircTrim_Status
+{
+    HircTrim_StateTypeDef   State;
+    uint32_t                IsLocked;       /*!< The error is inside the dead-band */
+    uint32_t                IsSaturated;    /*!< The fine trim reaches 0 or HIRC_TRIM_FINE_MSK */
+    uint32_t                MeasuredFreq;   /*!< Last measured HIRC frequency in Hz */
+    int32_t                 ErrorPpm;       /*!< Last measured error */
+    int32_t                 PpmPerStep;     /*!< Learned ppm per fine trim LSB */
+    uint32_t                Trim;           /*!< Current HIRCTRIM */
+    uint32_t                AdjustCnt;      /*!< Number of trim adjustments */
+
+} HircTrim_StatusTypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef HircTrim_Init(CLKTRIM_HandleTypeDef *hclktrim, HircTrim_InitTypeDef *pInit);
+HAL_StatusTypeDef HircTrim_DeInit(void);
+
+void HircTrim_Process(void);
+void HircTrim_GetStatus(HircTrim_StatusTypeDef *pStatus);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,762 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file ir_remote.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/22
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "ir_remote.h"
+
+#if defined(HAL_TIM_MODULE_ENABLED) || defined(HAL_PCA_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define IR_PCA_CCF_ALL_Msk          (PCA_CR_CCF0 | PCA_CR_CCF1 | PCA_CR_CCF2 | PCA_CR_CCF3 | PCA_CR_CCF4)
+#define IR_PCA_CH_NUM               5
+#define IR_TIM_CH_NUM               4
+
+#define IR_US_MUL_FRAC_BITS         12
+
+/* NEC timing (us) */
+#define IR_NEC_HDR_MARK             9000
+#define IR_NEC_HDR_SPACE            4500
+#define IR_NEC_RPT_SPACE            2250
+#define IR_NEC_BIT_MARK             560
+#define IR_NEC_ZERO_SPACE           560
+#define IR_NEC_ONE_SPACE            1690
+#define IR_NEC_BITS                 32
+
+/* RC5 timing (us) */
+#define IR_RC5_HALF_BIT             889
+#define IR_RC5_BITS                 14
+
+typedef enum IrRemote_RxState
+{
+    IR_RX_IDLE          = 0,
+    IR_RX_NEC_HDR_SPACE,
+    IR_RX_NEC_BIT_MARK,
+    IR_RX_NEC_BIT_SPACE,
+    IR_RX_NEC_RPT_MARK,
+
+    /**
+     *  RC5 Manchester states, MIDx: at the middle of a bit x,
+     *  STARTx: at the start of a bit x
+     */
+    IR_RX_RC5_MID1,
+    IR_RX_RC5_MID0,
+    IR_RX_RC5_START1,
+    IR_RX_RC5_START0,
+
+} IrRemote_RxStateTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+/**
+ *  The duration is in the range of nominal +/- 25%
+ */
+#define _IR_IS_NEAR(__US__, __NOMINAL__)    \
+            (((__US__) * 4 >= (__NOMINAL__) * 3) && ((__US__) * 4 <= (__NOMINAL__) * 5))
+
+#define _CCAPM(__PCAx__, __IDX__)           (*(&(__PCAx__)->CCAPM0 + (__IDX__)))
+#define _CCAP(__PCAx__, __IDX__)            (*(&(__PCAx__)->CCAP0 + (__IDX__)))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static IrRemote_TypeDef     *g_pIr = 0;
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+static void _IrRemote_TimCaptureISR(TIM_HandleTypeDef *htim);
+
+static const pTIM_CallbackTypeDef   g_IrRemote_FastCallbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_CC1] = _IrRemote_TimCaptureISR,
+    [HAL_TIM_FAST_CB_CC2] = _IrRemote_TimCaptureISR,
+    [HAL_TIM_FAST_CB_CC3] = _IrRemote_TimCaptureISR,
+    [HAL_TIM_FAST_CB_CC4] = _IrRemote_TimCaptureISR,
+};
+#endif
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static void _IrRemote_Report(IrRemote_TypeDef *pIr, IrRemote_FrameTypeDef *pFrame)
+{
+    if( pIr->Init.pfRxCallback )
+        pIr->Init.pfRxCallback(pIr, pFrame);
+    return;
+}
+
+/**
+ *  @brief  Check and report a NEC frame, LSB first: address, ~address, command, ~command
+ *
+ *  @param [in] pIr     The IR object
+ *  @return
+ *      None
+ */
+static void _IrRemote_NecDone(IrRemote_TypeDef *pIr)
+{
+    IrRemote_FrameTypeDef   *pFrame = &pIr->LastNec;
+    uint32_t                data = pIr->RxData;
+
+    if( (((data >> 16) ^ (data >> 24)) & 0xFF) != 0xFF )
+        return;
+
+    pFrame->Protocol = IR_PROTOCOL_NEC;
+    pFrame->IsRepeat = 0;
+    pFrame->Toggle   = 0;
+    pFrame->Command  = (uint8_t)(data >> 16);
+
+    /* the extended NEC uses 16-bits address without the inverted byte */
+    pFrame->Address = (((data ^ (data >> 8)) & 0xFF) == 0xFF)
+                    ? (uint16_t)(data & 0xFF) : (uint16_t)(data & 0xFFFF);
+
+    _IrRemote_Report(pIr, pFrame);
+    return;
+}
+
+/**
+ *  @brief  Report a RC5 frame, MSB first: S1, S2 (inverted command bit 6), toggle,
+ *          5-bits address, 6-bits command
+ *
+ *  @param [in] pIr     The IR object
+ *  @return
+ *      None
+ */
+static void _IrRemote_Rc5Done(IrRemote_TypeDef *pIr)
+{
+    IrRemote_FrameTypeDef   frame;
+    uint32_t                data = pIr->RxData;
+
+    frame.Protocol = IR_PROTOCOL_RC5;
+    frame.IsRepeat = 0;
+    frame.Toggle   = (uint8_t)((data >> 11) & 0x1);
+    frame.Address  = (uint16_t)((data >> 6) & 0x1F);
+    frame.Command  = (uint8_t)((data & 0x3F) | ((data & (0x1ul << 12)) ? 0 : 0x40));
+
+    _IrRemote_Report(pIr, &frame);
+    return;
+}
+
+/**
+ *  @brief  Manchester decoding of RC5, a bit is emitted at the edge in the middle of the bit
+ *
+ *  @param [in] pIr             The IR object
+ *  @param [in] state           The current state (IR_RX_RC5_xxx)
+ *  @param [in] duration_us     The duration of the ended level
+ *  @param [in] is_mark_end     The ended level is a mark
+ *  @return
+ *      The next state
+ */
+static uint32_t _IrRemote_Rc5Step(IrRemote_TypeDef *pIr, uint32_t state, uint32_t duration_us, uint32_t is_mark_end)
+{
+    uint32_t    is_short = _IR_IS_NEAR(duration_us, IR_RC5_HALF_BIT);
+    uint32_t    is_long = _IR_IS_NEAR(duration_us, 2 * IR_RC5_HALF_BIT);
+    uint32_t    next = IR_RX_IDLE;
+    uint32_t    bit = 0;
+
+    if( is_mark_end )
+    {
+        /* '0' is mark then space */
+        if( state == IR_RX_RC5_MID1 && is_short )
+            return IR_RX_RC5_START1;
+
+        if( !(state == IR_RX_RC5_MID1 && is_long) && !(state == IR_RX_RC5_START0 && is_short) )
+            return IR_RX_IDLE;
+
+        bit  = 0;
+        next = IR_RX_RC5_MID0;
+    }
+    else
+    {
+        /* '1' is space then mark */
+        if( state == IR_RX_RC5_MID0 && is_short )
+            return IR_RX_RC5_START0;
+
+        if( !(state == IR_RX_RC5_MID0 && is_long) && !(state == IR_RX_RC5_START1 && is_short) )
+            return IR_RX_IDLE;
+
+        bit  = 1;
+        next = IR_RX_RC5_MID1;
+    }
+
+    pIr->RxData = (pIr->RxData << 1) | bit;
+
+    if( ++pIr->RxBitCnt == IR_RC5_BITS )
+    {
+        _IrRemote_Rc5Done(pIr);
+        next = IR_RX_IDLE;
+    }
+
+    return next;
+}
+
+/**
+ *  @brief  Handle a captured edge
+ *
+ *  @param [in] pIr     The IR object
+ *  @param [in] cnt     The captured counter
+ *  @return
+ *      None
+ */
+static void _IrRemote_OnCapture(IrRemote_TypeDef *pIr, uint32_t cnt)
+{
+    uint32_t    ticks = (uint16_t)(cnt - pIr->RxLastCnt);
+    uint32_t    is_mark_end = 0;
+
+    pIr->RxLastCnt = (uint16_t)cnt;
+
+    /* the receiver output is active low, it is high after the end of a mark */
+    is_mark_end = (pIr->Init.RxPort->IDR & pIr->Init.RxPin) ? 1 : 0;
+
+    IrRemote_FeedEdge(pIr, (ticks * pIr->RxUsMul) >> IR_US_MUL_FRAC_BITS, is_mark_end);
+    return;
+}
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+static void _IrRemote_TimCaptureISR(TIM_HandleTypeDef *htim)
+{
+    IrRemote_TypeDef    *pIr = g_pIr;
+
+    if( !pIr || pIr->Init.pRxHandle != htim )
+        return;
+
+    _IrRemote_OnCapture(pIr, *(&htim->Instance->CCR1 + pIr->RxIdx));
+    return;
+}
+
+static void _IrRemote_TimSetOcMode(TIM_TypeDef *TIMx, uint32_t channel, uint32_t oc_mode)
+{
+    __IO uint32_t   *pCCMR = (channel < TIM_CHANNEL_3) ? &TIMx->CCMR1_OUT : &TIMx->CCMR2_OUT;
+    uint32_t        shift = (channel & TIM_CHANNEL_2) ? 8 : 0;
+
+    MODIFY_REG(*pCCMR, TIM_CCMR1_OUT_OC1M << shift, oc_mode << shift);
+    return;
+}
+#endif
+
+/**
+ *  @brief  Gate the carrier
+ *
+ *  @param [in] pIr         The IR object
+ *  @param [in] is_on       1: the carrier is output
+ *  @return
+ *      None
+ */
+static void _IrRemote_Carrier(IrRemote_TypeDef *pIr, uint32_t is_on)
+{
+#if defined(HAL_TIM_MODULE_ENABLED)
+    _IrRemote_TimSetOcMode(pIr->Init.htimCarrier->Instance, pIr->Init.CarrierChannel,
+                           (is_on) ? TIM_OCMODE_PWM1 : TIM_OCMODE_FORCED_INACTIVE);
+#endif
+    return;
+}
+
+/**
+ *  @brief  Append a half-bit or a segment of a frame,
+ *          the adjacent segments of the same level are merged
+ *
+ *  @param [in] pIr             The IR object
+ *  @param [in] is_mark         The level of the segment
+ *  @param [in] duration_us     The duration of the segment
+ *  @return
+ *      None
+ */
+static void _IrRemote_PushSegment(IrRemote_TypeDef *pIr, uint32_t is_mark, uint32_t duration_us)
+{
+    uint32_t    num = pIr->TxNum;
+
+    /* a frame starts with a mark, even segments are marks */
+    if( num == 0 && !is_mark )
+        return;
+
+    if( num && (num & 0x1) == is_mark )
+    {
+        pIr->TxLoad[num - 1] += duration_us;
+        return;
+    }
+
+    if( num < IR_TX_SEGMENT_MAX )
+    {
+        pIr->TxLoad[num] = duration_us;
+        pIr->TxNum = (uint8_t)(num + 1);
+    }
+    return;
+}
+
+static void _IrRemote_BuildNec(IrRemote_TypeDef *pIr, IrRemote_FrameTypeDef *pFrame)
+{
+    uint32_t    data = 0;
+
+    _IrRemote_PushSegment(pIr, 1, IR_NEC_HDR_MARK);
+
+    if( pFrame->IsRepeat )
+    {
+        _IrRemote_PushSegment(pIr, 0, IR_NEC_RPT_SPACE);
+        _IrRemote_PushSegment(pIr, 1, IR_NEC_BIT_MARK);
+        return;
+    }
+
+    data = (pFrame->Address > 0xFF)
+         ? pFrame->Address : (pFrame->Address | ((~pFrame->Address & 0xFFul) << 8));
+    data |= ((uint32_t)pFrame->Command << 16) | ((~(uint32_t)pFrame->Command & 0xFFul) << 24);
+
+    _IrRemote_PushSegment(pIr, 0, IR_NEC_HDR_SPACE);
+
+    for(uint32_t i = 0; i < IR_NEC_BITS; i++, data >>= 1)
+    {
+        _IrRemote_PushSegment(pIr, 1, IR_NEC_BIT_MARK);
+        _IrRemote_PushSegment(pIr, 0, (data & 0x1) ? IR_NEC_ONE_SPACE : IR_NEC_ZERO_SPACE);
+    }
+
+    _IrRemote_PushSegment(pIr, 1, IR_NEC_BIT_MARK);
+    return;
+}
+
+static void _IrRemote_BuildRc5(IrRemote_TypeDef *pIr, IrRemote_FrameTypeDef *pFrame)
+{
+    uint32_t    data = 0;
+
+    data = (0x1ul << 13)
+         | ((pFrame->Command & 0x40) ? 0 : (0x1ul << 12))
+         | ((uint32_t)(pFrame->Toggle & 0x1) << 11)
+         | ((uint32_t)(pFrame->Address & 0x1F) << 6)
+         | (pFrame->Command & 0x3F);
+
+    for(int i = IR_RC5_BITS - 1; i >= 0; i--)
+    {
+        uint32_t    bit = (data >> i) & 0x1;
+
+        _IrRemote_PushSegment(pIr, bit ^ 0x1, IR_RC5_HALF_BIT);
+        _IrRemote_PushSegment(pIr, bit, IR_RC5_HALF_BIT);
+    }
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the IR remote, the capture channel (both edges) and the
+ *          carrier PWM (frequency and duty) MUST be configured by user
+ *
+ *  @param [in] pIr         The IR object
+ *  @param [in] pInit       The configuration
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef IrRemote_Init(IrRemote_TypeDef *pIr, IrRemote_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        if( !pIr || !pInit || (g_pIr && g_pIr != pIr) )
+            break;
+
+        if( pInit->RxHwSel != IR_HW_NONE &&
+            (!pInit->pRxHandle || !pInit->RxPort || !pInit->RxTickFreq ||
+             pInit->RxTickFreq > (uint32_t)((65535ull * 4000000ull) / (IR_NEC_HDR_MARK * 5))) )
+            break;
+
+        if( pInit->htimCarrier && (!pInit->hEnvelope || !pInit->EnvelopeTickFreq) )
+            break;
+
+        memset(pIr, 0x0, sizeof(IrRemote_TypeDef));
+        pIr->Init = *pInit;
+
+        if( pInit->RxHwSel != IR_HW_NONE )
+            pIr->RxUsMul = (uint32_t)((1000000ull << IR_US_MUL_FRAC_BITS) / pInit->RxTickFreq);
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+        if( pInit->RxHwSel == IR_HW_TIM )
+        {
+            if( (pInit->RxChannel >> 2) >= IR_TIM_CH_NUM )
+                break;
+
+            pIr->RxIdx = (uint8_t)(pInit->RxChannel >> 2);
+        }
+#endif
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+        if( pInit->RxHwSel == IR_HW_PCA )
+        {
+            uint32_t    idx = 0;
+
+            while( idx < IR_PCA_CH_NUM && !(pInit->RxChannel & (0x1ul << idx)) )
+                idx++;
+
+            if( idx >= IR_PCA_CH_NUM || (pInit->RxChannel & ~(0x1ul << idx)) )
+                break;
+
+            pIr->RxIdx = (uint8_t)idx;
+        }
+#endif
+
+#if defined(HAL_TIM_MODULE_ENABLED) && defined(HAL_BASETIM_MODULE_ENABLED)
+        if( pInit->htimCarrier )
+        {
+            BASETIM_HandleTypeDef   *hBASETIM = pInit->hEnvelope;
+
+            hBASETIM->Init.CntTimSel  = BASETIM_TIMER_SELECT;
+            hBASETIM->Init.AutoReload = BASETIM_AUTORELOAD_ENABLE;
+            hBASETIM->Init.OneShot    = BASETIM_REPEAT_MODE;
+            hBASETIM->Init.Period     = 0;
+            if( HAL_BASETIM_Base_Init(hBASETIM) != HAL_OK )
+                break;
+
+            pIr->EnvCntMax = (hBASETIM->Init.MaxCntLevel == BASETIM_MAXCNTLEVEL_32BIT)
+                           ? BASETIM_MAXCNTVALUE_32BIT : BASETIM_MAXCNTVALUE_16BIT;
+
+            /* the carrier keeps running, the output is gated by the OC mode */
+            _IrRemote_Carrier(pIr, 0);
+            if( HAL_TIM_PWM_Start(pInit->htimCarrier, pInit->CarrierChannel) != HAL_OK )
+                break;
+        }
+#else
+        if( pInit->htimCarrier )
+            break;
+#endif
+
+        g_pIr = pIr;
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Start decoding, the CPU can sleep between the edges
+ *
+ *  @param [in] pIr         The IR object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef IrRemote_StartReceive(IrRemote_TypeDef *pIr)
+{
+    if( !pIr || g_pIr != pIr )
+        return HAL_ERROR;
+
+    pIr->RxState           = IR_RX_IDLE;
+    pIr->LastNec.Protocol  = 0;
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+    if( pIr->Init.RxHwSel == IR_HW_TIM )
+    {
+        TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pIr->Init.pRxHandle;
+
+        pIr->RxLastCnt = (uint16_t)htim->Instance->CNT;
+        HAL_TIM_RegisterFastCallbacks(htim, g_IrRemote_FastCallbacks);
+        return HAL_TIM_IC_Start_IT(htim, pIr->Init.RxChannel);
+    }
+#endif
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+    if( pIr->Init.RxHwSel == IR_HW_PCA )
+    {
+        PCA_HandleTypeDef   *hpca = (PCA_HandleTypeDef*)pIr->Init.pRxHandle;
+        PCA_TypeDef         *PCAx = hpca->Instance;
+
+        pIr->RxLastCnt = (uint16_t)PCAx->CNT;
+        PCAx->INTCLR = (0x1ul << pIr->RxIdx);
+        _CCAPM(PCAx, pIr->RxIdx) = PCA_CCAPM0_CAPP | PCA_CCAPM0_CAPN | PCA_CCAPM0_CCIE;
+
+        __HAL_PCA_ENABLE(hpca);
+        return HAL_OK;
+    }
+#endif
+
+    return (pIr->Init.RxHwSel == IR_HW_NONE) ? HAL_OK : HAL_ERROR;
+}
+
+/**
+ *  @brief  Stop decoding
+ *
+ *  @param [in] pIr         The IR object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef IrRemote_StopReceive(IrRemote_TypeDef *pIr)
+{
+    if( !pIr || g_pIr != pIr )
+        return HAL_ERROR;
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+    if( pIr->Init.RxHwSel == IR_HW_TIM )
+    {
+        TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pIr->Init.pRxHandle;
+
+        HAL_TIM_IC_Stop_IT(htim, pIr->Init.RxChannel);
+        HAL_TIM_RegisterFastCallbacks(htim, NULL);
+    }
+#endif
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+    if( pIr->Init.RxHwSel == IR_HW_PCA )
+    {
+        PCA_TypeDef     *PCAx = ((PCA_HandleTypeDef*)pIr->Init.pRxHandle)->Instance;
+
+        _CCAPM(PCAx, pIr->RxIdx) = 0;
+        PCAx->INTCLR = (0x1ul << pIr->RxIdx);
+    }
+#endif
+
+    pIr->RxState = IR_RX_IDLE;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Run the decoder state machine with the duration of the ended level,
+ *          it is called by the capture ISR or by user with other edge sources
+ *
+ *  @param [in] pIr             The IR object
+ *  @param [in] duration_us     The duration of the ended level
+ *  @param [in] is_mark_end     1: a mark (carrier) ended, 0: a space ended
+ *  @return
+ *      None
+ */
+void IrRemote_FeedEdge(IrRemote_TypeDef *pIr, uint32_t duration_us, uint32_t is_mark_end)
+{
+    uint32_t    state = pIr->RxState;
+    uint32_t    next = IR_RX_IDLE;
+
+    switch( state )
+    {
+        case IR_RX_IDLE:
+            if( !is_mark_end )
+                break;
+
+            if( (pIr->Init.ProtocolMask & IR_PROTOCOL_NEC) && _IR_IS_NEAR(duration_us, IR_NEC_HDR_MARK) )
+            {
+                next = IR_RX_NEC_HDR_SPACE;
+                break;
+            }
+
+            if( pIr->Init.ProtocolMask & IR_PROTOCOL_RC5 )
+            {
+                /* the first edge is the middle of S1 ('1') */
+                pIr->RxData   = 0x1;
+                pIr->RxBitCnt = 1;
+                next = _IrRemote_Rc5Step(pIr, IR_RX_RC5_MID1, duration_us, is_mark_end);
+            }
+            break;
+
+        case IR_RX_NEC_HDR_SPACE:
+            if( is_mark_end )
+                break;
+
+            if( _IR_IS_NEAR(duration_us, IR_NEC_HDR_SPACE) )
+            {
+                pIr->RxData   = 0;
+                pIr->RxBitCnt = 0;
+                next = IR_RX_NEC_BIT_MARK;
+            }
+            else if( _IR_IS_NEAR(duration_us, IR_NEC_RPT_SPACE) )
+                next = IR_RX_NEC_RPT_MARK;
+            break;
+
+        case IR_RX_NEC_BIT_MARK:
+            if( is_mark_end && _IR_IS_NEAR(duration_us, IR_NEC_BIT_MARK) )
+                next = IR_RX_NEC_BIT_SPACE;
+            break;
+
+        case IR_RX_NEC_BIT_SPACE:
+            if( is_mark_end )
+                break;
+
+            if( _IR_IS_NEAR(duration_us, IR_NEC_ONE_SPACE) )
+                pIr->RxData |= (0x1ul << pIr->RxBitCnt);
+            else if( !_IR_IS_NEAR(duration_us, IR_NEC_ZERO_SPACE) )
+                break;
+
+            if( ++pIr->RxBitCnt < IR_NEC_BITS )
+            {
+                next = IR_RX_NEC_BIT_MARK;
+                break;
+            }
+
+            _IrRemote_NecDone(pIr);
+            break;
+
+        case IR_RX_NEC_RPT_MARK:
+            if( is_mark_end && _IR_IS_NEAR(duration_us, IR_NEC_BIT_MARK) && pIr->LastNec.Protocol )
+            {
+                IrRemote_FrameTypeDef   frame = pIr->LastNec;
+
+                frame.IsRepeat = 1;
+                _IrRemote_Report(pIr, &frame);
+            }
+            break;
+
+        default:
+            next = _IrRemote_Rc5Step(pIr, state, duration_us, is_mark_end);
+            break;
+    }
+
+    pIr->RxState = (uint8_t)next;
+    return;
+}
+
+/**
+ *  @brief  Send a frame, the mark/space durations are precomputed and the
+ *          envelope timer gates the carrier in interrupts
+ *
+ *  @param [in] pIr         The IR object
+ *  @param [in] pFrame      The frame (IR_PROTOCOL_NEC or IR_PROTOCOL_RC5)
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef IrRemote_Send(IrRemote_TypeDef *pIr, IrRemote_FrameTypeDef *pFrame)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+#if defined(HAL_TIM_MODULE_ENABLED) && defined(HAL_BASETIM_MODULE_ENABLED)
+        BASETIM_HandleTypeDef   *hBASETIM = 0;
+
+        if( !pIr || !pFrame || g_pIr != pIr || !pIr->Init.htimCarrier )
+            break;
+
+        if( pIr->IsTxBusy )
+        {
+            status = HAL_BUSY;
+            break;
+        }
+
+        pIr->TxNum = 0;
+
+        if( pFrame->Protocol == IR_PROTOCOL_NEC )
+            _IrRemote_BuildNec(pIr, pFrame);
+        else if( pFrame->Protocol == IR_PROTOCOL_RC5 )
+            _IrRemote_BuildRc5(pIr, pFrame);
+        else
+            break;
+
+        /* a frame ends with a mark */
+        if( !(pIr->TxNum & 0x1) )
+            pIr->TxNum--;
+
+        for(uint32_t i = 0; i < pIr->TxNum; i++)
+        {
+            uint32_t    ticks = (uint32_t)(((uint64_t)pIr->TxLoad[i] * pIr->Init.EnvelopeTickFreq + 500000ull) / 1000000ull);
+
+            pIr->TxLoad[i] = (pIr->EnvCntMax - ticks + 1ul) & pIr->EnvCntMax;
+        }
+
+        hBASETIM = pIr->Init.hEnvelope;
+
+        pIr->TxIdx    = 0;
+        pIr->IsTxBusy = 1;
+
+        __HAL_BASETIM_CLEAR_IT(hBASETIM);
+        WRITE_REG(hBASETIM->Instance->LOAD, pIr->TxLoad[0]);
+        WRITE_REG(hBASETIM->Instance->BGLOAD, pIr->TxLoad[(pIr->TxNum > 1) ? 1 : 0]);
+
+        _IrRemote_Carrier(pIr, 1);
+
+        status = HAL_BASETIM_Base_Start_IT(hBASETIM);
+        if( status != HAL_OK )
+        {
+            _IrRemote_Carrier(pIr, 0);
+            pIr->IsTxBusy = 0;
+        }
+#endif
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Check a frame is being sent
+ *
+ *  @param [in] pIr         The IR object
+ *  @return
+ *      1: busy, 0: idle
+ */
+uint32_t IrRemote_IsTxBusy(IrRemote_TypeDef *pIr)
+{
+    return (pIr) ? pIr->IsTxBusy : 0;
+}
+
+/**
+ *  @brief  PCA capture handler of the decoder,
+ *          call it from PCA_IRQHandler() instead of HAL_PCA_IRQHandler()
+ *
+ *  @return
+ *      None
+ */
+void IrRemote_PCA_IRQHandler(void)
+{
+#if defined(HAL_PCA_MODULE_ENABLED)
+    IrRemote_TypeDef    *pIr = g_pIr;
+    PCA_TypeDef         *PCAx = 0;
+    uint32_t            flags = 0;
+
+    if( !pIr || pIr->Init.RxHwSel != IR_HW_PCA )
+        return;
+
+    PCAx  = ((PCA_HandleTypeDef*)pIr->Init.pRxHandle)->Instance;
+    flags = PCAx->CR & IR_PCA_CCF_ALL_Msk;
+    PCAx->INTCLR = flags;
+
+    if( flags & (0x1ul << pIr->RxIdx) )
+        _IrRemote_OnCapture(pIr, _CCAP(PCAx, pIr->RxIdx));
+#endif
+    return;
+}
+
+/**
+ *  @brief  BASETIM ISR of the encoder, it gates the carrier at the end of a segment,
+ *          call it from the BASETIM vector instead of HAL_BASETIM_IRQHandler()
+ *
+ *  @return
+ *      None
+ */
+void IrRemote_Envelope_IRQHandler(void)
+{
+#if defined(HAL_TIM_MODULE_ENABLED) && defined(HAL_BASETIM_MODULE_ENABLED)
+    IrRemote_TypeDef        *pIr = g_pIr;
+    BASETIM_HandleTypeDef   *hBASETIM = 0;
+    uint32_t                idx = 0;
+
+    if( !pIr || !pIr->IsTxBusy )
+        return;
+
+    hBASETIM = pIr->Init.hEnvelope;
+    __HAL_BASETIM_CLEAR_IT(hBASETIM);
+
+    idx = pIr->TxIdx + 1;
+    if( idx >= pIr->TxNum )
+    {
+        _IrRemote_Carrier(pIr, 0);
+        HAL_BASETIM_Base_Stop_IT(hBASETIM);
+        pIr->IsTxBusy = 0;
+
+        if( pIr->Init.pfTxCallback )
+            pIr->Init.pfTxCallback(pIr);
+        return;
+    }
+
+    /* the counter was reloaded with the duration of this segment */
+    _IrRemote_Carrier(pIr, !(idx & 0x1));
+
+    if( idx + 1 < pIr->TxNum )
+        WRITE_REG(hBASETIM->Instance->BGLOAD, pIr->TxLoad[idx + 1]);
+
+    pIr->TxIdx = (uint8_t)idx;
+#endif
+    return;
+}
+
+#endif /* HAL_TIM_MODULE_ENABLED || HAL_PCA_MODULE_ENABLED */
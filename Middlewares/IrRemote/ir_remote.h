@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file ir_remote.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/22
+ * @license
+ * @description
+ *  Infrared remote (NEC / RC5) decoder and encoder.
+ *
+ *  + Decoder: the edges of the IR receiver output (active low) are captured by
+ *    a TIM channel or a PCA module on both edges, a state machine in the
+ *    capture ISR classifies the mark/space durations, nothing is polled.
+ *  + Encoder: the carrier (36~38 KHz) is a PWM channel of TIM1/TIM2 configured
+ *    by user, it is gated by switching the output mode between PWM1 and forced
+ *    inactive. The mark/space boundaries are timed by a BASETIM whose next
+ *    duration is preloaded to BGLOAD.
+ *
+ *  Only one IR object is supported. The TIM of the decoder takes the fast
+ *  callbacks of its handle, it can not be shared with other fast callback users.
+ */
+
+#ifndef __ir_remote_H_c8TfM3qA_lRv5_HzDo_s1Ky_uH4wGb6nXeUm__
+#define __ir_remote_H_c8TfM3qA_lRv5_HzDo_s1Ky_uH4wGb6nXeUm__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define IR_PROTOCOL_NEC             0x1u
+#define IR_PROTOCOL_RC5             0x2u
+
+/**
+ *  Max mark/space segments of an encoded frame (NEC: header + 32 bits + stop)
+ */
+#define IR_TX_SEGMENT_MAX           68
+
+typedef enum IrRemote_HwSel
+{
+    IR_HW_NONE      = 0,    /*!< Edges are fed by IrRemote_FeedEdge() */
+    IR_HW_TIM,              /*!< TIM1/TIM2 input capture, TIM_ICPOLARITY_BOTHEDGE */
+    IR_HW_PCA,              /*!< PCA capture on both edges */
+
+} IrRemote_HwSelTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+struct IrRemote;
+
+/**
+ *  @brief A decoded or to-be-encoded frame
+ */
+typedef struct IrRemote_Frame
+{
+    uint8_t     Protocol;       /*!< IR_PROTOCOL_xxx */
+    uint8_t     IsRepeat;       /*!< NEC repeat code */
+    uint8_t     Toggle;         /*!< RC5 toggle bit */
+    uint8_t     Command;        /*!< NEC: 8-bits, RC5: 7-bits (RC5X) */
+    uint16_t    Address;        /*!< NEC: 8 or 16-bits (extended), RC5: 5-bits */
+
+} IrRemote_FrameTypeDef;
+
+/**
+ *  @brief Callbacks, they are executed in ISR context
+ */
+typedef void (*IrRemote_RxCallbackTypeDef)(struct IrRemote *pIr, IrRemote_FrameTypeDef *pFrame);
+typedef void (*IrRemote_TxCallbackTypeDef)(struct IrRemote *pIr);
+
+/**
+ *  @brief Initial configuration of the IR remote
+ */
+typedef struct IrRemote_Init
+{
+    /* decoder */
+    IrRemote_HwSelTypeDef       RxHwSel;
+    void                        *pRxHandle;     /*!< TIM_HandleTypeDef or PCA_HandleTypeDef, the counter is free running */
+    uint32_t                    RxChannel;      /*!< TIM_CHANNEL_x or PCA_CHANNEL_x */
+    uint32_t                    RxTickFreq;     /*!< Counter frequency, a NEC header (9ms + 25%) MUST be less than 65536 counts */
+    GPIO_TypeDef                *RxPort;        /*!< The receiver pin, its level tells the edge direction */
+    uint32_t                    RxPin;
+    uint32_t                    ProtocolMask;   /*!< IR_PROTOCOL_xxx */
+    IrRemote_RxCallbackTypeDef  pfRxCallback;
+
+    /* encoder */
+    TIM_HandleTypeDef           *htimCarrier;   /*!< PWM of the carrier, NULL: no encoder */
+    uint32_t                    CarrierChannel; /*!< TIM_CHANNEL_x */
+    BASETIM_HandleTypeDef       *hEnvelope;     /*!< Timer of the mark/space durations */
+    uint32_t                    EnvelopeTickFreq;
+    IrRemote_TxCallbackTypeDef  pfTxCallback;
+
+    void                        *pUserData;
+
+} IrRemote_InitTypeDef;
+
+/**
+ *  @brief IR remote object
+ */
+typedef struct IrRemote
+{
+    IrRemote_InitTypeDef    Init;
+
+    /* decoder */
+    uint32_t                RxUsMul;        /*!< Counts to micro-seconds, Q12 */
+    uint16_t                RxLastCnt;
+    uint8_t                 RxIdx;          /*!< Channel index of the capture */
+    uint8_t                 RxState;
+    uint8_t                 RxBitCnt;
+    uint32_t                RxData;
+    IrRemote_FrameTypeDef   LastNec;        /*!< The frame of the NEC repeat code */
+
+    /* encoder */
+    uint32_t                EnvCntMax;
+    uint32_t                TxLoad[IR_TX_SEGMENT_MAX];  /*!< BGLOAD of every segment, even: mark, odd: space */
+    volatile uint8_t        TxNum;
+    volatile uint8_t        TxIdx;
+    volatile uint8_t        IsTxBusy;
+
+} IrRemote_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef IrRemote_Init(IrRemote_TypeDef *pIr, IrRemote_InitTypeDef *pInit);
+
+HAL_StatusTypeDef IrRemote_StartReceive(IrRemote_TypeDef *pIr);
+HAL_StatusTypeDef IrRemote_StopReceive(IrRemote_TypeDef *pIr);
+void IrRemote_FeedEdge(IrRemote_TypeDef *pIr, uint32_t duration_us, uint32_t is_mark_end);
+
+HAL_StatusTypeDef IrRemote_Send(IrRemote_TypeDef *pIr, IrRemote_FrameTypeDef *pFrame);
+uint32_t IrRemote_IsTxBusy(IrRemote_TypeDef *pIr);
+
+void IrRemote_PCA_IRQHandler(void);
+void IrRemote_Envelope_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,337 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file keypad.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/26
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "keypad.h"
+#include "gpio_exti.h"
+
+#if defined(HAL_GPIO_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  @brief  Push an event, it is only called by the producer (Keypad_ScanTick)
+ */
+static void _Keypad_Push(Keypad_TypeDef *pKeypad, uint32_t key, uint32_t type)
+{
+    uint32_t    head = pKeypad->QHead;
+    uint32_t    next = (head + 1) & (KEYPAD_QUEUE_SIZE - 1);
+
+    if( next == pKeypad->QTail )
+    {
+        pKeypad->DropCnt++;
+        return;
+    }
+
+    pKeypad->Queue[head].Key  = (uint8_t)key;
+    pKeypad->Queue[head].Type = (uint8_t)type;
+
+    /* the event MUST be visible before the head moves */
+    __DMB();
+    pKeypad->QHead = next;
+    return;
+}
+
+static void _Keypad_ColumnIrq(Keypad_TypeDef *pKeypad, uint32_t is_enable)
+{
+    for(uint32_t i = 0; i < pKeypad->Init.ColNum; i++)
+    {
+        GPIO_TypeDef    *GPIOx = pKeypad->Init.Cols[i].Port;
+        uint32_t        bit = (0x1ul << pKeypad->Init.Cols[i].PinIdx);
+
+        if( is_enable )
+        {
+            GPIOx->INTCLR = bit;
+            GPIOx->INTEN |= bit;
+        }
+        else
+        {
+            GPIOx->INTEN &= ~bit;
+        }
+    }
+    return;
+}
+
+static uint32_t _Keypad_IsAnyColumnLow(Keypad_TypeDef *pKeypad)
+{
+    for(uint32_t i = 0; i < pKeypad->Init.ColNum; i++)
+    {
+        if( !(pKeypad->Init.Cols[i].Port->IDR & (0x1ul << pKeypad->Init.Cols[i].PinIdx)) )
+            return 1;
+    }
+    return 0;
+}
+
+static void _Keypad_DriveRows(Keypad_TypeDef *pKeypad, uint32_t is_low)
+{
+    for(uint32_t i = 0; i < pKeypad->Init.RowNum; i++)
+    {
+        uint32_t    bit = (0x1ul << pKeypad->Init.Rows[i].PinIdx);
+
+        if( is_low )
+            pKeypad->Init.Rows[i].Port->ODCLR = bit;
+        else
+            pKeypad->Init.Rows[i].Port->ODSET = bit;
+    }
+    return;
+}
+
+/**
+ *  @brief  Drive all rows low and wait for a column edge
+ */
+static void _Keypad_EnterIdle(Keypad_TypeDef *pKeypad)
+{
+    uint32_t    primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    _Keypad_DriveRows(pKeypad, 1);
+
+    for(volatile uint32_t i = 0; i < KEYPAD_SETTLE_LOOPS; i++) {}
+
+    _Keypad_ColumnIrq(pKeypad, 1);
+    pKeypad->IsScanning = 0;
+
+    /* a key pressed before the interrupts were enabled has no edge */
+    if( _Keypad_IsAnyColumnLow(pKeypad) )
+    {
+        _Keypad_ColumnIrq(pKeypad, 0);
+        pKeypad->IsScanning = 1;
+    }
+
+    __set_PRIMASK(primask);
+    return;
+}
+
+/**
+ *  @brief  Callback of the column EXTI (ISR context), start the scanning
+ */
+static void _Keypad_ColumnCallback(GPIO_TypeDef *GPIOx, uint32_t pin_idx, uint32_t level, void *pUserData)
+{
+    Keypad_TypeDef  *pKeypad = (Keypad_TypeDef*)pUserData;
+
+    UNUSED(GPIOx);
+    UNUSED(pin_idx);
+    UNUSED(level);
+
+    _Keypad_ColumnIrq(pKeypad, 0);
+    pKeypad->IsScanning = 1;
+    return;
+}
+
+/**
+ *  @brief  Scan the matrix
+ *
+ *  @return
+ *      Bitmap of the pressed keys (raw)
+ */
+static uint32_t _Keypad_Scan(Keypad_TypeDef *pKeypad)
+{
+    uint32_t    raw = 0;
+    uint32_t    key = 0;
+
+    _Keypad_DriveRows(pKeypad, 0);
+
+    for(uint32_t r = 0; r < pKeypad->Init.RowNum; r++)
+    {
+        GPIO_TypeDef    *pRowPort = pKeypad->Init.Rows[r].Port;
+        uint32_t        row_bit = (0x1ul << pKeypad->Init.Rows[r].PinIdx);
+
+        pRowPort->ODCLR = row_bit;
+
+        for(volatile uint32_t i = 0; i < KEYPAD_SETTLE_LOOPS; i++) {}
+
+        for(uint32_t c = 0; c < pKeypad->Init.ColNum; c++, key++)
+        {
+            if( !(pKeypad->Init.Cols[c].Port->IDR & (0x1ul << pKeypad->Init.Cols[c].PinIdx)) )
+                raw |= (0x1ul << key);
+        }
+
+        pRowPort->ODSET = row_bit;
+    }
+
+    return raw;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize a keypad, the columns are registered to GpioExti and
+ *          the keypad enters idle
+ *
+ *  @param [in] pKeypad     The keypad
+ *  @param [in] pInit       The configuration
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Keypad_Init(Keypad_TypeDef *pKeypad, Keypad_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        GpioExti_PinConfigTypeDef   config = {0};
+        uint32_t                    i = 0;
+
+        if( !pKeypad || !pInit || !pInit->RowNum || pInit->RowNum > KEYPAD_ROW_MAX ||
+            !pInit->ColNum || pInit->ColNum > KEYPAD_COL_MAX ||
+            pInit->RowNum * pInit->ColNum > KEYPAD_KEY_MAX || pInit->LongPressTicks >= 0xFFFF )
+            break;
+
+        memset(pKeypad, 0x0, sizeof(Keypad_TypeDef));
+        pKeypad->Init = *pInit;
+        pKeypad->Cnt0 = 0xFFFFFFFFul;
+        pKeypad->Cnt1 = 0xFFFFFFFFul;
+
+        config.pfCallback = _Keypad_ColumnCallback;
+        config.pUserData  = pKeypad;
+        config.Trigger    = GPIO_EXTI_TRIGGER_FALLING;
+        config.HoldUs     = 0;
+
+        for(i = 0; i < pInit->ColNum; i++)
+        {
+            if( GpioExti_Register(pInit->Cols[i].Port, pInit->Cols[i].PinIdx, &config) != HAL_OK )
+                break;
+        }
+
+        if( i < pInit->ColNum )
+        {
+            while( i-- )
+                GpioExti_Unregister(pInit->Cols[i].Port, pInit->Cols[i].PinIdx);
+            break;
+        }
+
+        _Keypad_EnterIdle(pKeypad);
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Scan and debounce the keypad, call it periodically (e.g. every 5 ms
+ *          from a timer ISR). It returns immediately when the keypad is idle.
+ *
+ *  @param [in] pKeypad     The keypad
+ *  @return
+ *      None
+ */
+void Keypad_ScanTick(Keypad_TypeDef *pKeypad)
+{
+    uint32_t    raw = 0;
+    uint32_t    toggled = 0;
+
+    if( !pKeypad->IsScanning )
+        return;
+
+    raw = _Keypad_Scan(pKeypad);
+
+    /**
+     *  Vertical counters, a key toggles after 4 consecutive samples differ from
+     *  its debounced state. The counters of the unchanged keys are reset.
+     */
+    toggled        = raw ^ pKeypad->Stable;
+    pKeypad->Cnt0  = ~(pKeypad->Cnt0 & toggled);
+    pKeypad->Cnt1  = pKeypad->Cnt0 ^ (pKeypad->Cnt1 & toggled);
+    toggled       &= pKeypad->Cnt0 & pKeypad->Cnt1;
+    pKeypad->Stable ^= toggled;
+
+    for(uint32_t key = 0, bits = toggled; bits; key++, bits >>= 1)
+    {
+        if( !(bits & 0x1) )
+            continue;
+
+        if( pKeypad->Stable & (0x1ul << key) )
+        {
+            pKeypad->HoldTicks[key] = 0;
+            _Keypad_Push(pKeypad, key, KEYPAD_EVENT_PRESS);
+        }
+        else
+        {
+            _Keypad_Push(pKeypad, key, KEYPAD_EVENT_RELEASE);
+        }
+    }
+
+    if( pKeypad->Init.LongPressTicks )
+    {
+        for(uint32_t key = 0, bits = pKeypad->Stable; bits; key++, bits >>= 1)
+        {
+            if( !(bits & 0x1) || pKeypad->HoldTicks[key] > pKeypad->Init.LongPressTicks )
+                continue;
+
+            /* saturate at LongPressTicks + 1, the event is reported once */
+            if( ++pKeypad->HoldTicks[key] == pKeypad->Init.LongPressTicks )
+                _Keypad_Push(pKeypad, key, KEYPAD_EVENT_LONG_PRESS);
+        }
+    }
+
+    if( !(raw | pKeypad->Stable) )
+        _Keypad_EnterIdle(pKeypad);
+
+    return;
+}
+
+/**
+ *  @brief  Pop an event, it is only called by the consumer (e.g. main loop)
+ *
+ *  @param [in] pKeypad     The keypad
+ *  @param [in] pEvent      The event
+ *  @return
+ *      1: get an event, 0: the queue is empty
+ */
+uint32_t Keypad_GetEvent(Keypad_TypeDef *pKeypad, Keypad_EventTypeDef *pEvent)
+{
+    uint32_t    tail = pKeypad->QTail;
+
+    if( tail == pKeypad->QHead )
+        return 0;
+
+    /* the head is read before the event */
+    __DMB();
+    *pEvent = pKeypad->Queue[tail];
+    __DMB();
+
+    pKeypad->QTail = (tail + 1) & (KEYPAD_QUEUE_SIZE - 1);
+    return 1;
+}
+
+/**
+ *  @brief  The keypad is waiting for a column edge and all events are read,
+ *          the system can sleep
+ *
+ *  @param [in] pKeypad     The keypad
+ *  @return
+ *      1: idle, 0: busy
+ */
+uint32_t Keypad_IsIdle(Keypad_TypeDef *pKeypad)
+{
+    return (!pKeypad->IsScanning && pKeypad->QTail == pKeypad->QHead) ? 1 : 0;
+}
+
+#endif /* HAL_GPIO_MODULE_ENABLED */
@@ -0,0 +1,157 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file keypad.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/26
+ * @license
+ * @description
+ *  Matrix keypad (up to 8x8, max 32 keys) with an event queue.
+ *
+ *  + Idle: all rows are driven low and the falling edge of any column wakes
+ *    the scanner through GpioExti, Keypad_ScanTick() returns immediately and
+ *    the system can sleep.
+ *  + Scanning: Keypad_ScanTick() (e.g. every 5 ms from a timer ISR) drives the
+ *    rows one by one. All keys are debounced in parallel by 2-bits vertical
+ *    counters (4 stable samples), so any number of keys can be held (N-key
+ *    rollover needs a diode on every key, or ghost keys are reported).
+ *  + Press/release/long-press events are pushed into a single-producer/
+ *    single-consumer ring (the tick ISR produces, the main loop consumes with
+ *    Keypad_GetEvent()), no lock is needed.
+ *  + When all keys are released, the rows are driven low and the column
+ *    interrupts are re-enabled.
+ *
+ *  The rows MUST be configured as open-drain outputs and the columns as inputs
+ *  with pull-up by user. GpioExti_IRQHandler() MUST be called from the GPIO
+ *  ISRs of the column ports.
+ */
+
+#ifndef __keypad_H_t2GxR8mN_lWd5_HkJa_s1Vc_uE7qPz3bYoLh__
+#define __keypad_H_t2GxR8mN_lWd5_HkJa_s1Vc_uE7qPz3bYoLh__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define KEYPAD_ROW_MAX              8
+#define KEYPAD_COL_MAX              8
+#define KEYPAD_KEY_MAX              32      /*!< RowNum * ColNum, one 32-bits bitmap */
+
+/**
+ *  Events of the queue, it MUST be a power of 2
+ */
+#ifndef KEYPAD_QUEUE_SIZE
+#define KEYPAD_QUEUE_SIZE           16
+#endif
+
+#if (KEYPAD_QUEUE_SIZE & (KEYPAD_QUEUE_SIZE - 1))
+#error "keypad: KEYPAD_QUEUE_SIZE MUST be a power of 2 !"
+#endif
+
+/**
+ *  Delay loops for the columns to settle after a row is driven low
+ */
+#ifndef KEYPAD_SETTLE_LOOPS
+#define KEYPAD_SETTLE_LOOPS         4
+#endif
+
+typedef enum Keypad_EventType
+{
+    KEYPAD_EVENT_PRESS          = 1,
+    KEYPAD_EVENT_RELEASE,
+    KEYPAD_EVENT_LONG_PRESS,
+
+} Keypad_EventTypeTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief A row or column pin
+ */
+typedef struct Keypad_Pin
+{
+    GPIO_TypeDef        *Port;
+    uint32_t            PinIdx;     /*!< 0 ~ 15 */
+
+} Keypad_PinTypeDef;
+
+/**
+ *  @brief Configuration of a keypad
+ */
+typedef struct Keypad_Init
+{
+    Keypad_PinTypeDef   Rows[KEYPAD_ROW_MAX];
+    uint32_t            RowNum;
+    Keypad_PinTypeDef   Cols[KEYPAD_COL_MAX];
+    uint32_t            ColNum;
+
+    uint32_t            LongPressTicks;     /*!< Scan ticks of a long press (< 0xFFFF), 0: disable */
+
+} Keypad_InitTypeDef;
+
+/**
+ *  @brief A key event, the key index is (row * ColNum + col)
+ */
+typedef struct Keypad_Event
+{
+    uint8_t             Key;
+    uint8_t             Type;       /*!< Keypad_EventTypeTypeDef */
+
+} Keypad_EventTypeDef;
+
+/**
+ *  @brief A keypad
+ */
+typedef struct Keypad
+{
+    Keypad_InitTypeDef  Init;
+
+    volatile uint32_t   IsScanning;
+
+    uint32_t            Stable;         /*!< Debounced pressed keys */
+    uint32_t            Cnt0;           /*!< Vertical counter, bit 0 */
+    uint32_t            Cnt1;           /*!< Vertical counter, bit 1 */
+    uint16_t            HoldTicks[KEYPAD_KEY_MAX];
+
+    volatile uint32_t   QHead;          /*!< Written by the producer only */
+    volatile uint32_t   QTail;          /*!< Written by the consumer only */
+    uint32_t            DropCnt;        /*!< Events lost by a full queue */
+    Keypad_EventTypeDef Queue[KEYPAD_QUEUE_SIZE];
+
+} Keypad_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef Keypad_Init(Keypad_TypeDef *pKeypad, Keypad_InitTypeDef *pInit);
+
+void Keypad_ScanTick(Keypad_TypeDef *pKeypad);
+uint32_t Keypad_GetEvent(Keypad_TypeDef *pKeypad, Keypad_EventTypeDef *pEvent);
+uint32_t Keypad_IsIdle(Keypad_TypeDef *pKeypad);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file par_bus.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/25
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "par_bus.h"
+
+#if defined(HAL_GPIO_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define PAR_BUS_BENCH_BUF_SIZE      64
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static uint32_t _ParBus_SetMask(ParBus_TypeDef *pBus, uint32_t value)
+{
+    uint32_t    set = pBus->SetLut[0][value & 0xFF];
+
+#if (PAR_BUS_LANE_MAX > 1)
+    if( pBus->LaneNum > 1 )
+        set |= pBus->SetLut[1][(value >> 8) & 0xFF];
+#endif
+
+    return set;
+}
+
+static void _ParBus_WriteBlock8(ParBus_TypeDef *pBus, const uint8_t *pData, uint32_t count)
+{
+    GPIO_TypeDef    *GPIOx = pBus->Init.DataPort;
+    const uint16_t  *pLut = pBus->SetLut[0];
+    uint32_t        data_mask = pBus->DataMask;
+    uint32_t        strobe = pBus->Init.StrobePin;
+    __IO uint32_t   *pAssert = pBus->pStrobeAssert;
+    __IO uint32_t   *pDeassert = pBus->pStrobeDeassert;
+
+    if( pBus->IsStrobeMerged )
+    {
+        uint32_t    clr_extra = pBus->ClrExtra;
+        uint32_t    set_extra = pBus->SetExtra;
+
+        while( count-- )
+        {
+            uint32_t    set = pLut[*pData++];
+
+            GPIOx->ODCLR = (set ^ data_mask) | clr_extra;
+            GPIOx->ODSET = set | set_extra;
+            *pDeassert   = strobe;
+        }
+        return;
+    }
+
+    while( count-- )
+    {
+        uint32_t    set = pLut[*pData++];
+
+        GPIOx->ODCLR = set ^ data_mask;
+        GPIOx->ODSET = set;
+        *pAssert     = strobe;
+        *pDeassert   = strobe;
+    }
+    return;
+}
+
+#if (PAR_BUS_LANE_MAX > 1)
+static void _ParBus_WriteBlock16(ParBus_TypeDef *pBus, const uint16_t *pData, uint32_t count)
+{
+    GPIO_TypeDef    *GPIOx = pBus->Init.DataPort;
+    const uint16_t  *pLutL = pBus->SetLut[0];
+    const uint16_t  *pLutH = pBus->SetLut[1];
+    uint32_t        data_mask = pBus->DataMask;
+    uint32_t        strobe = pBus->Init.StrobePin;
+    __IO uint32_t   *pAssert = pBus->pStrobeAssert;
+    __IO uint32_t   *pDeassert = pBus->pStrobeDeassert;
+
+    if( pBus->IsStrobeMerged )
+    {
+        uint32_t    clr_extra = pBus->ClrExtra;
+        uint32_t    set_extra = pBus->SetExtra;
+
+        while( count-- )
+        {
+            uint32_t    value = *pData++;
+            uint32_t    set = pLutL[value & 0xFF] | pLutH[value >> 8];
+
+            GPIOx->ODCLR = (set ^ data_mask) | clr_extra;
+            GPIOx->ODSET = set | set_extra;
+            *pDeassert   = strobe;
+        }
+        return;
+    }
+
+    while( count-- )
+    {
+        uint32_t    value = *pData++;
+        uint32_t    set = pLutL[value & 0xFF] | pLutH[value >> 8];
+
+        GPIOx->ODCLR = set ^ data_mask;
+        GPIOx->ODSET = set;
+        *pAssert     = strobe;
+        *pDeassert   = strobe;
+    }
+    return;
+}
+#endif
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize a bus and build the lookup tables, the strobe is deasserted
+ *
+ *  @param [in] pBus        The bus
+ *  @param [in] pInit       The configuration
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef ParBus_Init(ParBus_TypeDef *pBus, ParBus_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        uint32_t    bit = 0;
+
+        if( !pBus || !pInit || !pInit->DataPort || !pInit->StrobePort || !pInit->StrobePin ||
+            !pInit->WidthBits || pInit->WidthBits > PAR_BUS_WIDTH_MAX )
+            break;
+
+        memset(pBus, 0x0, sizeof(ParBus_TypeDef));
+        pBus->Init    = *pInit;
+        pBus->LaneNum = (pInit->WidthBits + 7) >> 3;
+
+        for(bit = 0; bit < pInit->WidthBits; bit++)
+        {
+            uint32_t    pin = 0;
+
+            if( pInit->DataPins[bit] > 15 )
+                break;
+
+            pin = (0x1ul << pInit->DataPins[bit]);
+            if( pBus->DataMask & pin )
+                break;
+
+            pBus->DataMask |= pin;
+        }
+
+        if( bit < pInit->WidthBits )
+            break;
+
+        pBus->IsStrobeMerged = (pInit->StrobePort == pInit->DataPort);
+        if( pBus->IsStrobeMerged && (pBus->DataMask & pInit->StrobePin) )
+            break;
+
+        for(uint32_t lane = 0; lane < pBus->LaneNum; lane++)
+        {
+            for(uint32_t value = 0; value < 256; value++)
+            {
+                uint32_t    set = 0;
+
+                for(uint32_t b = 0; b < 8 && (lane * 8 + b) < pInit->WidthBits; b++)
+                {
+                    if( value & (0x1ul << b) )
+                        set |= (0x1ul << pInit->DataPins[lane * 8 + b]);
+                }
+
+                pBus->SetLut[lane][value] = (uint16_t)set;
+            }
+        }
+
+        if( pInit->IsStrobeActiveLow )
+        {
+            pBus->pStrobeAssert   = &pInit->StrobePort->ODCLR;
+            pBus->pStrobeDeassert = &pInit->StrobePort->ODSET;
+            pBus->ClrExtra        = (pBus->IsStrobeMerged) ? pInit->StrobePin : 0;
+        }
+        else
+        {
+            pBus->pStrobeAssert   = &pInit->StrobePort->ODSET;
+            pBus->pStrobeDeassert = &pInit->StrobePort->ODCLR;
+            pBus->SetExtra        = (pBus->IsStrobeMerged) ? pInit->StrobePin : 0;
+        }
+
+        *pBus->pStrobeDeassert = pInit->StrobePin;
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Write one bus word
+ *
+ *  @param [in] pBus        The bus
+ *  @param [in] value       The value
+ *  @return
+ *      None
+ */
+void ParBus_Write(ParBus_TypeDef *pBus, uint32_t value)
+{
+    GPIO_TypeDef    *GPIOx = pBus->Init.DataPort;
+    uint32_t        set = _ParBus_SetMask(pBus, value);
+
+    GPIOx->ODCLR = (set ^ pBus->DataMask) | pBus->ClrExtra;
+    GPIOx->ODSET = set | pBus->SetExtra;
+
+    if( !pBus->IsStrobeMerged )
+        *pBus->pStrobeAssert = pBus->Init.StrobePin;
+
+    *pBus->pStrobeDeassert = pBus->Init.StrobePin;
+    return;
+}
+
+/**
+ *  @brief  Write a block of bus words
+ *
+ *  @param [in] pBus        The bus
+ *  @param [in] pData       The words, uint8_t for 1 ~ 8 bits bus, uint16_t for 9 ~ 16 bits bus
+ *  @param [in] count       Number of words
+ *  @return
+ *      None
+ */
+void ParBus_WriteBlock(ParBus_TypeDef *pBus, const void *pData, uint32_t count)
+{
+#if (PAR_BUS_LANE_MAX > 1)
+    if( pBus->LaneNum > 1 )
+    {
+        _ParBus_WriteBlock16(pBus, (const uint16_t*)pData, count);
+        return;
+    }
+#endif
+
+    _ParBus_WriteBlock8(pBus, (const uint8_t*)pData, count);
+    return;
+}
+
+/**
+ *  @brief  Write the same word repeatedly (e.g. fill a display area),
+ *          the data pins are set once and only the strobe is pulsed
+ *
+ *  @param [in] pBus        The bus
+ *  @param [in] value       The value
+ *  @param [in] count       Number of words
+ *  @return
+ *      None
+ */
+void ParBus_Fill(ParBus_TypeDef *pBus, uint32_t value, uint32_t count)
+{
+    __IO uint32_t   *pAssert = pBus->pStrobeAssert;
+    __IO uint32_t   *pDeassert = pBus->pStrobeDeassert;
+    uint32_t        strobe = pBus->Init.StrobePin;
+
+    if( !count )
+        return;
+
+    ParBus_Write(pBus, value);
+
+    while( --count )
+    {
+        *pAssert   = strobe;
+        *pDeassert = strobe;
+    }
+    return;
+}
+
+/**
+ *  @brief  Measure the throughput of ParBus_WriteBlock(), the interrupts are
+ *          not disabled. The count SHOULD take more than 100 ms for the
+ *          resolution of HAL_GetTick().
+ *
+ *  @param [in] pBus        The bus
+ *  @param [in] count       Number of words to write
+ *  @return
+ *      KBytes per second (MB/s = KB/s / 1000), 0 if the duration is too short
+ */
+uint32_t ParBus_Benchmark(ParBus_TypeDef *pBus, uint32_t count)
+{
+    uint16_t    buf[PAR_BUS_BENCH_BUF_SIZE / 2];
+    uint32_t    words_per_buf = PAR_BUS_BENCH_BUF_SIZE / pBus->LaneNum;
+    uint32_t    remain = count;
+    uint32_t    start = 0;
+    uint32_t    elapsed = 0;
+
+    for(uint32_t i = 0; i < PAR_BUS_BENCH_BUF_SIZE / 2; i++)
+        buf[i] = (uint16_t)(0xA55Au ^ (i * 0x0101u));
+
+    start = HAL_GetTick();
+
+    while( remain )
+    {
+        uint32_t    words = (remain > words_per_buf) ? words_per_buf : remain;
+
+        ParBus_WriteBlock(pBus, buf, words);
+        remain -= words;
+    }
+
+    elapsed = HAL_GetTick() - start;
+    if( !elapsed )
+        return 0;
+
+    /* bytes per ms is KB/s */
+    return (uint32_t)(((uint64_t)count * pBus->LaneNum) / elapsed);
+}
+
+#endif /* HAL_GPIO_MODULE_ENABLED */
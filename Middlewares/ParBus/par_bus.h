@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file par_bus.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/25
+ * @license
+ * @description
+ *  Parallel 8/16-bits write bus on GPIO (8080-style LCD, external latches).
+ *
+ *  + The logical bus bits are mapped to contiguous or scattered pins of one
+ *    GPIO port, the ODSET mask of every byte value of every byte lane is
+ *    precomputed in a 256-entry table. The ODCLR mask is the complement in the
+ *    data pins, so a write never reads or modifies ODR.
+ *  + When the strobe is on the data port, a write is 3 stores:
+ *      ODCLR = clear-mask | strobe-assert, ODSET = set-mask | strobe-assert,
+ *      strobe-deassert
+ *    With the strobe on another port, a write is 4 stores.
+ *  + ParBus_Fill() sets the data once and only pulses the strobe.
+ *
+ *  No delay is inserted, the strobe pulse is one store (>= 2 HCLK cycles),
+ *  check the write timing of the device at high HCLK.
+ */
+
+#ifndef __par_bus_H_n4YcT7kW_lBs2_HgMe_s5Rq_uD8vLa3hZxKi__
+#define __par_bus_H_n4YcT7kW_lBs2_HgMe_s5Rq_uD8vLa3hZxKi__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  Max width of a bus (8 or 16), every byte lane takes a 512 bytes table
+ */
+#ifndef PAR_BUS_WIDTH_MAX
+#define PAR_BUS_WIDTH_MAX           16
+#endif
+
+#define PAR_BUS_LANE_MAX            (PAR_BUS_WIDTH_MAX / 8)
+
+#if (PAR_BUS_WIDTH_MAX != 8) && (PAR_BUS_WIDTH_MAX != 16)
+#error "par_bus: PAR_BUS_WIDTH_MAX MUST be 8 or 16 !"
+#endif
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief Initial configuration of a bus, the pins MUST be configured as
+ *         output by user
+ */
+typedef struct ParBus_Init
+{
+    GPIO_TypeDef        *DataPort;
+    uint8_t             DataPins[PAR_BUS_WIDTH_MAX];    /*!< Pin index (0 ~ 15) of every bus bit, LSB first */
+    uint32_t            WidthBits;                      /*!< 1 ~ PAR_BUS_WIDTH_MAX */
+
+    GPIO_TypeDef        *StrobePort;                    /*!< WR of 8080 or LE of a latch */
+    uint32_t            StrobePin;                      /*!< GPIO_PIN_x */
+    uint32_t            IsStrobeActiveLow;              /*!< 1: 8080 WR (latched at the rising edge) */
+
+} ParBus_InitTypeDef;
+
+/**
+ *  @brief A bus
+ */
+typedef struct ParBus
+{
+    ParBus_InitTypeDef  Init;
+
+    uint32_t            DataMask;       /*!< All data pins */
+    uint32_t            LaneNum;
+
+    /* strobe assert masks merged into the data stores (strobe on the data port) */
+    uint32_t            IsStrobeMerged;
+    uint32_t            ClrExtra;
+    uint32_t            SetExtra;
+    __IO uint32_t       *pStrobeAssert;     /*!< ODCLR or ODSET of the strobe port */
+    __IO uint32_t       *pStrobeDeassert;
+
+    uint16_t            SetLut[PAR_BUS_LANE_MAX][256];  /*!< ODSET mask of every byte value of every lane */
+
+} ParBus_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef ParBus_Init(ParBus_TypeDef *pBus, ParBus_InitTypeDef *pInit);
+
+void ParBus_Write(ParBus_TypeDef *pBus, uint32_t value);
+void ParBus_WriteBlock(ParBus_TypeDef *pBus, const void *pData, uint32_t count);
+void ParBus_Fill(ParBus_TypeDef *pBus, uint32_t value, uint32_t count);
+
+uint32_t ParBus_Benchmark(ParBus_TypeDef *pBus, uint32_t count);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,328 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file pca_meas.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/18
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "pca_meas.h"
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define PCA_MEAS_CCF_ALL_Msk        (PCA_CR_CCF0 | PCA_CR_CCF1 | PCA_CR_CCF2 | PCA_CR_CCF3 | PCA_CR_CCF4)
+
+typedef enum pca_meas_edge
+{
+    PCA_MEAS_EDGE_NONE      = 0,    /*!< Wait the first rising edge */
+    PCA_MEAS_EDGE_RISING,           /*!< Last captured edge is rising */
+    PCA_MEAS_EDGE_FALLING,          /*!< Last captured edge is falling */
+
+} pca_meas_edge_t;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _CCAPM(__PCAx__, __CH__)        (*(&(__PCAx__)->CCAPM0 + (__CH__)))
+#define _CCAP(__PCAx__, __CH__)         (*(&(__PCAx__)->CCAP0 + (__CH__)))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct pca_meas_ch
+{
+    uint32_t                last_rise;
+    uint32_t                last_fall;
+    uint32_t                period_sum;
+    uint32_t                high_sum;
+    uint16_t                sample_cnt;
+    uint16_t                idle_ovf;
+    pca_meas_edge_t         edge;
+
+    PcaMeas_ResultTypeDef   result;
+
+} pca_meas_ch_t;
+
+typedef struct pca_meas_dev
+{
+    PcaMeas_InitTypeDef     Init;
+    uint32_t                ovf_high;       /*!< High 16-bits of the extended counter */
+    pca_meas_ch_t           ch[PCA_MEAS_CHANNEL_NUM];
+
+} pca_meas_dev_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static pca_meas_dev_t       g_PcaMeasDev;
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static void _PcaMeas_Capture(PCA_TypeDef *PCAx, uint32_t ch_idx, uint32_t cap)
+{
+    pca_meas_ch_t   *pCh = &g_PcaMeasDev.ch[ch_idx];
+
+    pCh->idle_ovf = 0;
+
+    if( pCh->edge != PCA_MEAS_EDGE_RISING )
+    {
+        /* rising edge, next is falling */
+        MODIFY_REG(_CCAPM(PCAx, ch_idx), PCA_CCAPM0_CAPP | PCA_CCAPM0_CAPN, PCA_INPUT_POLARITY_FALLING);
+
+        if( pCh->edge == PCA_MEAS_EDGE_FALLING )
+        {
+            pCh->period_sum += cap - pCh->last_rise;
+            pCh->high_sum   += pCh->last_fall - pCh->last_rise;
+
+            if( ++pCh->sample_cnt == (0x1u << g_PcaMeasDev.Init.AvgShift) )
+            {
+                pCh->result.Period   = pCh->period_sum >> g_PcaMeasDev.Init.AvgShift;
+                pCh->result.HighTime = pCh->high_sum >> g_PcaMeasDev.Init.AvgShift;
+                pCh->result.IsValid  = 1;
+                pCh->result.UpdateCnt++;
+
+                pCh->period_sum = 0;
+                pCh->high_sum   = 0;
+                pCh->sample_cnt = 0;
+            }
+        }
+
+        pCh->last_rise = cap;
+        pCh->edge      = PCA_MEAS_EDGE_RISING;
+    }
+    else
+    {
+        /* falling edge, next is rising */
+        MODIFY_REG(_CCAPM(PCAx, ch_idx), PCA_CCAPM0_CAPP | PCA_CCAPM0_CAPN, PCA_INPUT_POLARITY_RISING);
+
+        pCh->last_fall = cap;
+        pCh->edge      = PCA_MEAS_EDGE_FALLING;
+    }
+    return;
+}
+
+static void _PcaMeas_Overflow(void)
+{
+    pca_meas_dev_t  *pDev = &g_PcaMeasDev;
+
+    pDev->ovf_high += 0x10000ul;
+
+    if( pDev->Init.TimeoutOvf == 0 )
+        return;
+
+    for(int i = 0; i < PCA_MEAS_CHANNEL_NUM; i++)
+    {
+        pca_meas_ch_t   *pCh = &pDev->ch[i];
+
+        if( !(pDev->Init.ChannelMask & (0x1ul << i)) || pCh->idle_ovf > pDev->Init.TimeoutOvf )
+            continue;
+
+        if( ++pCh->idle_ovf > pDev->Init.TimeoutOvf )
+        {
+            /* no signal, restart from the first rising edge */
+            MODIFY_REG(_CCAPM(pDev->Init.hpca->Instance, i),
+                       PCA_CCAPM0_CAPP | PCA_CCAPM0_CAPN, PCA_INPUT_POLARITY_RISING);
+
+            pCh->edge            = PCA_MEAS_EDGE_NONE;
+            pCh->period_sum      = 0;
+            pCh->high_sum        = 0;
+            pCh->sample_cnt      = 0;
+            pCh->result.IsValid  = 0;
+            pCh->result.UpdateCnt++;
+        }
+    }
+    return;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the PCA capture channels and start the measurement
+ *
+ *  @param [in] pInit       The configuration of the measurement
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef PcaMeas_Init(PcaMeas_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+    pca_meas_dev_t      *pDev = &g_PcaMeasDev;
+
+    do {
+        PCA_IC_InitTypeDef  ic_config = { .ICPolarity = PCA_INPUT_POLARITY_RISING, };
+        uint32_t            intid = PCA_IT_OVERFLOW;
+
+        if( !pInit || !pInit->hpca || !pInit->ClockFreq ||
+            pInit->AvgShift > PCA_MEAS_AVG_SHIFT_MAX ||
+            !(pInit->ChannelMask & ((0x1ul << PCA_MEAS_CHANNEL_NUM) - 1)) )
+            break;
+
+        memset(pDev, 0x0, sizeof(pca_meas_dev_t));
+        pDev->Init = *pInit;
+
+        if( HAL_PCA_IC_Init(pInit->hpca) != HAL_OK )
+            break;
+
+        for(int i = 0; i < PCA_MEAS_CHANNEL_NUM; i++)
+        {
+            if( !(pInit->ChannelMask & (0x1ul << i)) )
+                continue;
+
+            HAL_PCA_IC_ConfigChannel(pInit->hpca, &ic_config, (0x1ul << i));
+            intid |= (0x1ul << i);  /* PCA_IT_CCx has the same bit of PCA_CHANNEL_x */
+        }
+
+        __HAL_PCA_CLEAR_IT(pInit->hpca, PCA_MEAS_CCF_ALL_Msk | PCA_FLAG_OVERFLOW);
+
+        status = HAL_PCA_Start_IT(pInit->hpca, intid);
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Stop the measurement
+ *
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef PcaMeas_DeInit(void)
+{
+    pca_meas_dev_t  *pDev = &g_PcaMeasDev;
+
+    if( !pDev->Init.hpca )
+        return HAL_ERROR;
+
+    HAL_PCA_Stop_IT(pDev->Init.hpca, PCA_IT_OVERFLOW | (pDev->Init.ChannelMask & 0x1Ful));
+
+    memset(pDev, 0x0, sizeof(pca_meas_dev_t));
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Get the averaged result of a channel
+ *
+ *  @param [in] Channel     Target channel, PCA_CHANNEL_x
+ *  @param [in] pResult     Report the result
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef PcaMeas_GetResult(uint32_t Channel, PcaMeas_ResultTypeDef *pResult)
+{
+    pca_meas_dev_t  *pDev = &g_PcaMeasDev;
+    uint32_t        primask = 0;
+    uint32_t        ch_idx = 0;
+
+    if( !pResult || !(Channel & pDev->Init.ChannelMask) )
+        return HAL_ERROR;
+
+    while( !(Channel & (0x1ul << ch_idx)) )
+        ch_idx++;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    *pResult = pDev->ch[ch_idx].result;
+    __set_PRIMASK(primask);
+
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Get the frequency of a channel
+ *
+ *  @param [in] Channel     Target channel, PCA_CHANNEL_x
+ *  @param [in] Scale       Unit of the frequency, 1: Hz, 10: 0.1Hz, 100: 0.01Hz
+ *                          (ClockFreq * Scale must be less than 2^32)
+ *  @return
+ *      Frequency in (1 / Scale) Hz, 0 if no valid signal
+ */
+uint32_t PcaMeas_GetFrequency(uint32_t Channel, uint32_t Scale)
+{
+    PcaMeas_ResultTypeDef   result = {0};
+
+    if( PcaMeas_GetResult(Channel, &result) != HAL_OK ||
+        !result.IsValid || !result.Period )
+        return 0;
+
+    return (g_PcaMeasDev.Init.ClockFreq * Scale + (result.Period >> 1)) / result.Period;
+}
+
+/**
+ *  @brief  Get the duty cycle of a channel
+ *
+ *  @param [in] Channel     Target channel, PCA_CHANNEL_x
+ *  @param [in] Scale       Full scale of the duty, e.g. 100: percent, 1000: permille
+ *  @return
+ *      Duty cycle (0 ~ Scale), 0 if no valid signal
+ */
+uint32_t PcaMeas_GetDuty(uint32_t Channel, uint32_t Scale)
+{
+    PcaMeas_ResultTypeDef   result = {0};
+
+    if( PcaMeas_GetResult(Channel, &result) != HAL_OK ||
+        !result.IsValid || !result.Period )
+        return 0;
+
+    return (uint32_t)(((uint64_t)result.HighTime * Scale + (result.Period >> 1)) / result.Period);
+}
+
+/**
+ *  @brief  The service routine of the measurement,
+ *          call it from PCA_IRQHandler() instead of HAL_PCA_IRQHandler()
+ *
+ *  @return
+ *      None
+ */
+void PcaMeas_IRQHandler(void)
+{
+    pca_meas_dev_t  *pDev = &g_PcaMeasDev;
+    PCA_TypeDef     *PCAx = 0;
+    uint32_t        flags = 0;
+    uint32_t        high = 0;
+    uint32_t        is_ovf = 0;
+
+    if( !pDev->Init.hpca )
+        return;
+
+    PCAx  = pDev->Init.hpca->Instance;
+    flags = PCAx->CR & (PCA_MEAS_CCF_ALL_Msk | PCA_CR_CF);
+    PCAx->INTCLR = flags;
+
+    high = pDev->ovf_high;
+
+    if( flags & PCA_CR_CF )
+    {
+        is_ovf = 1;
+        _PcaMeas_Overflow();
+    }
+
+    flags &= (pDev->Init.ChannelMask & PCA_MEAS_CCF_ALL_Msk);
+
+    for(uint32_t i = 0; flags; i++, flags >>= 1)
+    {
+        uint32_t    cap = 0;
+
+        if( !(flags & 0x1ul) )
+            continue;
+
+        cap = _CCAP(PCAx, i) & 0xFFFFul;
+
+        /* A small capture with a pending overflow is captured after the overflow */
+        cap += (is_ovf && cap < 0x8000ul) ? pDev->ovf_high : high;
+
+        _PcaMeas_Capture(PCAx, i, cap);
+    }
+
+    return;
+}
+
+#endif /* HAL_PCA_MODULE_ENABLED */
@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file pca_meas.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/18
+ * @license
+ * @description
+ *  Frequency and duty-cycle measurement on the 5 PCA capture channels.
+ *
+ *  + The 16-bits captures are extended to 32-bits with the PCA overflow.
+ *  + Every channel alternates the capture edge (rising -> falling -> rising),
+ *    the ISR only accumulates the period and the high time.
+ *  + The averaged results are published every (1 << AvgShift) periods and
+ *    the frequency/duty math is done in the caller context.
+ */
+
+#ifndef __pca_meas_H_r4WcN8qY_lHe2_HtZk_s6mB_uV1pDx9aFjKs__
+#define __pca_meas_H_r4WcN8qY_lHe2_HtZk_s6mB_uV1pDx9aFjKs__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define PCA_MEAS_CHANNEL_NUM            5
+
+/**
+ *  Maximum averaging, (1 << PCA_MEAS_AVG_SHIFT_MAX) periods
+ */
+#define PCA_MEAS_AVG_SHIFT_MAX          8
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct PcaMeas_Init
+{
+    PCA_HandleTypeDef   *hpca;          /*!< PCA handle, Instance and Init (clock source) are set by user */
+    uint32_t            ClockFreq;      /*!< PCA counter clock in Hz (e.g. PCLK / 4) */
+    uint32_t            ChannelMask;    /*!< Measured channels, PCA_CHANNEL_x */
+    uint32_t            AvgShift;       /*!< Average (1 << AvgShift) periods, 0 ~ PCA_MEAS_AVG_SHIFT_MAX */
+    uint32_t            TimeoutOvf;     /*!< The result is invalidated after TimeoutOvf counter overflows
+                                             (65536 counts) without edge, 0: never */
+} PcaMeas_InitTypeDef;
+
+/**
+ *  @brief Averaged result of one channel
+ */
+typedef struct PcaMeas_Result
+{
+    uint32_t    Period;         /*!< Period in PCA counts */
+    uint32_t    HighTime;       /*!< High time in PCA counts */
+    uint32_t    UpdateCnt;      /*!< Increased every time the result is published */
+    uint32_t    IsValid;        /*!< 0: no signal (timeout) or not enough edges yet */
+
+} PcaMeas_ResultTypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef PcaMeas_Init(PcaMeas_InitTypeDef *pInit);
+HAL_StatusTypeDef PcaMeas_DeInit(void);
+
+HAL_StatusTypeDef PcaMeas_GetResult(uint32_t Channel, PcaMeas_ResultTypeDef *pResult);
+
+uint32_t PcaMeas_GetFrequency(uint32_t Channel, uint32_t Scale);
+uint32_t PcaMeas_GetDuty(uint32_t Channel, uint32_t Scale);
+
+void PcaMeas_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file pwm_seq.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/15
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "pwm_seq.h"
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+/* PWM_SEQ_TIMER_MAX for the instances without CCR1~CCR4 (TIM1A/TIM1B/TIM2A/TIM2B/TIM2C) */
+#define _PWM_SEQ_SLOT(__TIMx__)         (((__TIMx__) == TIM1) ? 0 :                     \
+                                         ((__TIMx__) == TIM2) ? 1 : PWM_SEQ_TIMER_MAX)
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static PwmSeq_TypeDef       *g_pPwmSeq[PWM_SEQ_TIMER_MAX] = {0};
+
+static void _PwmSeq_UpdateISR(TIM_HandleTypeDef *htim);
+
+static const pTIM_CallbackTypeDef   g_PwmSeq_FastCallbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_UPDATE] = _PwmSeq_UpdateISR,
+};
+
+static const uint32_t       g_PwmSeq_ChannelPreload[PWM_SEQ_CHANNEL_MAX] =
+{
+    TIM_CCMR1_OUT_OC1PE, TIM_CCMR1_OUT_OC2PE, TIM_CCMR2_OUT_OC3PE, TIM_CCMR2_OUT_OC4PE,
+};
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  @brief  TIM update ISR, load the next step to the preload registers
+ *
+ *  @param [in] htim        TIM handle
+ *  @return
+ *      None
+ */
+static void _PwmSeq_UpdateISR(TIM_HandleTypeDef *htim)
+{
+    PwmSeq_TypeDef      *pSeq = g_pPwmSeq[_PWM_SEQ_SLOT(htim->Instance)];
+    uint16_t            *pCur = pSeq->pCur;
+    __IO uint32_t       **ppCCR = pSeq->pCCR;
+
+    /* unrolled, the cost only depends on the number of channels */
+    switch( pSeq->ChannelCnt )
+    {
+        case 4: *ppCCR[3] = pCur[3];    /* fall through */
+        case 3: *ppCCR[2] = pCur[2];    /* fall through */
+        case 2: *ppCCR[1] = pCur[1];    /* fall through */
+        default:
+            *ppCCR[0] = pCur[0];
+            break;
+    }
+
+    pCur += pSeq->ChannelCnt;
+
+    if( pCur == pSeq->pHalf )
+    {
+        if( pSeq->Init.pfHalfCallback )
+            pSeq->Init.pfHalfCallback(pSeq);
+    }
+    else if( pCur == pSeq->pEnd )
+    {
+        pCur = pSeq->Init.pBuffer;
+
+        if( !pSeq->Init.IsLoop )
+        {
+            /* the last step is loaded, keep it */
+            __HAL_TIM_DISABLE_IT(htim, TIM_IT_UPDATE);
+            pSeq->State = PWM_SEQ_STATE_IDLE;
+        }
+
+        if( pSeq->Init.pfFullCallback )
+            pSeq->Init.pfFullCallback(pSeq);
+    }
+
+    pSeq->pCur = pCur;
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize a PWM sequencer
+ *
+ *  @param [in] pSeq        The sequencer object
+ *  @param [in] pInit       The configuration of the sequencer
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef PwmSeq_Init(PwmSeq_TypeDef *pSeq, PwmSeq_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        TIM_TypeDef     *TIMx = 0;
+
+        if( !pSeq || !pInit || !pInit->htim || !pInit->pBuffer ||
+            pInit->StepNum < 2 || !(pInit->ChannelMask & PWM_SEQ_CHANNEL_ALL) ||
+            _PWM_SEQ_SLOT(pInit->htim->Instance) >= PWM_SEQ_TIMER_MAX )
+            break;
+
+        memset(pSeq, 0x0, sizeof(PwmSeq_TypeDef));
+        pSeq->Init = *pInit;
+
+        TIMx = pInit->htim->Instance;
+        for(int ch = 0; ch < PWM_SEQ_CHANNEL_MAX; ch++)
+        {
+            if( !(pInit->ChannelMask & (0x1ul << ch)) )
+                continue;
+
+            pSeq->pCCR[pSeq->ChannelCnt++] = &TIMx->CCR1 + ch;
+        }
+
+        pSeq->pHalf = pInit->pBuffer + (pInit->StepNum >> 1) * pSeq->ChannelCnt;
+        pSeq->pEnd  = pInit->pBuffer + pInit->StepNum * pSeq->ChannelCnt;
+        pSeq->State = PWM_SEQ_STATE_IDLE;
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Start the sequence from the head of the buffer
+ *
+ *  @param [in] pSeq        The sequencer object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef PwmSeq_Start(PwmSeq_TypeDef *pSeq)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        TIM_HandleTypeDef   *htim = 0;
+        uint32_t            slot = 0;
+
+        if( !pSeq || !pSeq->Init.htim || pSeq->State != PWM_SEQ_STATE_IDLE )
+            break;
+
+        htim = pSeq->Init.htim;
+        slot = _PWM_SEQ_SLOT(htim->Instance);
+        if( slot >= PWM_SEQ_TIMER_MAX )
+            break;
+
+        if( g_pPwmSeq[slot] && g_pPwmSeq[slot] != pSeq &&
+            g_pPwmSeq[slot]->State == PWM_SEQ_STATE_BUSY )
+        {
+            status = HAL_BUSY;
+            break;
+        }
+
+        g_pPwmSeq[slot] = pSeq;
+
+        /* Enable the CCR preload, the new duty takes effect at the next update event */
+        for(int ch = 0; ch < PWM_SEQ_CHANNEL_MAX; ch++)
+        {
+            if( !(pSeq->Init.ChannelMask & (0x1ul << ch)) )
+                continue;
+
+            if( ch < 2 )    SET_BIT(htim->Instance->CCMR1_OUT, g_PwmSeq_ChannelPreload[ch]);
+            else            SET_BIT(htim->Instance->CCMR2_OUT, g_PwmSeq_ChannelPreload[ch]);
+        }
+
+        /* Load the first step to the active registers */
+        for(uint32_t i = 0; i < pSeq->ChannelCnt; i++)
+            *pSeq->pCCR[i] = pSeq->Init.pBuffer[i];
+
+        WRITE_REG(htim->Instance->EGR, TIM_EGR_UG);
+        __HAL_TIM_CLEAR_IT(htim, TIM_IT_UPDATE);
+
+        pSeq->pCur  = pSeq->Init.pBuffer + pSeq->ChannelCnt;
+        pSeq->State = PWM_SEQ_STATE_BUSY;
+
+        HAL_TIM_RegisterFastCallbacks(htim, g_PwmSeq_FastCallbacks);
+        __HAL_TIM_ENABLE_IT(htim, TIM_IT_UPDATE);
+
+        for(int ch = 0; ch < PWM_SEQ_CHANNEL_MAX; ch++)
+        {
+            if( pSeq->Init.ChannelMask & (0x1ul << ch) )
+                HAL_TIM_PWM_Start(htim, (uint32_t)ch << 2);
+        }
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Stop the sequence and the PWM outputs
+ *
+ *  @param [in] pSeq        The sequencer object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef PwmSeq_Stop(PwmSeq_TypeDef *pSeq)
+{
+    TIM_HandleTypeDef   *htim = 0;
+    uint32_t            slot = 0;
+
+    if( !pSeq || !pSeq->Init.htim )
+        return HAL_ERROR;
+
+    htim = pSeq->Init.htim;
+    slot = _PWM_SEQ_SLOT(htim->Instance);
+
+    /* Not started, the TIM may be used by another sequencer or the user */
+    if( slot >= PWM_SEQ_TIMER_MAX || g_pPwmSeq[slot] != pSeq )
+    {
+        pSeq->State = PWM_SEQ_STATE_IDLE;
+        return HAL_OK;
+    }
+
+    __HAL_TIM_DISABLE_IT(htim, TIM_IT_UPDATE);
+
+    for(int ch = 0; ch < PWM_SEQ_CHANNEL_MAX; ch++)
+    {
+        if( pSeq->Init.ChannelMask & (0x1ul << ch) )
+            HAL_TIM_PWM_Stop(htim, (uint32_t)ch << 2);
+    }
+
+    HAL_TIM_RegisterFastCallbacks(htim, NULL);
+
+    pSeq->State = PWM_SEQ_STATE_IDLE;
+    g_pPwmSeq[slot] = 0;
+    return HAL_OK;
+}
+
+#endif /* HAL_TIM_MODULE_ENABLED */
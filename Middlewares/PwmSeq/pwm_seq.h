@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file pwm_seq.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/15
+ * @license
+ * @description
+ *  PWM waveform sequencer, a software "DMA" for the CCRx updates of TIM1/TIM2.
+ *
+ *  The samples are interleaved per PWM period, one CCR value for every enabled
+ *  channel in ascending channel order:
+ *      { CH1[0], CH3[0], CH1[1], CH3[1], ... }
+ *  The update ISR loads the next step into the preload registers, so the new
+ *  duty takes effect at the next update event without glitch.
+ */
+
+#ifndef __pwm_seq_H_bT5vQ2nK_lWm8_HfRc_s0yD_uJ7aXp3eLhGs__
+#define __pwm_seq_H_bT5vQ2nK_lWm8_HfRc_s0yD_uJ7aXp3eLhGs__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define PWM_SEQ_CHANNEL_1           (0x1ul << (TIM_CHANNEL_1 >> 2))
+#define PWM_SEQ_CHANNEL_2           (0x1ul << (TIM_CHANNEL_2 >> 2))
+#define PWM_SEQ_CHANNEL_3           (0x1ul << (TIM_CHANNEL_3 >> 2))
+#define PWM_SEQ_CHANNEL_4           (0x1ul << (TIM_CHANNEL_4 >> 2))
+#define PWM_SEQ_CHANNEL_ALL         0xFul
+
+#define PWM_SEQ_CHANNEL_MAX         4
+
+/**
+ *  Number of timers which can run a sequencer at the same time (TIM1 and TIM2)
+ */
+#define PWM_SEQ_TIMER_MAX           2
+
+typedef enum PwmSeq_State
+{
+    PWM_SEQ_STATE_IDLE      = 0,
+    PWM_SEQ_STATE_BUSY,
+
+} PwmSeq_StateTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+struct PwmSeq;
+
+/**
+ *  @brief Half/Full buffer callback, it is executed in the TIM update ISR
+ */
+typedef void (*PwmSeq_CallbackTypeDef)(struct PwmSeq *pSeq);
+
+typedef struct PwmSeq_Init
+{
+    TIM_HandleTypeDef       *htim;          /*!< TIM handle, initialized by HAL_TIM_PWM_Init() and
+                                                 the channels configured by HAL_TIM_PWM_ConfigChannel() */
+    uint32_t                ChannelMask;    /*!< Channels of the sequence, PWM_SEQ_CHANNEL_x */
+
+    uint16_t                *pBuffer;       /*!< Interleaved CCR samples */
+    uint32_t                StepNum;        /*!< Number of PWM periods in pBuffer */
+    uint32_t                IsLoop;         /*!< 1: Restart from the head of pBuffer, 0: stop at the end */
+
+    PwmSeq_CallbackTypeDef  pfHalfCallback; /*!< First half of pBuffer is consumed, it can be refilled */
+    PwmSeq_CallbackTypeDef  pfFullCallback; /*!< Second half of pBuffer is consumed, it can be refilled */
+    void                    *pUserData;
+
+} PwmSeq_InitTypeDef;
+
+typedef struct PwmSeq
+{
+    PwmSeq_InitTypeDef      Init;
+
+    /* ISR context */
+    uint16_t                *pCur;
+    uint16_t                *pHalf;
+    uint16_t                *pEnd;
+    __IO uint32_t           *pCCR[PWM_SEQ_CHANNEL_MAX];
+    uint32_t                ChannelCnt;
+
+    __IO PwmSeq_StateTypeDef    State;
+
+} PwmSeq_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef PwmSeq_Init(PwmSeq_TypeDef *pSeq, PwmSeq_InitTypeDef *pInit);
+HAL_StatusTypeDef PwmSeq_Start(PwmSeq_TypeDef *pSeq);
+HAL_StatusTypeDef PwmSeq_Stop(PwmSeq_TypeDef *pSeq);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
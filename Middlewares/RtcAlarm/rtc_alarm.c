@@ -0,0 +1,525 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file rtc_alarm.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/27
+ * @license
+ * @description
+ *  The heap and the Alarm1 registers are shared by the thread context and the
+ *  RTC ISR, they are protected by masking the RTC IRQ (not PRIMASK, since
+ *  programming Alarm1 waits for the RTC write window with a HAL_GetTick()
+ *  timeout).
+ */
+
+
+#include <string.h>
+#include "rtc_alarm.h"
+
+#if defined(HAL_RTC_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define RTC_ALARM_SECS_PER_DAY          86400ul
+#define RTC_ALARM_DAYS_PER_4_YEARS      1461ul
+#define RTC_ALARM_YEAR_MIN              1970ul
+#define RTC_ALARM_YEAR_MAX              2099ul
+
+/**
+ *  Consecutive retries of a failed Alarm1 programming in the RTC ISR
+ */
+#define RTC_ALARM_RETRY_MAX             3ul
+
+/**
+ *  All calendar fields are compared except the weekday, the weekday register
+ *  may not be maintained by user
+ */
+#define RTC_ALARM_MATCH_FIELDS          (RTC_ALARM_ALL_ENABLE & ~RTC_ALARM_WEEK_ENABLE)
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _ENTER_CRITICAL()               NVIC_DisableIRQ(RTC_IRQn)
+#define _EXIT_CRITICAL()                NVIC_EnableIRQ(RTC_IRQn)
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct rtc_alarm_dev
+{
+    RTC_HandleTypeDef   *hrtc;
+
+    RtcAlarm_TypeDef    *pHeap[RTC_ALARM_MAX];
+    uint32_t            count;
+
+    uint32_t            programmed;     /*!< Expiry programmed to Alarm1, 0: disabled */
+    uint32_t            retry_cnt;      /*!< Consecutive failures of the Alarm1 programming */
+
+} rtc_alarm_dev_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static const uint16_t   g_RtcAlarm_DaysBeforeMonth[12] =
+{
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+static rtc_alarm_dev_t      g_RtcAlarm_Dev;
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static void _RtcAlarm_HeapSet(uint32_t idx, RtcAlarm_TypeDef *pAlarm)
+{
+    g_RtcAlarm_Dev.pHeap[idx] = pAlarm;
+    pAlarm->HeapIdx = idx + 1;
+    return;
+}
+
+static void _RtcAlarm_SiftUp(uint32_t idx)
+{
+    RtcAlarm_TypeDef    **pHeap = g_RtcAlarm_Dev.pHeap;
+    RtcAlarm_TypeDef    *pAlarm = pHeap[idx];
+
+    while( idx )
+    {
+        uint32_t    parent = (idx - 1) >> 1;
+
+        if( pHeap[parent]->Expires <= pAlarm->Expires )
+            break;
+
+        _RtcAlarm_HeapSet(idx, pHeap[parent]);
+        idx = parent;
+    }
+
+    _RtcAlarm_HeapSet(idx, pAlarm);
+    return;
+}
+
+static void _RtcAlarm_SiftDown(uint32_t idx)
+{
+    RtcAlarm_TypeDef    **pHeap = g_RtcAlarm_Dev.pHeap;
+    RtcAlarm_TypeDef    *pAlarm = pHeap[idx];
+    uint32_t            count = g_RtcAlarm_Dev.count;
+
+    for(;;)
+    {
+        uint32_t    child = (idx << 1) + 1;
+
+        if( child >= count )
+            break;
+
+        if( child + 1 < count && pHeap[child + 1]->Expires < pHeap[child]->Expires )
+            child++;
+
+        if( pAlarm->Expires <= pHeap[child]->Expires )
+            break;
+
+        _RtcAlarm_HeapSet(idx, pHeap[child]);
+        idx = child;
+    }
+
+    _RtcAlarm_HeapSet(idx, pAlarm);
+    return;
+}
+
+static HAL_StatusTypeDef _RtcAlarm_Insert(RtcAlarm_TypeDef *pAlarm)
+{
+    rtc_alarm_dev_t     *pDev = &g_RtcAlarm_Dev;
+
+    if( pDev->count >= RTC_ALARM_MAX )
+        return HAL_ERROR;
+
+    pDev->pHeap[pDev->count] = pAlarm;
+    _RtcAlarm_SiftUp(pDev->count++);
+    return HAL_OK;
+}
+
+static void _RtcAlarm_Remove(RtcAlarm_TypeDef *pAlarm)
+{
+    rtc_alarm_dev_t     *pDev = &g_RtcAlarm_Dev;
+    uint32_t            idx = pAlarm->HeapIdx - 1;
+    RtcAlarm_TypeDef    *pLast = pDev->pHeap[--pDev->count];
+
+    pAlarm->HeapIdx = 0;
+
+    if( pLast == pAlarm )
+        return;
+
+    /* move the last one to the hole, it may go either way */
+    _RtcAlarm_HeapSet(idx, pLast);
+    _RtcAlarm_SiftUp(idx);
+    _RtcAlarm_SiftDown(pLast->HeapIdx - 1);
+    return;
+}
+
+/**
+ *  @brief  Program Alarm1 with the earliest alarm, the RTC IRQ MUST be masked.
+ *          A failed programming (e.g. HAL_BUSY, the RTC handle is locked by a
+ *          preempted context) leaves 'programmed' cleared and is retried by
+ *          pending the RTC IRQ, RTC_ALARM_RETRY_MAX times in a row at most to
+ *          not starve the lock owner.
+ */
+static void _RtcAlarm_Program(void)
+{
+    rtc_alarm_dev_t     *pDev = &g_RtcAlarm_Dev;
+    RTC_HandleTypeDef   *hrtc = pDev->hrtc;
+    RtcAlarm_TypeDef    *pTop = (pDev->count) ? pDev->pHeap[0] : 0;
+    HAL_StatusTypeDef   status = HAL_OK;
+
+    if( !pTop )
+    {
+        if( pDev->programmed )
+        {
+            status = HAL_RTC_Alarm1_Config(hrtc, DISABLE);
+            if( status == HAL_OK )
+                pDev->programmed = 0;
+        }
+    }
+    else if( pTop->Expires != pDev->programmed )
+    {
+        RTC_DateTypeDef     date = {0};
+        RTC_TimeTypeDef     time = {0};
+
+        RtcAlarm_EpochToCalendar(pTop->Expires, &date, &time);
+
+        /* a stale Alarm1 match is harmless, the ISR dispatches by the current time */
+        pDev->programmed = 0;
+
+        do {
+            status = HAL_RTC_Alarm1_Config(hrtc, DISABLE);
+            if( status != HAL_OK )
+                break;
+
+            status = HAL_RTC_Alarm1_SetTime(hrtc, &time);
+            if( status != HAL_OK )
+                break;
+
+            status = HAL_RTC_Alarm1_SetDate(hrtc, &date);
+            if( status != HAL_OK )
+                break;
+
+            /* HAL_RTC_Alarm1_Set_INT_Source() does not unlock the write protection */
+            hrtc->Instance->WPR = RTC_WRITE_PROTECT_KEY1;
+            hrtc->Instance->WPR = RTC_WRITE_PROTECT_KEY2;
+            status = HAL_RTC_Alarm1_Set_INT_Source(hrtc, RTC_ALARM_MATCH_FIELDS);
+            if( status != HAL_OK )
+                break;
+
+            status = HAL_RTC_Alarm1_Config(hrtc, ENABLE);
+            if( status != HAL_OK )
+                break;
+
+            pDev->programmed = pTop->Expires;
+        } while(0);
+    }
+
+    if( status != HAL_OK )
+    {
+        if( pDev->retry_cnt < RTC_ALARM_RETRY_MAX )
+        {
+            pDev->retry_cnt++;
+            NVIC_SetPendingIRQ(RTC_IRQn);
+        }
+        return;
+    }
+
+    pDev->retry_cnt = 0;
+
+    /* Alarm1 only matches at its second, a passed one is dispatched by software */
+    if( pTop && pTop->Expires <= HAL_RTC_GetEpoch(hrtc, 0) )
+        NVIC_SetPendingIRQ(RTC_IRQn);
+
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the scheduler, Alarm1 and the RTC IRQ are enabled
+ *
+ *  @param [in] hrtc        The initialized RTC handle
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcAlarm_Init(RTC_HandleTypeDef *hrtc)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        if( !hrtc || !hrtc->Instance )
+            break;
+
+        NVIC_DisableIRQ(RTC_IRQn);
+
+        memset(&g_RtcAlarm_Dev, 0x0, sizeof(g_RtcAlarm_Dev));
+        g_RtcAlarm_Dev.hrtc = hrtc;
+
+        HAL_RTC_Alarm1_Config(hrtc, DISABLE);
+        HAL_RTC_Alarm_Clear_Flag(RTC_ALARM_1);
+        HAL_RTC_Alarm_INT_Config(hrtc, RTC_ALARM_1, ENABLE);
+
+        NVIC_ClearPendingIRQ(RTC_IRQn);
+        NVIC_EnableIRQ(RTC_IRQn);
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Setup an alarm object
+ *
+ *  @param [in] pAlarm          The alarm object
+ *  @param [in] pfCallback      The expired callback (executed in ISR context)
+ *  @param [in] pUserData       The user data of the callback
+ *  @return
+ *      None
+ */
+void RtcAlarm_Setup(RtcAlarm_TypeDef *pAlarm, RtcAlarm_CallbackTypeDef pfCallback, void *pUserData)
+{
+    if( !pAlarm )
+        return;
+
+    memset(pAlarm, 0x0, sizeof(RtcAlarm_TypeDef));
+    pAlarm->pfCallback = pfCallback;
+    pAlarm->pUserData  = pUserData;
+    return;
+}
+
+/**
+ *  @brief  Start (or restart) an alarm
+ *
+ *  @param [in] pAlarm      The alarm object
+ *  @param [in] expires     The first expiry in Unix seconds (see HAL_RTC_GetEpoch())
+ *  @param [in] period      The re-arm period in seconds (e.g. RTC_ALARM_PERIOD_DAILY), 0: one-shot
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcAlarm_Start(RtcAlarm_TypeDef *pAlarm, uint32_t expires, uint32_t period)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    if( !pAlarm || !g_RtcAlarm_Dev.hrtc || !expires )
+        return status;
+
+    _ENTER_CRITICAL();
+
+    if( pAlarm->HeapIdx )
+        _RtcAlarm_Remove(pAlarm);
+
+    pAlarm->Expires = expires;
+    pAlarm->Period  = period;
+
+    status = _RtcAlarm_Insert(pAlarm);
+
+    g_RtcAlarm_Dev.retry_cnt = 0;
+    _RtcAlarm_Program();
+
+    _EXIT_CRITICAL();
+    return status;
+}
+
+/**
+ *  @brief  Start (or restart) an alarm at a calendar time
+ *
+ *  @param [in] pAlarm      The alarm object
+ *  @param [in] pDate       The date of the first expiry (1970 ~ 2099, WeekDay is ignored)
+ *  @param [in] pTime       The time (24-hours) of the first expiry
+ *  @param [in] period      The re-arm period in seconds, 0: one-shot
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcAlarm_StartAt(RtcAlarm_TypeDef *pAlarm, RTC_DateTypeDef *pDate, RTC_TimeTypeDef *pTime, uint32_t period)
+{
+    if( !pDate || !pTime )
+        return HAL_ERROR;
+
+    return RtcAlarm_Start(pAlarm, RtcAlarm_CalendarToEpoch(pDate, pTime), period);
+}
+
+/**
+ *  @brief  Stop an alarm, it is safe to stop an idle alarm
+ *
+ *  @param [in] pAlarm      The alarm object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcAlarm_Stop(RtcAlarm_TypeDef *pAlarm)
+{
+    if( !pAlarm || !g_RtcAlarm_Dev.hrtc )
+        return HAL_ERROR;
+
+    _ENTER_CRITICAL();
+
+    if( pAlarm->HeapIdx )
+    {
+        _RtcAlarm_Remove(pAlarm);
+
+        g_RtcAlarm_Dev.retry_cnt = 0;
+        _RtcAlarm_Program();
+    }
+
+    _EXIT_CRITICAL();
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Check the alarm is armed or not
+ *
+ *  @param [in] pAlarm      The alarm object
+ *  @return
+ *      1: armed, 0: idle
+ */
+uint32_t RtcAlarm_IsActive(RtcAlarm_TypeDef *pAlarm)
+{
+    return (pAlarm && pAlarm->HeapIdx) ? 1ul : 0ul;
+}
+
+/**
+ *  @brief  Get the earliest expiry (e.g. to decide the sleep depth)
+ *
+ *  @return
+ *      Unix seconds, 0: no alarm is armed
+ */
+uint32_t RtcAlarm_GetNext(void)
+{
+    uint32_t    expires = 0;
+
+    if( !g_RtcAlarm_Dev.hrtc )
+        return 0;
+
+    _ENTER_CRITICAL();
+    expires = (g_RtcAlarm_Dev.count) ? g_RtcAlarm_Dev.pHeap[0]->Expires : 0;
+    _EXIT_CRITICAL();
+    return expires;
+}
+
+/**
+ *  @brief  Convert a calendar time to Unix seconds
+ *
+ *  @param [in] pDate       The date (1970 ~ 2099, WeekDay is ignored)
+ *  @param [in] pTime       The time (24-hours)
+ *  @return
+ *      Unix seconds, 0 if the date is out of range
+ */
+uint32_t RtcAlarm_CalendarToEpoch(RTC_DateTypeDef *pDate, RTC_TimeTypeDef *pTime)
+{
+    uint32_t    year = pDate->Year;
+    uint32_t    days = 0;
+
+    if( year < RTC_ALARM_YEAR_MIN || year > RTC_ALARM_YEAR_MAX ||
+        pDate->Month < 1 || pDate->Month > 12 || pDate->Date < 1 )
+        return 0;
+
+    /* a year divisible by 4 is a leap year in 1901 ~ 2099 */
+    days = (year - 1970) * 365 + ((year - 1969) >> 2)
+         + g_RtcAlarm_DaysBeforeMonth[pDate->Month - 1] + pDate->Date - 1;
+
+    if( pDate->Month > 2 && !(year & 0x3) )
+        days++;
+
+    return days * RTC_ALARM_SECS_PER_DAY + pTime->Hours * 3600ul + pTime->Minutes * 60ul + pTime->Seconds;
+}
+
+/**
+ *  @brief  Convert Unix seconds to a calendar time
+ *
+ *  @param [in] epoch       Unix seconds
+ *  @param [in] pDate       The date (with WeekDay)
+ *  @param [in] pTime       The time (24-hours)
+ *  @return
+ *      None
+ */
+void RtcAlarm_EpochToCalendar(uint32_t epoch, RTC_DateTypeDef *pDate, RTC_TimeTypeDef *pTime)
+{
+    uint32_t    days = epoch / RTC_ALARM_SECS_PER_DAY;
+    uint32_t    secs = epoch - days * RTC_ALARM_SECS_PER_DAY;
+    uint32_t    quad = days / RTC_ALARM_DAYS_PER_4_YEARS;
+    uint32_t    year = 0;
+    uint32_t    month = 1;
+    uint32_t    leap = 0;
+
+    pTime->Hours   = (uint8_t)(secs / 3600);
+    secs          -= pTime->Hours * 3600ul;
+    pTime->Minutes = (uint8_t)(secs / 60);
+    pTime->Seconds = (uint8_t)(secs - pTime->Minutes * 60ul);
+
+    /* 1970/01/01 is Thursday */
+    pDate->WeekDay = (uint8_t)((days + RTC_WEEKDAY_THURSDAY) % 7);
+
+    year  = 1970 + quad * 4;
+    days -= quad * RTC_ALARM_DAYS_PER_4_YEARS;
+
+    for(;;)
+    {
+        uint32_t    len = (year & 0x3) ? 365 : 366;
+
+        if( days < len )
+            break;
+
+        days -= len;
+        year++;
+    }
+
+    leap = !(year & 0x3);
+
+    for(month = 1; month < 12; month++)
+    {
+        if( days < g_RtcAlarm_DaysBeforeMonth[month] + ((month >= 2) ? leap : 0) )
+            break;
+    }
+
+    pDate->Year  = year;
+    pDate->Month = (uint8_t)month;
+    pDate->Date  = (uint8_t)(days - g_RtcAlarm_DaysBeforeMonth[month - 1] - ((month > 2) ? leap : 0) + 1);
+    return;
+}
+
+/**
+ *  @brief  Dispatch the expired alarms and re-program Alarm1.
+ *          Call it from RTC_IRQHandler() after HAL_RTC_IRQHandler()
+ *          (the RTC IRQ is also pended by software for a passed alarm).
+ *
+ *  @return
+ *      None
+ */
+void RtcAlarm_IRQHandler(void)
+{
+    rtc_alarm_dev_t     *pDev = &g_RtcAlarm_Dev;
+    uint32_t            now = 0;
+
+    if( !pDev->hrtc )
+        return;
+
+    now = HAL_RTC_GetEpoch(pDev->hrtc, 0);
+
+    while( pDev->count && pDev->pHeap[0]->Expires <= now )
+    {
+        RtcAlarm_TypeDef    *pAlarm = pDev->pHeap[0];
+
+        _RtcAlarm_Remove(pAlarm);
+
+        if( pAlarm->Period )
+        {
+            /* skip the periods missed during a long latency */
+            pAlarm->Expires += ((now - pAlarm->Expires) / pAlarm->Period + 1) * pAlarm->Period;
+            _RtcAlarm_Insert(pAlarm);
+        }
+
+        /* the callback may start or stop alarms */
+        if( pAlarm->pfCallback )
+            pAlarm->pfCallback(pAlarm);
+
+        now = HAL_RTC_GetEpoch(pDev->hrtc, 0);
+    }
+
+    _RtcAlarm_Program();
+    return;
+}
+
+#endif /* HAL_RTC_MODULE_ENABLED */
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file rtc_alarm.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/27
+ * @license
+ * @description
+ *  Calendar alarms multiplexed onto the RTC Alarm1.
+ *
+ *  + The armed alarms are kept in a binary min-heap ordered by the expiry time
+ *    (Unix seconds), Alarm1 is always programmed with the earliest one. The
+ *    system can deep-sleep until the next event instead of waking up every
+ *    second to compare the time in software.
+ *  + RtcAlarm_IRQHandler() dispatches all expired alarms (including the ones
+ *    missed during a long interrupt latency) and re-arms the periodic ones.
+ *  + An alarm already expired when it is started is dispatched by pending the
+ *    RTC IRQ.
+ *
+ *  The RTC MUST be initialized (24-hours format) and the calendar set by user.
+ *  The alarm callbacks are executed in ISR context.
+ *
+ *  Alarm1 is re-programmed in the RTC ISR. Other RTC HAL calls of the
+ *  application should mask RTC_IRQn, otherwise the ISR may find the RTC handle
+ *  locked (HAL_BUSY). A failed programming is retried a few times by pending
+ *  the RTC IRQ, then on the next RtcAlarm_Start()/RtcAlarm_Stop() or RTC IRQ.
+ */
+
+#ifndef __rtc_alarm_H_m6QfZ1xB_lTc8_HrVn_s3Kw_uG9hDj2eYsPu__
+#define __rtc_alarm_H_m6QfZ1xB_lTc8_HrVn_s3Kw_uG9hDj2eYsPu__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  Max number of armed alarms
+ */
+#ifndef RTC_ALARM_MAX
+#define RTC_ALARM_MAX               32
+#endif
+
+#define RTC_ALARM_PERIOD_DAILY      86400ul
+#define RTC_ALARM_PERIOD_WEEKLY     (7ul * 86400ul)
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+struct RtcAlarm;
+
+/**
+ *  @brief Alarm expired callback, it is executed in ISR context
+ */
+typedef void (*RtcAlarm_CallbackTypeDef)(struct RtcAlarm *pAlarm);
+
+/**
+ *  @brief Alarm object, it MUST be setup with RtcAlarm_Setup() before use
+ */
+typedef struct RtcAlarm
+{
+    uint32_t                    Expires;    /*!< Unix seconds */
+    uint32_t                    Period;     /*!< Re-arm period in seconds, 0: one-shot */
+    uint32_t                    HeapIdx;    /*!< (index + 1) in the heap, 0: not armed */
+
+    RtcAlarm_CallbackTypeDef    pfCallback;
+    void                        *pUserData;
+
+} RtcAlarm_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef RtcAlarm_Init(RTC_HandleTypeDef *hrtc);
+
+void RtcAlarm_Setup(RtcAlarm_TypeDef *pAlarm, RtcAlarm_CallbackTypeDef pfCallback, void *pUserData);
+HAL_StatusTypeDef RtcAlarm_Start(RtcAlarm_TypeDef *pAlarm, uint32_t expires, uint32_t period);
+HAL_StatusTypeDef RtcAlarm_StartAt(RtcAlarm_TypeDef *pAlarm, RTC_DateTypeDef *pDate, RTC_TimeTypeDef *pTime, uint32_t period);
+HAL_StatusTypeDef RtcAlarm_Stop(RtcAlarm_TypeDef *pAlarm);
+
+uint32_t RtcAlarm_IsActive(RtcAlarm_TypeDef *pAlarm);
+uint32_t RtcAlarm_GetNext(void);
+
+uint32_t RtcAlarm_CalendarToEpoch(RTC_DateTypeDef *pDate, RTC_TimeTypeDef *pTime);
+void RtcAlarm_EpochToCalendar(uint32_t epoch, RTC_DateTypeDef *pDate, RTC_TimeTypeDef *pTime);
+
+void RtcAlarm_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
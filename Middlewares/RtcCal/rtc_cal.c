@@ -0,0 +1,447 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file rtc_cal.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  The 1PPS edges are accumulated in ISR context, the conversions (64-bits
+ *  divisions) and the flash operations are done in RtcCal_Process().
+ */
+
+
+#include <string.h>
+#include "rtc_cal.h"
+
+#if defined(HAL_RTC_MODULE_ENABLED) && defined(HAL_CLKTRIM_MODULE_ENABLED) && defined(HAL_FLASH_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define RTC_CAL_STORE_MAGIC             0x43435452ul    /*!< 'RTCC' */
+
+#define RTC_CAL_TIMEOUT_MARGIN_MS       1000ul
+
+/**
+ *  A PPS interval out of +/-1.5% is a missed or a glitch edge
+ */
+#define RTC_CAL_PPS_TOLERANCE           (LXT_VALUE >> 6)
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _ABS(x)                         (((x) < 0) ? -(x) : (x))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  The record in flash
+ */
+typedef struct rtc_cal_store
+{
+    uint32_t    magic;
+    int32_t     error_ppb;
+    uint32_t    check;          /*!< ~(magic ^ error_ppb) */
+
+} rtc_cal_store_t;
+
+typedef struct rtc_cal_dev
+{
+    RTC_HandleTypeDef       *hrtc;
+    CLKTRIM_HandleTypeDef   *hclktrim;
+    RtcCal_InitTypeDef      Init;
+    RtcCal_ResultTypeDef    Result;
+
+    volatile uint32_t       State;          /*!< RtcCal_StateTypeDef */
+    uint32_t                StartTick;
+    uint32_t                TimeoutMs;
+
+    /* 1PPS, accessed in ISR */
+    volatile uint32_t       PpsEdges;       /*!< Edges of the window, 0: waiting for the first edge */
+    uint32_t                PpsLast;
+    volatile uint32_t       PpsCycles;      /*!< LXT cycles of the window */
+
+} rtc_cal_dev_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static const struct
+{
+    uint32_t    period;
+    uint32_t    mode;
+} g_RtcCal_Periods[] =
+{
+    { 60, RTC_TIME_ADJUST_SEC60 },
+    { 30, RTC_TIME_ADJUST_SEC30 },
+    { 15, RTC_TIME_ADJUST_SEC15 },
+    {  6, RTC_TIME_ADJUST_SEC06 },
+};
+
+static rtc_cal_dev_t        g_RtcCal_Dev;
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  @brief  LXT error of the HXT measurement
+ *
+ *  @param [in] cnt     HXT cycles during (WindowSec * LXT_VALUE) LXT cycles
+ *  @return
+ *      Error in ppb, positive: LXT is fast
+ */
+static int32_t _RtcCal_HxtErrorPpb(uint32_t cnt)
+{
+    int64_t     lxt_cycles = (int64_t)g_RtcCal_Dev.Init.WindowSec * LXT_VALUE;
+    int64_t     diff = (int64_t)HXT_VALUE * lxt_cycles - (int64_t)LXT_VALUE * cnt;
+
+    /**
+     *  error = HXT_VALUE * lxt_cycles / (LXT_VALUE * cnt) - 1, the denominator
+     *  is scaled down by 1000 to keep (diff * 10^6) in 64-bits
+     */
+    return (int32_t)((diff * 1000000) / (((int64_t)LXT_VALUE * cnt) / 1000));
+}
+
+/**
+ *  @brief  LXT error of the 1PPS measurement
+ *
+ *  @return
+ *      Error in ppb, positive: LXT is fast
+ */
+static int32_t _RtcCal_PpsErrorPpb(void)
+{
+    int64_t     expected = (int64_t)g_RtcCal_Dev.Init.WindowSec * LXT_VALUE;
+
+    return (int32_t)((((int64_t)g_RtcCal_Dev.PpsCycles - expected) * 1000000000) / expected);
+}
+
+static void _RtcCal_Finish(int32_t error_ppb)
+{
+    RtcCal_Apply(error_ppb);
+
+    if( g_RtcCal_Dev.Init.StoreAddr )
+        RtcCal_Save();
+
+    g_RtcCal_Dev.State = RTC_CAL_STATE_IDLE;
+    return;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the calibration, the RTC calibration is not changed
+ *
+ *  @param [in] hrtc        The RTC handle
+ *  @param [in] hclktrim    The CLKTRIM handle, it can be NULL with RTC_CAL_REF_PPS
+ *  @param [in] pInit       The configuration
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcCal_Init(RTC_HandleTypeDef *hrtc, CLKTRIM_HandleTypeDef *hclktrim, RtcCal_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        if( !hrtc || !pInit || !pInit->WindowSec || (pInit->StoreAddr & (FLASH_PAGE_SIZE - 1)) )
+            break;
+
+        if( hrtc->Init.ClockSource != RTC_CLOCK_LXT )
+            break;
+
+        if( pInit->RefSource == RTC_CAL_REF_HXT )
+        {
+            /* CALCNT is 32-bits */
+            if( !hclktrim || (uint64_t)HXT_VALUE * pInit->WindowSec > 0xFFFFFFFFull )
+                break;
+        }
+        else if( pInit->RefSource == RTC_CAL_REF_PPS )
+        {
+        #if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+            /* the tickless time base reloads LPTIM, it does not free-run */
+            break;
+        #endif
+        }
+        else
+            break;
+
+        memset(&g_RtcCal_Dev, 0x0, sizeof(g_RtcCal_Dev));
+        g_RtcCal_Dev.hrtc      = hrtc;
+        g_RtcCal_Dev.hclktrim  = hclktrim;
+        g_RtcCal_Dev.Init      = *pInit;
+        g_RtcCal_Dev.TimeoutMs = pInit->WindowSec * 1000 + RTC_CAL_TIMEOUT_MARGIN_MS;
+
+        /* for PPS, the first edge may come 1 second later */
+        if( pInit->RefSource == RTC_CAL_REF_PPS )
+            g_RtcCal_Dev.TimeoutMs += 1000;
+
+        HAL_RTC_Calibration_Get(hrtc, &g_RtcCal_Dev.Result.AdjustMode, &g_RtcCal_Dev.Result.Trim);
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Apply the coefficient saved in flash (e.g. at boot)
+ *
+ *  @return
+ *      HAL_OK: applied, HAL_ERROR: no valid record
+ */
+HAL_StatusTypeDef RtcCal_Restore(void)
+{
+    rtc_cal_store_t     *pStore = (rtc_cal_store_t*)g_RtcCal_Dev.Init.StoreAddr;
+
+    if( !g_RtcCal_Dev.hrtc || !pStore )
+        return HAL_ERROR;
+
+    if( pStore->magic != RTC_CAL_STORE_MAGIC ||
+        pStore->check != ~(pStore->magic ^ (uint32_t)pStore->error_ppb) )
+        return HAL_ERROR;
+
+    return RtcCal_Apply(pStore->error_ppb);
+}
+
+/**
+ *  @brief  Start a measurement, the result is applied by RtcCal_Process()
+ *
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcCal_Start(void)
+{
+    if( !g_RtcCal_Dev.hrtc || g_RtcCal_Dev.State == RTC_CAL_STATE_MEASURING )
+        return HAL_ERROR;
+
+    if( g_RtcCal_Dev.Init.RefSource == RTC_CAL_REF_HXT )
+    {
+        CLKTRIM_HandleTypeDef   *hclktrim = g_RtcCal_Dev.hclktrim;
+
+        if( __HAL_RCC_GET_FLAG(RCC_FLAG_HXTRDY) == RESET )
+            return HAL_ERROR;
+
+        __HAL_RCC_CLKTRIM_CLK_ENABLE();
+
+        hclktrim->Instance                 = CLKTRIM;
+        hclktrim->Init.ReferClockSel       = CLKTRIM_REFCLK_LXT;
+        hclktrim->Init.MonitorCalClockSel  = CLKTRIM_MONCALCLK_HXT;
+        hclktrim->Init.MonitorInterval     = g_RtcCal_Dev.Init.WindowSec * LXT_VALUE;
+        hclktrim->Init.MonitorOverflowTime = 0;
+        hclktrim->Init.ClkTrimMode         = CLKTRIM_MODE_CAL;
+        if( HAL_CLKTRIM_Init(hclktrim) != HAL_OK )
+            return HAL_ERROR;
+
+        __HAL_CLKTRIM_CLEAR_FLAG(hclktrim, CLKTRIM_FLAG_STOP);
+        __HAL_CLKTRIM_START(hclktrim);
+    }
+    else
+    {
+        g_RtcCal_Dev.PpsCycles = 0;
+        g_RtcCal_Dev.PpsEdges  = 0;
+    }
+
+    g_RtcCal_Dev.StartTick = HAL_GetTick();
+
+    /* the PPS ISR starts accumulating after this */
+    __DMB();
+    g_RtcCal_Dev.State = RTC_CAL_STATE_MEASURING;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Run the calibration, call it periodically from the main loop
+ *
+ *  @return
+ *      The state, RTC_CAL_STATE_DONE is returned once when a new coefficient
+ *      is applied, and then RTC_CAL_STATE_IDLE
+ */
+RtcCal_StateTypeDef RtcCal_Process(void)
+{
+    if( g_RtcCal_Dev.State != RTC_CAL_STATE_MEASURING )
+        return (RtcCal_StateTypeDef)g_RtcCal_Dev.State;
+
+    if( g_RtcCal_Dev.Init.RefSource == RTC_CAL_REF_HXT )
+    {
+        CLKTRIM_HandleTypeDef   *hclktrim = g_RtcCal_Dev.hclktrim;
+
+        if( __HAL_CLKTRIM_GET_FLAG(hclktrim, CLKTRIM_FLAG_STOP) )
+        {
+            uint32_t    cnt = __HAL_CLKTRIM_GET_VALCNT(hclktrim);
+
+            __HAL_CLKTRIM_STOP(hclktrim);
+            _RtcCal_Finish(_RtcCal_HxtErrorPpb(cnt));
+            return RTC_CAL_STATE_DONE;
+        }
+    }
+    else if( g_RtcCal_Dev.PpsEdges > g_RtcCal_Dev.Init.WindowSec )
+    {
+        _RtcCal_Finish(_RtcCal_PpsErrorPpb());
+        return RTC_CAL_STATE_DONE;
+    }
+
+    if( HAL_GetTick() - g_RtcCal_Dev.StartTick > g_RtcCal_Dev.TimeoutMs )
+    {
+        if( g_RtcCal_Dev.Init.RefSource == RTC_CAL_REF_HXT )
+            __HAL_CLKTRIM_STOP(g_RtcCal_Dev.hclktrim);
+
+        g_RtcCal_Dev.State = RTC_CAL_STATE_ERROR;
+    }
+
+    return (RtcCal_StateTypeDef)g_RtcCal_Dev.State;
+}
+
+/**
+ *  @brief  The 1PPS edge handler, call it in the ISR of the 1PPS pin
+ *
+ *  @return
+ *      None
+ */
+void RtcCal_PpsIRQHandler(void)
+{
+    uint32_t    cnt = LPTIM->CNTVAL & LPTIM_CNTVAL_LPT_CNT_Msk;
+    uint32_t    delta = 0;
+
+    if( g_RtcCal_Dev.State != RTC_CAL_STATE_MEASURING ||
+        g_RtcCal_Dev.PpsEdges > g_RtcCal_Dev.Init.WindowSec )
+        return;
+
+    delta = (cnt - g_RtcCal_Dev.PpsLast) & LPTIM_CNTVAL_LPT_CNT_Msk;
+    g_RtcCal_Dev.PpsLast = cnt;
+
+    if( g_RtcCal_Dev.PpsEdges &&
+        _ABS((int32_t)delta - (int32_t)LXT_VALUE) > (int32_t)RTC_CAL_PPS_TOLERANCE )
+    {
+        /* restart the window from this edge */
+        g_RtcCal_Dev.PpsCycles = 0;
+        g_RtcCal_Dev.PpsEdges  = 1;
+        g_RtcCal_Dev.StartTick = HAL_GetTick();
+        return;
+    }
+
+    if( g_RtcCal_Dev.PpsEdges )
+        g_RtcCal_Dev.PpsCycles += delta;
+
+    g_RtcCal_Dev.PpsEdges++;
+    return;
+}
+
+/**
+ *  @brief  Compensate an LXT error with the RTC calibration
+ *
+ *  @param [in] error_ppb   LXT error in ppb, positive: LXT is fast
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcCal_Apply(int32_t error_ppb)
+{
+    RtcCal_ResultTypeDef    *pResult = &g_RtcCal_Dev.Result;
+    int32_t                 trim = 0;
+    uint32_t                i = 0;
+
+    if( !g_RtcCal_Dev.hrtc )
+        return HAL_ERROR;
+
+    /* the longest period of which the trim fits has the best resolution */
+    for(i = 0; i < sizeof(g_RtcCal_Periods) / sizeof(g_RtcCal_Periods[0]); i++)
+    {
+        int64_t     cycles = (int64_t)error_ppb * g_RtcCal_Periods[i].period * LXT_VALUE;
+
+        cycles += (cycles < 0) ? -500000000 : 500000000;
+        trim    = (int32_t)(cycles / 1000000000);
+
+        if( _ABS(trim) <= RTC_CAL_TRIM_MAX )
+            break;
+    }
+
+    pResult->IsSaturated = 0;
+    if( i == sizeof(g_RtcCal_Periods) / sizeof(g_RtcCal_Periods[0]) )
+    {
+        i--;
+        trim = (trim < 0) ? -RTC_CAL_TRIM_MAX : RTC_CAL_TRIM_MAX;
+        pResult->IsSaturated = 1;
+    }
+
+    /**
+     *  RCLKTRIM.TRIM is the signed count of the cycles compensated every adjust
+     *  period (RTC_RCLKTRIM_TRIM, HAL_RTC_Calibration_Config()): a positive
+     *  trim adds cycles and speeds up the RTC. A fast LXT is compensated with
+     *  a negative trim.
+     */
+    pResult->Trim = (int8_t)(-trim);
+
+    pResult->ErrorPpb   = error_ppb;
+    pResult->AdjustMode = g_RtcCal_Periods[i].mode;
+
+    return HAL_RTC_Calibration_Config(g_RtcCal_Dev.hrtc, pResult->AdjustMode, pResult->Trim);
+}
+
+/**
+ *  @brief  Save the current coefficient into flash, the page is erased only
+ *          when the record is changed
+ *
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef RtcCal_Save(void)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+    uint32_t            addr = g_RtcCal_Dev.Init.StoreAddr;
+
+    do {
+        rtc_cal_store_t         *pStore = (rtc_cal_store_t*)addr;
+        rtc_cal_store_t         record = {0};
+        FLASH_EraseInitTypeDef  erase = {0};
+        uint32_t                page_err = 0;
+
+        if( !addr )
+            break;
+
+        record.magic     = RTC_CAL_STORE_MAGIC;
+        record.error_ppb = g_RtcCal_Dev.Result.ErrorPpb;
+        record.check     = ~(record.magic ^ (uint32_t)record.error_ppb);
+
+        if( !memcmp(pStore, &record, sizeof(record)) )
+        {
+            status = HAL_OK;
+            break;
+        }
+
+        if( HAL_FLASH_OPERATION_Unlock(addr) != HAL_OK )
+            break;
+
+        erase.TypeErase   = FLASH_TYPEERASE_PAGES;
+        erase.PageAddress = addr;
+        erase.NbPages     = 1;
+
+        status = HAL_FLASH_Erase(&erase, &page_err);
+        if( status == HAL_OK )
+            status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + 4, (uint32_t)record.error_ppb);
+        if( status == HAL_OK )
+            status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr + 8, record.check);
+
+        /* the magic is the last, a broken record is never valid */
+        if( status == HAL_OK )
+            status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, record.magic);
+
+        HAL_FLASH_OPERATION_Lock(addr);
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Get the result of the calibration
+ *
+ *  @param [in] pResult     The result
+ *  @return
+ *      None
+ */
+void RtcCal_GetResult(RtcCal_ResultTypeDef *pResult)
+{
+    *pResult = g_RtcCal_Dev.Result;
+    return;
+}
+
+#endif /* HAL_RTC_MODULE_ENABLED && HAL_CLKTRIM_MODULE_ENABLED && HAL_FLASH_MODULE_ENABLED */
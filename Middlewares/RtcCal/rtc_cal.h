@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file rtc_cal.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Drift measurement and digital calibration of the RTC (LXT clock).
+ *
+ *  + The LXT error is measured against a reference over WindowSec seconds:
+ *      - RTC_CAL_REF_HXT: CLKTRIM counts HXT cycles during WindowSec * LXT_VALUE
+ *        LXT cycles (0.12 ppb resolution per second of window at 8 MHz).
+ *      - RTC_CAL_REF_PPS: an external 1PPS, RtcCal_PpsIRQHandler() MUST be
+ *        called at every edge (e.g. from a GpioExti callback). It samples the
+ *        LPTIM counter, which MUST free-run on LXT (16-bits, no reload value).
+ *        The resolution is 30.5 ppm / WindowSec. It is rejected with
+ *        USE_HAL_TICKLESS, the HAL time base owns and reloads LPTIM.
+ *  + The error is compensated with the RTC RCLKTRIM register, the longest
+ *    adjust period (60/30/15/6 seconds) of which the trim fits is selected.
+ *  + The coefficient is saved into a flash page and RtcCal_Restore() applies it
+ *    at the next boot without a new measurement.
+ *
+ *  RtcCal_Process() MUST be called periodically from the main loop (thread
+ *  context). The RTC MUST be initialized with RTC_CLOCK_LXT. CLKTRIM is
+ *  re-configured at every start, it can be shared with other services which do
+ *  not use it at the same time.
+ */
+
+#ifndef __rtc_cal_H_c4NsY7eQ_lHw2_HpDx_s9Ka_uR6mTz1vGbLf__
+#define __rtc_cal_H_c4NsY7eQ_lHw2_HpDx_s9Ka_uR6mTz1vGbLf__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define RTC_CAL_TRIM_MAX            126     /*!< IS_RTC_TIME_TRIM() */
+
+typedef enum RtcCal_Ref
+{
+    RTC_CAL_REF_HXT     = 0,
+    RTC_CAL_REF_PPS,
+
+} RtcCal_RefTypeDef;
+
+typedef enum RtcCal_State
+{
+    RTC_CAL_STATE_IDLE      = 0,
+    RTC_CAL_STATE_MEASURING,
+    RTC_CAL_STATE_DONE,         /*!< A new coefficient is applied */
+    RTC_CAL_STATE_ERROR,        /*!< The reference is lost (timeout) */
+
+} RtcCal_StateTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief Configuration of the calibration
+ */
+typedef struct RtcCal_Init
+{
+    uint32_t    RefSource;      /*!< RtcCal_RefTypeDef */
+    uint32_t    WindowSec;      /*!< Measurement window in seconds, HXT: 1 ~ 500 (8 MHz) */
+    uint32_t    StoreAddr;      /*!< Flash page (FLASH_PAGE_SIZE aligned) of the coefficient, 0: not persisted */
+
+} RtcCal_InitTypeDef;
+
+/**
+ *  @brief Result of the calibration
+ */
+typedef struct RtcCal_Result
+{
+    int32_t     ErrorPpb;       /*!< LXT error in ppb, positive: LXT is fast */
+    uint32_t    AdjustMode;     /*!< RTC_TIME_ADJUST_MODE_Definitions */
+    int8_t      Trim;
+    uint32_t    IsSaturated;    /*!< The error is out of the trim range */
+
+} RtcCal_ResultTypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef RtcCal_Init(RTC_HandleTypeDef *hrtc, CLKTRIM_HandleTypeDef *hclktrim, RtcCal_InitTypeDef *pInit);
+HAL_StatusTypeDef RtcCal_Restore(void);
+
+HAL_StatusTypeDef RtcCal_Start(void);
+RtcCal_StateTypeDef RtcCal_Process(void);
+void RtcCal_PpsIRQHandler(void);
+
+HAL_StatusTypeDef RtcCal_Apply(int32_t error_ppb);
+HAL_StatusTypeDef RtcCal_Save(void);
+void RtcCal_GetResult(RtcCal_ResultTypeDef *pResult);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,481 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file soft_uart.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/21
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "soft_uart.h"
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define SOFT_UART_PCA_CH_NUM        5
+
+#define SOFT_UART_PCA_CCF_ALL_Msk   (PCA_CR_CCF0 | PCA_CR_CCF1 | PCA_CR_CCF2 | PCA_CR_CCF3 | PCA_CR_CCF4)
+
+/**
+ *  Delay in PCA counts from Transmit_IT() to the first start bit
+ */
+#define SOFT_UART_START_TICKS       32
+
+/**
+ *  The shortest bit in PCA counts
+ */
+#define SOFT_UART_MIN_BIT_TICKS     64
+
+#define SOFT_UART_RX_IDLE           0xFF
+
+#define SOFT_UART_CCAPM_TX_TOGGLE   (PCA_CCAPM0_ECOM | PCA_CCAPM0_MAT | PCA_CCAPM0_TOG | PCA_CCAPM0_CCIE)
+#define SOFT_UART_CCAPM_TX_MATCH    (PCA_CCAPM0_ECOM | PCA_CCAPM0_MAT | PCA_CCAPM0_CCIE)
+#define SOFT_UART_CCAPM_RX_CAPTURE  (PCA_CCAPM0_CAPN | PCA_CCAPM0_CCIE)
+#define SOFT_UART_CCAPM_RX_SAMPLE   (PCA_CCAPM0_ECOM | PCA_CCAPM0_MAT | PCA_CCAPM0_CCIE)
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _CCAPM(__PCAx__, __IDX__)       (*(&(__PCAx__)->CCAPM0 + (__IDX__)))
+#define _CCAP(__PCAx__, __IDX__)        (*(&(__PCAx__)->CCAP0 + (__IDX__)))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static SoftUart_HandleTypeDef   *g_pSoftUartModule[SOFT_UART_PCA_CH_NUM] = {0};
+static PCA_TypeDef              *g_pSoftUartPca = 0;
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static uint32_t _SoftUart_ChannelIdx(uint32_t channel)
+{
+    uint32_t    idx = 0;
+
+    while( idx < SOFT_UART_PCA_CH_NUM && channel != (0x1ul << idx) )
+        idx++;
+
+    return idx;
+}
+
+/**
+ *  @brief  Load the next byte of the buffer as a frame starting at frame_start
+ *
+ *  @param [in] hsuart          The handle
+ *  @param [in] frame_start     PCA count of the falling edge of the start bit
+ *  @return
+ *      None
+ */
+static void _SoftUart_TxLoadFrame(SoftUart_HandleTypeDef *hsuart, uint32_t frame_start)
+{
+    PCA_TypeDef     *PCAx = hsuart->Init.hpca->Instance;
+
+    hsuart->TxFrame      = (uint16_t)(((uint32_t)*hsuart->pTxBuffPtr++ << 1) | (0x1ul << (SOFT_UART_FRAME_BITS - 1)));
+    hsuart->TxFrameStart = (uint16_t)frame_start;
+    hsuart->TxBitIdx     = 0;
+    hsuart->TxXferCount--;
+
+    _CCAP(PCAx, hsuart->TxIdx) = hsuart->TxFrameStart;
+    return;
+}
+
+/**
+ *  @brief  TX compare match, the output was just toggled to the level of TxBitIdx
+ *          (or the stop bit of the last byte is finished)
+ *
+ *  @param [in] hsuart      The handle
+ *  @return
+ *      None
+ */
+static void _SoftUart_TxISR(SoftUart_HandleTypeDef *hsuart)
+{
+    PCA_TypeDef     *PCAx = hsuart->Init.hpca->Instance;
+    uint32_t        idx = hsuart->TxBitIdx;
+    uint32_t        rest = 0;
+    uint32_t        level = 0;
+
+    if( idx >= SOFT_UART_FRAME_BITS )
+    {
+        /* the stop bit of the last byte is on the line */
+        _CCAPM(PCAx, hsuart->TxIdx) = 0;
+        hsuart->gState = SOFT_UART_STATE_READY;
+        SoftUart_TxCpltCallback(hsuart);
+        return;
+    }
+
+    /* the next bit with the other level */
+    rest  = hsuart->TxFrame >> idx;
+    level = rest & 0x1ul;
+
+    do {
+        idx++;
+        rest >>= 1;
+    } while( idx < SOFT_UART_FRAME_BITS && (rest & 0x1ul) == level );
+
+    if( idx < SOFT_UART_FRAME_BITS )
+    {
+        hsuart->TxBitIdx = (uint8_t)idx;
+        _CCAP(PCAx, hsuart->TxIdx) = (uint16_t)(hsuart->TxFrameStart + hsuart->BitOffset[idx]);
+        return;
+    }
+
+    /* high until the end of the stop bit, the next start bit toggles there */
+    if( hsuart->TxXferCount )
+    {
+        _SoftUart_TxLoadFrame(hsuart, hsuart->TxFrameStart + hsuart->BitOffset[SOFT_UART_FRAME_BITS]);
+        return;
+    }
+
+    hsuart->TxBitIdx = SOFT_UART_FRAME_BITS;
+    _CCAPM(PCAx, hsuart->TxIdx) = SOFT_UART_CCAPM_TX_MATCH;
+    _CCAP(PCAx, hsuart->TxIdx)  = (uint16_t)(hsuart->TxFrameStart + hsuart->BitOffset[SOFT_UART_FRAME_BITS]);
+    return;
+}
+
+/**
+ *  @brief  RX capture (start edge) or compare (bit sampling)
+ *
+ *  @param [in] hsuart      The handle
+ *  @return
+ *      None
+ */
+static void _SoftUart_RxISR(SoftUart_HandleTypeDef *hsuart)
+{
+    PCA_TypeDef     *PCAx = hsuart->Init.hpca->Instance;
+    uint32_t        idx = hsuart->RxBitIdx;
+    uint32_t        bit = 0;
+
+    if( idx == SOFT_UART_RX_IDLE )
+    {
+        /* falling edge of the start bit, sample at the middle of it */
+        hsuart->RxFrameStart = (uint16_t)_CCAP(PCAx, hsuart->RxIdx);
+        hsuart->RxBitIdx     = 0;
+
+        _CCAPM(PCAx, hsuart->RxIdx) = SOFT_UART_CCAPM_RX_SAMPLE;
+        _CCAP(PCAx, hsuart->RxIdx)  = (uint16_t)(hsuart->RxFrameStart + hsuart->SampleOffset[0]);
+        return;
+    }
+
+    bit = (hsuart->Init.RxPort->IDR & hsuart->Init.RxPin) ? 0x1ul : 0x0ul;
+
+    if( idx < SOFT_UART_FRAME_BITS - 1 )
+    {
+        if( idx == 0 && bit )
+        {
+            /* glitch, not a start bit */
+            hsuart->RxBitIdx = SOFT_UART_RX_IDLE;
+            _CCAPM(PCAx, hsuart->RxIdx) = SOFT_UART_CCAPM_RX_CAPTURE;
+            return;
+        }
+
+        hsuart->RxShift  = (uint8_t)((hsuart->RxShift >> 1) | (bit << 7));
+        hsuart->RxBitIdx = (uint8_t)++idx;
+        _CCAP(PCAx, hsuart->RxIdx) = (uint16_t)(hsuart->RxFrameStart + hsuart->SampleOffset[idx]);
+        return;
+    }
+
+    /* stop bit, wait the next start edge */
+    hsuart->RxBitIdx = SOFT_UART_RX_IDLE;
+    _CCAPM(PCAx, hsuart->RxIdx) = SOFT_UART_CCAPM_RX_CAPTURE;
+
+    if( hsuart->RxState != SOFT_UART_STATE_BUSY_RX )
+    {
+        hsuart->ErrorCode |= SOFT_UART_ERROR_ORE;
+        return;
+    }
+
+    if( !bit )
+    {
+        hsuart->ErrorCode |= SOFT_UART_ERROR_FE;
+        SoftUart_ErrorCallback(hsuart);
+        return;
+    }
+
+    *hsuart->pRxBuffPtr++ = hsuart->RxShift;
+
+    if( --hsuart->RxXferCount == 0 )
+    {
+        hsuart->RxState = SOFT_UART_STATE_READY;
+        SoftUart_RxCpltCallback(hsuart);
+    }
+
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize a software UART port, the TX line is idle high
+ *          and the RX waits a start bit
+ *
+ *  @param [in] hsuart      The handle with Init configured
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SoftUart_Init(SoftUart_HandleTypeDef *hsuart)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        PCA_TypeDef     *PCAx = 0;
+        uint32_t        bit_q8 = 0;
+        uint32_t        tx_idx = 0;
+        uint32_t        rx_idx = 0;
+
+        if( !hsuart || !hsuart->Init.hpca || !hsuart->Init.RxPort || !hsuart->Init.BaudRate )
+            break;
+
+        tx_idx = _SoftUart_ChannelIdx(hsuart->Init.TxChannel);
+        rx_idx = _SoftUart_ChannelIdx(hsuart->Init.RxChannel);
+        if( tx_idx >= SOFT_UART_PCA_CH_NUM || rx_idx >= SOFT_UART_PCA_CH_NUM || tx_idx == rx_idx ||
+            g_pSoftUartModule[tx_idx] || g_pSoftUartModule[rx_idx] )
+            break;
+
+        /* a whole frame MUST fit the 16-bits compare distance */
+        bit_q8 = (uint32_t)(((uint64_t)hsuart->Init.PcaClock << 8) / hsuart->Init.BaudRate);
+        if( (bit_q8 >> 8) < SOFT_UART_MIN_BIT_TICKS ||
+            (bit_q8 >> 8) * (SOFT_UART_FRAME_BITS + 1) > 0xFFFFul )
+            break;
+
+        hsuart->TxIdx = (uint8_t)tx_idx;
+        hsuart->RxIdx = (uint8_t)rx_idx;
+
+        for(uint32_t i = 0; i <= SOFT_UART_FRAME_BITS; i++)
+            hsuart->BitOffset[i] = (uint16_t)((i * bit_q8) >> 8);
+
+        for(uint32_t i = 0; i < SOFT_UART_FRAME_BITS; i++)
+            hsuart->SampleOffset[i] = (uint16_t)((i * bit_q8 + (bit_q8 >> 1)) >> 8);
+
+        hsuart->TxXferCount = 0;
+        hsuart->RxXferCount = 0;
+        hsuart->ErrorCode   = SOFT_UART_ERROR_NONE;
+        hsuart->RxBitIdx    = SOFT_UART_RX_IDLE;
+
+        PCAx = hsuart->Init.hpca->Instance;
+        g_pSoftUartPca = PCAx;
+        g_pSoftUartModule[tx_idx] = hsuart;
+        g_pSoftUartModule[rx_idx] = hsuart;
+
+        /* TX: the compare output (CCAPOx) is the line level, idle high */
+        _CCAPM(PCAx, tx_idx) = 0;
+        PCAx->CCAPO |= (0x1ul << tx_idx);
+        PCAx->POCR  |= (PCA_POCR_POE0 << tx_idx);
+
+        PCAx->INTCLR = (0x1ul << tx_idx) | (0x1ul << rx_idx);
+        _CCAPM(PCAx, rx_idx) = SOFT_UART_CCAPM_RX_CAPTURE;
+
+        __HAL_PCA_ENABLE(hsuart->Init.hpca);
+
+        hsuart->gState  = SOFT_UART_STATE_READY;
+        hsuart->RxState = SOFT_UART_STATE_READY;
+
+        status = HAL_OK;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Release the PCA modules of a port
+ *
+ *  @param [in] hsuart      The handle
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SoftUart_DeInit(SoftUart_HandleTypeDef *hsuart)
+{
+    PCA_TypeDef     *PCAx = 0;
+
+    if( !hsuart || hsuart->gState == SOFT_UART_STATE_RESET )
+        return HAL_ERROR;
+
+    PCAx = hsuart->Init.hpca->Instance;
+
+    _CCAPM(PCAx, hsuart->TxIdx) = 0;
+    _CCAPM(PCAx, hsuart->RxIdx) = 0;
+    PCAx->POCR &= ~(PCA_POCR_POE0 << hsuart->TxIdx);
+
+    g_pSoftUartModule[hsuart->TxIdx] = 0;
+    g_pSoftUartModule[hsuart->RxIdx] = 0;
+
+    hsuart->gState  = SOFT_UART_STATE_RESET;
+    hsuart->RxState = SOFT_UART_STATE_RESET;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Send an amount of data in non blocking mode
+ *
+ *  @param [in] hsuart      The handle
+ *  @param [in] pData       Pointer to data buffer
+ *  @param [in] Size        Amount of data to be sent
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SoftUart_Transmit_IT(SoftUart_HandleTypeDef *hsuart, uint8_t *pData, uint16_t Size)
+{
+    PCA_TypeDef     *PCAx = 0;
+    uint32_t        primask = 0;
+
+    if( !hsuart || hsuart->gState != SOFT_UART_STATE_READY )
+        return HAL_BUSY;
+
+    if( !pData || Size == 0 )
+        return HAL_ERROR;
+
+    PCAx = hsuart->Init.hpca->Instance;
+
+    hsuart->pTxBuffPtr  = pData;
+    hsuart->TxXferSize  = Size;
+    hsuart->TxXferCount = Size;
+    hsuart->gState      = SOFT_UART_STATE_BUSY_TX;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    _SoftUart_TxLoadFrame(hsuart, PCAx->CNT + SOFT_UART_START_TICKS);
+
+    PCAx->INTCLR = (0x1ul << hsuart->TxIdx);
+    _CCAPM(PCAx, hsuart->TxIdx) = SOFT_UART_CCAPM_TX_TOGGLE;
+
+    __set_PRIMASK(primask);
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Receive an amount of data in non blocking mode
+ *
+ *  @param [in] hsuart      The handle
+ *  @param [in] pData       Pointer to data buffer
+ *  @param [in] Size        Amount of data to be received
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SoftUart_Receive_IT(SoftUart_HandleTypeDef *hsuart, uint8_t *pData, uint16_t Size)
+{
+    if( !hsuart || hsuart->RxState != SOFT_UART_STATE_READY )
+        return HAL_BUSY;
+
+    if( !pData || Size == 0 )
+        return HAL_ERROR;
+
+    hsuart->pRxBuffPtr  = pData;
+    hsuart->RxXferSize  = Size;
+    hsuart->RxXferCount = Size;
+    hsuart->ErrorCode   = SOFT_UART_ERROR_NONE;
+
+    __DMB();
+    hsuart->RxState = SOFT_UART_STATE_BUSY_RX;
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Abort the ongoing transmission, the line goes back to idle high
+ *
+ *  @param [in] hsuart      The handle
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SoftUart_AbortTransmit(SoftUart_HandleTypeDef *hsuart)
+{
+    PCA_TypeDef     *PCAx = 0;
+    uint32_t        primask = 0;
+
+    if( !hsuart || hsuart->gState == SOFT_UART_STATE_RESET )
+        return HAL_ERROR;
+
+    PCAx = hsuart->Init.hpca->Instance;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    _CCAPM(PCAx, hsuart->TxIdx) = 0;
+    PCAx->CCAPO |= (0x1ul << hsuart->TxIdx);
+    PCAx->INTCLR = (0x1ul << hsuart->TxIdx);
+
+    hsuart->TxXferCount = 0;
+    hsuart->gState      = SOFT_UART_STATE_READY;
+
+    __set_PRIMASK(primask);
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Abort the ongoing reception, the frame on the line is still tracked
+ *
+ *  @param [in] hsuart      The handle
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SoftUart_AbortReceive(SoftUart_HandleTypeDef *hsuart)
+{
+    if( !hsuart || hsuart->RxState == SOFT_UART_STATE_RESET )
+        return HAL_ERROR;
+
+    hsuart->RxXferCount = 0;
+    hsuart->RxState     = SOFT_UART_STATE_READY;
+    return HAL_OK;
+}
+
+uint32_t SoftUart_GetError(SoftUart_HandleTypeDef *hsuart)
+{
+    return hsuart->ErrorCode;
+}
+
+__weak void SoftUart_TxCpltCallback(SoftUart_HandleTypeDef *hsuart)
+{
+    UNUSED(hsuart);
+}
+
+__weak void SoftUart_RxCpltCallback(SoftUart_HandleTypeDef *hsuart)
+{
+    UNUSED(hsuart);
+}
+
+__weak void SoftUart_ErrorCallback(SoftUart_HandleTypeDef *hsuart)
+{
+    UNUSED(hsuart);
+}
+
+/**
+ *  @brief  PCA handler of all software UART ports,
+ *          call it from PCA_IRQHandler() instead of HAL_PCA_IRQHandler()
+ *
+ *  @return
+ *      None
+ */
+void SoftUart_PCA_IRQHandler(void)
+{
+    PCA_TypeDef     *PCAx = g_pSoftUartPca;
+    uint32_t        flags = 0;
+
+    if( !PCAx )
+        return;
+
+    flags = PCAx->CR & SOFT_UART_PCA_CCF_ALL_Msk;
+    PCAx->INTCLR = flags;
+
+    for(uint32_t i = 0; flags; i++, flags >>= 1)
+    {
+        SoftUart_HandleTypeDef  *hsuart = g_pSoftUartModule[i];
+
+        if( !(flags & 0x1ul) || !hsuart )
+            continue;
+
+        if( i == hsuart->TxIdx )    _SoftUart_TxISR(hsuart);
+        else                        _SoftUart_RxISR(hsuart);
+    }
+
+    return;
+}
+
+#endif /* HAL_PCA_MODULE_ENABLED */
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file soft_uart.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/21
+ * @license
+ * @description
+ *  Software UART (8N1) on the PCA capture/compare modules, one module for TX
+ *  and one for RX of every port.
+ *
+ *  + TX: the compare output is toggled by hardware at the bit boundaries where
+ *    the level changes, the ISR only moves the compare point to the next
+ *    transition (at most 10 interrupts per byte).
+ *  + RX: the falling edge of the start bit is captured, then the module is
+ *    switched to compare and the RX pin is sampled at the middle of every bit.
+ *  + The API follows the interrupt mode of the UART HAL driver
+ *    (Transmit_IT/Receive_IT, TxCplt/RxCplt/Error weak callbacks).
+ *
+ *  The PCA counter MUST be free running (16-bits). The worst case latency of
+ *  the PCA ISR (including the other modules serviced before) MUST be shorter
+ *  than half a bit, a missed RX sample point is only matched again after a
+ *  wrap of the counter. Tests/host/test_soft_uart.c models 2 ports in full
+ *  duplex at HCLK 24 MHz: other ISRs may block the PCA IRQ up to 20/10/2 us
+ *  at 9600/19200/38400 baud.
+ */
+
+#ifndef __soft_uart_H_p7LdY2vS_lHq9_HmWc_s4Ex_uB6tNk1aRfJo__
+#define __soft_uart_H_p7LdY2vS_lHq9_HmWc_s4Ex_uB6tNk1aRfJo__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define SOFT_UART_FRAME_BITS        10      /*!< start + 8 data + stop */
+
+typedef enum SoftUart_State
+{
+    SOFT_UART_STATE_RESET       = 0x00U,
+    SOFT_UART_STATE_READY       = 0x20U,
+    SOFT_UART_STATE_BUSY_TX     = 0x21U,
+    SOFT_UART_STATE_BUSY_RX     = 0x22U,
+
+} SoftUart_StateTypeDef;
+
+#define SOFT_UART_ERROR_NONE        0x00000000U
+#define SOFT_UART_ERROR_FE          0x00000004U     /*!< Frame error (stop bit is low) */
+#define SOFT_UART_ERROR_ORE         0x00000008U     /*!< A byte is received without Receive_IT */
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief Configuration of a software UART port
+ */
+typedef struct SoftUart_Init
+{
+    PCA_HandleTypeDef   *hpca;
+
+    uint32_t            PcaClock;       /*!< Counter frequency of the PCA in Hz */
+    uint32_t            BaudRate;
+
+    uint32_t            TxChannel;      /*!< PCA_CHANNEL_x, the TX pin is its compare output */
+    uint32_t            RxChannel;      /*!< PCA_CHANNEL_x, the RX pin is its capture input */
+    GPIO_TypeDef        *RxPort;        /*!< GPIO of the RX pin, it is sampled by IDR */
+    uint32_t            RxPin;          /*!< GPIO_PIN_x */
+
+} SoftUart_InitTypeDef;
+
+/**
+ *  @brief Software UART handle
+ */
+typedef struct __SoftUart_HandleTypeDef
+{
+    SoftUart_InitTypeDef    Init;
+
+    uint8_t                 *pTxBuffPtr;
+    uint16_t                TxXferSize;
+    volatile uint16_t       TxXferCount;
+
+    uint8_t                 *pRxBuffPtr;
+    uint16_t                RxXferSize;
+    volatile uint16_t       RxXferCount;
+
+    volatile uint8_t        gState;     /*!< SoftUart_StateTypeDef of TX */
+    volatile uint8_t        RxState;    /*!< SoftUart_StateTypeDef of RX */
+    volatile uint32_t       ErrorCode;
+
+    /* private */
+    uint8_t                 TxIdx;      /*!< PCA module index */
+    uint8_t                 RxIdx;
+    uint16_t                BitOffset[SOFT_UART_FRAME_BITS + 1];    /*!< Start of every bit from the frame start */
+    uint16_t                SampleOffset[SOFT_UART_FRAME_BITS];     /*!< Middle of every bit from the start edge */
+
+    uint16_t                TxFrame;    /*!< bit0: start bit, bit9: stop bit */
+    uint16_t                TxFrameStart;
+    uint8_t                 TxBitIdx;
+
+    uint8_t                 RxBitIdx;
+    uint8_t                 RxShift;
+    uint16_t                RxFrameStart;
+
+} SoftUart_HandleTypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef SoftUart_Init(SoftUart_HandleTypeDef *hsuart);
+HAL_StatusTypeDef SoftUart_DeInit(SoftUart_HandleTypeDef *hsuart);
+
+HAL_StatusTypeDef SoftUart_Transmit_IT(SoftUart_HandleTypeDef *hsuart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef SoftUart_Receive_IT(SoftUart_HandleTypeDef *hsuart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef SoftUart_AbortTransmit(SoftUart_HandleTypeDef *hsuart);
+HAL_StatusTypeDef SoftUart_AbortReceive(SoftUart_HandleTypeDef *hsuart);
+
+uint32_t SoftUart_GetError(SoftUart_HandleTypeDef *hsuart);
+
+void SoftUart_TxCpltCallback(SoftUart_HandleTypeDef *hsuart);
+void SoftUart_RxCpltCallback(SoftUart_HandleTypeDef *hsuart);
+void SoftUart_ErrorCallback(SoftUart_HandleTypeDef *hsuart);
+
+void SoftUart_PCA_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,733 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file stepper.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/19
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "stepper.h"
+
+#if defined(HAL_TIM_MODULE_ENABLED) || defined(HAL_PCA_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define STEPPER_TIM_NUM             2
+#define STEPPER_TIM_CH_NUM          4
+#define STEPPER_PCA_CH_NUM          5
+
+#define STEPPER_PERIOD_MAX          (0xFFFFul << 8)
+
+/**
+ *  q is limited to 0.5 (Q32), then 1.5 * q^2 fits 32-bits
+ */
+#define STEPPER_Q_MAX               0x80000000ul
+
+#define STEPPER_PCA_CCF_ALL_Msk     (PCA_CR_CCF0 | PCA_CR_CCF1 | PCA_CR_CCF2 | PCA_CR_CCF3 | PCA_CR_CCF4)
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+/* STEPPER_TIM_NUM for the instances without CCR1~CCR4 (TIM1A/TIM1B/TIM2A/TIM2B/TIM2C) */
+#define _STEPPER_TIM_SLOT(__TIMx__)     (((__TIMx__) == TIM1) ? 0 :                     \
+                                         ((__TIMx__) == TIM2) ? 1 : STEPPER_TIM_NUM)
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+#if defined(HAL_TIM_MODULE_ENABLED)
+static Stepper_TypeDef      *g_pStepperTim[STEPPER_TIM_NUM][STEPPER_TIM_CH_NUM] = {{0}};
+
+static void _Stepper_TimCC1ISR(TIM_HandleTypeDef *htim);
+static void _Stepper_TimCC2ISR(TIM_HandleTypeDef *htim);
+static void _Stepper_TimCC3ISR(TIM_HandleTypeDef *htim);
+static void _Stepper_TimCC4ISR(TIM_HandleTypeDef *htim);
+
+static const pTIM_CallbackTypeDef   g_Stepper_FastCallbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_CC1] = _Stepper_TimCC1ISR,
+    [HAL_TIM_FAST_CB_CC2] = _Stepper_TimCC2ISR,
+    [HAL_TIM_FAST_CB_CC3] = _Stepper_TimCC3ISR,
+    [HAL_TIM_FAST_CB_CC4] = _Stepper_TimCC4ISR,
+};
+#endif
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+static Stepper_TypeDef      *g_pStepperPca[STEPPER_PCA_CH_NUM] = {0};
+static PCA_TypeDef          *g_pStepperPcaInst = 0;
+#endif
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static uint32_t _Stepper_Sqrt(uint64_t value)
+{
+    uint64_t    root = 0;
+    uint64_t    bit = 0x1ull << 62;
+
+    while( bit > value )
+        bit >>= 2;
+
+    while( bit )
+    {
+        if( value >= root + bit )
+        {
+            value -= root + bit;
+            root   = (root >> 1) + bit;
+        }
+        else
+            root >>= 1;
+
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+static void _Stepper_TimSetOcMode(TIM_TypeDef *TIMx, uint32_t channel, uint32_t oc_mode)
+{
+    __IO uint32_t   *pCCMR = (channel < TIM_CHANNEL_3) ? &TIMx->CCMR1_OUT : &TIMx->CCMR2_OUT;
+    uint32_t        shift = (channel & TIM_CHANNEL_2) ? 8 : 0;
+
+    MODIFY_REG(*pCCMR, TIM_CCMR1_OUT_OC1M << shift, oc_mode << shift);
+    return;
+}
+#endif
+
+/**
+ *  @brief  Start toggling the STEP pin, the first edge is after STEPPER_START_TICKS
+ *
+ *  @param [in] pAxis       The axis
+ *  @return
+ *      None
+ */
+static void _Stepper_HwStart(Stepper_TypeDef *pAxis)
+{
+    pAxis->IsPinHigh = 0;
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+    if( pAxis->Init.HwSel == STEPPER_HW_TIM )
+    {
+        TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pAxis->Init.pHandle;
+        uint32_t            it = TIM_IT_CC1 << (pAxis->Init.Channel >> 2);
+
+        pAxis->NextCmp   = (uint16_t)(htim->Instance->CNT + STEPPER_START_TICKS);
+        *pAxis->pCmpReg  = pAxis->NextCmp;
+
+        __HAL_TIM_CLEAR_IT(htim, it);
+        _Stepper_TimSetOcMode(htim->Instance, pAxis->Init.Channel, TIM_OCMODE_TOGGLE);
+        __HAL_TIM_ENABLE_IT(htim, it);
+        return;
+    }
+#endif
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+    if( pAxis->Init.HwSel == STEPPER_HW_PCA )
+    {
+        PCA_HandleTypeDef   *hpca = (PCA_HandleTypeDef*)pAxis->Init.pHandle;
+        __IO uint32_t       *pCCAPM = &hpca->Instance->CCAPM0 + (pAxis->pCmpReg - &hpca->Instance->CCAP0);
+
+        pAxis->NextCmp   = (uint16_t)(hpca->Instance->CNT + STEPPER_START_TICKS);
+        *pAxis->pCmpReg  = pAxis->NextCmp;
+
+        hpca->Instance->INTCLR = pAxis->Init.Channel;
+        *pCCAPM = PCA_CCAPM0_ECOM | PCA_CCAPM0_MAT | PCA_CCAPM0_TOG | PCA_CCAPM0_CCIE;
+        return;
+    }
+#endif
+
+    return;
+}
+
+/**
+ *  @brief  Stop toggling the STEP pin
+ *
+ *  @param [in] pAxis       The axis
+ *  @return
+ *      None
+ */
+static void _Stepper_HwStop(Stepper_TypeDef *pAxis)
+{
+#if defined(HAL_TIM_MODULE_ENABLED)
+    if( pAxis->Init.HwSel == STEPPER_HW_TIM )
+    {
+        TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pAxis->Init.pHandle;
+
+        __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1 << (pAxis->Init.Channel >> 2));
+        _Stepper_TimSetOcMode(htim->Instance, pAxis->Init.Channel, TIM_OCMODE_FORCED_INACTIVE);
+    }
+#endif
+
+#if defined(HAL_PCA_MODULE_ENABLED)
+    if( pAxis->Init.HwSel == STEPPER_HW_PCA )
+    {
+        PCA_HandleTypeDef   *hpca = (PCA_HandleTypeDef*)pAxis->Init.pHandle;
+
+        *(&hpca->Instance->CCAPM0 + (pAxis->pCmpReg - &hpca->Instance->CCAP0)) = 0;
+    }
+#endif
+
+    pAxis->IsPinHigh = 0;
+    return;
+}
+
+static void _Stepper_SetDir(Stepper_TypeDef *pAxis, uint32_t is_reverse)
+{
+    if( !pAxis->Init.DirPort )
+        return;
+
+    if( is_reverse ^ pAxis->Init.DirInvert )
+        pAxis->Init.DirPort->ODSET = pAxis->Init.DirPin;
+    else
+        pAxis->Init.DirPort->ODCLR = pAxis->Init.DirPin;
+
+    return;
+}
+
+/**
+ *  @brief  Pop the next move from the queue
+ *
+ *  @param [in] pAxis       The axis
+ *  @return
+ *      0: the queue is empty
+ */
+static uint32_t _Stepper_LoadNext(Stepper_TypeDef *pAxis)
+{
+    uint32_t    rd_idx = pAxis->RdIdx;
+
+    if( rd_idx == pAxis->WrIdx )
+        return 0;
+
+    pAxis->Cur   = pAxis->Init.pQueue[rd_idx & (pAxis->Init.QueueSize - 1)];
+    pAxis->RdIdx = rd_idx + 1;
+
+    _Stepper_SetDir(pAxis, pAxis->Cur.IsReverse);
+
+    pAxis->StepCnt = 0;
+    pAxis->Period  = pAxis->Cur.PStart;
+    pAxis->MCur    = (pAxis->Cur.MStep) ? pAxis->Cur.MStep : pAxis->Cur.MMant;
+    return 1;
+}
+
+/**
+ *  @brief  One step of the delay recurrence, p' = p * (1 -/+ q + 1.5 * q^2), q = |m| * p^2
+ *
+ *  @param [in] p           Step period, ticks in Q24.8
+ *  @param [in] m_mant      Mantissa of |m|
+ *  @param [in] m_shift     Shift of |m|, >= 32
+ *  @param [in] is_accel    Acceleration (period decreases) or deceleration
+ *  @return
+ *      The next step period
+ */
+static uint32_t
+_Stepper_Recurrence(uint32_t p, uint32_t m_mant, uint32_t m_shift, uint32_t is_accel)
+{
+    uint64_t    q = 0;
+    uint32_t    q2 = 0;
+    uint32_t    dp = 0;
+
+    /* q in Q32, p^2 is reduced to integer ticks^2 (<= 2^32) */
+    q = ((((uint64_t)p * p) >> 16) * m_mant) >> (m_shift - 32);
+    if( q > STEPPER_Q_MAX )
+        q = STEPPER_Q_MAX;
+
+    q2 = (uint32_t)(((uint64_t)q * q) >> 32);
+    q2 = q2 + (q2 >> 1);
+
+    dp = (uint32_t)(((uint64_t)p * (uint32_t)q) >> 32);
+    p += (uint32_t)(((uint64_t)p * q2) >> 32);
+
+    return (is_accel) ? p - dp : p + dp;
+}
+
+/**
+ *  @brief  Ramp m of the S-curve, it goes up in the first half of a ramp and down in the second half
+ *
+ *  @param [in] pAxis       The axis
+ *  @param [in] idx         Step index in the ramp
+ *  @return
+ *      None
+ */
+static void _Stepper_RampM(Stepper_TypeDef *pAxis, uint32_t idx)
+{
+    uint32_t    m_step = pAxis->Cur.MStep;
+
+    if( !m_step )
+        return;
+
+    if( idx < (pAxis->Cur.AccSteps >> 1) )
+    {
+        if( pAxis->MCur <= pAxis->Cur.MMant - m_step )
+            pAxis->MCur += m_step;
+    }
+    else if( pAxis->MCur > m_step )
+        pAxis->MCur -= m_step;
+
+    return;
+}
+
+/**
+ *  @brief  Period of the next step
+ *
+ *  @param [in] pAxis       The axis
+ *  @return
+ *      Step period, ticks in Q24.8
+ */
+static uint32_t _Stepper_NextPeriod(Stepper_TypeDef *pAxis)
+{
+    Stepper_PlanTypeDef     *pCur = &pAxis->Cur;
+    uint32_t                step_cnt = pAxis->StepCnt;
+    uint32_t                p = pAxis->Period;
+
+    if( step_cnt < pCur->AccSteps )
+    {
+        _Stepper_RampM(pAxis, step_cnt);
+
+        p = _Stepper_Recurrence(p, pAxis->MCur, pCur->MShift, 1);
+        if( p < pCur->PMin )
+            p = pCur->PMin;
+    }
+    else if( step_cnt >= pCur->DecStart )
+    {
+        if( step_cnt == pCur->DecStart && pCur->MStep )
+            pAxis->MCur = pCur->MStep;
+
+        _Stepper_RampM(pAxis, step_cnt - pCur->DecStart);
+
+        p = _Stepper_Recurrence(p, pAxis->MCur, pCur->MShift, 0);
+        if( p > STEPPER_PERIOD_MAX )
+            p = STEPPER_PERIOD_MAX;
+    }
+    else
+    {
+        p = pCur->PMin;
+    }
+
+    return p;
+}
+
+static void _Stepper_SetCmp(Stepper_TypeDef *pAxis, uint32_t ticks)
+{
+    pAxis->NextCmp  = (uint16_t)(pAxis->NextCmp + ticks);
+    *pAxis->pCmpReg = pAxis->NextCmp;
+    return;
+}
+
+/**
+ *  @brief  Compare match, the STEP pin was just toggled by hardware
+ *
+ *  @param [in] pAxis       The axis
+ *  @return
+ *      None
+ */
+static void _Stepper_OnCompare(Stepper_TypeDef *pAxis)
+{
+    if( !pAxis->IsPinHigh )
+    {
+        /* rising edge, one step */
+        uint32_t    ticks = pAxis->Period >> 8;
+        uint32_t    high = ticks >> 1;
+
+        _Stepper_SetCmp(pAxis, high);
+
+        pAxis->IsPinHigh = 1;
+        pAxis->LowTicks  = (uint16_t)(ticks - high);
+        pAxis->StepCnt++;
+        pAxis->Position += (pAxis->Cur.IsReverse) ? -1 : 1;
+        return;
+    }
+
+    /* falling edge */
+    pAxis->IsPinHigh = 0;
+
+    if( pAxis->StepCnt < pAxis->Cur.Steps )
+    {
+        _Stepper_SetCmp(pAxis, pAxis->LowTicks);
+
+        /* the next edge is scheduled, the recurrence runs out of the critical timing */
+        pAxis->Period = _Stepper_NextPeriod(pAxis);
+        return;
+    }
+
+    if( pAxis->Init.pfDoneCallback )
+        pAxis->Init.pfDoneCallback(pAxis);
+
+    if( !pAxis->IsStopReq && _Stepper_LoadNext(pAxis) )
+    {
+        _Stepper_SetCmp(pAxis, pAxis->LowTicks);
+        return;
+    }
+
+    _Stepper_HwStop(pAxis);
+
+    pAxis->IsStopReq = 0;
+    pAxis->State     = STEPPER_STATE_IDLE;
+    return;
+}
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+static void _Stepper_TimCCISR(TIM_HandleTypeDef *htim, uint32_t ch_idx)
+{
+    Stepper_TypeDef     *pAxis = g_pStepperTim[_STEPPER_TIM_SLOT(htim->Instance)][ch_idx];
+
+    if( pAxis )
+        _Stepper_OnCompare(pAxis);
+
+    return;
+}
+
+static void _Stepper_TimCC1ISR(TIM_HandleTypeDef *htim)  { _Stepper_TimCCISR(htim, 0); }
+static void _Stepper_TimCC2ISR(TIM_HandleTypeDef *htim)  { _Stepper_TimCCISR(htim, 1); }
+static void _Stepper_TimCC3ISR(TIM_HandleTypeDef *htim)  { _Stepper_TimCCISR(htim, 2); }
+static void _Stepper_TimCC4ISR(TIM_HandleTypeDef *htim)  { _Stepper_TimCCISR(htim, 3); }
+#endif
+
+/**
+ *  @brief  Plan a move, all divisions of the profile are done here
+ *
+ *  @param [in] pAxis       The axis
+ *  @param [in] pPlan       Report the plan
+ *  @param [in] steps       Signed number of steps
+ *  @param [in] speed       Cruise speed in steps/s
+ *  @param [in] accel       Acceleration in steps/s^2, 0: constant speed
+ *  @param [in] profile     Stepper_ProfileTypeDef
+ *  @return
+ *      HAL status
+ */
+static HAL_StatusTypeDef
+_Stepper_Plan(
+    Stepper_TypeDef         *pAxis,
+    Stepper_PlanTypeDef     *pPlan,
+    int32_t                 steps,
+    uint32_t                speed,
+    uint32_t                accel,
+    Stepper_ProfileTypeDef  profile)
+{
+    uint64_t    freq = pAxis->Init.TickFreq;
+    uint64_t    value = 0;
+
+    memset(pPlan, 0x0, sizeof(Stepper_PlanTypeDef));
+
+    if( steps == 0 || speed == 0 )
+        return HAL_ERROR;
+
+    pPlan->IsReverse = (steps < 0);
+    pPlan->Steps     = (steps < 0) ? (uint32_t)(-steps) : (uint32_t)steps;
+
+    value = (freq << 8) / speed;
+    if( value < (STEPPER_MIN_PERIOD_TICKS << 8) || value > STEPPER_PERIOD_MAX )
+        return HAL_ERROR;
+
+    pPlan->PMin     = (uint32_t)value;
+    pPlan->PStart   = pPlan->PMin;
+    pPlan->DecStart = pPlan->Steps;
+    pPlan->MShift   = 32;
+
+    if( accel == 0 )
+        return HAL_OK;
+
+    /* m = accel / F^2, normalized to a 31-bits mantissa by shift-subtract */
+    {
+        uint64_t    den = freq * freq;
+        uint64_t    rem = accel;
+        uint32_t    mant = 0;
+        uint32_t    shift = 0;
+
+        if( rem >= den )
+            return HAL_ERROR;
+
+        while( mant < (0x1ul << 30) && shift < 62 )
+        {
+            rem  <<= 1;
+            mant <<= 1;
+            shift++;
+
+            if( rem >= den )
+            {
+                rem  -= den;
+                mant |= 0x1ul;
+            }
+        }
+
+        if( shift <= 32 )
+            return HAL_ERROR;
+
+        pPlan->MMant  = mant;
+        pPlan->MShift = (uint8_t)shift;
+    }
+
+    /* first period F / sqrt(2 * accel), Q8 */
+    value = (freq << 16) / _Stepper_Sqrt((uint64_t)accel << 17);
+    if( value > STEPPER_PERIOD_MAX )
+        value = STEPPER_PERIOD_MAX;
+
+    if( value <= pPlan->PMin )
+        return HAL_OK;
+
+    pPlan->PStart = (uint32_t)value;
+
+    value = ((uint64_t)speed * speed) / ((uint64_t)accel << 1);
+    if( value > (pPlan->Steps >> 1) )
+        value = pPlan->Steps >> 1;
+
+    pPlan->AccSteps = (uint32_t)value;
+    pPlan->DecStart = pPlan->Steps - pPlan->AccSteps;
+
+    if( profile == STEPPER_PROFILE_SCURVE && pPlan->AccSteps >= 4 )
+    {
+        /* triangular m with the same average, the peak is 2 * m */
+        pPlan->MShift--;
+        pPlan->MStep = pPlan->MMant / (pPlan->AccSteps >> 1);
+    }
+
+    return HAL_OK;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize an axis, the STEP pin is kept low
+ *
+ *  @param [in] pAxis       The axis
+ *  @param [in] pInit       The configuration of the axis
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Stepper_Init(Stepper_TypeDef *pAxis, Stepper_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        if( !pAxis || !pInit || !pInit->pHandle || !pInit->TickFreq ||
+            !pInit->pQueue || !pInit->QueueSize || (pInit->QueueSize & (pInit->QueueSize - 1)) )
+            break;
+
+        memset(pAxis, 0x0, sizeof(Stepper_TypeDef));
+        pAxis->Init = *pInit;
+
+    #if defined(HAL_TIM_MODULE_ENABLED)
+        if( pInit->HwSel == STEPPER_HW_TIM )
+        {
+            TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pInit->pHandle;
+            uint32_t            ch_idx = pInit->Channel >> 2;
+
+            if( ch_idx >= STEPPER_TIM_CH_NUM ||
+                _STEPPER_TIM_SLOT(htim->Instance) >= STEPPER_TIM_NUM )
+                break;
+
+            pAxis->pCmpReg = &htim->Instance->CCR1 + ch_idx;
+
+            _Stepper_TimSetOcMode(htim->Instance, pInit->Channel, TIM_OCMODE_FORCED_INACTIVE);
+
+            g_pStepperTim[_STEPPER_TIM_SLOT(htim->Instance)][ch_idx] = pAxis;
+            HAL_TIM_RegisterFastCallbacks(htim, g_Stepper_FastCallbacks);
+
+            /* output enabled, counter running */
+            status = HAL_TIM_OC_Start(htim, pInit->Channel);
+        }
+    #endif
+
+    #if defined(HAL_PCA_MODULE_ENABLED)
+        if( pInit->HwSel == STEPPER_HW_PCA )
+        {
+            PCA_HandleTypeDef   *hpca = (PCA_HandleTypeDef*)pInit->pHandle;
+            uint32_t            ch_idx = 0;
+
+            while( ch_idx < STEPPER_PCA_CH_NUM && !(pInit->Channel & (0x1ul << ch_idx)) )
+                ch_idx++;
+
+            if( ch_idx >= STEPPER_PCA_CH_NUM || (pInit->Channel & ~(0x1ul << ch_idx)) )
+                break;
+
+            pAxis->pCmpReg = &hpca->Instance->CCAP0 + ch_idx;
+            *(&hpca->Instance->CCAPM0 + ch_idx) = 0;
+
+            g_pStepperPca[ch_idx] = pAxis;
+            g_pStepperPcaInst     = hpca->Instance;
+
+            __HAL_PCA_ENABLE(hpca);
+            status = HAL_OK;
+        }
+    #endif
+
+        if( status != HAL_OK )
+            break;
+
+        pAxis->State = STEPPER_STATE_IDLE;
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Plan a move and append it to the queue, the axis starts if it is idle
+ *
+ *  @param [in] pAxis       The axis
+ *  @param [in] steps       Signed number of steps (the sign is the direction)
+ *  @param [in] speed       Cruise speed in steps/s
+ *  @param [in] accel       Acceleration and deceleration in steps/s^2, 0: constant speed
+ *  @param [in] profile     Stepper_ProfileTypeDef
+ *  @return
+ *      HAL status
+ *          HAL_BUSY: the queue is full
+ */
+HAL_StatusTypeDef
+Stepper_QueueMove(
+    Stepper_TypeDef         *pAxis,
+    int32_t                 steps,
+    uint32_t                speed,
+    uint32_t                accel,
+    Stepper_ProfileTypeDef  profile)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        Stepper_PlanTypeDef     plan;
+        uint32_t                wr_idx = 0;
+        uint32_t                primask = 0;
+
+        if( !pAxis || !pAxis->pCmpReg )
+            break;
+
+        status = _Stepper_Plan(pAxis, &plan, steps, speed, accel, profile);
+        if( status != HAL_OK )
+            break;
+
+        wr_idx = pAxis->WrIdx;
+        if( wr_idx - pAxis->RdIdx >= pAxis->Init.QueueSize )
+        {
+            status = HAL_BUSY;
+            break;
+        }
+
+        pAxis->Init.pQueue[wr_idx & (pAxis->Init.QueueSize - 1)] = plan;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        pAxis->WrIdx = wr_idx + 1;
+
+        if( pAxis->State == STEPPER_STATE_IDLE && _Stepper_LoadNext(pAxis) )
+        {
+            pAxis->State = STEPPER_STATE_BUSY;
+            _Stepper_HwStart(pAxis);
+        }
+
+        __set_PRIMASK(primask);
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Stop the axis and flush the queue
+ *
+ *  @param [in] pAxis           The axis
+ *  @param [in] is_immediate    1: stop at once, 0: decelerate to stop
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Stepper_Stop(Stepper_TypeDef *pAxis, uint32_t is_immediate)
+{
+    uint32_t    primask = 0;
+
+    if( !pAxis || !pAxis->pCmpReg )
+        return HAL_ERROR;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    pAxis->RdIdx = pAxis->WrIdx;
+
+    if( pAxis->State == STEPPER_STATE_BUSY )
+    {
+        if( is_immediate )
+        {
+            _Stepper_HwStop(pAxis);
+            pAxis->State = STEPPER_STATE_IDLE;
+        }
+        else
+        {
+            Stepper_PlanTypeDef     *pCur = &pAxis->Cur;
+            uint32_t                step_cnt = pAxis->StepCnt;
+
+            pAxis->IsStopReq = 1;
+
+            if( step_cnt < pCur->DecStart )
+            {
+                /* the deceleration needs the same steps as the acceleration done so far */
+                uint32_t    dec_steps = (step_cnt < pCur->AccSteps) ? step_cnt : pCur->AccSteps;
+
+                pCur->AccSteps = dec_steps;
+                pCur->DecStart = step_cnt;
+                pCur->Steps    = step_cnt + dec_steps;
+
+                if( pCur->Steps == 0 )
+                    pCur->Steps = 1;
+            }
+        }
+    }
+
+    __set_PRIMASK(primask);
+    return HAL_OK;
+}
+
+uint32_t Stepper_IsBusy(Stepper_TypeDef *pAxis)
+{
+    return (pAxis->State == STEPPER_STATE_BUSY);
+}
+
+int32_t Stepper_GetPosition(Stepper_TypeDef *pAxis)
+{
+    return pAxis->Position;
+}
+
+void Stepper_SetPosition(Stepper_TypeDef *pAxis, int32_t position)
+{
+    uint32_t    primask = __get_PRIMASK();
+
+    __disable_irq();
+    pAxis->Position = position;
+    __set_PRIMASK(primask);
+    return;
+}
+
+/**
+ *  @brief  PCA compare handler of the axes on PCA,
+ *          call it from PCA_IRQHandler() instead of HAL_PCA_IRQHandler()
+ *
+ *  @return
+ *      None
+ */
+void Stepper_PCA_IRQHandler(void)
+{
+#if defined(HAL_PCA_MODULE_ENABLED)
+    PCA_TypeDef     *PCAx = g_pStepperPcaInst;
+    uint32_t        flags = 0;
+
+    if( !PCAx )
+        return;
+
+    flags = PCAx->CR & STEPPER_PCA_CCF_ALL_Msk;
+    PCAx->INTCLR = flags;
+
+    for(uint32_t i = 0; flags; i++, flags >>= 1)
+    {
+        if( (flags & 0x1ul) && g_pStepperPca[i] )
+            _Stepper_OnCompare(g_pStepperPca[i]);
+    }
+#endif
+    return;
+}
+
+#endif /* HAL_TIM_MODULE_ENABLED || HAL_PCA_MODULE_ENABLED */
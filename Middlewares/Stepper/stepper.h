@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file stepper.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/19
+ * @license
+ * @description
+ *  Stepper motor motion profiles on output compare channels (TIM1/TIM2 CHx or PCA CCAPx).
+ *
+ *  + The STEP pin is toggled by the compare hardware, the ISR only moves the
+ *    compare point, so the pulse timing has no interrupt latency jitter as long
+ *    as the ISR is served within half of a step period.
+ *  + The per-step delay uses the division-free recurrence
+ *        p' = p * (1 + q + 1.5 * q^2),  q = m * p^2,  m = -/+ accel / F^2
+ *    (negative while accelerating), all divisions are done in Stepper_QueueMove().
+ *  + S-curve is approximated by ramping m up and down in the step domain
+ *    (triangular acceleration with the same average).
+ *  + Every axis has its own queue of moves, the next move starts right after
+ *    the last step of the current one.
+ *
+ *  The counter of TIM (ARR = 0xFFFF) or PCA MUST be free running, one tick is
+ *  1 / TickFreq second and a step period MUST be less than 65536 ticks.
+ */
+
+#ifndef __stepper_H_a4GmW7rC_lYx1_HsNd_s6Tb_uK8eQj3vPzLi__
+#define __stepper_H_a4GmW7rC_lYx1_HsNd_s6Tb_uK8eQj3vPzLi__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  The minimum step period in ticks, the ISR MUST finish in half of it
+ */
+#ifndef STEPPER_MIN_PERIOD_TICKS
+#define STEPPER_MIN_PERIOD_TICKS    40
+#endif
+
+/**
+ *  Delay in ticks from the start of a move to the first step edge
+ */
+#define STEPPER_START_TICKS         32
+
+typedef enum Stepper_HwSel
+{
+    STEPPER_HW_TIM      = 0,    /*!< TIM1/TIM2 CH1~CH4, TIM_HandleTypeDef */
+    STEPPER_HW_PCA,             /*!< PCA CCAP0~CCAP4, PCA_HandleTypeDef */
+
+} Stepper_HwSelTypeDef;
+
+typedef enum Stepper_Profile
+{
+    STEPPER_PROFILE_TRAPEZOID   = 0,
+    STEPPER_PROFILE_SCURVE,
+
+} Stepper_ProfileTypeDef;
+
+typedef enum Stepper_State
+{
+    STEPPER_STATE_IDLE      = 0,
+    STEPPER_STATE_BUSY,
+
+} Stepper_StateTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+struct Stepper;
+
+/**
+ *  @brief Callback of the end of a move, it is executed in ISR context
+ */
+typedef void (*Stepper_CallbackTypeDef)(struct Stepper *pAxis);
+
+/**
+ *  @brief A planned move, the parameters of the step recurrence
+ */
+typedef struct Stepper_Plan
+{
+    uint32_t    Steps;          /*!< Number of steps */
+    uint32_t    AccSteps;       /*!< Steps of the acceleration (and deceleration) */
+    uint32_t    DecStart;       /*!< Step index where the deceleration starts */
+    uint32_t    PStart;         /*!< First step period, ticks in Q24.8 */
+    uint32_t    PMin;           /*!< Cruise step period, ticks in Q24.8 */
+    uint32_t    MMant;          /*!< m = MMant / 2^MShift (peak of the S-curve) */
+    uint32_t    MStep;          /*!< S-curve: MMant change per step, 0: trapezoid */
+    uint8_t     MShift;
+    uint8_t     IsReverse;
+
+} Stepper_PlanTypeDef;
+
+/**
+ *  @brief Initial configuration of an axis
+ */
+typedef struct Stepper_Init
+{
+    Stepper_HwSelTypeDef    HwSel;
+    void                    *pHandle;       /*!< TIM_HandleTypeDef (HAL_TIM_OC_Init) or PCA_HandleTypeDef */
+    uint32_t                Channel;        /*!< TIM_CHANNEL_x or PCA_CHANNEL_x of the STEP pin */
+    uint32_t                TickFreq;       /*!< Counter frequency of the timer in Hz */
+
+    GPIO_TypeDef            *DirPort;       /*!< DIR pin, NULL if not used */
+    uint32_t                DirPin;         /*!< GPIO_PIN_x */
+    uint32_t                DirInvert;      /*!< 1: DIR high for the negative direction */
+
+    Stepper_PlanTypeDef     *pQueue;        /*!< Buffer of the move queue */
+    uint32_t                QueueSize;      /*!< Number of entries of pQueue, MUST be power of 2 */
+
+    Stepper_CallbackTypeDef pfDoneCallback; /*!< Called at the end of every move */
+    void                    *pUserData;
+
+} Stepper_InitTypeDef;
+
+/**
+ *  @brief Stepper axis object
+ */
+typedef struct Stepper
+{
+    Stepper_InitTypeDef     Init;
+
+    __IO uint32_t           *pCmpReg;       /*!< CCRx or CCAPx */
+    uint16_t                NextCmp;
+    uint16_t                LowTicks;       /*!< Ticks from the falling edge to the next step */
+    uint8_t                 IsPinHigh;
+
+    volatile uint8_t        State;          /*!< Stepper_StateTypeDef */
+    volatile uint8_t        IsStopReq;
+
+    /* running move */
+    Stepper_PlanTypeDef     Cur;
+    uint32_t                StepCnt;
+    uint32_t                Period;         /*!< Current step period, ticks in Q24.8 */
+    uint32_t                MCur;           /*!< Current m of the S-curve */
+
+    volatile int32_t        Position;
+
+    volatile uint32_t       WrIdx;
+    volatile uint32_t       RdIdx;
+
+} Stepper_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef Stepper_Init(Stepper_TypeDef *pAxis, Stepper_InitTypeDef *pInit);
+
+HAL_StatusTypeDef Stepper_QueueMove(Stepper_TypeDef *pAxis, int32_t steps, uint32_t speed,
+                                    uint32_t accel, Stepper_ProfileTypeDef profile);
+
+HAL_StatusTypeDef Stepper_Stop(Stepper_TypeDef *pAxis, uint32_t is_immediate);
+
+uint32_t Stepper_IsBusy(Stepper_TypeDef *pAxis);
+int32_t Stepper_GetPosition(Stepper_TypeDef *pAxis);
+void Stepper_SetPosition(Stepper_TypeDef *pAxis, int32_t position);
+
+void Stepper_PCA_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,864 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file sw_timer.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/12
+ * @license
+ * @description
+ *  The wheel tracks the absolute tick 'now' (the next tick to be processed).
+ *  A timer is put into level L when (Expires - now) < (1 << ((L + 1) * BITS)),
+ *  and the higher levels cascade into the lower ones when 'now' crosses their
+ *  slot boundary.
+ *
+ *  The hardware counter counts up from its start value to the maximum value,
+ *  raises the overflow interrupt and reloads BGLOAD, so a period of N counts
+ *  starts at MAX + 1 - N. The counter is never written after the start: the
+ *  ISR folds every finished period into (base_tick, base_frac) and programs
+ *  BGLOAD, i.e. the period which follows the running one, to end at the next
+ *  tick with work. No count is lost by a re-programming.
+ */
+
+
+#include <string.h>
+#include "sw_timer.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define SW_TIMER_WHEEL_MASK             (SW_TIMER_WHEEL_SLOTS - 1ul)
+#define SW_TIMER_WHEEL_RANGE            (0x1ul << (SW_TIMER_WHEEL_BITS * SW_TIMER_WHEEL_LEVELS))
+
+/**
+ *  The minimum counts of the guard before a reload, longer than a BGLOAD
+ *  synchronization of LPTIM. A period is at least two guards and one tick.
+ */
+#define SW_TIMER_GUARD_COUNTS           8ul
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _LEVEL_SHIFT(__LEVEL__)         ((__LEVEL__) * SW_TIMER_WHEEL_BITS)
+
+#define _ENTER_CRITICAL(__PRIMASK__)    do { (__PRIMASK__) = __get_PRIMASK(); __disable_irq(); } while(0)
+#define _EXIT_CRITICAL(__PRIMASK__)     __set_PRIMASK(__PRIMASK__)
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct sw_timer_wheel
+{
+    SwTimer_InitTypeDef     Init;
+
+    uint32_t                cnt_max;        /*!< Maximum value of the hardware counter */
+    uint32_t                load;           /*!< Start value of the running period */
+    uint32_t                next_load;      /*!< BGLOAD, start value of the next period */
+    uint32_t                run_ticks;      /*!< Maximum ticks of one period */
+    uint32_t                min_counts;     /*!< Minimum counts of one period */
+    uint32_t                guard_counts;   /*!< BGLOAD is not written this close to the reload */
+    uint32_t                tick_mask;      /*!< (1 << TickShift) - 1 */
+
+    uint32_t                base_tick;      /*!< Tick at the start of the running period */
+    uint32_t                base_frac;      /*!< Sub-tick counts of base_tick */
+    uint32_t                hw_target;      /*!< Tick at the end of the next period */
+
+    uint32_t                now;            /*!< Next tick to be processed by the wheel */
+    uint32_t                bitmap[SW_TIMER_WHEEL_LEVELS];
+    SwTimer_TypeDef         *pSlots[SW_TIMER_WHEEL_LEVELS * SW_TIMER_WHEEL_SLOTS];
+
+    uint8_t                 is_initialized;
+
+} sw_timer_wheel_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static sw_timer_wheel_t     g_SwTimerWheel;
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static uint32_t _SwTimer_HW_GetCounter(void)
+{
+#if defined(HAL_LPTIM_MODULE_ENABLED)
+    if( g_SwTimerWheel.Init.HwSel == SW_TIMER_HW_LPTIM )
+        return ((LPTIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle)->Instance->CNTVAL;
+#endif
+
+#if defined(HAL_BASETIM_MODULE_ENABLED)
+    return ((BASETIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle)->Instance->CNT;
+#else
+    return 0ul;
+#endif
+}
+
+static uint32_t _SwTimer_HW_IsOverflow(void)
+{
+#if defined(HAL_LPTIM_MODULE_ENABLED)
+    if( g_SwTimerWheel.Init.HwSel == SW_TIMER_HW_LPTIM )
+        return (((LPTIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle)->Instance->INTSR & LPTIM_INTSR_INTF);
+#endif
+
+#if defined(HAL_BASETIM_MODULE_ENABLED)
+    return (((BASETIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle)->Instance->RAWINTSR & BASETIM_RAWINTSR_RIS);
+#else
+    return 0ul;
+#endif
+}
+
+static void _SwTimer_HW_ClearOverflow(void)
+{
+#if defined(HAL_LPTIM_MODULE_ENABLED)
+    if( g_SwTimerWheel.Init.HwSel == SW_TIMER_HW_LPTIM )
+    {
+        __HAL_LPTIM_CLEAR_IT((LPTIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle);
+        return;
+    }
+#endif
+
+#if defined(HAL_BASETIM_MODULE_ENABLED)
+    __HAL_BASETIM_CLEAR_IT((BASETIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle);
+#endif
+    return;
+}
+
+/**
+ *  @brief  Load the counter, it is only used before the counter runs
+ */
+static void _SwTimer_HW_Load(uint32_t load)
+{
+#if defined(HAL_LPTIM_MODULE_ENABLED)
+    if( g_SwTimerWheel.Init.HwSel == SW_TIMER_HW_LPTIM )
+    {
+        LPTIM_HandleTypeDef     *hLPTIM = (LPTIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle;
+
+        __HAL_LPTIM_CLEAR_IT(hLPTIM);
+        __HAL_LPTIM_SET_COUNTER(hLPTIM, load);
+        return;
+    }
+#endif
+
+#if defined(HAL_BASETIM_MODULE_ENABLED)
+    {
+        BASETIM_HandleTypeDef   *hBASETIM = (BASETIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle;
+
+        __HAL_BASETIM_CLEAR_IT(hBASETIM);
+        WRITE_REG(hBASETIM->Instance->LOAD, load);
+        WRITE_REG(hBASETIM->Instance->BGLOAD, load);
+    }
+#endif
+    return;
+}
+
+/**
+ *  @brief  Set the start value of the next period, the running period is not
+ *          restarted. The LPTIM only waits a previous write still in sync.
+ */
+static void _SwTimer_HW_SetNextLoad(uint32_t load)
+{
+    g_SwTimerWheel.next_load = load;
+
+#if defined(HAL_LPTIM_MODULE_ENABLED)
+    if( g_SwTimerWheel.Init.HwSel == SW_TIMER_HW_LPTIM )
+    {
+        LPTIM_HandleTypeDef     *hLPTIM = (LPTIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle;
+
+        while( __HAL_LPTIM_SYNC_FLAG(hLPTIM->Instance) ) {}
+        WRITE_REG(hLPTIM->Instance->BGLOAD, load);
+        return;
+    }
+#endif
+
+#if defined(HAL_BASETIM_MODULE_ENABLED)
+    WRITE_REG(((BASETIM_HandleTypeDef*)g_SwTimerWheel.Init.pHwHandle)->Instance->BGLOAD, load);
+#endif
+    return;
+}
+
+static uint32_t _SwTimer_PeriodCounts(uint32_t load)
+{
+    return (g_SwTimerWheel.cnt_max - load) + 1ul;
+}
+
+/**
+ *  @brief  Get the elapsed counts since the start of the running period, the
+ *          next period is included if the overflow is not serviced yet
+ *          (interrupts MUST be disabled by caller)
+ */
+static uint32_t _SwTimer_GetElapsedCounts(void)
+{
+    uint32_t    is_ovf = 0;
+    uint32_t    cnt = 0;
+
+    is_ovf = _SwTimer_HW_IsOverflow();
+    cnt    = _SwTimer_HW_GetCounter();
+
+    if( !is_ovf && _SwTimer_HW_IsOverflow() )
+    {
+        /* the counter overflowed between the two reads */
+        is_ovf = 1;
+        cnt    = _SwTimer_HW_GetCounter();
+    }
+
+    if( is_ovf )
+    {
+        return _SwTimer_PeriodCounts(g_SwTimerWheel.load) +
+               ((cnt - g_SwTimerWheel.next_load) & g_SwTimerWheel.cnt_max);
+    }
+
+    return (cnt - g_SwTimerWheel.load) & g_SwTimerWheel.cnt_max;
+}
+
+static uint32_t _SwTimer_GetTick(void)
+{
+    uint32_t    total = g_SwTimerWheel.base_frac + _SwTimer_GetElapsedCounts();
+    return g_SwTimerWheel.base_tick + (total >> g_SwTimerWheel.Init.TickShift);
+}
+
+/**
+ *  @brief  Fold the finished period into the time base at the overflow
+ *          (interrupts MUST be disabled by caller)
+ */
+static void _SwTimer_Fold(void)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            total = pWheel->base_frac + _SwTimer_PeriodCounts(pWheel->load);
+
+    pWheel->base_tick += (total >> pWheel->Init.TickShift);
+    pWheel->base_frac  = (total & pWheel->tick_mask);
+    pWheel->load       = pWheel->next_load;
+
+    _SwTimer_HW_ClearOverflow();
+    return;
+}
+
+static void _SwTimer_Link(SwTimer_TypeDef *pTimer)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            delta = pTimer->Expires - pWheel->now;
+    uint32_t            expires = pTimer->Expires;
+    uint32_t            level = 0;
+    uint32_t            slot = 0;
+
+    if( (int32_t)delta < 0 )
+    {
+        /* already expired, process it at the next tick */
+        expires = pWheel->now;
+        delta   = 0;
+    }
+    else if( delta >= SW_TIMER_WHEEL_RANGE )
+    {
+        /* out of range, park it at the farthest slot and re-cascade later */
+        expires = pWheel->now + SW_TIMER_WHEEL_RANGE - 1ul;
+        delta   = SW_TIMER_WHEEL_RANGE - 1ul;
+    }
+
+    while( level < (SW_TIMER_WHEEL_LEVELS - 1) &&
+           delta >= (0x1ul << _LEVEL_SHIFT(level + 1)) )
+        level++;
+
+    slot = (expires >> _LEVEL_SHIFT(level)) & SW_TIMER_WHEEL_MASK;
+
+    pTimer->WheelIdx = (uint16_t)(level * SW_TIMER_WHEEL_SLOTS + slot);
+    pTimer->ppPrev   = &pWheel->pSlots[pTimer->WheelIdx];
+    pTimer->pNext    = pWheel->pSlots[pTimer->WheelIdx];
+
+    if( pTimer->pNext )
+        pTimer->pNext->ppPrev = &pTimer->pNext;
+
+    pWheel->pSlots[pTimer->WheelIdx] = pTimer;
+    pWheel->bitmap[level] |= (0x1ul << slot);
+    return;
+}
+
+static void _SwTimer_Unlink(SwTimer_TypeDef *pTimer)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+
+    *pTimer->ppPrev = pTimer->pNext;
+    if( pTimer->pNext )
+        pTimer->pNext->ppPrev = pTimer->ppPrev;
+
+    if( !pWheel->pSlots[pTimer->WheelIdx] )
+    {
+        pWheel->bitmap[pTimer->WheelIdx / SW_TIMER_WHEEL_SLOTS] &=
+            ~(0x1ul << (pTimer->WheelIdx & SW_TIMER_WHEEL_MASK));
+    }
+
+    pTimer->pNext  = 0;
+    pTimer->ppPrev = 0;
+    return;
+}
+
+static uint32_t _SwTimer_Cascade(uint32_t level, uint32_t slot)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    SwTimer_TypeDef     *pCur = pWheel->pSlots[level * SW_TIMER_WHEEL_SLOTS + slot];
+
+    pWheel->pSlots[level * SW_TIMER_WHEEL_SLOTS + slot] = 0;
+    pWheel->bitmap[level] &= ~(0x1ul << slot);
+
+    while( pCur )
+    {
+        SwTimer_TypeDef     *pNext = pCur->pNext;
+
+        _SwTimer_Link(pCur);
+        pCur = pNext;
+    }
+
+    return slot;
+}
+
+/**
+ *  @brief  Get the ticks from 'now' (a tick not processed yet) to the next tick
+ *          which has work to do in a level (cascade or expiry), 0xFFFFFFFF when
+ *          the level is empty
+ */
+static uint32_t _SwTimer_LevelEventDelta(uint32_t level, uint32_t now)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            shift = _LEVEL_SHIFT(level);
+    uint32_t            cur = (now >> shift) & SW_TIMER_WHEEL_MASK;
+    uint32_t            base = now & ~((0x1ul << (shift + SW_TIMER_WHEEL_BITS)) - 1ul);
+    uint32_t            pending = 0;
+    uint32_t            tick = 0;
+
+    if( !pWheel->bitmap[level] )
+        return 0xFFFFFFFFul;
+
+    /* the slot of 'now' is still ahead only if 'now' is aligned to the level */
+    if( (now & ((0x1ul << shift) - 1ul)) == 0 )
+        pending = pWheel->bitmap[level] & (0xFFFFFFFFul << cur);
+    else if( cur < SW_TIMER_WHEEL_MASK )
+        pending = pWheel->bitmap[level] & (0xFFFFFFFFul << (cur + 1));
+
+    if( pending )
+    {
+        uint32_t    slot = 0;
+
+        while( !(pending & 0x1ul) )
+        {
+            pending >>= 1;
+            slot++;
+        }
+
+        tick = base + (slot << shift);
+    }
+    else
+    {
+        /* only the wrapped slots left, wake up when the level wraps */
+        tick = base + (0x1ul << (shift + SW_TIMER_WHEEL_BITS));
+    }
+
+    return tick - now;
+}
+
+/**
+ *  @brief  Get the ticks from 'now' to the next tick which has work to do
+ *          (cascade or expiry), 0xFFFFFFFF when the wheel is empty
+ */
+static uint32_t _SwTimer_NextEventDelta(void)
+{
+    uint32_t    min_delta = 0xFFFFFFFFul;
+
+    for(uint32_t level = 0; level < SW_TIMER_WHEEL_LEVELS; level++)
+    {
+        uint32_t    delta = _SwTimer_LevelEventDelta(level, g_SwTimerWheel.now);
+
+        if( delta < min_delta )
+            min_delta = delta;
+    }
+
+    return min_delta;
+}
+
+/**
+ *  @brief  Get the ticks from (now + span) to the next expiry of the timers in
+ *          a slot which is processed up to (now + span), 0: unknown (a periodic
+ *          timer may expire again before), 0xFFFFFFFF: none
+ */
+static uint32_t _SwTimer_SlotEventAfter(SwTimer_TypeDef *pCur, uint32_t span)
+{
+    uint32_t    min_delta = 0xFFFFFFFFul;
+
+    for(; pCur; pCur = pCur->pNext)
+    {
+        uint32_t    next = pCur->Expires - g_SwTimerWheel.now;
+
+        if( (int32_t)(next - span) <= 0 )
+        {
+            if( !pCur->Period )
+                continue;
+
+            /* re-armed from the expiry */
+            next += pCur->Period;
+            if( (int32_t)(next - span) <= 0 )
+                return 0ul;
+        }
+
+        if( next - span < min_delta )
+            min_delta = next - span;
+    }
+
+    return min_delta;
+}
+
+/**
+ *  @brief  Get the ticks from (now + span) to the next tick which has work to
+ *          do, 0xFFFFFFFF when there is none. The work up to (now + span) is
+ *          done at (now + span), the expiries of its timers are predicted
+ *          (1 when they are unknown). A cascade after it is not waited, its
+ *          timers expire later.
+ */
+static uint32_t _SwTimer_NextEventAfter(uint32_t span)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            end = pWheel->now + span;
+    uint32_t            min_delta = 0xFFFFFFFFul;
+    uint32_t            delta = 0;
+
+    for(uint32_t level = 1; level < SW_TIMER_WHEEL_LEVELS; level++)
+    {
+        uint32_t    shift = _LEVEL_SHIFT(level);
+        uint32_t    tick = 0;
+        uint32_t    slot = 0;
+
+        if( !pWheel->bitmap[level] )
+            continue;
+
+        /* the slots cascaded up to 'end' */
+        tick = (pWheel->now + (0x1ul << shift) - 1ul) & ~((0x1ul << shift) - 1ul);
+        for(; (int32_t)(tick - end) <= 0; tick += (0x1ul << shift))
+        {
+            slot  = (tick >> shift) & SW_TIMER_WHEEL_MASK;
+            delta = _SwTimer_SlotEventAfter(pWheel->pSlots[level * SW_TIMER_WHEEL_SLOTS + slot], span);
+            if( delta == 0 )
+                return 1ul;
+
+            if( delta < min_delta )
+                min_delta = delta;
+        }
+
+        /* the first slot after 'end', at the level wrap the other wrapped slots follow */
+        tick  = end + 1ul + _SwTimer_LevelEventDelta(level, end + 1ul);
+        slot  = (tick >> shift) & SW_TIMER_WHEEL_MASK;
+        delta = _SwTimer_SlotEventAfter(pWheel->pSlots[level * SW_TIMER_WHEEL_SLOTS + slot], span);
+        if( delta == 0 )
+            return 1ul;
+
+        if( (slot == 0 || delta == 0xFFFFFFFFul) && tick - end < delta )
+            delta = tick - end;
+
+        if( delta < min_delta )
+            min_delta = delta;
+    }
+
+    for(uint32_t i = 0; i < SW_TIMER_WHEEL_SLOTS && pWheel->bitmap[0]; i++)
+    {
+        SwTimer_TypeDef     *pCur = pWheel->pSlots[(pWheel->now + i) & SW_TIMER_WHEEL_MASK];
+
+        if( !pCur )
+            continue;
+
+        if( i > span )
+        {
+            if( i - span < min_delta )
+                min_delta = i - span;
+            break;
+        }
+
+        if( (delta = _SwTimer_SlotEventAfter(pCur, span)) == 0 )
+            return 1ul;
+
+        if( delta < min_delta )
+            min_delta = delta;
+    }
+
+    return min_delta;
+}
+
+/**
+ *  @brief  Process one tick of the wheel (interrupts MUST be disabled by caller)
+ */
+static void _SwTimer_ProcessTick(uint32_t *pPrimask)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            now = pWheel->now;
+    uint32_t            slot = now & SW_TIMER_WHEEL_MASK;
+
+    if( slot == 0 )
+    {
+        for(int level = 1; level < SW_TIMER_WHEEL_LEVELS; level++)
+        {
+            if( _SwTimer_Cascade(level, (now >> _LEVEL_SHIFT(level)) & SW_TIMER_WHEEL_MASK) )
+                break;
+        }
+    }
+
+    while( pWheel->pSlots[slot] )
+    {
+        SwTimer_TypeDef     *pTimer = pWheel->pSlots[slot];
+
+        _SwTimer_Unlink(pTimer);
+
+        if( pTimer->Period )
+        {
+            pTimer->Expires += pTimer->Period;
+            if( (int32_t)(pTimer->Expires - now) <= 0 )
+                pTimer->Expires = now + pTimer->Period;
+
+            _SwTimer_Link(pTimer);
+        }
+
+        if( pTimer->pfCallback )
+        {
+            _EXIT_CRITICAL(*pPrimask);
+            pTimer->pfCallback(pTimer);
+            _ENTER_CRITICAL(*pPrimask);
+        }
+    }
+
+    pWheel->now = now + 1;
+    return;
+}
+
+/**
+ *  @brief  Program the period which follows the running one to end at the next
+ *          tick with work (interrupts MUST be disabled by caller). The work
+ *          before the end of the running period is done at its end.
+ */
+static void _SwTimer_Reschedule(void)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            period = _SwTimer_PeriodCounts(pWheel->load);
+    uint32_t            total = 0;
+    uint32_t            end_tick = 0;
+    uint32_t            end_frac = 0;
+    uint32_t            span = 0;
+    uint32_t            ticks = 0;
+    uint32_t            counts = 0;
+
+    /**
+     *  An un-serviced overflow (the ISR re-programs after folding it) or too
+     *  close to the reload, BGLOAD may be taken or not
+     */
+    if( _SwTimer_GetElapsedCounts() + pWheel->guard_counts >= period )
+        return;
+
+    total    = pWheel->base_frac + period;
+    end_tick = pWheel->base_tick + (total >> pWheel->Init.TickShift);
+    end_frac = total & pWheel->tick_mask;
+
+    if( (int32_t)(end_tick - pWheel->now) > 0 )
+        span = end_tick - pWheel->now;
+
+    ticks = _SwTimer_NextEventAfter(span);
+    if( ticks > pWheel->run_ticks )
+        ticks = pWheel->run_ticks;
+
+    counts = (ticks << pWheel->Init.TickShift) - end_frac;
+    if( counts < pWheel->min_counts )
+        counts = pWheel->min_counts;
+
+    pWheel->hw_target = end_tick + ((end_frac + counts) >> pWheel->Init.TickShift);
+
+    if( ((pWheel->cnt_max - counts + 1ul) & pWheel->cnt_max) != pWheel->next_load )
+        _SwTimer_HW_SetNextLoad((pWheel->cnt_max - counts + 1ul) & pWheel->cnt_max);
+
+    return;
+}
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize the timer wheel and start the hardware timer
+ *
+ *  @param [in] pInit       The configuration of the timer wheel
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SwTimer_Init(SwTimer_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+
+    do {
+        if( !pInit || !pInit->pHwHandle || pInit->TickShift > 16 )
+            break;
+
+        memset(pWheel, 0x0, sizeof(sw_timer_wheel_t));
+        pWheel->Init      = *pInit;
+        pWheel->tick_mask = (0x1ul << pInit->TickShift) - 1ul;
+
+        if( pInit->HwSel == SW_TIMER_HW_LPTIM )
+        {
+        #if defined(USE_HAL_TICKLESS) && (USE_HAL_TICKLESS)
+            /* LPTIM is the tickless time base of the HAL */
+            break;
+        #elif defined(HAL_LPTIM_MODULE_ENABLED)
+            LPTIM_HandleTypeDef     *hLPTIM = (LPTIM_HandleTypeDef*)pInit->pHwHandle;
+
+            hLPTIM->Init.CntTimSel  = LPTIM_TIMER_SELECT;
+            hLPTIM->Init.AutoReload = LPTIM_AUTORELOAD_ENABLE;
+            hLPTIM->Init.Period     = 0;
+            if( HAL_LPTIM_Base_Init(hLPTIM) != HAL_OK )
+                break;
+
+            pWheel->cnt_max = 0xFFFFul;
+        #else
+            break;
+        #endif
+        }
+        else
+        {
+        #if defined(HAL_BASETIM_MODULE_ENABLED)
+            BASETIM_HandleTypeDef   *hBASETIM = (BASETIM_HandleTypeDef*)pInit->pHwHandle;
+
+            hBASETIM->Init.CntTimSel  = BASETIM_TIMER_SELECT;
+            hBASETIM->Init.AutoReload = BASETIM_AUTORELOAD_ENABLE;
+            hBASETIM->Init.OneShot    = BASETIM_REPEAT_MODE;
+            hBASETIM->Init.Period     = 0;
+            if( HAL_BASETIM_Base_Init(hBASETIM) != HAL_OK )
+                break;
+
+            pWheel->cnt_max = (hBASETIM->Init.MaxCntLevel == BASETIM_MAXCNTLEVEL_32BIT)
+                            ? BASETIM_MAXCNTVALUE_32BIT : BASETIM_MAXCNTVALUE_16BIT;
+        #else
+            break;
+        #endif
+        }
+
+        /* keep the 32-bits arithmetic of (base_frac + two periods) from overflowing */
+        pWheel->run_ticks = ((pWheel->cnt_max > 0xFFFFul) ? 0x3FFFFFFFul : pWheel->cnt_max) >> pInit->TickShift;
+        if( pWheel->run_ticks == 0 )
+            break;
+
+        if( pWheel->run_ticks > SW_TIMER_RUN_TICKS )
+            pWheel->run_ticks = SW_TIMER_RUN_TICKS;
+
+        pWheel->min_counts   = (pWheel->tick_mask < (SW_TIMER_GUARD_COUNTS << 1)) ? (SW_TIMER_GUARD_COUNTS << 1) : pWheel->tick_mask + 1ul;
+        pWheel->guard_counts = pWheel->min_counts >> 1;
+
+        /* free-run with the maximum period until the first timer is started */
+        pWheel->load      = (pWheel->cnt_max - (pWheel->run_ticks << pInit->TickShift) + 1ul) & pWheel->cnt_max;
+        pWheel->next_load = pWheel->load;
+        pWheel->hw_target = pWheel->run_ticks << 1;
+        _SwTimer_HW_Load(pWheel->load);
+
+    #if defined(HAL_LPTIM_MODULE_ENABLED)
+        if( pInit->HwSel == SW_TIMER_HW_LPTIM )
+            status = HAL_LPTIM_Base_Start_IT((LPTIM_HandleTypeDef*)pInit->pHwHandle);
+    #endif
+
+    #if defined(HAL_BASETIM_MODULE_ENABLED)
+        if( pInit->HwSel == SW_TIMER_HW_BASETIM )
+            status = HAL_BASETIM_Base_Start_IT((BASETIM_HandleTypeDef*)pInit->pHwHandle);
+    #endif
+
+        pWheel->is_initialized = (status == HAL_OK);
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Stop the hardware timer, all armed timers are dropped
+ *
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SwTimer_DeInit(void)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+
+    if( !pWheel->is_initialized )
+        return status;
+
+#if defined(HAL_LPTIM_MODULE_ENABLED)
+    if( pWheel->Init.HwSel == SW_TIMER_HW_LPTIM )
+        status = HAL_LPTIM_Base_Stop_IT((LPTIM_HandleTypeDef*)pWheel->Init.pHwHandle);
+#endif
+
+#if defined(HAL_BASETIM_MODULE_ENABLED)
+    if( pWheel->Init.HwSel == SW_TIMER_HW_BASETIM )
+        status = HAL_BASETIM_Base_Stop_IT((BASETIM_HandleTypeDef*)pWheel->Init.pHwHandle);
+#endif
+
+    for(uint32_t i = 0; i < SW_TIMER_WHEEL_LEVELS * SW_TIMER_WHEEL_SLOTS; i++)
+    {
+        while( pWheel->pSlots[i] )
+            _SwTimer_Unlink(pWheel->pSlots[i]);
+    }
+
+    pWheel->is_initialized = 0;
+    return status;
+}
+
+/**
+ *  @brief  Setup a software timer object
+ *
+ *  @param [in] pTimer          The timer object
+ *  @param [in] pfCallback      The expired callback (executed in ISR context)
+ *  @param [in] pUserData       The user data of the callback
+ *  @return
+ *      None
+ */
+void SwTimer_Setup(SwTimer_TypeDef *pTimer, SwTimer_CallbackTypeDef pfCallback, void *pUserData)
+{
+    if( !pTimer )
+        return;
+
+    memset(pTimer, 0x0, sizeof(SwTimer_TypeDef));
+    pTimer->pfCallback = pfCallback;
+    pTimer->pUserData  = pUserData;
+    return;
+}
+
+/**
+ *  @brief  Start (or restart) a software timer
+ *
+ *  @param [in] pTimer      The timer object
+ *  @param [in] timeout     The ticks to the first expiry (0 is treated as 1)
+ *  @param [in] period      The ticks of the re-arm period, 0: one-shot timer
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SwTimer_Start(SwTimer_TypeDef *pTimer, uint32_t timeout, uint32_t period)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            primask = 0;
+
+    if( !pTimer || !pWheel->is_initialized )
+        return HAL_ERROR;
+
+    if( timeout == 0 )
+        timeout = 1;
+
+    _ENTER_CRITICAL(primask);
+
+    if( pTimer->ppPrev )
+        _SwTimer_Unlink(pTimer);
+
+    pTimer->Expires = _SwTimer_GetTick() + timeout;
+    pTimer->Period  = period;
+    _SwTimer_Link(pTimer);
+
+    /* the new deadline is earlier than the programmed one */
+    if( (int32_t)(pTimer->Expires - pWheel->hw_target) < 0 )
+        _SwTimer_Reschedule();
+
+    _EXIT_CRITICAL(primask);
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Stop a software timer, it is safe to stop an idle timer
+ *
+ *  @param [in] pTimer      The timer object
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef SwTimer_Stop(SwTimer_TypeDef *pTimer)
+{
+    uint32_t    primask = 0;
+
+    if( !pTimer )
+        return HAL_ERROR;
+
+    /**
+     *  The hardware is not re-programmed, the wheel only wakes up
+     *  once more at the previous deadline.
+     */
+    _ENTER_CRITICAL(primask);
+
+    if( pTimer->ppPrev )
+        _SwTimer_Unlink(pTimer);
+
+    _EXIT_CRITICAL(primask);
+    return HAL_OK;
+}
+
+/**
+ *  @brief  Check the timer is armed or not
+ *
+ *  @param [in] pTimer      The timer object
+ *  @return
+ *      1: armed, 0: idle
+ */
+uint32_t SwTimer_IsActive(SwTimer_TypeDef *pTimer)
+{
+    return (pTimer && pTimer->ppPrev) ? 1ul : 0ul;
+}
+
+/**
+ *  @brief  Get the current tick of the timer wheel
+ *
+ *  @return
+ *      Current tick
+ */
+uint32_t SwTimer_GetTick(void)
+{
+    uint32_t    tick = 0;
+    uint32_t    primask = 0;
+
+    if( !g_SwTimerWheel.is_initialized )
+        return 0;
+
+    _ENTER_CRITICAL(primask);
+    tick = _SwTimer_GetTick();
+    _EXIT_CRITICAL(primask);
+    return tick;
+}
+
+/**
+ *  @brief  The service routine of the timer wheel.
+ *          Call it from the IRQ handler of the selected hardware timer
+ *          (TIM10_IRQHandler/TIM11_IRQHandler/LPTIM_IRQHandler) instead of
+ *          HAL_BASETIM_IRQHandler()/HAL_LPTIM_IRQHandler().
+ *
+ *  @return
+ *      None
+ */
+void SwTimer_IRQHandler(void)
+{
+    sw_timer_wheel_t    *pWheel = &g_SwTimerWheel;
+    uint32_t            primask = 0;
+    uint32_t            cur = 0;
+
+    if( !pWheel->is_initialized )
+        return;
+
+    _ENTER_CRITICAL(primask);
+
+    if( _SwTimer_HW_IsOverflow() )
+        _SwTimer_Fold();
+
+    cur = _SwTimer_GetTick();
+
+    while( (int32_t)(cur - pWheel->now) >= 0 )
+    {
+        uint32_t    delta = _SwTimer_NextEventDelta();
+
+        if( delta > cur - pWheel->now )
+        {
+            /* nothing to do until 'cur', skip the empty ticks */
+            pWheel->now = cur + 1;
+            break;
+        }
+
+        pWheel->now += delta;
+        _SwTimer_ProcessTick(&primask);
+
+        /* callbacks may take a while */
+        cur = _SwTimer_GetTick();
+    }
+
+    _SwTimer_Reschedule();
+
+    _EXIT_CRITICAL(primask);
+    return;
+}
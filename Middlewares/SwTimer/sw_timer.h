@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file sw_timer.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/12
+ * @license
+ * @description
+ *  Hierarchical software timer wheel driven by one hardware timer (BASETIM or LPTIM).
+ *
+ *  + Start/Stop are O(1), a timer is linked into one slot of one wheel level.
+ *  + The hardware counter free-runs and is never re-loaded, so the time base
+ *    does not drift. The period which follows the running one is programmed
+ *    (BGLOAD) to end at the next deadline, so the CPU only wakes up when a timer
+ *    expires or at least every SW_TIMER_RUN_TICKS.
+ *  + A timer started with a deadline inside the running period expires at the
+ *    end of it, the latency is bounded by SW_TIMER_RUN_TICKS.
+ *  + Timer callbacks are executed in the context of the hardware timer ISR.
+ *    The latency of this ISR MUST be shorter than half a tick: a period is at
+ *    least one tick, BGLOAD is not written in its last half and a second
+ *    overflow before the ISR is lost.
+ */
+
+#ifndef __sw_timer_H_wNq8kDc3_lzXe_HVpT_sIyR_uR2mXb7oJfAa__
+#define __sw_timer_H_wNq8kDc3_lzXe_HVpT_sIyR_uR2mXb7oJfAa__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  Slots of a wheel level is (1 << SW_TIMER_WHEEL_BITS), max 32 slots (one 32-bits bitmap per level)
+ *  The range of the wheel is (1 << (SW_TIMER_WHEEL_BITS * SW_TIMER_WHEEL_LEVELS)) ticks
+ */
+#ifndef SW_TIMER_WHEEL_BITS
+#define SW_TIMER_WHEEL_BITS         5
+#endif
+
+#ifndef SW_TIMER_WHEEL_LEVELS
+#define SW_TIMER_WHEEL_LEVELS       4
+#endif
+
+#define SW_TIMER_WHEEL_SLOTS        (0x1ul << SW_TIMER_WHEEL_BITS)
+
+/**
+ *  Maximum ticks of one hardware period, it bounds the latency of a deadline
+ *  inside the running period (and the wake-up interval without timer)
+ */
+#ifndef SW_TIMER_RUN_TICKS
+#define SW_TIMER_RUN_TICKS          32
+#endif
+
+#if (SW_TIMER_WHEEL_BITS > 5) || ((SW_TIMER_WHEEL_BITS * SW_TIMER_WHEEL_LEVELS) > 31)
+#error "sw_timer: wheel configuration out of range !"
+#endif
+
+/**
+ *  @brief Hardware timer which drives the wheel
+ */
+typedef enum SwTimer_HwSel
+{
+    SW_TIMER_HW_BASETIM     = 0,    /*!< BASETIM (TIM10/TIM11), BASETIM_HandleTypeDef */
+    SW_TIMER_HW_LPTIM,              /*!< LPTIM, LPTIM_HandleTypeDef (keep running in deep-sleep with LXT/SIRC),
+                                         rejected when USE_HAL_TICKLESS owns LPTIM */
+
+} SwTimer_HwSelTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+struct SwTimer;
+
+/**
+ *  @brief Timer expired callback, it is executed in ISR context
+ */
+typedef void (*SwTimer_CallbackTypeDef)(struct SwTimer *pTimer);
+
+/**
+ *  @brief Software timer object, it MUST be setup with SwTimer_Setup() before use
+ */
+typedef struct SwTimer
+{
+    struct SwTimer              *pNext;
+    struct SwTimer              **ppPrev;       /*!< The link which points to this timer, NULL when not armed */
+    uint32_t                    Expires;        /*!< Absolute expiry tick */
+    uint32_t                    Period;         /*!< Re-arm period in ticks, 0: one-shot */
+    uint16_t                    WheelIdx;       /*!< (level * SW_TIMER_WHEEL_SLOTS + slot) */
+
+    SwTimer_CallbackTypeDef     pfCallback;
+    void                        *pUserData;
+
+} SwTimer_TypeDef;
+
+/**
+ *  @brief Initial configuration of the timer wheel
+ */
+typedef struct SwTimer_Init
+{
+    SwTimer_HwSelTypeDef    HwSel;
+
+    void                    *pHwHandle;     /*!< BASETIM_HandleTypeDef or LPTIM_HandleTypeDef.
+                                                 Instance, clock and prescaler are set by user,
+                                                 the other fields are overwritten by SwTimer_Init() */
+
+    uint32_t                TickShift;      /*!< One tick of the wheel is (1 << TickShift) hardware counts */
+
+} SwTimer_InitTypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef SwTimer_Init(SwTimer_InitTypeDef *pInit);
+HAL_StatusTypeDef SwTimer_DeInit(void);
+
+void SwTimer_Setup(SwTimer_TypeDef *pTimer, SwTimer_CallbackTypeDef pfCallback, void *pUserData);
+HAL_StatusTypeDef SwTimer_Start(SwTimer_TypeDef *pTimer, uint32_t timeout, uint32_t period);
+HAL_StatusTypeDef SwTimer_Stop(SwTimer_TypeDef *pTimer);
+
+uint32_t SwTimer_IsActive(SwTimer_TypeDef *pTimer);
+uint32_t SwTimer_GetTick(void);
+
+void SwTimer_IRQHandler(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
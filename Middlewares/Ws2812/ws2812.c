@@ -0,0 +1,478 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file ws2812.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/23
+ * @license
+ * @description
+ */
+
+
+#include <string.h>
+#include "ws2812.h"
+
+#if defined(HAL_GPIO_MODULE_ENABLED)
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/* LED bit timing (ns) */
+#define WS2812_T0H_NS               350
+#define WS2812_T0H_MAX_NS           500
+#define WS2812_T0L_NS               800
+#define WS2812_T1H_NS               700
+#define WS2812_T1L_NS               600
+
+/* the allowed SCK of SPI mode, 1 SPI bit is T0H and 2 SPI bits are T1H */
+#define WS2812_SPI_CLOCK_MIN        2000000ul
+#define WS2812_SPI_CLOCK_MAX        3600000ul
+
+/**
+ *  HCLK cycles of the GPIO writes and the branches around a delay,
+ *  they are not covered by the calibration of the delay loop
+ */
+#ifndef WS2812_GPIO_OVERHEAD_CYCLES
+#define WS2812_GPIO_OVERHEAD_CYCLES     6
+#endif
+
+#define WS2812_CALIB_LOOPS_1        16
+#define WS2812_CALIB_LOOPS_2        80
+
+/* the line keeps low more than the reset time (>= 1 ms) between 2 frames */
+#define WS2812_RESET_TICKS          2
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef enum ws2812_clk_src
+{
+    WS2812_CLK_SRC_NONE     = 0,
+    WS2812_CLK_SRC_SYSTICK,         /*!< HCLK cycles */
+    WS2812_CLK_SRC_TIMESTAMP,       /*!< HAL_GetCycles64(), e.g. SysTick is stopped in the tickless mode */
+
+} ws2812_clk_src_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+#if defined(HAL_SPI_MODULE_ENABLED)
+/**
+ *  SPI patterns of the 4 LED bits of a nibble, MSB first
+ */
+#if (WS2812_SPI_BITS == 4)
+/* '0' = 1000, '1' = 1100, a nibble is 2 SPI bytes */
+static const uint16_t     g_Ws2812_Lut[16] =
+{
+    0x8888, 0x888C, 0x88C8, 0x88CC, 0x8C88, 0x8C8C, 0x8CC8, 0x8CCC,
+    0xC888, 0xC88C, 0xC8C8, 0xC8CC, 0xCC88, 0xCC8C, 0xCCC8, 0xCCCC,
+};
+#else
+/* '0' = 100, '1' = 110, a nibble is 12 SPI bits */
+static const uint16_t     g_Ws2812_Lut[16] =
+{
+    0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+    0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6,
+};
+#endif
+
+#define WS2812_SPI_BYTES_PER_COLOR      WS2812_SPI_BITS
+#endif
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  @brief  Start a SysTick measurement, the interrupts MUST be disabled
+ *
+ *  @return
+ *      The current SysTick value
+ */
+static uint32_t _Ws2812_CyclesStart(void)
+{
+    /* reading CTRL clears COUNTFLAG */
+    (void)SysTick->CTRL;
+    return SysTick->VAL;
+}
+
+/**
+ *  @brief  HCLK cycles since _Ws2812_CyclesStart(), the window MUST be shorter
+ *          than 2 SysTick periods
+ *
+ *  @param [in] start       The return value of _Ws2812_CyclesStart()
+ *  @return
+ *      Elapsed cycles
+ */
+static uint32_t _Ws2812_CyclesElapsed(uint32_t start)
+{
+    uint32_t    now = SysTick->VAL;
+    uint32_t    reload = SysTick->LOAD + 1;
+    uint32_t    cycles = 0;
+
+    cycles = (start >= now) ? start - now : start + reload - now;
+
+    if( (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) && start >= now )
+        cycles += reload;
+
+    return cycles;
+}
+
+/**
+ *  @brief  The counter to measure the IRQ-off windows
+ *
+ *  @return
+ *      ws2812_clk_src_t
+ */
+static ws2812_clk_src_t _Ws2812_GetClkSrc(void)
+{
+    if( (SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) && (SysTick->CTRL & SysTick_CTRL_CLKSOURCE_Msk) )
+        return WS2812_CLK_SRC_SYSTICK;
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+    if( HAL_TIM_Timestamp_GetFreq() )
+        return WS2812_CLK_SRC_TIMESTAMP;
+#endif
+
+    return WS2812_CLK_SRC_NONE;
+}
+
+static void _Ws2812_Delay(uint32_t loops)
+{
+    volatile uint32_t   cnt = loops;
+
+    while( cnt )
+        cnt--;
+
+    return;
+}
+
+/**
+ *  @brief  Calibrate the delay loop and compute the loops of every level
+ *
+ *  @param [in] pWs         The strip
+ *  @return
+ *      HAL status
+ */
+static HAL_StatusTypeDef _Ws2812_GpioCalibrate(Ws2812_TypeDef *pWs)
+{
+    const uint32_t  target_ns[4] = { WS2812_T0H_NS, WS2812_T0L_NS, WS2812_T1H_NS, WS2812_T1L_NS };
+    uint16_t        *pDelays[4] = { &pWs->DelayT0H, &pWs->DelayT0L, &pWs->DelayT1H, &pWs->DelayT1L };
+    uint32_t        hclk_khz = pWs->HclkFreq / 1000;
+    uint32_t        primask = 0;
+    uint32_t        t1 = 0, t2 = 0;
+    uint32_t        slope_q8 = 0, fixed = 0;
+
+    if( !(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) || !(SysTick->CTRL & SysTick_CTRL_CLKSOURCE_Msk) )
+        return HAL_ERROR;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    t1 = _Ws2812_CyclesStart();
+    _Ws2812_Delay(WS2812_CALIB_LOOPS_1);
+    t1 = _Ws2812_CyclesElapsed(t1);
+
+    t2 = _Ws2812_CyclesStart();
+    _Ws2812_Delay(WS2812_CALIB_LOOPS_2);
+    t2 = _Ws2812_CyclesElapsed(t2);
+
+    __set_PRIMASK(primask);
+
+    if( t2 <= t1 )
+        return HAL_ERROR;
+
+    slope_q8 = ((t2 - t1) << 8) / (WS2812_CALIB_LOOPS_2 - WS2812_CALIB_LOOPS_1);
+    fixed    = t1 - ((WS2812_CALIB_LOOPS_1 * slope_q8) >> 8) + WS2812_GPIO_OVERHEAD_CYCLES;
+
+    /* the shortest high level MUST still be a '0' */
+    if( fixed * 1000000ul > WS2812_T0H_MAX_NS * hclk_khz )
+        return HAL_ERROR;
+
+    for(int i = 0; i < 4; i++)
+    {
+        uint32_t    cycles = (target_ns[i] * hclk_khz) / 1000000ul;
+
+        *pDelays[i] = (uint16_t)((cycles > fixed) ? ((cycles - fixed) << 8) / slope_q8 : 0);
+    }
+
+    return HAL_OK;
+}
+
+static void _Ws2812_GpioFeed(Ws2812_TypeDef *pWs, const uint8_t *pData, uint32_t len)
+{
+    GPIO_TypeDef    *GPIOx = pWs->Init.Port;
+    uint32_t        pin = pWs->Init.Pin;
+
+    while( len-- )
+    {
+        uint32_t    value = *pData++;
+
+        for(uint32_t mask = 0x80; mask; mask >>= 1)
+        {
+            if( value & mask )
+            {
+                GPIOx->ODSET = pin;
+                _Ws2812_Delay(pWs->DelayT1H);
+                GPIOx->ODCLR = pin;
+                _Ws2812_Delay(pWs->DelayT1L);
+            }
+            else
+            {
+                GPIOx->ODSET = pin;
+                _Ws2812_Delay(pWs->DelayT0H);
+                GPIOx->ODCLR = pin;
+                _Ws2812_Delay(pWs->DelayT0L);
+            }
+        }
+    }
+
+    return;
+}
+
+#if defined(HAL_SPI_MODULE_ENABLED)
+/**
+ *  @brief  Send the colors through SPI, the next SPI byte is encoded
+ *          while the current one is shifting
+ *
+ *  @param [in] SPIx        The SPI instance
+ *  @param [in] pData       The colors
+ *  @param [in] len         Bytes of the colors
+ *  @return
+ *      None
+ */
+static void _Ws2812_SpiFeed(SPI_TypeDef *SPIx, const uint8_t *pData, uint32_t len)
+{
+    uint32_t    value = *pData++;
+    uint32_t    pattern = ((uint32_t)g_Ws2812_Lut[value >> 4] << (WS2812_SPI_BITS * 4)) | g_Ws2812_Lut[value & 0xF];
+    int         shift = (WS2812_SPI_BYTES_PER_COLOR - 1) * 8;
+
+    SPIx->DATA = (uint8_t)(pattern >> shift);
+
+    while( 1 )
+    {
+        uint32_t    next = 0;
+
+        shift -= 8;
+        if( shift < 0 )
+        {
+            if( --len == 0 )
+                break;
+
+            value   = *pData++;
+            pattern = ((uint32_t)g_Ws2812_Lut[value >> 4] << (WS2812_SPI_BITS * 4)) | g_Ws2812_Lut[value & 0xF];
+            shift   = (WS2812_SPI_BYTES_PER_COLOR - 1) * 8;
+        }
+
+        next = (uint8_t)(pattern >> shift);
+
+        while( !(SPIx->SR & SPI_SR_SPIF) ) {}
+        (void)SPIx->DATA;
+
+        SPIx->DATA = next;
+    }
+
+    while( !(SPIx->SR & SPI_SR_SPIF) ) {}
+    (void)SPIx->DATA;
+    return;
+}
+#endif
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Initialize a strip, the GPIO delays are calibrated at the current HCLK,
+ *          call it again after the clock is changed
+ *
+ *  @param [in] pWs         The strip
+ *  @param [in] pInit       The configuration
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Ws2812_Init(Ws2812_TypeDef *pWs, Ws2812_InitTypeDef *pInit)
+{
+    HAL_StatusTypeDef   status = HAL_ERROR;
+
+    do {
+        if( !pWs || !pInit || !pInit->pPixels || !pInit->PixelNum )
+            break;
+
+        memset(pWs, 0x0, sizeof(Ws2812_TypeDef));
+        pWs->Init         = *pInit;
+        pWs->HclkFreq     = HAL_RCC_GetHCLKFreq();
+        pWs->LastShowTick = HAL_GetTick() - WS2812_RESET_TICKS;
+
+        if( pInit->Mode == WS2812_MODE_GPIO )
+        {
+            if( !pInit->Port || !pInit->Pin )
+                break;
+
+            pInit->Port->ODCLR = pInit->Pin;
+
+            status = _Ws2812_GpioCalibrate(pWs);
+            break;
+        }
+
+#if defined(HAL_SPI_MODULE_ENABLED)
+        if( pInit->Mode == WS2812_MODE_SPI )
+        {
+            if( !pInit->hspi || pInit->SpiClock < WS2812_SPI_CLOCK_MIN || pInit->SpiClock > WS2812_SPI_CLOCK_MAX )
+                break;
+
+            __HAL_SPI_ENABLE(pInit->hspi);
+            status = HAL_OK;
+        }
+#endif
+    } while(0);
+
+    return status;
+}
+
+/**
+ *  @brief  Set the color of a pixel, it is sent by Ws2812_Show()
+ *
+ *  @param [in] pWs         The strip
+ *  @param [in] index       The pixel index
+ *  @param [in] red         Red
+ *  @param [in] green       Green
+ *  @param [in] blue        Blue
+ *  @return
+ *      None
+ */
+void Ws2812_SetPixel(Ws2812_TypeDef *pWs, uint32_t index, uint8_t red, uint8_t green, uint8_t blue)
+{
+    uint8_t     *pPixel = 0;
+
+    if( index >= pWs->Init.PixelNum )
+        return;
+
+    pPixel = &pWs->Init.pPixels[index * 3];
+    pPixel[0] = green;
+    pPixel[1] = red;
+    pPixel[2] = blue;
+    return;
+}
+
+/**
+ *  @brief  Set the color of all pixels
+ *
+ *  @param [in] pWs         The strip
+ *  @param [in] red         Red
+ *  @param [in] green       Green
+ *  @param [in] blue        Blue
+ *  @return
+ *      None
+ */
+void Ws2812_Fill(Ws2812_TypeDef *pWs, uint8_t red, uint8_t green, uint8_t blue)
+{
+    for(uint32_t i = 0; i < pWs->Init.PixelNum; i++)
+        Ws2812_SetPixel(pWs, i, red, green, blue);
+
+    return;
+}
+
+/**
+ *  @brief  Send all pixels to the strip, the interrupts are disabled during
+ *          every chunk of Init.PixelsPerIrqOff (WS2812_PIXELS_PER_IRQ_OFF_MAX
+ *          at most) pixels
+ *
+ *  @param [in] pWs         The strip
+ *  @return
+ *      HAL status
+ */
+HAL_StatusTypeDef Ws2812_Show(Ws2812_TypeDef *pWs)
+{
+    ws2812_clk_src_t    clk_src = WS2812_CLK_SRC_NONE;
+    uint32_t            chunk = 0;
+
+    if( !pWs || !pWs->Init.pPixels )
+        return HAL_ERROR;
+
+    /* a window always fits the measurement (less than 2 periods of the counter) */
+    chunk = pWs->Init.PixelsPerIrqOff;
+    if( !chunk || chunk > WS2812_PIXELS_PER_IRQ_OFF_MAX )
+        chunk = WS2812_PIXELS_PER_IRQ_OFF_MAX;
+
+    clk_src = _Ws2812_GetClkSrc();
+
+    /* latch the previous frame */
+    while( (HAL_GetTick() - pWs->LastShowTick) < WS2812_RESET_TICKS ) {}
+
+    for(uint32_t pixel = 0; pixel < pWs->Init.PixelNum; pixel += chunk)
+    {
+        const uint8_t   *pData = &pWs->Init.pPixels[pixel * 3];
+        uint32_t        len = pWs->Init.PixelNum - pixel;
+        uint32_t        primask = 0;
+        uint64_t        start = 0;
+        uint64_t        cycles = 0;
+
+        len = ((len > chunk) ? chunk : len) * 3;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        if( clk_src == WS2812_CLK_SRC_SYSTICK )
+            start = _Ws2812_CyclesStart();
+#if defined(HAL_TIM_MODULE_ENABLED)
+        else if( clk_src == WS2812_CLK_SRC_TIMESTAMP )
+            start = HAL_GetCycles64();
+#endif
+
+#if defined(HAL_SPI_MODULE_ENABLED)
+        if( pWs->Init.Mode == WS2812_MODE_SPI )
+            _Ws2812_SpiFeed(pWs->Init.hspi->Instance, pData, len);
+        else
+#endif
+            _Ws2812_GpioFeed(pWs, pData, len);
+
+        if( clk_src == WS2812_CLK_SRC_SYSTICK )
+            cycles = _Ws2812_CyclesElapsed((uint32_t)start);
+#if defined(HAL_TIM_MODULE_ENABLED)
+        else if( clk_src == WS2812_CLK_SRC_TIMESTAMP )
+            cycles = HAL_GetCycles64() - start;
+#endif
+
+        __set_PRIMASK(primask);
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+        /* to HCLK cycles */
+        if( clk_src == WS2812_CLK_SRC_TIMESTAMP )
+            cycles = (cycles * pWs->HclkFreq) / HAL_TIM_Timestamp_GetFreq();
+#endif
+
+        if( cycles > pWs->IrqOffCyclesMax )
+            pWs->IrqOffCyclesMax = (uint32_t)cycles;
+    }
+
+    pWs->LastShowTick = HAL_GetTick();
+    return HAL_OK;
+}
+
+/**
+ *  @brief  The longest IRQ-off window of Ws2812_Show()
+ *
+ *  @param [in] pWs         The strip
+ *  @return
+ *      Micro-seconds
+ */
+uint32_t Ws2812_GetIrqOffUs(Ws2812_TypeDef *pWs)
+{
+    if( !pWs || !pWs->HclkFreq )
+        return 0;
+
+    return (uint32_t)(((uint64_t)pWs->IrqOffCyclesMax * 1000000ull) / pWs->HclkFreq);
+}
+
+void Ws2812_ResetIrqOffStat(Ws2812_TypeDef *pWs)
+{
+    if( pWs )
+        pWs->IrqOffCyclesMax = 0;
+
+    return;
+}
+
+#endif /* HAL_GPIO_MODULE_ENABLED */
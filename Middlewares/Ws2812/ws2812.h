@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file ws2812.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/23
+ * @license
+ * @description
+ *  WS2812 (NeoPixel) LED strip driver without DMA.
+ *
+ *  + SPI mode: every LED bit is encoded to WS2812_SPI_BITS SPI bits
+ *    ('0' = 100(0), '1' = 110(0)) by a nibble lookup table, the next SPI byte
+ *    is encoded while the current one is shifting. The SPI has no FIFO, so
+ *    there is a short gap at every byte boundary. With 4 bits, a byte holds
+ *    exactly 2 LED bits and the gap only stretches the low time, it is the
+ *    default. 3 bits (2.4 MHz) MUST only be used if the gap is tolerated.
+ *  + GPIO mode: bit-bang fallback with ODSET/ODCLR and a delay loop, the loop
+ *    is calibrated with SysTick at the current HCLK in Ws2812_Init().
+ *
+ *  The interrupts are disabled while Init.PixelsPerIrqOff pixels are sent,
+ *  the line is low between the chunks and an interrupt there MUST be shorter
+ *  than the reset time of the LEDs (50 ~ 280 us). The longest measured window
+ *  is reported by Ws2812_GetIrqOffUs(), it is measured with SysTick or with the
+ *  TIM timestamp when SysTick is stopped (tickless mode).
+ */
+
+#ifndef __ws2812_H_f3PwR8yN_lKc1_HvTe_s6Ma_uZ2dQj5gLbUx__
+#define __ws2812_H_f3PwR8yN_lKc1_HvTe_s6Ma_uZ2dQj5gLbUx__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+/**
+ *  SPI bits of an LED bit (3 or 4)
+ */
+#ifndef WS2812_SPI_BITS
+#define WS2812_SPI_BITS             4
+#endif
+
+#if (WS2812_SPI_BITS != 3) && (WS2812_SPI_BITS != 4)
+#error "ws2812: WS2812_SPI_BITS MUST be 3 or 4 !"
+#endif
+
+/**
+ *  Max pixels of an IRQ-off window, 32 * 30 us = 0.96 ms. A window is shorter
+ *  than a 1 ms SysTick period and the HAL tick is not lost.
+ */
+#define WS2812_PIXELS_PER_IRQ_OFF_MAX   32
+
+typedef enum Ws2812_Mode
+{
+    WS2812_MODE_SPI     = 0,    /*!< MOSI drives DIN, SCK = 2.4 MHz (3 bits) or 3.2 MHz (4 bits) */
+    WS2812_MODE_GPIO,           /*!< Bit-bang on a GPIO output */
+
+} Ws2812_ModeTypeDef;
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+/**
+ *  @brief Initial configuration of a strip
+ */
+typedef struct Ws2812_Init
+{
+    Ws2812_ModeTypeDef  Mode;
+
+#if defined(HAL_SPI_MODULE_ENABLED)
+    SPI_HandleTypeDef   *hspi;              /*!< Master, CPOL low, CPHA 1-edge, initialized by user */
+#else
+    void                *hspi;
+#endif
+    uint32_t            SpiClock;           /*!< SCK frequency in Hz */
+
+    GPIO_TypeDef        *Port;              /*!< GPIO mode, the pin MUST be an output */
+    uint32_t            Pin;
+
+    uint8_t             *pPixels;           /*!< PixelNum * 3 bytes in G, R, B order */
+    uint32_t            PixelNum;
+    uint32_t            PixelsPerIrqOff;    /*!< Pixels sent in one IRQ-off window,
+                                                 0 or larger: WS2812_PIXELS_PER_IRQ_OFF_MAX */
+
+} Ws2812_InitTypeDef;
+
+/**
+ *  @brief A strip
+ */
+typedef struct Ws2812
+{
+    Ws2812_InitTypeDef  Init;
+
+    uint32_t            HclkFreq;
+    uint32_t            LastShowTick;
+
+    /* GPIO mode, loops of the delay */
+    uint16_t            DelayT0H;
+    uint16_t            DelayT0L;
+    uint16_t            DelayT1H;
+    uint16_t            DelayT1L;
+
+    uint32_t            IrqOffCyclesMax;    /*!< The longest measured IRQ-off window in HCLK cycles */
+
+} Ws2812_TypeDef;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+HAL_StatusTypeDef Ws2812_Init(Ws2812_TypeDef *pWs, Ws2812_InitTypeDef *pInit);
+
+void Ws2812_SetPixel(Ws2812_TypeDef *pWs, uint32_t index, uint8_t red, uint8_t green, uint8_t blue);
+void Ws2812_Fill(Ws2812_TypeDef *pWs, uint8_t red, uint8_t green, uint8_t blue);
+
+HAL_StatusTypeDef Ws2812_Show(Ws2812_TypeDef *pWs);
+
+uint32_t Ws2812_GetIrqOffUs(Ws2812_TypeDef *pWs);
+void Ws2812_ResetIrqOffStat(Ws2812_TypeDef *pWs);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,302 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file bench_cycles.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ */
+
+
+#include "bench_cycles.h"
+#include "log.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define BENCH_SYSTICK_RELOAD        SysTick_LOAD_RELOAD_Msk
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static volatile uint32_t    g_Bench_Sink = 0;
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static void _Bench_Empty(void *pUserData)
+{
+    (void)pUserData;
+    return;
+}
+
+static uint32_t _Bench_Run(Bench_FuncTypeDef pfFunc, void *pUserData)
+{
+    uint32_t    min_cycles = 0xFFFFFFFFul;
+
+    for(int i = 0; i < BENCH_LOOPS; i++)
+    {
+        uint32_t    start = 0, end = 0;
+
+        start = SysTick->VAL;
+        pfFunc(pUserData);
+        end = SysTick->VAL;
+
+        /* Down-counter, the run is far shorter than one reload period */
+        start = (start - end) & BENCH_SYSTICK_RELOAD;
+        if( start < min_cycles )
+            min_cycles = start;
+    }
+
+    return min_cycles;
+}
+
+#if defined(HAL_ADC_MODULE_ENABLED)
+static void _Bench_ADC_ChannelIdClz(void *pUserData)
+{
+    ADC_HandleTypeDef   *hADC = (ADC_HandleTypeDef*)pUserData;
+
+    /* The baseline of HAL_ADC_Init()/HAL_ADC_ConfigChannel() */
+    g_Bench_Sink = 31 - __CLZ(hADC->Init.AChannelSel);
+    return;
+}
+
+static void _Bench_ADC_ItTypeChain(void *pUserData)
+{
+    HAL_ADC_ChannelSelTypeDef   ch = ((ADC_HandleTypeDef*)pUserData)->Init.AChannelSel;
+
+    /* The baseline of HAL_ADC_Start_IT(), the interrupt of the channel before the descriptor table */
+#if defined(CONFIG_USE_ZB32L003S)
+    g_Bench_Sink = (ch == HAL_ADC_CHANNEL_0) ? HAL_ADC_IT_CHANNEL_0 :
+                   (ch == HAL_ADC_CHANNEL_1) ? HAL_ADC_IT_CHANNEL_1 :
+                   (ch == HAL_ADC_CHANNEL_2) ? HAL_ADC_IT_CHANNEL_2 :
+                   (ch == HAL_ADC_CHANNEL_3) ? HAL_ADC_IT_CHANNEL_3 :
+                   (ch == HAL_ADC_CHANNEL_4) ? HAL_ADC_IT_CHANNEL_4 :
+                   (ch == HAL_ADC_CHANNEL_5) ? HAL_ADC_IT_CHANNEL_5 :
+                   (ch == HAL_ADC_CHANNEL_6) ? HAL_ADC_IT_CHANNEL_6 :
+                   HAL_ADC_IT_CHANNEL_7;
+#elif defined(CONFIG_USE_ZB32L030) || defined(CONFIG_USE_ZB32L032)
+    g_Bench_Sink = (ch == HAL_ADC_CHANNEL_0)  ? HAL_ADC_IT_CHANNEL_0 :
+                   (ch == HAL_ADC_CHANNEL_1)  ? HAL_ADC_IT_CHANNEL_1 :
+                   (ch == HAL_ADC_CHANNEL_2)  ? HAL_ADC_IT_CHANNEL_2 :
+                   (ch == HAL_ADC_CHANNEL_3)  ? HAL_ADC_IT_CHANNEL_3 :
+                   (ch == HAL_ADC_CHANNEL_4)  ? HAL_ADC_IT_CHANNEL_4 :
+                   (ch == HAL_ADC_CHANNEL_5)  ? HAL_ADC_IT_CHANNEL_5 :
+                   (ch == HAL_ADC_CHANNEL_6)  ? HAL_ADC_IT_CHANNEL_6 :
+                   (ch == HAL_ADC_CHANNEL_7)  ? HAL_ADC_IT_CHANNEL_7 :
+                   (ch == HAL_ADC_CHANNEL_8)  ? HAL_ADC_IT_CHANNEL_8 :
+                   (ch == HAL_ADC_CHANNEL_9)  ? HAL_ADC_IT_CHANNEL_9 :
+                   (ch == HAL_ADC_CHANNEL_10) ? HAL_ADC_IT_CHANNEL_10 :
+                   (ch == HAL_ADC_CHANNEL_11) ? HAL_ADC_IT_CHANNEL_11 :
+                   (ch == HAL_ADC_CHANNEL_12) ? HAL_ADC_IT_CHANNEL_12 :
+                   (ch == HAL_ADC_CHANNEL_13) ? HAL_ADC_IT_CHANNEL_13 :
+                   (ch == HAL_ADC_CHANNEL_14) ? HAL_ADC_IT_CHANNEL_14 :
+                   (ch == HAL_ADC_CHANNEL_15) ? HAL_ADC_IT_CHANNEL_15 :
+                   (ch == HAL_ADC_CHANNEL_16) ? HAL_ADC_IT_CHANNEL_16 :
+                   (ch == HAL_ADC_CHANNEL_17) ? HAL_ADC_IT_CHANNEL_17 :
+                   (ch == HAL_ADC_CHANNEL_18) ? HAL_ADC_IT_CHANNEL_18 :
+                   (ch == HAL_ADC_CHANNEL_19) ? HAL_ADC_IT_CHANNEL_19 :
+                   (ch == HAL_ADC_CHANNEL_20) ? HAL_ADC_IT_CHANNEL_20 :
+                   (ch == HAL_ADC_CHANNEL_21) ? HAL_ADC_IT_CHANNEL_21 :
+                   (ch == HAL_ADC_CHANNEL_22) ? HAL_ADC_IT_CHANNEL_22 :
+                   HAL_ADC_IT_CHANNEL_23;
+#endif
+    return;
+}
+
+static void _Bench_ADC_ItTypeTable(void *pUserData)
+{
+    ADC_HandleTypeDef   *hADC = (ADC_HandleTypeDef*)pUserData;
+
+    g_Bench_Sink = HAL_ADC_ChannelDescTable[HAL_ADC_GetChannelId(hADC->Init.AChannelSel)].ItMask;
+    return;
+}
+
+static void _Bench_ADC_ChannelId(void *pUserData)
+{
+    ADC_HandleTypeDef   *hADC = (ADC_HandleTypeDef*)pUserData;
+
+    g_Bench_Sink = HAL_ADC_GetChannelId(hADC->Init.AChannelSel);
+    return;
+}
+
+static void _Bench_ADC_Start(void *pUserData)
+{
+    HAL_ADC_Start_IT((ADC_HandleTypeDef*)pUserData);
+    return;
+}
+
+static void _Bench_ADC_FastStart(void *pUserData)
+{
+    ADC_HandleTypeDef   *hADC = (ADC_HandleTypeDef*)pUserData;
+
+    HAL_ADC_FastStart_IT(hADC, g_Bench_Sink);
+    return;
+}
+
+static void _Bench_ADC_GetValue(void *pUserData)
+{
+    ADC_HandleTypeDef   *hADC = (ADC_HandleTypeDef*)pUserData;
+
+    g_Bench_Sink = HAL_ADC_GetValue(hADC, hADC->Init.AChannelSel);
+    return;
+}
+
+static void _Bench_ADC_FastGetValue(void *pUserData)
+{
+    g_Bench_Sink = HAL_ADC_FastGetValue((ADC_HandleTypeDef*)pUserData);
+    return;
+}
+#endif  /* defined(HAL_ADC_MODULE_ENABLED) */
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+static void _Bench_TIM_Update(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+    g_Bench_Sink++;
+    return;
+}
+
+static const pTIM_CallbackTypeDef   g_Bench_TIM_Callbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_UPDATE] = _Bench_TIM_Update,
+};
+
+static void _Bench_TIM_UpdateOnly(void *pUserData)
+{
+    TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pUserData;
+
+    /* The cost of raising and clearing the update event, subtracted from the handlers */
+    htim->Instance->EGR = TIM_EGR_UG;
+    __HAL_TIM_CLEAR_IT(htim, TIM_IT_UPDATE);
+    return;
+}
+
+static void _Bench_TIM_IRQ(void *pUserData)
+{
+    TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pUserData;
+
+    htim->Instance->EGR = TIM_EGR_UG;
+    HAL_TIM_IRQHandler(htim);
+    return;
+}
+
+static void _Bench_TIM_FastIRQ(void *pUserData)
+{
+    TIM_HandleTypeDef   *htim = (TIM_HandleTypeDef*)pUserData;
+
+    htim->Instance->EGR = TIM_EGR_UG;
+    HAL_TIM_FastIRQHandler(htim);
+    return;
+}
+#endif  /* defined(HAL_TIM_MODULE_ENABLED) */
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+/**
+ *  @brief  Measure the cycles of a function
+ *
+ *  @param [in] pfFunc      The function under test
+ *  @param [in] pUserData   The argument of pfFunc
+ *  @return
+ *      The minimum cycles of BENCH_LOOPS runs, the call overhead is excluded
+ */
+uint32_t Bench_Measure(Bench_FuncTypeDef pfFunc, void *pUserData)
+{
+    uint32_t    ctrl = SysTick->CTRL;
+    uint32_t    load = SysTick->LOAD;
+    uint32_t    cycles = 0, overhead = 0;
+
+    /* Free-run SysTick on HCLK without interrupt */
+    SysTick->CTRL = 0;
+    SysTick->LOAD = BENCH_SYSTICK_RELOAD;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    overhead = _Bench_Run(_Bench_Empty, 0);
+    cycles   = _Bench_Run(pfFunc, pUserData);
+
+    /* Restore the time base, the elapsed time of the run is lost */
+    SysTick->CTRL = 0;
+    SysTick->LOAD = load;
+    SysTick->VAL  = 0;
+    SysTick->CTRL = ctrl;
+
+    return (cycles > overhead) ? cycles - overhead : 0;
+}
+
+#if defined(HAL_ADC_MODULE_ENABLED)
+/**
+ *  @brief  ADC channel descriptor table and fast path (before/after)
+ *              + the removed code paths are kept here as baselines (__CLZ, ternary chain),
+ *                the worst case of the chain is the last channel (AIN7/AIN23)
+ *              + HAL_ADC_Start_IT() is the table version, against HAL_ADC_FastStart_IT()
+ *
+ *  @param [in] hADC        ADC handle, initialized in single mode and enabled by
+ *                              HAL_ADC_Start_IT() once, the ADC IRQ is disabled in NVIC
+ *  @return
+ *      None
+ */
+void Bench_ADC_Run(ADC_HandleTypeDef *hADC)
+{
+    uint32_t    before = 0, after = 0;
+
+    before = Bench_Measure(_Bench_ADC_ChannelIdClz, hADC);
+    after  = Bench_Measure(_Bench_ADC_ChannelId, hADC);
+    msg("ADC channel id     : __CLZ %u, HAL_ADC_GetChannelId %u cycles\n", before, after);
+
+    before = Bench_Measure(_Bench_ADC_ItTypeChain, hADC);
+    after  = Bench_Measure(_Bench_ADC_ItTypeTable, hADC);
+    msg("ADC channel IT     : ternary chain %u, descriptor table %u cycles\n", before, after);
+
+    before = Bench_Measure(_Bench_ADC_Start, hADC);
+    g_Bench_Sink = HAL_ADC_GetChannelId(hADC->Init.AChannelSel);
+    after  = Bench_Measure(_Bench_ADC_FastStart, hADC);
+    msg("ADC start          : HAL_ADC_Start_IT %u, HAL_ADC_FastStart_IT %u cycles\n", before, after);
+
+    before = Bench_Measure(_Bench_ADC_GetValue, hADC);
+    after  = Bench_Measure(_Bench_ADC_FastGetValue, hADC);
+    msg("ADC read           : HAL_ADC_GetValue %u, HAL_ADC_FastGetValue %u cycles\n", before, after);
+    return;
+}
+#endif  /* defined(HAL_ADC_MODULE_ENABLED) */
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+/**
+ *  @brief  TIM update interrupt dispatch, HAL_TIM_IRQHandler() (before) and
+ *          HAL_TIM_FastIRQHandler() (after)
+ *
+ *  @param [in] htim        TIM handle, started by HAL_TIM_Base_Start_IT() (update interrupt enabled),
+ *                              the TIM IRQ is disabled in NVIC
+ *  @return
+ *      None
+ */
+void Bench_TIM_Run(TIM_HandleTypeDef *htim)
+{
+    const pTIM_CallbackTypeDef  *pCallbacks = htim->pFastCallbacks;
+    uint32_t                    base = 0, before = 0, after = 0;
+
+    base   = Bench_Measure(_Bench_TIM_UpdateOnly, htim);
+    before = Bench_Measure(_Bench_TIM_IRQ, htim);
+
+    HAL_TIM_RegisterFastCallbacks(htim, g_Bench_TIM_Callbacks);
+    after  = Bench_Measure(_Bench_TIM_FastIRQ, htim);
+    HAL_TIM_RegisterFastCallbacks(htim, pCallbacks);
+
+    before = (before > base) ? before - base : 0;
+    after  = (after > base) ? after - base : 0;
+    msg("TIM update dispatch: HAL_TIM_IRQHandler %u, HAL_TIM_FastIRQHandler %u cycles\n", before, after);
+    return;
+}
+#endif  /* defined(HAL_TIM_MODULE_ENABLED) */
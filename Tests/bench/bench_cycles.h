@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file bench_cycles.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  On-target cycle benchmarks of the HAL fast paths (before/after).
+ *
+ *  + The cycles are measured with the SysTick down-counter on HCLK (no DWT on
+ *    Cortex-M0+), the minimum of BENCH_LOOPS runs is reported and the cost of
+ *    an empty call is subtracted.
+ *  + SysTick is taken over during a run and restored at the end, the SysTick
+ *    interrupt is masked, so run it from the main loop and not from an ISR.
+ *  + The results are printed with msg() (Common/log.h).
+ *
+ *  Add this file into the project of the target and call Bench_xxx_Run() after
+ *  the peripheral is initialized.
+ */
+
+#ifndef __bench_cycles_H_q8RdT2nW_lKe5_HvBy_s3Fm_uX7cLp4jZaGs__
+#define __bench_cycles_H_q8RdT2nW_lKe5_HvBy_s3Fm_uX7cLp4jZaGs__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define BENCH_LOOPS         16
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef void (*Bench_FuncTypeDef)(void *pUserData);
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+uint32_t Bench_Measure(Bench_FuncTypeDef pfFunc, void *pUserData);
+
+#if defined(HAL_ADC_MODULE_ENABLED)
+void Bench_ADC_Run(ADC_HandleTypeDef *hADC);
+#endif
+
+#if defined(HAL_TIM_MODULE_ENABLED)
+void Bench_TIM_Run(TIM_HandleTypeDef *htim);
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file host_cmsis.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Host replacement of the CMSIS core intrinsics (cmsis_gcc.h), it is force
+ *  included (-include) before the HAL headers so that the HAL and middleware
+ *  sources build as host programs.
+ *
+ *  + PRIMASK is a variable, g_Host_IrqOffCnt counts the critical sections.
+ *  + The peripherals are plain structures of the test, e.g.
+ *    htim.Instance = &fake_tim, the fixed instances (TIM1, LPTIM, ...) MUST
+ *    NOT be accessed.
+ */
+
+#ifndef __host_cmsis_H_m5TqW8rB_lNc3_HjZe_s6Dy_uK2vXh9pLaFo__
+#define __host_cmsis_H_m5TqW8rB_lNc3_HjZe_s6Dy_uK2vXh9pLaFo__
+
+#include <stdint.h>
+
+/* Skip the ARM intrinsics of cmsis_gcc.h */
+#define __CMSIS_GCC_H
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define __ASM                   __asm
+#define __PACKED                __attribute__((packed))
+#define __WEAK                  __attribute__((weak))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+extern uint32_t     g_Host_Primask;
+extern uint32_t     g_Host_IrqOffCnt;
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static inline void __disable_irq(void)
+{
+    if( !g_Host_Primask )
+        g_Host_IrqOffCnt++;
+
+    g_Host_Primask = 1;
+}
+
+static inline void __enable_irq(void)               { g_Host_Primask = 0; }
+static inline uint32_t __get_PRIMASK(void)          { return g_Host_Primask; }
+
+static inline void __set_PRIMASK(uint32_t priMask)
+{
+    if( !g_Host_Primask && priMask )
+        g_Host_IrqOffCnt++;
+
+    g_Host_Primask = priMask;
+}
+
+static inline uint32_t __get_CONTROL(void)          { return 0; }
+static inline void __set_CONTROL(uint32_t control)  { (void)control; }
+static inline uint32_t __get_IPSR(void)             { return 0; }
+static inline uint32_t __get_MSP(void)              { return 0; }
+static inline void __set_MSP(uint32_t topOfMainStack) { (void)topOfMainStack; }
+static inline uint32_t __get_PSP(void)              { return 0; }
+static inline void __set_PSP(uint32_t topOfProcStack) { (void)topOfProcStack; }
+
+static inline void __NOP(void)  {}
+static inline void __WFI(void)  {}
+static inline void __WFE(void)  {}
+static inline void __SEV(void)  {}
+static inline void __ISB(void)  {}
+static inline void __DSB(void)  {}
+static inline void __DMB(void)  {}
+
+static inline uint32_t __REV(uint32_t value)        { return __builtin_bswap32(value); }
+static inline uint32_t __CLZ(uint32_t value)        { return (value) ? (uint32_t)__builtin_clz(value) : 32; }
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file host_stub.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  HAL functions which are not under test, weak so a test can override them.
+ */
+
+
+#include <string.h>
+#include <sys/mman.h>
+#include "host_test.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define HOST_APB_BASE           0x40000000ul
+#define HOST_APB_SIZE           0x00030000ul    /*!< UART0 ~ GPIOD, RCC, FLASH, CRC */
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+uint32_t    g_Host_Primask   = 0;
+uint32_t    g_Host_IrqOffCnt = 0;
+
+uint32_t    g_Host_CheckCnt = 0;
+uint32_t    g_Host_FailCnt  = 0;
+
+uint32_t    g_Host_Tick     = 0;
+uint32_t    g_Host_PclkFreq = 24000000ul;
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+__weak uint32_t HAL_GetTick(void)
+{
+    return g_Host_Tick;
+}
+
+__weak uint32_t HAL_RCC_GetPCLKFreq(void)
+{
+    return g_Host_PclkFreq;
+}
+
+/**
+ *  @brief  Map RAM at the peripheral addresses, the fixed instances (TIM1,
+ *          LPTIM, GPIOA, ...) become plain memory of the test
+ *
+ *  @return
+ *      0: ok, others: the address range is not available
+ */
+int Host_MapPeripherals(void)
+{
+    void    *pAddr = mmap((void*)HOST_APB_BASE, HOST_APB_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if( pAddr != (void*)HOST_APB_BASE )
+    {
+        printf("map peripherals at 0x%08lX fail\n", HOST_APB_BASE);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *  @brief  Clear all the registers of the mapped peripherals
+ */
+void Host_ResetPeripherals(void)
+{
+    memset((void*)HOST_APB_BASE, 0x0, HOST_APB_SIZE);
+    return;
+}
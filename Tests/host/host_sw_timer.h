@@ -0,0 +1,34 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file host_sw_timer.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Forced include of test_sw_timer. The registers are plain memory, so the
+ *  write-1-to-clear of the overflow flags is routed to the simulation.
+ */
+
+#ifndef __host_sw_timer_H_q5RzT8wB_lKc3_HmYd_s1Pv_uX6nGf2jLaEs__
+#define __host_sw_timer_H_q5RzT8wB_lKc3_HmYd_s1Pv_uX6nGf2jLaEs__
+
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#undef __HAL_BASETIM_CLEAR_IT
+#define __HAL_BASETIM_CLEAR_IT(__HANDLE__)      Sim_ClearOverflow()
+
+#undef __HAL_LPTIM_CLEAR_IT
+#define __HAL_LPTIM_CLEAR_IT(__HANDLE__)        Sim_ClearOverflow()
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+void Sim_ClearOverflow(void);
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file host_test.h
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Minimal check macros and HAL stubs of the host unit tests.
+ */
+
+#ifndef __host_test_H_v2KsL7cQ_lRb8_HwNf_s4Gt_uM9dYj3xPeHa__
+#define __host_test_H_v2KsL7cQ_lRb8_HwNf_s4Gt_uM9dYj3xPeHa__
+
+#include <stdio.h>
+#include <stdint.h>
+#include "zb32l03x_hal.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define HOST_CHECK(cond)                                                    \
+    do{ g_Host_CheckCnt++;                                                  \
+        if( !(cond) ) {                                                     \
+            g_Host_FailCnt++;                                               \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        }                                                                   \
+    }while(0)
+
+#define HOST_REPORT(name)                                                   \
+    (printf("%s: %u checks, %u failed\n", (name), g_Host_CheckCnt, g_Host_FailCnt), \
+     (g_Host_FailCnt) ? 1 : 0)
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+extern uint32_t     g_Host_CheckCnt;
+extern uint32_t     g_Host_FailCnt;
+
+extern uint32_t     g_Host_Tick;        /*!< HAL_GetTick() */
+extern uint32_t     g_Host_PclkFreq;    /*!< HAL_RCC_GetPCLKFreq() */
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+int Host_MapPeripherals(void);
+void Host_ResetPeripherals(void);
+
+#endif
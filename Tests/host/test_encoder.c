@@ -0,0 +1,321 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file test_encoder.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Quadrature encoder service with synthetic count sequences.
+ *
+ *  + TIM1 is plain memory (Host_MapPeripherals()), the test writes CNT/CCR1
+ *    and raises CC1IF at the TI1 edges (every 2 counts in x4 mode).
+ *  + The timestamp (HAL_GetCycles64) is the simulated time, 1 MHz, and
+ *    HAL_TIM_Encoder_Start() can be forced to fail (linker --wrap).
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host_test.h"
+#include "encoder.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define SIM_FREQ                1000000ul   /* timestamp frequency */
+#define SIM_SAMPLE_CYCLES       1000ul      /* 1 ms control loop */
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _VEL(__CNT_PER_SEC__)   ((int32_t)((__CNT_PER_SEC__) * (1 << ENCODER_VELOCITY_FRAC_BITS)))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static uint64_t             g_Now = 0;
+static uint32_t             g_IsEncStartFail = 0;
+
+static TIM_HandleTypeDef    g_hTim;
+static Encoder_TypeDef      g_Enc;
+
+static double               g_Pos = 0.0;        /* true position, counts */
+static int64_t              g_PosCnt = 0;       /* floor(g_Pos) */
+
+static void _Dummy_Update(TIM_HandleTypeDef *htim) { (void)htim; }
+
+static const pTIM_CallbackTypeDef   g_User_Callbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_UPDATE] = _Dummy_Update,
+};
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+uint64_t __wrap_HAL_GetCycles64(void)
+{
+    return g_Now;
+}
+
+uint32_t __wrap_HAL_TIM_Timestamp_GetFreq(void)
+{
+    return SIM_FREQ;
+}
+
+HAL_StatusTypeDef __real_HAL_TIM_Encoder_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef __wrap_HAL_TIM_Encoder_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    return (g_IsEncStartFail) ? HAL_ERROR : __real_HAL_TIM_Encoder_Start(htim, Channel);
+}
+
+/**
+ *  TI1 edge at the time g_Now, the capture holds the count after the edge
+ */
+static void _Sim_Edge(void)
+{
+    TIM1->CCR1 = (uint16_t)g_PosCnt;
+    TIM1->SR   = TIM_FLAG_CC1;
+    HAL_TIM_FastIRQHandler(&g_hTim);
+    TIM1->SR   = 0;
+    return;
+}
+
+/**
+ *  Move at a constant velocity for one sample period, with the TI1 edges on
+ *  the even counts, then sample
+ */
+static void _Sim_Run(double vel, uint32_t samples)
+{
+    for(uint32_t n = 0; n < samples; n++)
+    {
+        uint64_t    t0 = g_Now;
+        double      p0 = g_Pos;
+        double      p1 = p0 + vel * SIM_SAMPLE_CYCLES / SIM_FREQ;
+
+        while( 1 )
+        {
+            int64_t     next = (vel > 0) ? g_PosCnt + 1 : g_PosCnt;
+            double      t = 0.0;
+
+            if( (vel > 0 && (double)next > p1) || (vel < 0 && (double)next < p1) || vel == 0 )
+                break;
+
+            t       = (double)t0 + ((double)next - p0) * SIM_FREQ / vel;
+            g_Now   = (uint64_t)llround(t);
+            g_PosCnt = (vel > 0) ? next : next - 1;
+
+            TIM1->CNT = (uint16_t)g_PosCnt;
+
+            /* TI1 toggles every 2 counts in x4 mode */
+            if( (g_PosCnt & 0x1) == 0 )
+                _Sim_Edge();
+        }
+
+        g_Pos     = p1;
+        g_Now     = t0 + SIM_SAMPLE_CYCLES;
+        TIM1->CNT = (uint16_t)g_PosCnt;
+
+        Encoder_Sample(&g_Enc);
+    }
+    return;
+}
+
+static int _Vel_Near(int32_t vel, int32_t expect, int32_t permille)
+{
+    int64_t     diff = (int64_t)vel - expect;
+    int64_t     tol = ((int64_t)abs(expect) * permille) / 1000 + 1;
+
+    return (diff <= tol && diff >= -tol);
+}
+
+static void _Test_Setup(void)
+{
+    Encoder_InitTypeDef     init = {0};
+
+    Host_ResetPeripherals();
+    memset(&g_hTim, 0x0, sizeof(g_hTim));
+
+    g_hTim.Instance = TIM1;
+    g_Now    = 0;
+    g_Pos    = 0.5;
+    g_PosCnt = 0;
+
+    init.htim            = &g_hTim;
+    init.WindowThreshold = 20;
+    init.StallTimeMs     = 200;
+
+    HOST_CHECK(Encoder_Init(&g_Enc, &init) == HAL_OK);
+    HOST_CHECK(Encoder_Start(&g_Enc) == HAL_OK);
+    return;
+}
+
+static void _Test_Validation(void)
+{
+    Encoder_InitTypeDef     init = {0};
+    TIM_HandleTypeDef       htim = {0};
+    Encoder_TypeDef         enc;
+
+    htim.Instance        = TIM1A;
+    init.htim            = &htim;
+    init.WindowThreshold = 20;
+
+    /* No encoder interface on TIM1A, it would collide with TIM2 */
+    HOST_CHECK(Encoder_Init(&enc, &init) == HAL_ERROR);
+
+    htim.Instance = TIM2;
+    HOST_CHECK(Encoder_Init(&enc, &init) == HAL_OK);
+
+    init.WindowThreshold = 0x8000;
+    HOST_CHECK(Encoder_Init(&enc, &init) == HAL_ERROR);
+    return;
+}
+
+static void _Test_StartRollback(void)
+{
+    Encoder_InitTypeDef     init = {0};
+    TIM_HandleTypeDef       htim = {0};
+    Encoder_TypeDef         enc_a, enc_b;
+
+    Host_ResetPeripherals();
+
+    htim.Instance        = TIM2;
+    init.htim            = &htim;
+    init.WindowThreshold = 20;
+    HOST_CHECK(Encoder_Init(&enc_a, &init) == HAL_OK);
+    HOST_CHECK(Encoder_Init(&enc_b, &init) == HAL_OK);
+
+    HOST_CHECK(HAL_TIM_RegisterFastCallbacks(&htim, g_User_Callbacks) == HAL_OK);
+
+    /* A failed start leaves the slot and the callbacks as they were */
+    g_IsEncStartFail = 1;
+    HOST_CHECK(Encoder_Start(&enc_a) == HAL_ERROR);
+    HOST_CHECK(htim.pFastCallbacks == g_User_Callbacks);
+    g_IsEncStartFail = 0;
+
+    HOST_CHECK(Encoder_Start(&enc_b) == HAL_OK);
+    HOST_CHECK(htim.pFastCallbacks != g_User_Callbacks);
+
+    /* The slot is owned by enc_b */
+    HOST_CHECK(Encoder_Start(&enc_a) == HAL_BUSY);
+    HOST_CHECK(Encoder_Stop(&enc_a) == HAL_OK);
+    HOST_CHECK(htim.pFastCallbacks != NULL);
+
+    HOST_CHECK(Encoder_Stop(&enc_b) == HAL_OK);
+    HOST_CHECK(htim.pFastCallbacks == NULL);
+    return;
+}
+
+static void _Test_PositionExtend(void)
+{
+    int64_t     expect = 0;
+    uint16_t    cnt = 0;
+
+    _Test_Setup();
+
+    /* Random moves up to +/-32767 counts between two samples, many 16-bits wraps */
+    for(int i = 0; i < 100000; i++)
+    {
+        int32_t     delta = (rand() % 65535) - 32767;
+
+        expect += delta;
+        cnt    += (uint16_t)delta;
+
+        TIM1->CNT = cnt;
+        g_Now    += SIM_SAMPLE_CYCLES;
+        Encoder_Sample(&g_Enc);
+
+        if( g_Enc.Position != expect )
+        {
+            HOST_CHECK(g_Enc.Position == expect);
+            break;
+        }
+    }
+
+    HOST_CHECK(Encoder_GetPosition32(&g_Enc) == (int32_t)expect);
+
+    /* Homing */
+    Encoder_SetPosition(&g_Enc, 1000);
+    TIM1->CNT = cnt + 5;
+    g_Now    += SIM_SAMPLE_CYCLES;
+    Encoder_Sample(&g_Enc);
+    HOST_CHECK(g_Enc.Position == 1005);
+
+    Encoder_Stop(&g_Enc);
+    return;
+}
+
+static void _Test_Velocity(void)
+{
+    Encoder_SnapshotTypeDef     snap;
+
+    _Test_Setup();
+
+    /* Low speed, T method on the edges */
+    _Sim_Run(100.0, 500);
+    HOST_CHECK(g_Enc.VelMode == ENCODER_VEL_MODE_EDGE);
+    HOST_CHECK(_Vel_Near(g_Enc.Velocity, _VEL(100), 10));
+
+    /* Reverse */
+    _Sim_Run(-250.0, 500);
+    HOST_CHECK(g_Enc.VelMode == ENCODER_VEL_MODE_EDGE);
+    HOST_CHECK(_Vel_Near(g_Enc.Velocity, _VEL(-250), 10));
+
+    /* High speed, 50 counts per sample > WindowThreshold, M method */
+    _Sim_Run(50000.0, 100);
+    HOST_CHECK(g_Enc.VelMode == ENCODER_VEL_MODE_WINDOW);
+    HOST_CHECK(!(TIM1->DIER & TIM_IT_CC1));
+    HOST_CHECK(_Vel_Near(g_Enc.Velocity, _VEL(50000), 10));
+
+    /* Hysteresis, 15 counts per sample stays in the window mode */
+    _Sim_Run(15000.0, 100);
+    HOST_CHECK(g_Enc.VelMode == ENCODER_VEL_MODE_WINDOW);
+    HOST_CHECK(_Vel_Near(g_Enc.Velocity, _VEL(15000), 70));
+
+    /* Back to the edges below the half of the threshold */
+    _Sim_Run(2000.0, 100);
+    HOST_CHECK(g_Enc.VelMode == ENCODER_VEL_MODE_EDGE);
+    HOST_CHECK(TIM1->DIER & TIM_IT_CC1);
+    HOST_CHECK(_Vel_Near(g_Enc.Velocity, _VEL(2000), 10));
+
+    Encoder_GetSnapshot(&g_Enc, &snap);
+    HOST_CHECK(snap.Position == g_PosCnt);
+    HOST_CHECK(snap.Velocity == g_Enc.Velocity);
+    HOST_CHECK(snap.Timestamp == g_Now);
+    HOST_CHECK((g_Enc.Sequence & 0x1) == 0);
+
+    /* Stop, the velocity is bounded by one edge pitch (2 counts) since the last edge */
+    _Sim_Run(0.0, 50);
+    HOST_CHECK(g_Enc.Velocity > 0 && g_Enc.Velocity <= _VEL(2 * 1000.0 / 50));
+
+    /* Stall */
+    _Sim_Run(0.0, 200);
+    HOST_CHECK(g_Enc.Velocity == 0);
+
+    Encoder_Stop(&g_Enc);
+    return;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+int main(void)
+{
+    if( Host_MapPeripherals() )
+        return 1;
+
+    srand(1);
+
+    _Test_Validation();
+    _Test_StartRollback();
+    _Test_PositionExtend();
+    _Test_Velocity();
+
+    return HOST_REPORT("test_encoder");
+}
@@ -0,0 +1,456 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file test_soft_uart.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Timing model of the software UART, two ports cross-connected in full
+ *  duplex at 9600 ~ 38400 baud.
+ *
+ *  + The PCA is plain memory (Host_MapPeripherals()), _Sim_Tick() plays the
+ *    hardware at every PCA count: compare match (flag, toggle of CCAPO),
+ *    capture of the falling edges and INTCLR.
+ *  + The CPU services the PCA IRQ after an entry latency plus a random
+ *    blocking by other ISRs, and is busy for a cost per serviced module.
+ *  + Every TX edge is checked against the ideal bit boundary and every RX
+ *    sample against the middle of the bit on the line.
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "soft_uart.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define SIM_BYTES               64
+
+/* HCLK 24 MHz, IRQ entry and the handler cost of a serviced module in cycles */
+#define SIM_CPU_FREQ            24000000ul
+#define SIM_ENTRY_CYCLES        16
+#define SIM_MODULE_CYCLES       100
+
+/**
+ *  Blocking of the PCA IRQ by other ISRs, the RX sample point MUST be reached
+ *  within half a bit. With 4 modules serviced in one ISR, it leaves about 2 us
+ *  to the other ISRs at 38400 baud.
+ */
+#define SIM_BLOCK_US_9600       20
+#define SIM_BLOCK_US_19200      10
+#define SIM_BLOCK_US_38400      2
+
+#define SIM_RX_PORT             GPIOA
+#define SIM_RX_PIN_A            GPIO_PIN_1
+#define SIM_RX_PIN_B            GPIO_PIN_2
+
+/* PCA modules, port A: TX 0 / RX 1, port B: TX 2 / RX 3 */
+#define SIM_A_TX                0
+#define SIM_A_RX                1
+#define SIM_B_TX                2
+#define SIM_B_RX                3
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _CCAPM(__IDX__)         (*(&PCA->CCAPM0 + (__IDX__)))
+#define _CCAP(__IDX__)          (*(&PCA->CCAP0 + (__IDX__)))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct sim_cpu
+{
+    uint32_t    EntryTicks;     /*!< IRQ entry to the first register access */
+    uint32_t    ModuleTicks;    /*!< Handler cost of a serviced module */
+    uint32_t    BlockTicks;     /*!< Max blocking by other ISRs */
+} sim_cpu_t;
+
+typedef struct sim_line
+{
+    uint32_t    Level;
+    uint64_t    FrameStart;     /*!< Falling edge of the last start bit */
+    uint32_t    BitIdx;         /*!< Bit of the frame on the line */
+} sim_line_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static PCA_HandleTypeDef        g_hPca;
+static SoftUart_HandleTypeDef   g_hSuartA;
+static SoftUart_HandleTypeDef   g_hSuartB;
+
+static uint64_t     g_Now = 0;
+static uint64_t     g_BusyUntil = 0;       /*!< The CPU is in the PCA ISR */
+static double       g_BitTicks = 0.0;
+static sim_line_t   g_LineA;            /*!< TX of port A, RX of port B */
+static sim_line_t   g_LineB;
+
+static double       g_TxEdgeErrMax = 0.0;   /*!< PCA counts */
+static double       g_RxSampleErrMax = 0.0; /*!< Ratio of a bit */
+static uint32_t     g_TxCpltCnt = 0;
+static uint32_t     g_RxCpltCnt = 0;
+static uint32_t     g_ErrorCnt = 0;
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+void SoftUart_TxCpltCallback(SoftUart_HandleTypeDef *hsuart)
+{
+    g_TxCpltCnt++;
+}
+
+void SoftUart_RxCpltCallback(SoftUart_HandleTypeDef *hsuart)
+{
+    g_RxCpltCnt++;
+}
+
+void SoftUart_ErrorCallback(SoftUart_HandleTypeDef *hsuart)
+{
+    g_ErrorCnt++;
+}
+
+static uint32_t _Sim_TxLevel(uint32_t idx)
+{
+    if( !(PCA->POCR & (PCA_POCR_POE0 << idx)) )
+        return 1;
+
+    return (PCA->CCAPO >> idx) & 0x1ul;
+}
+
+/**
+ *  Track the frame on a line and check the edge against the ideal bit boundary
+ */
+static void _Sim_LineUpdate(sim_line_t *pLine, uint32_t level)
+{
+    double      pos = 0.0, err = 0.0;
+    uint32_t    bit = 0;
+
+    if( level == pLine->Level )
+        return;
+
+    pLine->Level = level;
+
+    if( pLine->BitIdx >= SOFT_UART_FRAME_BITS && !level )
+    {
+        /* start bit */
+        pLine->FrameStart = g_Now;
+        pLine->BitIdx     = 0;
+        return;
+    }
+
+    pos = (double)(g_Now - pLine->FrameStart);
+    bit = (uint32_t)(pos / g_BitTicks + 0.5);
+    err = pos - bit * g_BitTicks;
+    if( err < 0 )   err = -err;
+
+    if( err > g_TxEdgeErrMax )
+        g_TxEdgeErrMax = err;
+
+    return;
+}
+
+static void _Sim_LineFrameEnd(sim_line_t *pLine)
+{
+    /* idle after the stop bit, the next falling edge is a start bit */
+    if( pLine->BitIdx < SOFT_UART_FRAME_BITS &&
+        g_Now - pLine->FrameStart >= (uint64_t)(SOFT_UART_FRAME_BITS * g_BitTicks - g_BitTicks / 2) )
+        pLine->BitIdx = SOFT_UART_FRAME_BITS;
+
+    return;
+}
+
+/**
+ *  One PCA count of the hardware
+ */
+static void _Sim_Tick(void)
+{
+    uint32_t    cnt = 0;
+    uint32_t    prev_a = g_LineA.Level;
+    uint32_t    prev_b = g_LineB.Level;
+
+    g_Now++;
+    cnt = (uint32_t)(g_Now & 0xFFFFul);
+    PCA->CNT = cnt;
+
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        uint32_t    mode = _CCAPM(i);
+
+        if( (mode & (PCA_CCAPM0_ECOM | PCA_CCAPM0_MAT)) == (PCA_CCAPM0_ECOM | PCA_CCAPM0_MAT) &&
+            (_CCAP(i) & 0xFFFFul) == cnt )
+        {
+            PCA->CR |= (0x1ul << i);
+
+            if( mode & PCA_CCAPM0_TOG )
+                PCA->CCAPO ^= (0x1ul << i);
+        }
+    }
+
+    _Sim_LineFrameEnd(&g_LineA);
+    _Sim_LineFrameEnd(&g_LineB);
+    _Sim_LineUpdate(&g_LineA, _Sim_TxLevel(SIM_A_TX));
+    _Sim_LineUpdate(&g_LineB, _Sim_TxLevel(SIM_B_TX));
+
+    /* the RX capture inputs, line A to port B and line B to port A */
+    if( prev_a && !g_LineA.Level && (_CCAPM(SIM_B_RX) & PCA_CCAPM0_CAPN) )
+    {
+        _CCAP(SIM_B_RX) = cnt;
+        PCA->CR |= (0x1ul << SIM_B_RX);
+    }
+
+    if( prev_b && !g_LineB.Level && (_CCAPM(SIM_A_RX) & PCA_CCAPM0_CAPN) )
+    {
+        _CCAP(SIM_A_RX) = cnt;
+        PCA->CR |= (0x1ul << SIM_A_RX);
+    }
+
+    return;
+}
+
+static void _Sim_ApplyIntClr(void)
+{
+    PCA->CR    &= ~PCA->INTCLR;
+    PCA->INTCLR = 0;
+    return;
+}
+
+/**
+ *  Check the RX sample point against the middle of the bit on the line
+ */
+static void _Sim_CheckSample(SoftUart_HandleTypeDef *hsuart, sim_line_t *pLine, uint32_t idx)
+{
+    double      err = 0.0;
+
+    if( !(PCA->CR & (0x1ul << idx)) || hsuart->RxBitIdx >= SOFT_UART_FRAME_BITS )
+        return;
+
+    err = (double)(g_Now - pLine->FrameStart) - (hsuart->RxBitIdx + 0.5) * g_BitTicks;
+    err = (err < 0) ? -err / g_BitTicks : err / g_BitTicks;
+
+    if( err > g_RxSampleErrMax )
+        g_RxSampleErrMax = err;
+
+    return;
+}
+
+static uint32_t _Sim_Pending(void)
+{
+    uint32_t    pending = 0;
+
+    for(uint32_t i = 0; i < 5; i++)
+    {
+        if( (PCA->CR & (0x1ul << i)) && (_CCAPM(i) & PCA_CCAPM0_CCIE) )
+            pending++;
+    }
+
+    return pending;
+}
+
+/**
+ *  Run the hardware and the CPU until both ports are done or timeout
+ */
+static void _Sim_Run(sim_cpu_t *pCpu, uint64_t timeout)
+{
+    uint64_t    end = g_Now + timeout;
+
+    while( g_Now < end && (g_TxCpltCnt < 2 || g_RxCpltCnt < 2) )
+    {
+        uint32_t    pending = 0;
+
+        _Sim_Tick();
+        _Sim_ApplyIntClr();
+
+        if( g_Now < g_BusyUntil || !(pending = _Sim_Pending()) )
+            continue;
+
+        /* entry latency and other ISRs, the hardware keeps running */
+        for(uint32_t delay = pCpu->EntryTicks + (pCpu->BlockTicks ? rand() % (pCpu->BlockTicks + 1) : 0);
+            delay; delay--)
+        {
+            _Sim_Tick();
+            _Sim_ApplyIntClr();
+        }
+
+        SIM_RX_PORT->IDR = (g_LineB.Level ? SIM_RX_PIN_A : 0) | (g_LineA.Level ? SIM_RX_PIN_B : 0);
+
+        _Sim_CheckSample(&g_hSuartA, &g_LineB, SIM_A_RX);
+        _Sim_CheckSample(&g_hSuartB, &g_LineA, SIM_B_RX);
+
+        pending = _Sim_Pending();
+        SoftUart_PCA_IRQHandler();
+        _Sim_ApplyIntClr();
+
+        g_BusyUntil = g_Now + pending * pCpu->ModuleTicks;
+    }
+
+    return;
+}
+
+static void _Test_FullDuplex(uint32_t pca_clock, uint32_t baud, uint32_t block_us)
+{
+    uint8_t     tx_a[SIM_BYTES], tx_b[SIM_BYTES];
+    uint8_t     rx_a[SIM_BYTES], rx_b[SIM_BYTES];
+    sim_cpu_t   cpu = {0};
+    uint64_t    frame_ticks = 0;
+
+    Host_ResetPeripherals();
+    memset(&g_hPca, 0x0, sizeof(g_hPca));
+    memset(&g_hSuartA, 0x0, sizeof(g_hSuartA));
+    memset(&g_hSuartB, 0x0, sizeof(g_hSuartB));
+    memset(rx_a, 0x0, sizeof(rx_a));
+    memset(rx_b, 0x0, sizeof(rx_b));
+
+    for(int i = 0; i < SIM_BYTES; i++)
+    {
+        tx_a[i] = (uint8_t)rand();
+        tx_b[i] = (uint8_t)rand();
+    }
+
+    /* 0x00 and 0xFF are the longest runs without edges, 0x55 has the most edges */
+    tx_a[0] = 0x00;     tx_a[1] = 0xFF;     tx_a[2] = 0x55;
+    tx_b[0] = 0x55;     tx_b[1] = 0x00;     tx_b[2] = 0xFF;
+
+    g_Now            = 0x1234;
+    PCA->CNT         = (uint32_t)g_Now;
+    g_BusyUntil      = 0;
+    g_BitTicks       = (double)pca_clock / baud;
+    g_TxEdgeErrMax   = 0.0;
+    g_RxSampleErrMax = 0.0;
+    g_TxCpltCnt      = 0;
+    g_RxCpltCnt      = 0;
+    g_ErrorCnt       = 0;
+
+    memset(&g_LineA, 0x0, sizeof(g_LineA));
+    memset(&g_LineB, 0x0, sizeof(g_LineB));
+    g_LineA.Level  = g_LineB.Level  = 1;
+    g_LineA.BitIdx = g_LineB.BitIdx = SOFT_UART_FRAME_BITS;
+
+    cpu.EntryTicks  = (uint32_t)(((uint64_t)pca_clock * SIM_ENTRY_CYCLES) / SIM_CPU_FREQ) + 1;
+    cpu.ModuleTicks = (uint32_t)(((uint64_t)pca_clock * SIM_MODULE_CYCLES) / SIM_CPU_FREQ) + 1;
+    cpu.BlockTicks  = (uint32_t)(((uint64_t)pca_clock * block_us) / 1000000ul);
+
+    g_hPca.Instance = PCA;
+
+    g_hSuartA.Init.hpca      = &g_hPca;
+    g_hSuartA.Init.PcaClock  = pca_clock;
+    g_hSuartA.Init.BaudRate  = baud;
+    g_hSuartA.Init.TxChannel = PCA_CHANNEL_0;
+    g_hSuartA.Init.RxChannel = PCA_CHANNEL_1;
+    g_hSuartA.Init.RxPort    = SIM_RX_PORT;
+    g_hSuartA.Init.RxPin     = SIM_RX_PIN_A;
+
+    g_hSuartB.Init           = g_hSuartA.Init;
+    g_hSuartB.Init.TxChannel = PCA_CHANNEL_2;
+    g_hSuartB.Init.RxChannel = PCA_CHANNEL_3;
+    g_hSuartB.Init.RxPin     = SIM_RX_PIN_B;
+
+    HOST_CHECK(SoftUart_Init(&g_hSuartA) == HAL_OK);
+    HOST_CHECK(SoftUart_Init(&g_hSuartB) == HAL_OK);
+    HOST_CHECK(_Sim_TxLevel(SIM_A_TX) == 1 && _Sim_TxLevel(SIM_B_TX) == 1);
+
+    HOST_CHECK(SoftUart_Receive_IT(&g_hSuartA, rx_a, SIM_BYTES) == HAL_OK);
+    HOST_CHECK(SoftUart_Receive_IT(&g_hSuartB, rx_b, SIM_BYTES) == HAL_OK);
+    HOST_CHECK(SoftUart_Transmit_IT(&g_hSuartA, tx_a, SIM_BYTES) == HAL_OK);
+
+    /* B starts half a bit later, the edges of the 2 ports interleave */
+    _Sim_Run(&cpu, (uint64_t)(g_BitTicks / 2));
+
+    HOST_CHECK(SoftUart_Transmit_IT(&g_hSuartB, tx_b, SIM_BYTES) == HAL_OK);
+
+    frame_ticks = (uint64_t)(g_BitTicks * SOFT_UART_FRAME_BITS);
+    _Sim_Run(&cpu, frame_ticks * (SIM_BYTES + 4));
+
+    HOST_CHECK(g_TxCpltCnt == 2);
+    HOST_CHECK(g_RxCpltCnt == 2);
+    HOST_CHECK(g_ErrorCnt == 0);
+    HOST_CHECK(g_hSuartA.ErrorCode == SOFT_UART_ERROR_NONE);
+    HOST_CHECK(g_hSuartB.ErrorCode == SOFT_UART_ERROR_NONE);
+    HOST_CHECK(memcmp(rx_b, tx_a, SIM_BYTES) == 0);
+    HOST_CHECK(memcmp(rx_a, tx_b, SIM_BYTES) == 0);
+
+    /* the edges are made by hardware, only the rounding of the bit offsets remains */
+    HOST_CHECK(g_TxEdgeErrMax <= 1.0);
+
+    /* the sampling jitter is the ISR latency */
+    HOST_CHECK(g_RxSampleErrMax < 0.4);
+
+    printf("  PCA %7u Hz, %5u baud, block %2u us: TX edge err %.2f counts, RX sample err %4.1f%% bit\n",
+           pca_clock, baud, block_us, g_TxEdgeErrMax, g_RxSampleErrMax * 100.0);
+
+    SoftUart_DeInit(&g_hSuartA);
+    SoftUart_DeInit(&g_hSuartB);
+    return;
+}
+
+static void _Test_Validation(void)
+{
+    SoftUart_HandleTypeDef      hsuart;
+
+    Host_ResetPeripherals();
+    memset(&hsuart, 0x0, sizeof(hsuart));
+    g_hPca.Instance = PCA;
+
+    hsuart.Init.hpca      = &g_hPca;
+    hsuart.Init.PcaClock  = 3000000ul;
+    hsuart.Init.TxChannel = PCA_CHANNEL_0;
+    hsuart.Init.RxChannel = PCA_CHANNEL_1;
+    hsuart.Init.RxPort    = SIM_RX_PORT;
+    hsuart.Init.RxPin     = SIM_RX_PIN_A;
+
+    /* a bit shorter than SOFT_UART_MIN_BIT_TICKS */
+    hsuart.Init.BaudRate = 115200;
+    HOST_CHECK(SoftUart_Init(&hsuart) == HAL_ERROR);
+
+    /* a frame longer than the 16-bits compare distance */
+    hsuart.Init.PcaClock = 24000000ul;
+    hsuart.Init.BaudRate = 2400;
+    HOST_CHECK(SoftUart_Init(&hsuart) == HAL_ERROR);
+
+    /* TX and RX on the same module */
+    hsuart.Init.BaudRate  = 9600;
+    hsuart.Init.RxChannel = PCA_CHANNEL_0;
+    HOST_CHECK(SoftUart_Init(&hsuart) == HAL_ERROR);
+    return;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+int main(void)
+{
+    const uint32_t  pca_clocks[] = { 3000000ul, 6000000ul, 24000000ul };
+    const uint32_t  bauds[][2] =
+    {
+        /* baud, other ISRs block the PCA IRQ up to (us) */
+        {  9600, SIM_BLOCK_US_9600 },
+        { 19200, SIM_BLOCK_US_19200 },
+        { 38400, SIM_BLOCK_US_38400 },
+    };
+
+    if( Host_MapPeripherals() )
+        return 1;
+
+    srand(1);
+
+    _Test_Validation();
+
+    for(uint32_t c = 0; c < sizeof(pca_clocks) / sizeof(pca_clocks[0]); c++)
+    {
+        for(uint32_t b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++)
+        {
+            /* 24 MHz at 9600 baud is rejected, a frame exceeds 16-bits */
+            if( ((uint64_t)pca_clocks[c] / bauds[b][0]) * (SOFT_UART_FRAME_BITS + 1) > 0xFFFFul )
+                continue;
+
+            _Test_FullDuplex(pca_clocks[c], bauds[b][0], 0);
+            _Test_FullDuplex(pca_clocks[c], bauds[b][0], bauds[b][1]);
+        }
+    }
+
+    return HOST_REPORT("test_soft_uart");
+}
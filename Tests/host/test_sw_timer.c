@@ -0,0 +1,337 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file test_sw_timer.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Software timer wheel against a count-by-count model of BASETIM/LPTIM.
+ *
+ *  + The counter counts up, reloads BGLOAD after the maximum value and sets
+ *    the overflow flag. The ISR runs after a random latency (less than the
+ *    guard of half a tick) when the interrupts are enabled.
+ *  + The true time is the number of simulated counts, SwTimer_GetTick() MUST
+ *    match it after any re-programming (LOAD is never written after start).
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "sw_timer.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define SIM_TICK_SHIFT          4
+#define SIM_TIMER_NUM           8
+#define SIM_IRQ_LATENCY_MAX     7ul     /* counts, less than half a tick */
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+#define _TRUE_TICK()            ((uint32_t)(g_Counts >> SIM_TICK_SHIFT))
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+typedef struct sim_timer
+{
+    SwTimer_TypeDef     Timer;
+    uint32_t            Expected;   /* expected expiry tick */
+    uint32_t            FireCnt;
+    uint32_t            MaxLate;    /* ticks */
+    uint32_t            EarlyCnt;
+
+} sim_timer_t;
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static SwTimer_HwSelTypeDef     g_HwSel;
+static uint32_t                 g_CntMax;
+static uint64_t                 g_Counts;
+static uint32_t                 g_IrqDelay;
+static uint32_t                 g_IrqCnt;
+static uint32_t                 g_Load;     /* LOAD after SwTimer_Init() */
+static uint32_t                 g_TickErrCnt;
+
+static BASETIM_HandleTypeDef    g_hBaseTim;
+static LPTIM_HandleTypeDef      g_hLpTim;
+
+static sim_timer_t              g_Timers[SIM_TIMER_NUM];
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+static __IO uint32_t* _Sim_CntReg(void)
+{
+    return (g_HwSel == SW_TIMER_HW_LPTIM) ? &LPTIM->CNTVAL : &TIM10->CNT;
+}
+
+static __IO uint32_t* _Sim_FlagReg(uint32_t *pBit)
+{
+    *pBit = (g_HwSel == SW_TIMER_HW_LPTIM) ? LPTIM_INTSR_INTF : BASETIM_RAWINTSR_RIS;
+    return (g_HwSel == SW_TIMER_HW_LPTIM) ? &LPTIM->INTSR : &TIM10->RAWINTSR;
+}
+
+void Sim_ClearOverflow(void)
+{
+    uint32_t        bit = 0;
+    __IO uint32_t   *pFlag = _Sim_FlagReg(&bit);
+
+    *pFlag &= ~bit;
+    return;
+}
+
+static uint32_t _Sim_LoadReg(void)
+{
+    return (g_HwSel == SW_TIMER_HW_LPTIM) ? LPTIM->LOAD : TIM10->LOAD;
+}
+
+/**
+ *  @brief  One count of the hardware, then the ISR if it is due
+ */
+static void _Sim_Step(void)
+{
+    __IO uint32_t   *pCnt = _Sim_CntReg();
+    uint32_t        bit = 0;
+    __IO uint32_t   *pFlag = _Sim_FlagReg(&bit);
+
+    if( *pCnt == g_CntMax )
+    {
+        *pCnt  = (g_HwSel == SW_TIMER_HW_LPTIM) ? LPTIM->BGLOAD : TIM10->BGLOAD;
+        *pFlag |= bit;
+
+        if( !g_IrqDelay )
+            g_IrqDelay = 1 + (uint32_t)rand() % (SIM_IRQ_LATENCY_MAX + 1);
+    }
+    else
+    {
+        *pCnt = (*pCnt + 1) & g_CntMax;
+    }
+
+    g_Counts++;
+
+    if( (*pFlag & bit) && g_IrqDelay && --g_IrqDelay == 0 && !g_Host_Primask )
+    {
+        g_IrqCnt++;
+        SwTimer_IRQHandler();
+    }
+    return;
+}
+
+static void _Sim_Run(uint32_t counts)
+{
+    while( counts-- )
+        _Sim_Step();
+
+    if( SwTimer_GetTick() != _TRUE_TICK() )
+        g_TickErrCnt++;
+    return;
+}
+
+static void _Sim_Callback(SwTimer_TypeDef *pTimer)
+{
+    sim_timer_t     *pSim = (sim_timer_t*)pTimer->pUserData;
+    uint32_t        now = _TRUE_TICK();
+
+    if( SwTimer_GetTick() != now )
+        g_TickErrCnt++;
+
+    if( (int32_t)(now - pSim->Expected) < 0 )
+        pSim->EarlyCnt++;
+    else if( now - pSim->Expected > pSim->MaxLate )
+        pSim->MaxLate = now - pSim->Expected;
+
+    pSim->FireCnt++;
+    pSim->Expected += pTimer->Period;
+    return;
+}
+
+static void _Sim_Start(sim_timer_t *pSim, uint32_t timeout, uint32_t period)
+{
+    pSim->Expected = _TRUE_TICK() + timeout;
+    HOST_CHECK(SwTimer_Start(&pSim->Timer, timeout, period) == HAL_OK);
+    return;
+}
+
+static void _Test_Setup(SwTimer_HwSelTypeDef hw, uint32_t is_32bits)
+{
+    SwTimer_InitTypeDef     init = {0};
+
+    Host_ResetPeripherals();
+    memset(&g_hBaseTim, 0x0, sizeof(g_hBaseTim));
+    memset(&g_hLpTim, 0x0, sizeof(g_hLpTim));
+
+    g_HwSel      = hw;
+    g_Counts     = 0;
+    g_IrqDelay   = 0;
+    g_IrqCnt     = 0;
+    g_TickErrCnt = 0;
+
+    g_hBaseTim.Instance = TIM10;
+    g_hBaseTim.Init.MaxCntLevel = (is_32bits) ? BASETIM_MAXCNTLEVEL_32BIT : BASETIM_MAXCNTLEVEL_16BIT;
+    g_hLpTim.Instance   = LPTIM;
+
+    g_CntMax = (hw == SW_TIMER_HW_BASETIM && is_32bits) ? 0xFFFFFFFFul : 0xFFFFul;
+
+    init.HwSel     = hw;
+    init.pHwHandle = (hw == SW_TIMER_HW_LPTIM) ? (void*)&g_hLpTim : (void*)&g_hBaseTim;
+    init.TickShift = SIM_TICK_SHIFT;
+    HOST_CHECK(SwTimer_Init(&init) == HAL_OK);
+
+    /* the counter starts at LOAD */
+    g_Load = _Sim_LoadReg();
+    *_Sim_CntReg() = g_Load;
+
+    for(int i = 0; i < SIM_TIMER_NUM; i++)
+    {
+        memset(&g_Timers[i], 0x0, sizeof(sim_timer_t));
+        SwTimer_Setup(&g_Timers[i].Timer, _Sim_Callback, &g_Timers[i]);
+    }
+    return;
+}
+
+/**
+ *  @brief  Random starts (earlier deadlines re-program the hardware), the tick
+ *          MUST not drift and a deadline is never early
+ */
+static void _Test_Random(SwTimer_HwSelTypeDef hw, uint32_t is_32bits)
+{
+    uint32_t    fire_cnt = 0;
+    uint32_t    early_cnt = 0;
+    uint32_t    max_late = 0;
+
+    _Test_Setup(hw, is_32bits);
+
+    for(int i = 0; i < 20000; i++)
+    {
+        sim_timer_t     *pSim = &g_Timers[rand() % SIM_TIMER_NUM];
+
+        _Sim_Run((uint32_t)rand() % 200);
+
+        if( rand() & 0x1 )
+            _Sim_Start(pSim, 1 + (uint32_t)rand() % 100, 0);
+        else if( !(rand() % 8) )
+            SwTimer_Stop(&pSim->Timer);
+    }
+
+    for(int i = 0; i < SIM_TIMER_NUM; i++)
+    {
+        fire_cnt  += g_Timers[i].FireCnt;
+        early_cnt += g_Timers[i].EarlyCnt;
+        if( g_Timers[i].MaxLate > max_late )
+            max_late = g_Timers[i].MaxLate;
+    }
+
+    printf("  %s %s: %u fires, max late %u ticks, %u IRQs, %lu ticks\n",
+           (hw == SW_TIMER_HW_LPTIM) ? "LPTIM  " : "BASETIM", (is_32bits) ? "32-bits" : "16-bits",
+           fire_cnt, max_late, g_IrqCnt, (unsigned long)_TRUE_TICK());
+
+    HOST_CHECK(g_TickErrCnt == 0);
+    HOST_CHECK(_Sim_LoadReg() == g_Load);
+    HOST_CHECK(fire_cnt > 1000);
+    HOST_CHECK(early_cnt == 0);
+    HOST_CHECK(max_late <= 2 * SW_TIMER_RUN_TICKS + 1);
+    return;
+}
+
+/**
+ *  @brief  Periodic timers fire on time. Alone, a timer needs one IRQ per
+ *          SW_TIMER_RUN_TICKS (and the level 1 wraps, the cascades are not
+ *          waited).
+ */
+static void _Test_Periodic(uint32_t period, uint32_t period2)
+{
+    uint32_t    irq_base = 0;
+    uint32_t    tick_base = 0;
+    uint32_t    late_cnt = 0;
+
+    _Test_Setup(SW_TIMER_HW_BASETIM, 0);
+
+    _Sim_Run(100);
+    _Sim_Start(&g_Timers[0], period, period);
+    if( period2 )
+        _Sim_Start(&g_Timers[1], period2, period2);
+
+    /* settle: the deadline may be inside the running period */
+    while( g_Timers[0].FireCnt < 3 || (period2 && g_Timers[1].FireCnt < 3) )
+        _Sim_Run(1);
+
+    irq_base  = g_IrqCnt;
+    tick_base = _TRUE_TICK();
+    for(int i = 0; i < 2; i++)
+    {
+        g_Timers[i].FireCnt = 0;
+        g_Timers[i].MaxLate = 0;
+    }
+
+    while( g_Timers[0].FireCnt < 200 )
+    {
+        uint32_t    fire_cnt = g_Timers[0].FireCnt + g_Timers[1].FireCnt;
+
+        while( g_Timers[0].FireCnt + g_Timers[1].FireCnt == fire_cnt )
+            _Sim_Run(1);
+
+        if( g_Timers[0].MaxLate || g_Timers[1].MaxLate )
+            late_cnt++;
+    }
+
+    printf("  period %3u/%3u ticks: %u/%u fires, %u IRQs, %u late\n",
+           period, period2, g_Timers[0].FireCnt, g_Timers[1].FireCnt, g_IrqCnt - irq_base, late_cnt);
+
+    HOST_CHECK(g_TickErrCnt == 0);
+    HOST_CHECK(g_Timers[0].EarlyCnt == 0 && g_Timers[1].EarlyCnt == 0);
+    HOST_CHECK(late_cnt == 0);
+
+    if( !period2 )
+    {
+        uint32_t    wraps = (_TRUE_TICK() - tick_base) >> (2 * SW_TIMER_WHEEL_BITS);
+
+        HOST_CHECK(g_IrqCnt - irq_base <= g_Timers[0].FireCnt * ((period + SW_TIMER_RUN_TICKS - 1) / SW_TIMER_RUN_TICKS) + wraps + 1);
+    }
+    return;
+}
+
+/**
+ *  @brief  Without timer, the hardware wakes up every SW_TIMER_RUN_TICKS
+ */
+static void _Test_Idle(void)
+{
+    _Test_Setup(SW_TIMER_HW_LPTIM, 0);
+
+    _Sim_Run((SW_TIMER_RUN_TICKS * 100) << SIM_TICK_SHIFT);
+
+    HOST_CHECK(g_TickErrCnt == 0);
+    HOST_CHECK(g_IrqCnt >= 99 && g_IrqCnt <= 100);
+    return;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+int main(void)
+{
+    if( Host_MapPeripherals() )
+        return 1;
+
+    srand(1);
+
+    _Test_Random(SW_TIMER_HW_BASETIM, 0);
+    _Test_Random(SW_TIMER_HW_BASETIM, 1);
+    _Test_Random(SW_TIMER_HW_LPTIM, 0);
+
+    _Test_Periodic(1, 0);
+    _Test_Periodic(10, 0);
+    _Test_Periodic(SW_TIMER_RUN_TICKS, 0);
+    _Test_Periodic(100, 0);
+    _Test_Periodic(100, 37);
+    _Test_Periodic(45, 7);
+
+    _Test_Idle();
+
+    return HOST_REPORT("test_sw_timer");
+}
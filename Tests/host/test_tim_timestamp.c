@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2022 Wei-Lun Hsu. All Rights Reserved.
+ */
+/** @file test_tim_timestamp.c
+ *
+ * @author Wei-Lun Hsu
+ * @version 0.1
+ * @date 2022/04/28
+ * @license
+ * @description
+ *  Wrap logic of the 64-bits TIM timestamp (HAL_GetCycles64/HAL_GetMicros64).
+ *
+ *  The fake TIM does not count by itself, _Sim_Advance() plays the counter
+ *  and raises UIF at the wrap, the IRQ handler is called with a random delay
+ *  (at most one period late, as the design requires).
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+
+//=============================================================================
+//                  Constant Definition
+//=============================================================================
+#define SIM_PERIOD          0x10000ul
+
+//=============================================================================
+//                  Macro Definition
+//=============================================================================
+
+//=============================================================================
+//                  Structure Definition
+//=============================================================================
+
+//=============================================================================
+//                  Global Data Definition
+//=============================================================================
+static TIM_TypeDef          g_Fake_TIM;
+static TIM_HandleTypeDef    g_hTim;
+static uint64_t             g_True_Cycles = 0;
+
+static void (*g_pfIRQHandler)(TIM_HandleTypeDef *htim) = HAL_TIM_IRQHandler;
+static uint32_t             g_Fast_UpdateCnt = 0;
+
+static void _Fast_Update(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+    g_Fast_UpdateCnt++;
+}
+
+static const pTIM_CallbackTypeDef   g_Fast_Callbacks[HAL_TIM_FAST_CB_NUM] =
+{
+    [HAL_TIM_FAST_CB_UPDATE] = _Fast_Update,
+};
+
+//=============================================================================
+//                  Private Function Definition
+//=============================================================================
+/**
+ *  SR is rc_w0, a HAL write of ~flag only clears the flag in the hardware,
+ *  the fake keeps the other bits of that write, drop them.
+ */
+static void _Sim_SyncSR(void)
+{
+    g_Fake_TIM.SR &= TIM_FLAG_UPDATE;
+}
+
+static void _Sim_Advance(uint32_t cycles)
+{
+    g_True_Cycles += cycles;
+
+    cycles += g_Fake_TIM.CNT;
+    if( cycles >= SIM_PERIOD )
+        g_Fake_TIM.SR |= TIM_FLAG_UPDATE;
+
+    g_Fake_TIM.CNT = cycles % SIM_PERIOD;
+    return;
+}
+
+static void _Sim_ServiceIRQ(void)
+{
+    if( !(g_Fake_TIM.SR & TIM_FLAG_UPDATE) )
+        return;
+
+    g_pfIRQHandler(&g_hTim);
+    _Sim_SyncSR();
+    return;
+}
+
+static void _Test_Start(uint32_t freq)
+{
+    memset(&g_Fake_TIM, 0, sizeof(g_Fake_TIM));
+    memset(&g_hTim, 0, sizeof(g_hTim));
+
+    g_hTim.Instance = &g_Fake_TIM;
+    g_Host_PclkFreq = freq;
+    g_True_Cycles   = 0;
+
+    HOST_CHECK(HAL_TIM_Timestamp_Start(&g_hTim) == HAL_OK);
+    _Sim_SyncSR();
+
+    HOST_CHECK(HAL_TIM_Timestamp_GetFreq() == freq);
+    HOST_CHECK(g_Fake_TIM.ARR == SIM_PERIOD - 1);
+    HOST_CHECK(g_Fake_TIM.DIER & TIM_IT_UPDATE);
+
+    if( g_pfIRQHandler == HAL_TIM_FastIRQHandler )
+        HOST_CHECK(HAL_TIM_RegisterFastCallbacks(&g_hTim, g_Fast_Callbacks) == HAL_OK);
+    return;
+}
+
+static void _Test_PendingWrap(void)
+{
+    uint64_t    before = 0, after = 0;
+
+    _Test_Start(24000000ul);
+
+    /* Just before the wrap */
+    _Sim_Advance(SIM_PERIOD - 3);
+    before = HAL_GetCycles64();
+    HOST_CHECK(before == g_True_Cycles);
+
+    /* Wrapped, the IRQ is not serviced yet */
+    _Sim_Advance(5);
+    after = HAL_GetCycles64();
+    HOST_CHECK(after == g_True_Cycles);
+    HOST_CHECK(after > before);
+
+    /* The handler folds the period, the time does not move */
+    _Sim_ServiceIRQ();
+    HOST_CHECK(!(g_Fake_TIM.SR & TIM_FLAG_UPDATE));
+    HOST_CHECK(HAL_GetCycles64() == after);
+    return;
+}
+
+static void _Test_CriticalSection(void)
+{
+    uint32_t    irq_off_cnt = 0;
+
+    _Test_Start(24000000ul);
+
+    _Sim_Advance(SIM_PERIOD + 10);
+
+    /* The flag clear and the high word update are done in one critical section */
+    irq_off_cnt = g_Host_IrqOffCnt;
+    _Sim_ServiceIRQ();
+    HOST_CHECK(g_Host_IrqOffCnt == irq_off_cnt + 1);
+    HOST_CHECK(g_Host_Primask == 0);
+    HOST_CHECK(HAL_GetCycles64() == g_True_Cycles);
+    return;
+}
+
+static void _Test_RandomRun(void)
+{
+    uint64_t    last = 0;
+
+    _Test_Start(24000000ul);
+
+    for(int i = 0; i < 1000000; i++)
+    {
+        uint32_t    step = (uint32_t)rand() % 40000;
+        uint64_t    now = 0;
+
+        /* At most one un-serviced wrap */
+        if( (g_Fake_TIM.SR & TIM_FLAG_UPDATE) && (g_Fake_TIM.CNT + step) >= SIM_PERIOD )
+            _Sim_ServiceIRQ();
+
+        _Sim_Advance(step);
+
+        if( rand() & 0x1 )
+            _Sim_ServiceIRQ();
+
+        now = HAL_GetCycles64();
+        if( now != g_True_Cycles || now < last )
+        {
+            HOST_CHECK(now == g_True_Cycles);
+            HOST_CHECK(now >= last);
+            break;
+        }
+
+        last = now;
+    }
+
+    HOST_CHECK(HAL_GetCycles64() == g_True_Cycles);
+    return;
+}
+
+static void _Test_Micros(uint32_t freq)
+{
+    _Test_Start(freq);
+
+    for(int i = 0; i < 200000; i++)
+    {
+        uint64_t    expect = 0, micros = 0, tolerance = 0;
+
+        if( g_Fake_TIM.SR & TIM_FLAG_UPDATE )
+            _Sim_ServiceIRQ();
+
+        _Sim_Advance((uint32_t)rand() % SIM_PERIOD);
+
+        expect = (g_True_Cycles * 1000000ull) / freq;
+        micros = HAL_GetMicros64();
+
+        /* The multiplier keeps 32 significant bits */
+        tolerance = 1 + (expect >> 30);
+
+        if( (micros > expect + tolerance) || (micros + tolerance < expect) )
+        {
+            printf("freq %u: cycles %llu, expect %llu us, got %llu us\n",
+                   freq, (unsigned long long)g_True_Cycles,
+                   (unsigned long long)expect, (unsigned long long)micros);
+            HOST_CHECK(0);
+            break;
+        }
+    }
+    return;
+}
+//=============================================================================
+//                  Public Function Definition
+//=============================================================================
+int main(void)
+{
+    srand(1);
+
+    _Test_PendingWrap();
+    _Test_CriticalSection();
+    _Test_RandomRun();
+
+    /* The same with the fast dispatch */
+    g_pfIRQHandler   = HAL_TIM_FastIRQHandler;
+    g_Fast_UpdateCnt = 0;
+
+    _Test_PendingWrap();
+    HOST_CHECK(g_Fast_UpdateCnt == 1);
+    _Test_CriticalSection();
+    _Test_RandomRun();
+
+    g_pfIRQHandler = HAL_TIM_IRQHandler;
+
+    /* PCLK with divider and the SIRC/LXT clock profiles are below 1 MHz */
+    _Test_Micros(24000000ul);
+    _Test_Micros(22120000ul);
+    _Test_Micros(4000000ul);
+    _Test_Micros(1000000ul);
+    _Test_Micros(38400ul);
+    _Test_Micros(32768ul);
+
+    return HOST_REPORT("test_tim_timestamp");
+}